@@ -168,6 +168,40 @@ typedef struct ldoc_raw_t
     uint64_t len;
 } ldoc_raw_t;
 
+/**
+ * @brief Payload representations.
+ *
+ * Determines whether string payloads of a node or entity are null-terminated
+ * strings or raw data structures (`ldoc_raw_t`) that reference an external
+ * buffer, such as the input of a zero-copy reader. Numeric datums of
+ * `LDOC_ENT_NUM`/`LDOC_ENT_NR` entities can be binary values instead, which is
+ * indicated by additional flags.
+ */
+typedef enum
+{
+    /**
+     * Null-terminated strings (`str`); the default.
+     */
+    LDOC_REP_STR = 0,
+    /**
+     * Raw data structures (`raw`) that are not null-terminated; `raw.pld` is NULL for null values.
+     */
+    LDOC_REP_RAW = 1,
+    /**
+     * Flag: the numeric datum is a 64-bit integer (`i64`).
+     */
+    LDOC_REP_I64 = 2,
+    /**
+     * Flag: the numeric datum is a double precision floating point number (`f64`).
+     */
+    LDOC_REP_F64 = 4
+} ldoc_rep_t;
+
+/**
+ * @brief Buffer size that suffices for formatting any binary numeric datum (see `ldoc_ent_dtm_fmt`).
+ */
+#define LDOC_NUM_LEN 32
+
 /**
  * @brief Payload data types for annotations.
  *
@@ -187,6 +221,14 @@ typedef union
      * Raw data structure.
      */
     ldoc_raw_t raw;
+    /**
+     * 64-bit integer (numeric datums only).
+     */
+    int64_t i64;
+    /**
+     * Double precision floating point number (numeric datums only).
+     */
+    double f64;
 } ldoc_anno_pld_t;
 
 /**
@@ -248,6 +290,14 @@ typedef union
      * Raw data structure.
      */
     ldoc_raw_t raw;
+    /**
+     * 64-bit integer (numeric datums only).
+     */
+    int64_t i64;
+    /**
+     * Double precision floating point number (numeric datums only).
+     */
+    double f64;
     /**
      * Annotation pair (datum + annotation payload)
      */
@@ -339,6 +389,10 @@ typedef struct ldoc_nde_t
      * Optional node annotation (markup).
      */
     ldoc_doc_anno_t mkup;
+    /**
+     * Representation of the annotation's string payloads (`ldoc_rep_t`).
+     */
+    uint8_t rep;
     /**
      * Longest path to a leaf.
      */
@@ -351,6 +405,14 @@ typedef struct ldoc_nde_t
      * Number of descending nodes.
      */
     uint32_t dsc_cnt;
+    /**
+     * Index of the annotations of descending nodes and entities, or NULL (see `ldoc_doc_index`).
+     */
+    struct ldoc_nde_idx_t* idx;
+    /**
+     * Pre-order number of the node in the document's offset index (see `ldoc_doc_pos_index`).
+     */
+    uint32_t pos;
     /**
      * List of descendent nodes.
      */
@@ -420,12 +482,65 @@ typedef struct ldoc_ent_t
      * Entity payload (datum).
      */
     ldoc_pld_t pld;
+    /**
+     * Representation of the payload's strings and numbers (`ldoc_rep_t` flags).
+     */
+    uint8_t rep;
     /**
      * Internal list-pointer.
      */
     TAILQ_ENTRY(ldoc_ent_t) ldoc_ent_entries;
 } ldoc_ent_t;
 
+/**
+ * @brief Memory block of an arena.
+ *
+ * The block's data area directly follows the (padded) block header.
+ */
+typedef struct ldoc_arna_blk_t
+{
+    /**
+     * Next block in the arena's block list.
+     */
+    struct ldoc_arna_blk_t* nxt;
+    /**
+     * Number of bytes of the data area that are in use.
+     */
+    size_t len;
+    /**
+     * Size of the data area in bytes.
+     */
+    size_t max;
+} ldoc_arna_blk_t;
+
+/**
+ * @brief Arena (bump) allocator.
+ *
+ * Hands out memory from large blocks; individual allocations cannot be
+ * released, but all of them are released at once by freeing the arena.
+ */
+typedef struct ldoc_arna_t
+{
+    /**
+     * Block that allocations are currently served from (head of the block list).
+     */
+    ldoc_arna_blk_t* blk;
+    /**
+     * Size of the data area of the next block that is being allocated.
+     */
+    size_t inc;
+} ldoc_arna_t;
+
+/**
+ * @brief String interning table (opaque); see `ldoc_intn_new`.
+ */
+typedef struct ldoc_intn_t ldoc_intn_t;
+
+/**
+ * @brief Compiled annotation path query (opaque); see `ldoc_qry_new`.
+ */
+typedef struct ldoc_qry_t ldoc_qry_t;
+
 /**
  * @brief Document structure.
  */
@@ -435,8 +550,109 @@ typedef struct ldoc_doc_t
      * Root node of the document.
      */
     ldoc_nde_t* rt;
+    /**
+     * Arena that holds nodes, entities and payload strings, or NULL if these are allocated individually.
+     */
+    ldoc_arna_t* arna;
+    /**
+     * Memory mapped file that payload strings point into, or NULL (see `ldoc_doc_load_mmap`).
+     */
+    void* map;
+    /**
+     * Length of the memory mapped file in bytes.
+     */
+    size_t map_len;
+    /**
+     * Set once node annotation indices were built (see `ldoc_doc_index`).
+     */
+    bool idx;
+    /**
+     * Interning table that all node and entity annotations are interned in, or NULL (see `ldoc_intn_new`); not owned by the document.
+     */
+    ldoc_intn_t* intn;
+    /**
+     * Index of the character offsets of nodes, or NULL (see `ldoc_doc_pos_index`).
+     */
+    struct ldoc_pos_idx_t* pos;
 } ldoc_doc_t;
 
+/**
+ * @brief Minimum number of descending nodes and entities of a node for building an annotation index.
+ */
+#define LDOC_NDE_IDX_MIN 16
+
+/**
+ * @brief Null index of frozen documents (no such node or entity).
+ */
+#define LDOC_FRZ_NULL UINT32_MAX
+
+/**
+ * @brief Immutable, array-based ("frozen") form of a document.
+ *
+ * Nodes and entities are identified by their indices into the arrays below.
+ * Nodes are stored in pre-order, so that the root has index 0 and the first
+ * child of a node directly follows it. Entities are stored in the order of
+ * their nodes, so that the entities of node `i` are those from `ents[i]` up to
+ * (excluding) `ents[i + 1]`. Payload strings are copied into a pool that the
+ * frozen document owns; they are raw data structures (`LDOC_REP_RAW`), which
+ * are null-terminated nonetheless.
+ */
+typedef struct ldoc_frz_t
+{
+    /**
+     * Number of nodes.
+     */
+    uint32_t nde_cnt;
+    /**
+     * Number of entities.
+     */
+    uint32_t ent_cnt;
+    /**
+     * Node types (`ldoc_struct_t`).
+     */
+    uint8_t* tpe;
+    /**
+     * Parent node indices (`LDOC_FRZ_NULL` for the root).
+     */
+    uint32_t* prnt;
+    /**
+     * First child node indices (`LDOC_FRZ_NULL` for none).
+     */
+    uint32_t* fst;
+    /**
+     * Next sibling node indices (`LDOC_FRZ_NULL` for none).
+     */
+    uint32_t* nxt;
+    /**
+     * Index of the first entity of each node; `nde_cnt + 1` entries.
+     */
+    uint32_t* ents;
+    /**
+     * Node annotations (`pld` is NULL for none).
+     */
+    ldoc_raw_t* anno;
+    /**
+     * Entity types (`ldoc_content_t`).
+     */
+    uint8_t* ent_tpe;
+    /**
+     * Representations of the entity datums (`ldoc_rep_t` flags).
+     */
+    uint8_t* ent_rep;
+    /**
+     * Entity annotations of annotated entities (`pld` is NULL for none).
+     */
+    ldoc_raw_t* ent_anno;
+    /**
+     * Entity datums.
+     */
+    ldoc_anno_pld_t* ent_dtm;
+    /**
+     * String pool.
+     */
+    char* pool;
+} ldoc_frz_t;
+
 /**
  * @brief A cursor position within a node.
  *
@@ -454,11 +670,49 @@ typedef struct ldoc_pos_t
      */
     uint64_t nde_off;
     /**
-     * Cursor offset within the node.
+     * Cursor offset within the node (relative to `nde_off`).
      */
     uint64_t off;
 } ldoc_pos_t;
 
+/**
+ * @brief Occurrence of a trie string in a document (see `ldoc_find_mtchs`).
+ */
+typedef struct ldoc_mtch_t
+{
+    /**
+     * Most detailed node that captures the occurrence, and the offset at which it begins.
+     */
+    ldoc_pos_t pos;
+    /**
+     * Length of the occurrence.
+     */
+    uint16_t len;
+    /**
+     * Annotation of the trie string.
+     */
+    ldoc_trie_anno_t anno;
+} ldoc_mtch_t;
+
+/**
+ * @brief Array of trie-string occurrences.
+ */
+typedef struct ldoc_mtch_arr_t
+{
+    /**
+     * Write pointer. Number of occurrences in `mtchs`.
+     */
+    size_t wptr;
+    /**
+     * Maximum number of occurrences that the array can hold without reallocating memory.
+     */
+    size_t max;
+    /**
+     * Occurrences in the order in which they end in the document.
+     */
+    ldoc_mtch_t* mtchs;
+} ldoc_mtch_arr_t;
+
 /**
  * @brief Information carrying types in a document: nodes and entities.
  */
@@ -476,6 +730,77 @@ typedef struct ldoc_res_t
     bool nde;
     ldoc_info_t info;
 } ldoc_res_t;
+
+/**
+ * @brief Number of query iterator frames that do not need to be allocated.
+ */
+#define LDOC_QRY_STK 16
+
+/**
+ * @brief Node whose children a query iterator is testing against a path segment.
+ */
+typedef struct ldoc_qry_frm_t
+{
+    /**
+     * Node.
+     */
+    ldoc_nde_t* nde;
+    /**
+     * Next entity to test, or NULL.
+     */
+    ldoc_ent_t* ent;
+    /**
+     * Next descendant to test, or NULL.
+     */
+    ldoc_nde_t* dsc;
+    /**
+     * Index of the path segment.
+     */
+    size_t i;
+    /**
+     * Whether a "**" segment was matched against zero levels already.
+     */
+    bool zro;
+} ldoc_qry_frm_t;
+
+/**
+ * @brief Iterator over all matches of a query; see `ldoc_qry_itr_init`.
+ */
+typedef struct ldoc_qry_itr_t
+{
+    /**
+     * Query.
+     */
+    ldoc_qry_t* qry;
+    /**
+     * Whether keys are compared as interned strings.
+     */
+    bool ptr;
+    /**
+     * Stack of frames (`stk` or allocated).
+     */
+    ldoc_qry_frm_t* frms;
+    /**
+     * Number of frames.
+     */
+    size_t cnt;
+    /**
+     * Capacity of `frms`.
+     */
+    size_t max;
+    /**
+     * Frames that do not need to be allocated.
+     */
+    ldoc_qry_frm_t stk[LDOC_QRY_STK];
+    /**
+     * Current match.
+     */
+    ldoc_res_t res;
+    /**
+     * Whether iterating ended early because memory could not be allocated.
+     */
+    bool fail;
+} ldoc_qry_itr_t;
     
 /**
  * @brief Coordinate with in a document.
@@ -640,6 +965,49 @@ typedef struct ldoc_vis_ent_t
     ldoc_ser_t* (*vis_txt)(ldoc_nde_t* nde, ldoc_ent_t* ent, ldoc_coord_t* coord);
 } ldoc_vis_ent_t;
 
+/**
+ * @brief Output sink for streaming string serializations.
+ *
+ * A sink appends serialized fragments to a single growable buffer. If a write
+ * callback (`wrt`) is set, then the buffer is handed to the callback whenever it
+ * fills up, so that a serialization never has to be held in memory completely.
+ */
+typedef struct ldoc_snk_t
+{
+    /**
+     * Buffer; always null-terminated, or NULL after `ldoc_snk_take` until the next append.
+     */
+    char* buf;
+    /**
+     * Number of bytes in the buffer (without null-terminator).
+     */
+    size_t len;
+    /**
+     * Allocated size of the buffer.
+     */
+    size_t max;
+    /**
+     * Initial size of the buffer, which is used again for the buffer after `ldoc_snk_take`.
+     */
+    size_t init;
+    /**
+     * Optional write callback; has to return false if `len` bytes of `str` could not be written.
+     */
+    bool (*wrt)(void* ctx, const char* str, size_t len);
+    /**
+     * Context that is passed on to the write callback `wrt`.
+     */
+    void* ctx;
+    /**
+     * Total number of bytes that were appended to the sink.
+     */
+    uint64_t tot;
+    /**
+     * Set when the sink failed (allocation, write callback, or non-string serialization).
+     */
+    bool err;
+} ldoc_snk_t;
+
 /**
  * @brief Null pointer for document objects.
  */
@@ -690,6 +1058,17 @@ char* ldoc_py2str(PyObject* obj);
  * @return Document representation of `dict`.
  */
 ldoc_doc_t* ldoc_pydict2doc(PyObject* dict);
+
+/**
+ * @brief Turns a Python dictionary into an arena allocated LibDocument document.
+ *
+ * <strong>Note:</strong> Removed when `LDOC_NOPYTHON` is defined.
+ *
+ * @param dict Python dictionary.
+ * @param hnt Expected number of bytes that the document will occupy (see `ldoc_doc_new_arena`).
+ * @return Document representation of `dict`.
+ */
+ldoc_doc_t* ldoc_pydict2doc_arena(PyObject* dict, size_t hnt);
     
 #endif // #ifndef LDOC_NOPYTHON
     
@@ -776,13 +1155,269 @@ void ldoc_pos_free(ldoc_pos_t* pos);
  */
 ldoc_doc_t* ldoc_doc_new();
 
+/**
+ * @brief Create a new document whose nodes, entities and payload strings are arena allocated.
+ *
+ * Nodes, entities and strings of such a document have to be created via
+ * `ldoc_doc_nde_new`, `ldoc_doc_ent_new` and `ldoc_doc_strndup`; they must not be
+ * released individually (`ldoc_nde_free`, `ldoc_ent_free`). `ldoc_doc_free`
+ * releases all of them with a few calls to `free`.
+ *
+ * @param hnt Expected number of bytes that the document will occupy (0: page size).
+ * @return An empty document with a root node (`LDOC_NDE_RT`), or `LDOC_DOC_NULL` if memory could not be allocated.
+ */
+ldoc_doc_t* ldoc_doc_new_arena(size_t hnt);
+
 /**
  * @brief Releases all allocated memory of a document (including nodes and entities).
  *
+ * For arena documents (see `ldoc_doc_new_arena`), this also releases the memory of all payload strings.
+ *
  * @param doc Document whose memory is being released.
  */
 void ldoc_doc_free(ldoc_doc_t* doc);
 
+/**
+ * @brief Saves a document in binary format.
+ *
+ * The format consists of a header, a table of nodes in pre-order, a table of
+ * entities in the order of their nodes and a pool of null-terminated strings.
+ * Numbers are stored in host byte order, so files are only portable between
+ * hosts of the same byte order.
+ *
+ * @param doc Document to save.
+ * @param pth Path of the file to write.
+ * @return True if the file was written; false otherwise.
+ */
+bool ldoc_doc_save(ldoc_doc_t* doc, const char* pth);
+
+/**
+ * @brief Loads a document that was saved via `ldoc_doc_save` by memory mapping it.
+ *
+ * Nodes and entities are arena allocated in a single pass over the file's
+ * tables; payload strings point into the mapped string pool and are neither
+ * copied nor parsed. The mapping is private, so that changes to payload strings
+ * are not written back. It is released by `ldoc_doc_free`.
+ *
+ * @param pth Path of the file to load.
+ * @return A document whose payload strings are `LDOC_REP_STR` strings, or `LDOC_DOC_NULL` if the file could not be mapped or is not a valid binary document.
+ */
+ldoc_doc_t* ldoc_doc_load_mmap(const char* pth);
+
+/**
+ * @brief Creates a string interning table.
+ *
+ * An interning table holds one copy of each string that is interned in it,
+ * so that equal strings are represented by the same pointer. A table can be
+ * shared by many documents (for example, all documents of a JSON Lines
+ * stream); it has to outlive them. Tables are not thread-safe.
+ *
+ * If `doc->intn` is set, `ldoc_find_anno` compares annotations by pointer;
+ * all annotations of such a document must be interned in `doc->intn`.
+ *
+ * @return A new interning table, or NULL if memory could not be allocated.
+ */
+ldoc_intn_t* ldoc_intn_new(void);
+
+/**
+ * @brief Releases an interning table and all of its strings.
+ *
+ * @param intn Interning table.
+ */
+void ldoc_intn_free(ldoc_intn_t* intn);
+
+/**
+ * @brief Interns a string.
+ *
+ * @param intn Interning table.
+ * @param str String, which does not need to be null-terminated.
+ * @param len Length of `str`.
+ * @return The table's null-terminated copy of `str`, which must not be modified, or NULL if memory could not be allocated.
+ */
+char* ldoc_intn_str(ldoc_intn_t* intn, const char* str, size_t len);
+
+/**
+ * @brief Looks up the interned copy of a string without interning it.
+ *
+ * @param intn Interning table.
+ * @param str String, which does not need to be null-terminated.
+ * @param len Length of `str`.
+ * @return The table's copy of `str`, or NULL if `str` was not interned.
+ */
+char* ldoc_intn_get(ldoc_intn_t* intn, const char* str, size_t len);
+
+/**
+ * @brief Returns the number of distinct strings in an interning table.
+ *
+ * @param intn Interning table.
+ * @return Number of strings.
+ */
+size_t ldoc_intn_cnt(ldoc_intn_t* intn);
+
+/**
+ * @brief Builds annotation indices for the nodes of a document.
+ *
+ * An index maps the annotations of a node's descendants and annotated
+ * entities to these, so that `ldoc_find_anno` does not need to scan them.
+ * Indices are only built for nodes with at least `LDOC_NDE_IDX_MIN`
+ * descendants and entities, since scanning fewer is faster. `ldoc_find_anno`
+ * also builds indices on demand for the nodes that it visits.
+ *
+ * Indices are kept up to date by `ldoc_nde_ent_push` and `ldoc_nde_dsc_push`;
+ * other modifications of a node's children drop its index. Annotations must
+ * not change while indexed.
+ *
+ * @param doc Document.
+ * @return True if all indices were built; false if memory could not be allocated.
+ */
+bool ldoc_doc_index(ldoc_doc_t* doc);
+
+/**
+ * @brief Builds the offset index of a document, which `ldoc_find_pos` uses.
+ *
+ * The index holds the text length of each node's own entities in document
+ * order, so that the node at a cursor offset is found in logarithmic time.
+ * Functions that take cursor offsets (`ldoc_find_pos`, `ldoc_lkahead`,
+ * `ldoc_find_kw`, `ldoc_find_mtchs`) only use an index that was built by this
+ * function; otherwise, they traverse the document on every call.
+ *
+ * The index is not kept up to date by the functions that modify nodes:
+ * after the entities of a node were changed, call `ldoc_doc_pos_upd`; after
+ * nodes were added, moved, or removed, call `ldoc_doc_pos_drop`.
+ *
+ * @param doc Document.
+ * @return True if the index was built; false if memory could not be allocated.
+ */
+bool ldoc_doc_pos_index(ldoc_doc_t* doc);
+
+/**
+ * @brief Updates the offset index of a document after the entities of a node changed.
+ *
+ * Takes time proportional to the number of the node's entities plus the
+ * logarithm of the number of nodes. The index is dropped if `nde` is not in
+ * it. Does nothing if the document has no offset index.
+ *
+ * @param doc Document.
+ * @param nde Node whose entities changed.
+ */
+void ldoc_doc_pos_upd(ldoc_doc_t* doc, ldoc_nde_t* nde);
+
+/**
+ * @brief Drops the offset index of a document, for example after nodes were added or removed.
+ *
+ * @param doc Document.
+ */
+void ldoc_doc_pos_drop(ldoc_doc_t* doc);
+
+/**
+ * @brief Creates the frozen form of a document.
+ *
+ * The frozen document does not refer to `doc`, which can be released or
+ * modified afterwards.
+ *
+ * @param doc Document to freeze.
+ * @return A frozen document, or NULL if memory could not be allocated or the document has more than `LDOC_FRZ_NULL - 1` nodes or entities.
+ */
+ldoc_frz_t* ldoc_frz_new(ldoc_doc_t* doc);
+
+/**
+ * @brief Releases a frozen document.
+ *
+ * @param frz Frozen document.
+ */
+void ldoc_frz_free(ldoc_frz_t* frz);
+
+/**
+ * @brief Same as `ldoc_find_anno`, but for frozen documents.
+ *
+ * @param frz Frozen document.
+ * @param pth Path of annotations.
+ * @param plen Number of path elements.
+ * @param nde Set to true if a node was found, or to false if an entity was found.
+ * @return Index of the node or entity that was found, or `LDOC_FRZ_NULL`.
+ */
+uint32_t ldoc_frz_find_anno(ldoc_frz_t* frz, char** pth, size_t plen, bool* nde);
+
+/**
+ * @brief Same as `ldoc_format_json_to`, but for frozen documents.
+ *
+ * The output matches the output for the original document, except that
+ * generated labels of unannotated nodes and entities contain their indices
+ * instead of their addresses.
+ *
+ * @param frz Frozen document.
+ * @param snk Sink that the serialization is appended to.
+ * @return True on success; false if the sink failed.
+ */
+bool ldoc_frz_format_json_to(ldoc_frz_t* frz, ldoc_snk_t* snk);
+
+/**
+ * @brief Same as `ldoc_format_json`, but for frozen documents (see `ldoc_frz_format_json_to`).
+ *
+ * @param frz Frozen document.
+ * @return Serialization of the frozen document (`LDOC_SER_CSTR`), or `LDOC_SER_NULL` on failure.
+ */
+ldoc_ser_t* ldoc_frz_format_json(ldoc_frz_t* frz);
+
+/**
+ * @brief Creates a new node object that belongs to a document.
+ *
+ * Same as `ldoc_nde_new`, except that the node is arena allocated if `doc` is an arena document.
+ *
+ * @param doc Document that the node will be added to.
+ * @param tpe Node type.
+ * @return A new node object with empty entity list and no descendants.
+ */
+ldoc_nde_t* ldoc_doc_nde_new(ldoc_doc_t* doc, ldoc_struct_t tpe);
+
+/**
+ * @brief Creates a new entity object that belongs to a document.
+ *
+ * Same as `ldoc_ent_new`, except that the entity is arena allocated if `doc` is an arena document.
+ *
+ * @param doc Document that the entity will be added to.
+ * @param tpe Entity type.
+ * @return A new entity object with the payload set to NULL.
+ */
+ldoc_ent_t* ldoc_doc_ent_new(ldoc_doc_t* doc, ldoc_content_t tpe);
+
+/**
+ * @brief Copies a string for use as payload within a document.
+ *
+ * The copy is arena allocated if `doc` is an arena document; otherwise, it is
+ * allocated via `strndup`.
+ *
+ * @param doc Document that the string will be used in.
+ * @param str String to copy.
+ * @param len Maximum number of characters to copy.
+ * @return Null-terminated copy of the string.
+ */
+char* ldoc_doc_strndup(ldoc_doc_t* doc, const char* str, size_t len);
+
+/**
+ * @brief Creates a new arena.
+ *
+ * @param inc Size of the first memory block in bytes (0: page size).
+ * @return A new arena, or NULL if memory could not be allocated.
+ */
+ldoc_arna_t* ldoc_arna_new(size_t inc);
+
+/**
+ * @brief Releases an arena and all memory that was allocated from it.
+ *
+ * @param arna Arena to release.
+ */
+void ldoc_arna_free(ldoc_arna_t* arna);
+
+/**
+ * @brief Allocates memory from an arena.
+ *
+ * @param arna Arena to allocate from.
+ * @param sz Number of bytes to allocate.
+ * @return Pointer to `sz` bytes (suitably aligned for any type), or NULL if memory could not be allocated.
+ */
+void* ldoc_arna_alloc(ldoc_arna_t* arna, size_t sz);
+
 /**
  * @brief Creates a new entity object.
  *
@@ -817,6 +1452,50 @@ ldoc_nde_t* ldoc_nde_new(ldoc_struct_t tpe);
  */
 void ldoc_nde_free(ldoc_nde_t* nde);
 
+/**
+ * @brief Returns the annotation string of a node, independent of its representation.
+ *
+ * @param nde Node.
+ * @param len Set to the length of the annotation string (0 if there is no annotation).
+ * @return Annotation string, which is not null-terminated if `nde->rep` is `LDOC_REP_RAW`, or NULL if there is no annotation.
+ */
+const char* ldoc_nde_anno_str(ldoc_nde_t* nde, size_t* len);
+
+/**
+ * @brief Returns the annotation string of an annotated entity (`LDOC_ENT_BR`, `LDOC_ENT_NR`, `LDOC_ENT_OR`), independent of its representation.
+ *
+ * @param ent Entity.
+ * @param len Set to the length of the annotation string (0 if there is no annotation).
+ * @return Annotation string, which is not null-terminated if `ent->rep` is `LDOC_REP_RAW`, or NULL if there is no annotation.
+ */
+const char* ldoc_ent_anno_str(ldoc_ent_t* ent, size_t* len);
+
+/**
+ * @brief Returns the string datum of an entity, independent of its representation.
+ *
+ * For annotated entities, this is the datum of the annotation pair. Booleans
+ * (`LDOC_ENT_BL`, `LDOC_ENT_BR`) and binary numeric datums have no string
+ * form; see `ldoc_ent_dtm_fmt` for the latter.
+ *
+ * @param ent Entity.
+ * @param len Set to the length of the datum (0 for null values and datums without string form).
+ * @return Datum, which is not null-terminated if `ent->rep` is `LDOC_REP_RAW`, or NULL for null values, booleans and binary numeric datums.
+ */
+const char* ldoc_ent_dtm_str(ldoc_ent_t* ent, size_t* len);
+
+/**
+ * @brief Returns the datum of an entity as a string, formatting binary numeric datums.
+ *
+ * Integers are formatted in decimal, floating point numbers with the fewest
+ * digits that read back as the same number.
+ *
+ * @param ent Entity.
+ * @param buf Buffer of at least `LDOC_NUM_LEN` characters that binary numeric datums are formatted into.
+ * @param len Set to the length of the datum (0 for null values and booleans).
+ * @return Datum as `ldoc_ent_dtm_str` returns it (NULL for null values and booleans), or `buf` for binary numeric datums.
+ */
+const char* ldoc_ent_dtm_fmt(ldoc_ent_t* ent, char* buf, size_t* len);
+
 /**
  * @brief Add an entity to the end of a node's entity list.
  *
@@ -945,6 +1624,90 @@ ldoc_ser_t* ldoc_format(ldoc_doc_t* doc, ldoc_vis_nde_ord_t* vis_nde, ldoc_vis_e
  */
 ldoc_ser_t* ldoc_format_json(ldoc_doc_t* doc);
 
+/**
+ * @brief Creates a new sink that collects a serialization in a growable buffer.
+ *
+ * @param max Initial buffer size in bytes; the page size is used if zero.
+ * @return A new, empty sink.
+ */
+ldoc_snk_t* ldoc_snk_new(size_t max);
+
+/**
+ * @brief Creates a new sink that passes a serialization on to a write callback.
+ *
+ * Fragments are buffered and handed to `wrt` in chunks of up to `max` bytes.
+ *
+ * @param wrt Write callback; has to return false if writing failed.
+ * @param ctx Context that is passed on to `wrt`.
+ * @param max Buffer size in bytes; the page size is used if zero.
+ * @return A new sink.
+ */
+ldoc_snk_t* ldoc_snk_new_wrt(bool (*wrt)(void* ctx, const char* str, size_t len), void* ctx, size_t max);
+
+/**
+ * @brief Frees the memory of a sink, including its buffer.
+ *
+ * <strong>Note:</strong> Does not flush the buffer; see `ldoc_snk_flsh`.
+ *
+ * @param snk Sink whose memory is being released.
+ */
+void ldoc_snk_free(ldoc_snk_t* snk);
+
+/**
+ * @brief Appends a string to a sink.
+ *
+ * @param snk Sink to which `str` is appended.
+ * @param str String that is appended (does not need to be null-terminated).
+ * @param len Number of bytes of `str` to append.
+ */
+void ldoc_snk_appnd(ldoc_snk_t* snk, const char* str, size_t len);
+
+/**
+ * @brief Hands the buffered contents of a sink to its write callback.
+ *
+ * Has no effect on sinks without write callback.
+ *
+ * @param snk Sink that is being flushed.
+ * @return False if the sink is in an error state, true otherwise.
+ */
+bool ldoc_snk_flsh(ldoc_snk_t* snk);
+
+/**
+ * @brief Takes the buffered contents of a sink (transfers ownership to the caller).
+ *
+ * The buffer itself is handed over without copying; the sink allocates a new
+ * buffer on the next append.
+ *
+ * @param snk Sink whose buffer is taken.
+ * @return Null-terminated string that has to be released with `free`, or `NULL` on errors.
+ */
+char* ldoc_snk_take(ldoc_snk_t* snk);
+
+/**
+ * @brief Formats (serializes) a document into a sink using a set of node and entity visitors.
+ *
+ * Every fragment that the visitors return is appended to the sink right away, which
+ * makes serialization linear in the size of the output. All visitors have to return
+ * string serializations (`LDOC_SER_CSTR`) or `LDOC_SER_NULL`. Sinks with write callbacks
+ * are flushed before returning.
+ *
+ * @param doc Document that is being serialized.
+ * @param vis_nde Node visitors.
+ * @param vis_ent Entity visitors.
+ * @param snk Sink that receives the serialization.
+ * @return True if the document was serialized completely, false otherwise.
+ */
+bool ldoc_format_to(ldoc_doc_t* doc, ldoc_vis_nde_ord_t* vis_nde, ldoc_vis_ent_t* vis_ent, ldoc_snk_t* snk);
+
+/**
+ * @brief Format a document as an object in JSON into a sink.
+ *
+ * @param doc Document that is being serialized as a JSON object.
+ * @param snk Sink that receives the serialization.
+ * @return True if the document was serialized completely, false otherwise.
+ */
+bool ldoc_format_json_to(ldoc_doc_t* doc, ldoc_snk_t* snk);
+
 /**
  * @brief Find an entity object based on its annotation.
  *
@@ -972,6 +1735,8 @@ ldoc_res_t* ldoc_find_anno_ent(ldoc_nde_t* nde, char* leaf);
  * ldoc_res_free(res);
  * </pre>
  *
+ * Uses existing annotation indices, but does not build any (see `ldoc_doc_index`).
+ *
  * @param nde Node object at which the search starts.
  * @param pth Search path (array of strings).
  * @param plen Length of the search path `pth`.
@@ -990,6 +1755,9 @@ ldoc_res_t* ldoc_find_anno_nde(ldoc_nde_t* nde, char** pth, size_t plen);
  * ldoc_res_free(res);
  * </pre>
  *
+ * Builds annotation indices for wide nodes on the way (see `ldoc_doc_index`),
+ * so that repeated searches take time proportional to the path length.
+ *
  * @param doc Document object that is being searched.
  * @param pth Search path (array of strings).
  * @param plen Length of the search path `pth`.
@@ -997,6 +1765,122 @@ ldoc_res_t* ldoc_find_anno_nde(ldoc_nde_t* nde, char** pth, size_t plen);
  */
 ldoc_res_t* ldoc_find_anno(ldoc_doc_t* doc, char** pth, size_t plen);
 
+/**
+ * @brief Compiles a search path, so that it can be searched for in many documents.
+ *
+ * The query keeps a copy of the path together with the lengths and hashes of
+ * its elements, and caches the interned counterparts of the elements for the
+ * interning table of the last document that it was executed on (see
+ * `ldoc_intn_new`). A query must not be executed on documents of an interning
+ * table that was created after a table it was previously executed with had
+ * been released. Queries are not thread-safe.
+ *
+ * <strong>Example:</strong> Searching for "address" and "name" in many documents.
+ * <pre>
+ * const char* pth[] = { "address", "name" };
+ * ldoc_qry_t* qry = ldoc_qry_new(pth, 2);
+ * // For each document `doc`:
+ * ldoc_res_t* res = ldoc_qry_exec(qry, doc);
+ * // Do something with `res`.
+ * ldoc_res_free(res);
+ * // After all documents:
+ * ldoc_qry_free(qry);
+ * </pre>
+ *
+ * @param pth Search path (array of strings), which is copied.
+ * @param plen Length of the search path `pth`.
+ * @return A new query, or NULL if memory could not be allocated.
+ */
+ldoc_qry_t* ldoc_qry_new(char** pth, size_t plen);
+
+/**
+ * @brief Releases a compiled query.
+ *
+ * @param qry Query.
+ */
+void ldoc_qry_free(ldoc_qry_t* qry);
+
+/**
+ * @brief Same as `ldoc_find_anno`, but for a compiled query.
+ *
+ * @param qry Query.
+ * @param doc Document object that is being searched.
+ * @return Result object with a node or entity that matches the search, or `LDOC_RES_NULL` otherwise.
+ */
+ldoc_res_t* ldoc_qry_exec(ldoc_qry_t* qry, ldoc_doc_t* doc);
+
+/**
+ * @brief Compiles a search path with wildcard segments.
+ *
+ * A "*" segment matches any descendant node, or any entity if it is the last
+ * segment. A "**" segment matches any number of node levels, including none;
+ * a trailing "**" matches all nodes and entities below. Other segments match
+ * annotations as in `ldoc_find_anno`. A node or entity that can be reached in
+ * several ways through more than one "**" segment is matched once per way.
+ *
+ * <strong>Example:</strong> All "name" entities at any depth.
+ * <pre>
+ * const char* pth[] = { "**", "name" };
+ * ldoc_qry_t* qry = ldoc_qry_glob(pth, 2);
+ * </pre>
+ *
+ * @param pth Search path (array of strings), which is copied.
+ * @param plen Length of the search path `pth`.
+ * @return A new query, or NULL if memory could not be allocated.
+ */
+ldoc_qry_t* ldoc_qry_glob(char** pth, size_t plen);
+
+/**
+ * @brief Starts iterating over all matches of a query in a document.
+ *
+ * Matches are returned in document order, with the entities of a node before
+ * its descendants. Iterating allocates nothing per match; memory is only
+ * allocated for paths deeper than `LDOC_QRY_STK` levels. The document must
+ * not be modified, and the query must not be used with documents of another
+ * interning table, until `ldoc_qry_itr_fin` is called.
+ *
+ * <strong>Example:</strong> Iterating over the matches of a query `qry`.
+ * <pre>
+ * ldoc_qry_itr_t itr;
+ * ldoc_res_t* res;
+ * ldoc_qry_itr_init(&itr, qry, doc);
+ * while ((res = ldoc_qry_itr_nxt(&itr)))
+ *     // Do something with `res`.
+ * ldoc_qry_itr_fin(&itr);
+ * </pre>
+ *
+ * @param itr Iterator, which is initialized.
+ * @param qry Query.
+ * @param doc Document object that is being searched.
+ */
+void ldoc_qry_itr_init(ldoc_qry_itr_t* itr, ldoc_qry_t* qry, ldoc_doc_t* doc);
+
+/**
+ * @brief Returns the next match of a query iterator.
+ *
+ * @param itr Iterator.
+ * @return Result that is owned by the iterator and valid until the next call, or `LDOC_RES_NULL` if there are no more matches or memory could not be allocated (in which case `itr->fail` is set).
+ */
+ldoc_res_t* ldoc_qry_itr_nxt(ldoc_qry_itr_t* itr);
+
+/**
+ * @brief Releases the memory of a query iterator.
+ *
+ * @param itr Iterator.
+ */
+void ldoc_qry_itr_fin(ldoc_qry_itr_t* itr);
+
+/**
+ * @brief Collects all matches of a query in a document.
+ *
+ * @param qry Query.
+ * @param doc Document object that is being searched.
+ * @param buf Buffer that receives the first `max` matches.
+ * @param max Capacity of `buf`.
+ * @return Number of matches, which can be greater than `max`, or `SIZE_MAX` if memory could not be allocated.
+ */
+size_t ldoc_qry_all(ldoc_qry_t* qry, ldoc_doc_t* doc, ldoc_res_t* buf, size_t max);
+
 /**
  * @brief Frees a result object.
  *
@@ -1020,7 +1904,8 @@ void ldoc_res_free(ldoc_res_t* res);
  * (if any) that appears in a document. If there are n characters in the document, then
  * position n refers to the end of the text.
  *
- * Note: Will currently perform very slow on extremely long texts. Needs optimization.
+ * Uses the document's offset index if one was built (see `ldoc_doc_pos_index`),
+ * and traverses the document otherwise.
  */
 ldoc_pos_t* ldoc_find_pos(ldoc_doc_t* doc, uint64_t off);
 
@@ -1035,10 +1920,45 @@ ldoc_pos_t* ldoc_find_pos(ldoc_doc_t* doc, uint64_t off);
  * (if any) that appears in a document. If there are n characters in the document, then
  * position n refers to the end of the text.
  *
- * Note: Will currently perform very slow on extremely long texts. Needs optimization.
+ * Matches can span entities and nodes; the returned position's offset is where
+ * the match begins. With an offset index (see `ldoc_doc_pos_index`), searches
+ * that resume at a later cursor position skip the text before it.
  */
 ldoc_pos_t* ldoc_find_kw(ldoc_doc_t* doc, uint64_t off, char* str);
 
+/**
+ * @brief Finds all occurrences of a trie's strings that begin on or after a cursor position.
+ *
+ * The text is scanned once with the trie's Aho-Corasick automaton (see
+ * `ldoc_trie_ac_bld`), so that the time taken does not depend on the number
+ * of strings in the trie. Occurrences can span entities and nodes, and can
+ * overlap each other. Uses the document's offset index if one was built (see
+ * `ldoc_doc_pos_index`).
+ *
+ * @param doc Document that is being searched.
+ * @param off Cursor position (see `ldoc_find_pos`).
+ * @param trie Trie whose strings are searched for.
+ * @return Array of occurrences, or NULL if memory could not be allocated.
+ */
+ldoc_mtch_arr_t* ldoc_find_mtchs(ldoc_doc_t* doc, uint64_t off, ldoc_trie_t* trie);
+
+/**
+ * @brief Releases an array of trie-string occurrences.
+ *
+ * @param arr Array whose memory is being released.
+ */
+void ldoc_mtch_arr_free(ldoc_mtch_arr_t* arr);
+
+/**
+ * @brief Returns the text that follows a cursor position.
+ *
+ * @param doc Document.
+ * @param off Cursor position (see `ldoc_find_pos`).
+ * @param ln Maximum number of characters.
+ * @return Serialization object with up to `ln` characters of text, or `LDOC_SER_NULL` if memory could not be allocated.
+ */
+ldoc_ser_t* ldoc_lkahead(ldoc_doc_t* doc, uint64_t off, uint16_t ln);
+
 //
 // HTML
 //
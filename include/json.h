@@ -64,9 +64,140 @@ typedef enum
     /**
      * Invalid JSON object.
      */
-    LDOC_JSON_INV
+    LDOC_JSON_INV,
+    /**
+     * Incomplete JSON object; more input is needed (push parsers only).
+     */
+    LDOC_JSON_MORE,
+    /**
+     * Parsing was stopped by an event callback (see `ldoc_json_sax_t`).
+     */
+    LDOC_JSON_STOP,
+    /**
+     * Memory could not be allocated; the parser cannot continue (push parsers only).
+     */
+    LDOC_JSON_MEM
 } ldoc_json_prs_err_t;
 
+/**
+ * @brief Callbacks for parsing events (SAX-style parsing without creating documents).
+ *
+ * Callbacks receive the user data passed to `ldoc_json_read_sax`. Strings are
+ * raw slices of the input, including escape sequences (see `ldoc_json_unesc`);
+ * numbers are passed as they appear in the input. A callback returns false to
+ * stop parsing; callbacks that are NULL are skipped.
+ */
+typedef struct ldoc_json_sax_t
+{
+    /**
+     * Beginning of an object, including the outermost object.
+     */
+    bool (*obj_bgn)(void* usr);
+    /**
+     * End of an object.
+     */
+    bool (*obj_end)(void* usr);
+    /**
+     * Beginning of an array.
+     */
+    bool (*arr_bgn)(void* usr);
+    /**
+     * End of an array.
+     */
+    bool (*arr_end)(void* usr);
+    /**
+     * Key of an object member; followed by the events of its value.
+     */
+    bool (*ky)(void* usr, const char* str, size_t len);
+    /**
+     * String value.
+     */
+    bool (*str)(void* usr, const char* str, size_t len);
+    /**
+     * Number value.
+     */
+    bool (*num)(void* usr, const char* str, size_t len);
+    /**
+     * Boolean value ("true" or "false").
+     */
+    bool (*bl)(void* usr, bool bl);
+    /**
+     * "null" value.
+     */
+    bool (*nll)(void* usr);
+} ldoc_json_sax_t;
+
+/**
+ * @brief Scanning kernels of the JSON reader.
+ *
+ * Kernels skip whitespace and scan string contents for quotes and backslashes
+ * several bytes at a time.
+ */
+typedef enum
+{
+    /**
+     * Best kernel that is supported by the CPU (runtime dispatch); the default.
+     */
+    LDOC_JSON_KRNL_AUTO = 0,
+    /**
+     * Portable scalar kernel (byte by byte).
+     */
+    LDOC_JSON_KRNL_SCL,
+    /**
+     * SSE2 kernel, 16 bytes at a time (x86 only).
+     */
+    LDOC_JSON_KRNL_SSE2,
+    /**
+     * AVX2 kernel, 32 bytes at a time (x86 only).
+     */
+    LDOC_JSON_KRNL_AVX2,
+    /**
+     * NEON kernel, 16 bytes at a time (ARM only).
+     */
+    LDOC_JSON_KRNL_NEON
+} ldoc_json_krnl_t;
+
+/**
+ * @brief Selects the scanning kernel used by all JSON readers.
+ *
+ * Not needed for regular use, since the best kernel is picked on first use;
+ * intended for testing and benchmarking. Must not be called while documents
+ * are being read.
+ *
+ * @param krnl Kernel to use.
+ * @return True if the kernel is available in this build and supported by the CPU; the kernel in use is left unchanged otherwise.
+ */
+bool ldoc_json_krnl(ldoc_json_krnl_t krnl);
+
+/**
+ * @brief Parser backends of the JSON reader.
+ */
+typedef enum
+{
+    /**
+     * Recursive descent over the input bytes; the default.
+     */
+    LDOC_JSON_PRSR_RD = 0,
+    /**
+     * Two stages: an index of structural characters is built first, using the
+     * scanning kernel's block classifier, which is then walked to create the
+     * document. Brackets are matched before any allocation takes place.
+     */
+    LDOC_JSON_PRSR_IDX
+} ldoc_json_prsr_t;
+
+/**
+ * @brief Selects the parser backend used by all JSON readers.
+ *
+ * Both backends create identical documents. The structural index rejects
+ * malformed nesting without allocating anything, but building the document
+ * dominates the parsing time of well-formed input, so that neither backend is
+ * generally faster. Must not be called while documents are being read.
+ *
+ * @param prsr Parser backend to use.
+ */
+void ldoc_json_prsr(ldoc_json_prsr_t prsr);
+
 /**
  * @brief Converts a single JSON object in string form to a document.
  *
@@ -89,6 +220,287 @@ ldoc_doc_t* ldoc_json_read(char* json, size_t len, off_t* err);
  * @return A document object representing the JSON object provided as string `json`, or `LDOC_DOC_NULL` if a parsing error was encountered.
  */
 ldoc_doc_t* ldoc_ldjson_read(char* ldj, size_t len, off_t* err, off_t* nxt);
+
+/**
+ * @brief Converts all JSON objects of a line-delimited JSON (LDJSON) string to documents in parallel.
+ *
+ * The string is split into chunks at newlines, which are parsed by a pool of
+ * threads. Each object has to be on a line of its own; it cannot span several
+ * lines, as `ldoc_ldjson_read` would permit. Blank lines are skipped.
+ *
+ * @param ldj JSON objects as a string.
+ * @param len Length of the string `ldj`.
+ * @param thrds Number of threads to use, including the calling thread; 0 for one thread per online CPU.
+ * @param cnt `*cnt` is set to the number of documents returned.
+ * @param err If a parsing error is encountered and the pointer `err` is not `NULL`, then `*err` is set to the character offset of the first parsing error.
+ * @return Documents in input order (see `ldoc_ldjson_batch_free`), or NULL if a parsing error was encountered; no documents are returned in that case.
+ */
+ldoc_doc_t** ldoc_ldjson_read_batch(char* ldj, size_t len, size_t thrds, size_t* cnt, off_t* err);
+
+/**
+ * @brief Frees the documents returned by `ldoc_ldjson_read_batch` as well as the array itself.
+ *
+ * @param docs Documents.
+ * @param cnt Number of documents.
+ */
+void ldoc_ldjson_batch_free(ldoc_doc_t** docs, size_t cnt);
+
+/**
+ * @brief Converts a JSON file to a document.
+ *
+ * The file is memory mapped and parsed in place, rather than read into a buffer first.
+ *
+ * @param pth Path of the file.
+ * @param err If a parsing error is encountered and the pointer `err` is not `NULL`, then `*err` is set to the character offset at which the parsing error was occurred.
+ * @return A document object representing the JSON object in the file, or `LDOC_DOC_NULL` if the file could not be mapped or a parsing error was encountered.
+ */
+ldoc_doc_t* ldoc_json_read_file(const char* pth, off_t* err);
+
+/**
+ * @brief LDJSON file that is read one record at a time.
+ */
+typedef struct ldoc_ldjson_file_t ldoc_ldjson_file_t;
+
+/**
+ * @brief Opens an LDJSON file for reading.
+ *
+ * The file is memory mapped; pages of records that have been read are
+ * released as reading progresses, so that files larger than the main memory
+ * can be processed.
+ *
+ * @param pth Path of the file.
+ * @return An LDJSON file handle (see `ldoc_ldjson_file_close`), or NULL if the file could not be opened or mapped.
+ */
+ldoc_ldjson_file_t* ldoc_ldjson_file_open(const char* pth);
+
+/**
+ * @brief Closes an LDJSON file; documents that were read from it remain valid.
+ *
+ * @param file LDJSON file handle.
+ */
+void ldoc_ldjson_file_close(ldoc_ldjson_file_t* file);
+
+/**
+ * @brief Determines whether all records of an LDJSON file have been read.
+ *
+ * @param file LDJSON file handle.
+ * @return True if nothing but whitespace is left.
+ */
+bool ldoc_ldjson_file_eof(ldoc_ldjson_file_t* file);
+
+/**
+ * @brief Converts the next JSON object of an LDJSON file to a document.
+ *
+ * @param file LDJSON file handle.
+ * @param err If a parsing error is encountered and the pointer `err` is not `NULL`, then `*err` is set to the character offset at which the parsing error was occurred.
+ * @return A document object representing the next JSON object, or `LDOC_DOC_NULL` at the end of the file (see `ldoc_ldjson_file_eof`) or if a parsing error was encountered; in the latter case, the rest of the line is skipped and the next call continues with the following record.
+ */
+ldoc_doc_t* ldoc_ldjson_file_read(ldoc_ldjson_file_t* file, off_t* err);
+
+/**
+ * @brief Push parser for LDJSON streams.
+ */
+typedef struct ldoc_ldjson_psh_t ldoc_ldjson_psh_t;
+
+/**
+ * @brief Creates a push parser, which turns LDJSON data that arrives in arbitrary chunks (pipes, sockets) into documents.
+ *
+ * @return A push parser (see `ldoc_ldjson_psh_free`), or NULL if memory could not be allocated.
+ */
+ldoc_ldjson_psh_t* ldoc_ldjson_psh_new(void);
+
+/**
+ * @brief Frees a push parser; documents returned by it remain valid.
+ *
+ * @param psh Push parser.
+ */
+void ldoc_ldjson_psh_free(ldoc_ldjson_psh_t* psh);
+
+/**
+ * @brief Appends a chunk of LDJSON data to the input of a push parser.
+ *
+ * Chunks may end anywhere, including within records and escape sequences.
+ *
+ * @param psh Push parser.
+ * @param chnk LDJSON data; copied.
+ * @param len Length of `chnk`.
+ * @return False if memory could not be allocated.
+ */
+bool ldoc_ldjson_psh_feed(ldoc_ldjson_psh_t* psh, const char* chnk, size_t len);
+
+/**
+ * @brief Converts the next complete JSON object that was fed to a push parser to a document.
+ *
+ * Call repeatedly until `LDOC_JSON_MORE` is returned, then feed more data.
+ * After an invalid object the parser resumes with the next object; input
+ * between objects other than whitespace is reported as invalid and skipped
+ * up to the end of its line. If memory cannot be allocated, then the parser
+ * fails for good and keeps returning `LDOC_JSON_MEM`.
+ *
+ * @param psh Push parser.
+ * @param doc `*doc` is set to the document, or to `LDOC_DOC_NULL` unless `LDOC_JSON_OK` is returned.
+ * @param err If a parsing error is encountered and the pointer `err` is not `NULL`, then `*err` is set to the offset of the error within the whole stream fed so far.
+ * @return `LDOC_JSON_OK` if a document was created, `LDOC_JSON_MORE` if no complete object is left, `LDOC_JSON_INV`, or `LDOC_JSON_MEM`.
+ */
+ldoc_json_prs_err_t ldoc_ldjson_psh_read(ldoc_ldjson_psh_t* psh, ldoc_doc_t** doc, off_t* err);
+
+/**
+ * @brief Number of bytes of an incomplete object that a push parser holds; at the end of a stream, a truncated last record.
+ *
+ * @param psh Push parser.
+ * @return Number of bytes of the incomplete object, or 0.
+ */
+size_t ldoc_ldjson_psh_pndg(ldoc_ldjson_psh_t* psh);
+
+/**
+ * @brief Parses a JSON object in string form and reports its contents through callbacks instead of creating a document.
+ *
+ * The document creating readers are consumers of the same events.
+ *
+ * @param sax Event callbacks.
+ * @param usr User data that is passed to the callbacks.
+ * @param json JSON object as a string.
+ * @param len Length of the string `json`.
+ * @param err If parsing fails or is stopped and the pointer `err` is not `NULL`, then `*err` is set to the character offset at which parsing ended.
+ * @param nxt If not NULL, then parsing starts at offset `*nxt` and `*nxt` will be set to the character offset at which the next JSON object (purportedly) begins.
+ * @return `LDOC_JSON_OK`, `LDOC_JSON_INV` on parsing errors, or `LDOC_JSON_STOP` if a callback stopped parsing.
+ */
+ldoc_json_prs_err_t ldoc_json_read_sax(const ldoc_json_sax_t* sax, void* usr, char* json, size_t len, off_t* err, off_t* nxt);
+
+/**
+ * @brief Converts a JSON object in string form into the root node of an existing document.
+ *
+ * In conjunction with `ldoc_doc_new_arena`, this function parses a JSON object
+ * into a document whose nodes, entities and strings are allocated in bulk.
+ *
+ * @param doc Empty document (see `ldoc_doc_new` and `ldoc_doc_new_arena`).
+ * @param json JSON object as a string.
+ * @param len Length of the string `json`.
+ * @param err If a parsing error is encountered and the pointer `err` is not `NULL`, then `*err` is set to the character offset at which the parsing error was occurred.
+ * @param nxt If not NULL, then parsing starts at offset `*nxt` and `*nxt` will be set to the character offset at which the next JSON object (purportedly) begins.
+ * @return True if the JSON object was parsed successfully; `doc` may be partially populated otherwise.
+ */
+bool ldoc_json_read_into(ldoc_doc_t* doc, char* json, size_t len, off_t* err, off_t* nxt);
+
+/**
+ * @brief Converts the parts of a single JSON object in string form that are on given annotation paths to a document.
+ *
+ * Paths have the form used by `ldoc_find_anno`: a sequence of keys, where
+ * array elements that are objects or arrays are matched by "NA". Values on a
+ * path are converted completely, their ancestors on the path are created
+ * as nodes, and everything else is skipped without creating nodes or entities.
+ * Skipped values are only checked for terminated strings and balanced
+ * brackets. Always uses the recursive descent parser.
+ *
+ * <strong>Example:</strong> Only keeping the values of "id" and "address/name".
+ * <pre>
+ * char* id[] = { "id" };
+ * char* name[] = { "address", "name" };
+ * char** pths[] = { id, name };
+ * size_t plens[] = { 1, 2 };
+ * ldoc_doc_t* doc = ldoc_json_read_pths(json, len, pths, plens, 2, &err);
+ * </pre>
+ *
+ * @param json JSON object as a string.
+ * @param len Length of the string `json`.
+ * @param pths Annotation paths; at most 64.
+ * @param plens Lengths of the paths in `pths`.
+ * @param pcnt Number of paths.
+ * @param err If a parsing error is encountered and the pointer `err` is not `NULL`, then `*err` is set to the character offset at which the parsing error was occurred.
+ * @return A document object with the values on the paths, or `LDOC_DOC_NULL` if a parsing error was encountered or there are too many paths.
+ */
+ldoc_doc_t* ldoc_json_read_pths(char* json, size_t len, char*** pths, size_t* plens, size_t pcnt, off_t* err);
+
+/**
+ * @brief Converts the parts of a JSON object -- one of many -- that are on given annotation paths to a document.
+ *
+ * The LDJSON counterpart of `ldoc_json_read_pths`.
+ *
+ * @param ldj JSON objects as a string.
+ * @param len Length of the string `ldj`.
+ * @param pths Annotation paths; at most 64.
+ * @param plens Lengths of the paths in `pths`.
+ * @param pcnt Number of paths.
+ * @param err If a parsing error is encountered and the pointer `err` is not `NULL`, then `*err` is set to the character offset at which the parsing error was occurred.
+ * @param nxt `*nxt` is the offset at which parsing starts; it will be set to the character offset at which the next JSON object (purportedly) begins.
+ * @return A document object with the values on the paths, or `LDOC_DOC_NULL` if a parsing error was encountered or no object is left.
+ */
+ldoc_doc_t* ldoc_ldjson_read_pths(char* ldj, size_t len, char*** pths, size_t* plens, size_t pcnt, off_t* err, off_t* nxt);
+
+/**
+ * @brief Converts a single JSON object in string form to a document whose keys are interned.
+ *
+ * Keys (and the "NA" labels of array elements) are interned in `intn`, so that
+ * documents that are read with the same table share a single copy of each key,
+ * and `ldoc_find_anno` compares keys by pointer (see `ldoc_intn_new`). Other
+ * strings, nodes and entities are arena allocated (see `ldoc_doc_new_arena`).
+ *
+ * <strong>Note:</strong> `intn` has to outlive the returned document.
+ *
+ * @param json JSON object as a string.
+ * @param len Length of the string `json`.
+ * @param intn Interning table for keys.
+ * @param err If a parsing error is encountered and the pointer `err` is not `NULL`, then `*err` is set to the character offset at which the parsing error was occurred.
+ * @return A document object representing the JSON object provided as string `json`, or `LDOC_DOC_NULL` if a parsing error was encountered.
+ */
+ldoc_doc_t* ldoc_json_read_intn(char* json, size_t len, ldoc_intn_t* intn, off_t* err);
+
+/**
+ * @brief Converts a JSON objects -- one of many -- in string form to a document whose keys are interned.
+ *
+ * The LDJSON counterpart of `ldoc_json_read_intn`.
+ *
+ * @param ldj JSON objects as a string.
+ * @param len Length of the string `ldj`.
+ * @param intn Interning table for keys, which is typically shared by all documents of `ldj`.
+ * @param err If a parsing error is encountered and the pointer `err` is not `NULL`, then `*err` is set to the character offset at which the parsing error was occurred.
+ * @param nxt `*nxt` is the offset at which parsing starts; it will be set to the character offset at which the next JSON object (purportedly) begins.
+ * @return A document object representing the JSON object at offset `*nxt`, or `LDOC_DOC_NULL` if a parsing error was encountered or no object is left.
+ */
+ldoc_doc_t* ldoc_ldjson_read_intn(char* ldj, size_t len, ldoc_intn_t* intn, off_t* err, off_t* nxt);
+
+/**
+ * @brief Converts a single JSON object in string form to a document without copying its strings.
+ *
+ * Keys, strings and numbers are not copied; they are stored as raw data
+ * structures (`ldoc_raw_t`) that point into `json`, and the nodes and entities
+ * are marked as `LDOC_REP_RAW`. Escape sequences are kept verbatim; see
+ * `ldoc_json_unesc`. Nodes and entities are arena allocated (see `ldoc_doc_new_arena`).
+ *
+ * <strong>Note:</strong> `json` has to outlive the returned document.
+ *
+ * @param json JSON object as a string.
+ * @param len Length of the string `json`.
+ * @param err If a parsing error is encountered and the pointer `err` is not `NULL`, then `*err` is set to the character offset at which the parsing error was occurred.
+ * @return A document object representing the JSON object provided as string `json`, or `LDOC_DOC_NULL` if a parsing error was encountered.
+ */
+ldoc_doc_t* ldoc_json_read_view(char* json, size_t len, off_t* err);
+
+/**
+ * @brief Converts a JSON objects -- one of many -- in string form to a document without copying its strings.
+ *
+ * The LDJSON counterpart of `ldoc_json_read_view`.
+ *
+ * @param ldj JSON objects as a string.
+ * @param len Length of the string `ldj`.
+ * @param err If a parsing error is encountered and the pointer `err` is not `NULL`, then `*err` is set to the character offset at which the parsing error was occurred.
+ * @param nxt `*nxt` is the offset at which parsing starts; it will be set to the character offset at which the next JSON object (purportedly) begins.
+ * @return A document object representing the JSON object at offset `*nxt`, or `LDOC_DOC_NULL` if a parsing error was encountered or no object is left.
+ */
+ldoc_doc_t* ldoc_ldjson_read_view(char* ldj, size_t len, off_t* err, off_t* nxt);
+
+/**
+ * @brief Unescapes a JSON string.
+ *
+ * Intended for string payloads of documents read by `ldoc_json_read_view`, which
+ * are unescaped on demand only. Strings without backslashes are just copied.
+ *
+ * @param str JSON string contents (without quotes); not necessarily null-terminated.
+ * @param len Length of `str`.
+ * @param ulen If not NULL, then `*ulen` is set to the length of the unescaped string.
+ * @return A null-terminated unescaped copy of `str` (UTF-8) that has to be released with `free`, or NULL if memory could not be allocated.
+ */
+char* ldoc_json_unesc(const char* str, size_t len, size_t* ulen);
     
 #ifdef __cplusplus
 } /* extern "C" */
@@ -81,6 +81,36 @@ typedef enum
     UTF32
 } ldoc_trie_ptr_t;
 
+/**
+ * @brief Layout of the descendants of `ASCII`, `UTF16` and `UTF32` trie nodes.
+ *
+ * Nodes start out with room for four descendants and grow into the next
+ * layout when that room is used up, which follows the node types of
+ * adaptive radix trees. Lookups scan the characters of the first two
+ * layouts, index the descendants by character in the third, and address
+ * them directly by character in the last.
+ */
+typedef enum
+{
+    /**
+     * Up to 4 descendants, in the order in which they were added.
+     */
+    LYT_N4,
+    /**
+     * Up to 16 descendants, in the order in which they were added.
+     */
+    LYT_N16,
+    /**
+     * Up to 48 descendants, in the order in which they were added, with a
+     * 256-entry index (one byte per character) behind the descendant pointers.
+     */
+    LYT_N48,
+    /**
+     * 256 descendant pointers, one per character; unused ones are NULL.
+     */
+    LYT_N256
+} ldoc_trie_lyt_t;
+
 /**
  * @brief Trie-node type.
  *
@@ -162,19 +192,37 @@ typedef struct ldoc_trie_nde_t
      */
     ldoc_trie_ptr_t tpe;
     /**
-     * Number of elements in the character array (`chr`), if applicable.
+     * Layout of the character array (`chr`) and descendants (`dscs`) for
+     * types `ASCII`, `UTF16` and `UTF32`.
+     */
+    ldoc_trie_lyt_t lyt;
+    /**
+     * Number of elements in the character array (`chr`), if applicable. For
+     * layout `LYT_N256`, this is the length of the `dscs` pointer array.
      */
     uint16_t size;
+    /**
+     * Length of the edge label (`lbl`).
+     */
+    uint16_t llen;
     /**
      * Character array that determines the character of descendant (via `dscs`)
      * nodes.
      *
      * For types `EN_ALPH` and `EN_ALPHNUM` the pointer `c0` is set to NULL and
      * the length of the `dscs` pointer array is determined by the implicitly
-     * represented characters as described by `ldoc_trie_ptr_t`.
+     * represented characters as described by `ldoc_trie_ptr_t`. The same
+     * applies to layout `LYT_N256`, where the characters are the indexes of
+     * the `dscs` pointer array.
      */
     ldoc_trie_char_t chr;
     struct ldoc_trie_nde_t** dscs;
+    /**
+     * Edge label: the characters that follow the node's own character on the
+     * way to it, which is not null-terminated. Only nodes of path-compressed
+     * tries (see `ldoc_trie_new_rdx`) have labels; otherwise it is NULL.
+     */
+    char* lbl;
     /**
      * Node type (root, empty, or annotation).
      */
@@ -190,6 +238,14 @@ typedef struct ldoc_trie_nde_t
  */
 extern ldoc_trie_nde_t* LDOC_TRIE_NDE_NULL;
 
+/**
+ * @brief Empty node for prefixes that end within an edge label.
+ *
+ * Returned by prefix lookups in path-compressed tries, where such prefixes
+ * do not have a node of their own.
+ */
+extern ldoc_trie_nde_t* LDOC_TRIE_NDE_PFX;
+
 /**
  * @brief Trie-node array.
  *
@@ -231,22 +287,145 @@ typedef struct ldoc_trie_t
      * Root node.
      */
     ldoc_trie_nde_t* root;
+    /**
+     * Memory of the trie's nodes, which is released with the trie (opaque).
+     */
+    struct ldoc_trie_slab_t* slab;
+    /**
+     * Whether chains of nodes with a single descendant are merged into one
+     * node with an edge label (see `ldoc_trie_new_rdx`).
+     */
+    bool rdx;
+    /**
+     * Aho-Corasick automaton for matching all strings at once, or NULL (see `ldoc_trie_ac_bld`).
+     */
+    struct ldoc_trie_ac_t* ac;
 } ldoc_trie_t;
 
+/**
+ * @brief Initial state of an Aho-Corasick scan (see `ldoc_trie_scan`).
+ */
+#define LDOC_TRIE_ST_RT 0
+
+/**
+ * @brief State that `ldoc_trie_scan` returns if memory could not be allocated.
+ */
+#define LDOC_TRIE_ST_ERR UINT32_MAX
+
+/**
+ * @brief Slot of a frozen trie's double array.
+ *
+ * The descendant of a slot `s` for character `c` is the slot
+ * `slts[s].base + (uint8_t)c + 1`, provided that its `chck` is `s`.
+ */
+typedef struct ldoc_trie_slt_t
+{
+    /**
+     * Base index of the slot's descendants.
+     */
+    int32_t base;
+    /**
+     * Index of the slot's parent, or `LDOC_TRIE_FRZ_NULL` for unused slots.
+     */
+    uint32_t chck;
+} ldoc_trie_slt_t;
+
+/**
+ * @brief Annotation of a string in a frozen trie.
+ */
+typedef struct ldoc_trie_frz_anno_t
+{
+    /**
+     * Payload offset (see `ldoc_trie_frz_new`).
+     */
+    uint64_t off;
+    /**
+     * Category.
+     */
+    uint16_t cat;
+    /**
+     * Reserved (padding).
+     */
+    uint16_t rsv[3];
+} ldoc_trie_frz_anno_t;
+
+/**
+ * @brief Immutable trie as a double array (see `ldoc_trie_frz_new`).
+ *
+ * All arrays point into a single image, which is laid out exactly as the
+ * file that `ldoc_trie_frz_save` writes, so that `ldoc_trie_frz_load_mmap`
+ * can use a file's mapping as is.
+ */
+typedef struct ldoc_trie_frz_t
+{
+    /**
+     * Number of slots.
+     */
+    uint32_t cnt;
+    /**
+     * Number of annotated strings.
+     */
+    uint32_t anno_cnt;
+    /**
+     * Slots; slot 0 is the root.
+     */
+    const ldoc_trie_slt_t* slts;
+    /**
+     * Index into `annos` for each slot, or `LDOC_TRIE_FRZ_NULL` for slots that do not end a string.
+     */
+    const uint32_t* idxs;
+    /**
+     * Annotations.
+     */
+    const ldoc_trie_frz_anno_t* annos;
+    /**
+     * Image.
+     */
+    void* img;
+    /**
+     * Length of the image in bytes.
+     */
+    size_t img_len;
+    /**
+     * Whether the image is a memory mapped file.
+     */
+    bool map;
+} ldoc_trie_frz_t;
+
+/**
+ * @brief No slot or annotation in a frozen trie.
+ */
+#define LDOC_TRIE_FRZ_NULL UINT32_MAX
+
 #pragma mark - Trie Allocation/Deallocation
 
 /**
  * @brief Creates a new trie object (including trie root node).
  *
- * @return A new trie object.
+ * @return A new trie object, or NULL if memory could not be allocated.
  */
 ldoc_trie_t* ldoc_trie_new();
+
+/**
+ * @brief Creates a new path-compressed (radix) trie object.
+ *
+ * Strings that are added to a path-compressed trie only create a node where
+ * they branch off from other strings; the remaining characters are kept in
+ * the node's edge label (`lbl`). Nodes are split when a string branches off
+ * within a label. Lookups, removals, collection and scans behave the same as
+ * for other tries, except that prefix lookups return `LDOC_TRIE_NDE_PFX` for
+ * prefixes that end within a label.
+ *
+ * @return A new path-compressed trie object, or NULL if memory could not be allocated.
+ */
+ldoc_trie_t* ldoc_trie_new_rdx();
     
 /**
  * @brief Frees the memory of a trie object.
  *
  * Releases the memory of the trie object, including all nodes, but it does
- * not release the memory of annotations.
+ * not release the memory of annotations. Nodes are allocated in blocks, so
+ * this takes time in proportion to the number of blocks rather than nodes.
  *
  * @param trie Trie whose memory is being released.
  */
@@ -292,8 +471,9 @@ void ldoc_trie_nde_arr_appnd(ldoc_trie_nde_arr_t* arr, ldoc_trie_nde_t* nde);
  * @param str String that is being added to the trie object `trie`.
  * @param tpe If nodes need to be allocated to store `str` in `trie`, then they will be of type `tpe`.
  * @param anno Annotation that is being stored along with the string `str`.
+ * @return True if the string was added; false if memory could not be allocated, in which case `str` is not in the trie (prefixes of it may be).
  */
-void ldoc_trie_add(ldoc_trie_t* trie, const char* str, ldoc_trie_ptr_t tpe, ldoc_trie_anno_t anno);
+bool ldoc_trie_add(ldoc_trie_t* trie, const char* str, ldoc_trie_ptr_t tpe, ldoc_trie_anno_t anno);
 
 /**
  * @brief Remove a string (prefix) from a trie.
@@ -311,11 +491,101 @@ ldoc_trie_nde_t* ldoc_trie_remove(ldoc_trie_t* trie, const char* str);
  *
  * @param trie Trie object to search for the presence of `string`.
  * @param string String to search for in trie `trie`.
- * @param prefixes When true, then return the node in `trie` at which the search for `string` ended. This indicates whether `string` is a prefix of another string in `trie`, but `string` itself was not added to `trie`.
+ * @param prefixes When true, then return the node in `trie` at which the search for `string` ended. This indicates whether `string` is a prefix of another string in `trie`, but `string` itself was not added to `trie`. In path-compressed tries, this can be `LDOC_TRIE_NDE_PFX`.
  * @return Trie node that matches `string` (see also `prefixes` description), or `LDOC_TRIE_NDE_NULL` otherwise.
  */
 ldoc_trie_nde_t* ldoc_trie_lookup(ldoc_trie_t* trie, const char* string, bool prefixes);
     
+#pragma mark - Multi-Pattern Matching
+
+/**
+ * @brief Builds the Aho-Corasick automaton of a trie.
+ *
+ * The automaton adds failure links to the trie's strings, so that
+ * `ldoc_trie_scan` finds all occurrences of all strings in a text in a single
+ * pass. It is built on demand by `ldoc_trie_scan`, and dropped when strings
+ * are added to or removed from the trie.
+ *
+ * @param trie Trie.
+ * @return True if the automaton was built; false if memory could not be allocated.
+ */
+bool ldoc_trie_ac_bld(ldoc_trie_t* trie);
+
+/**
+ * @brief Finds all occurrences of a trie's strings in a text.
+ *
+ * A text can be scanned in pieces: the state that is returned for one piece
+ * is passed on with the next, so that occurrences can span pieces.
+ *
+ * @param trie Trie.
+ * @param st State after the preceding text, or `LDOC_TRIE_ST_RT` at the beginning of a text.
+ * @param txt Text, which does not need to be null-terminated.
+ * @param len Length of `txt`.
+ * @param hit Called for each occurrence with `ctx`, the offset in `txt` after the occurrence's last character, the trie node of the string, and the string's length.
+ * @param ctx Context for `hit`.
+ * @return State after `txt`, or `LDOC_TRIE_ST_ERR` if the automaton could not be built (see `ldoc_trie_ac_bld`), in which case `hit` was not called.
+ */
+uint32_t ldoc_trie_scan(ldoc_trie_t* trie, uint32_t st, const char* txt, size_t len, void (*hit)(void* ctx, size_t end, ldoc_trie_nde_t* nde, uint16_t len), void* ctx);
+    
+#pragma mark - Frozen Tries
+
+/**
+ * @brief Freezes a trie into a double array.
+ *
+ * Frozen tries only support lookups, but they consist of a single image
+ * without pointers, which can be saved (see `ldoc_trie_frz_save`) and mapped
+ * by any number of processes (see `ldoc_trie_frz_load_mmap`). Payload
+ * pointers cannot be stored, so each annotated string gets a payload offset
+ * instead.
+ *
+ * @param trie Trie to freeze (plain or path-compressed).
+ * @param off Returns the payload offset for the payload `pld` of a string, given `ctx`; if NULL, then the payload pointer itself is stored as an integer.
+ * @param ctx Context for `off`.
+ * @return Frozen trie, or NULL if memory could not be allocated or the trie has too many nodes.
+ */
+ldoc_trie_frz_t* ldoc_trie_frz_new(ldoc_trie_t* trie, uint64_t (*off)(void* pld, void* ctx), void* ctx);
+
+/**
+ * @brief Releases a frozen trie, including its image or mapping.
+ *
+ * @param frz Frozen trie.
+ */
+void ldoc_trie_frz_free(ldoc_trie_frz_t* frz);
+
+/**
+ * @brief Saves a frozen trie.
+ *
+ * Numbers are stored in host byte order, so files are only portable between
+ * hosts of the same byte order.
+ *
+ * @param frz Frozen trie.
+ * @param pth Path of the file to write.
+ * @return True if the file was written; false otherwise.
+ */
+bool ldoc_trie_frz_save(ldoc_trie_frz_t* frz, const char* pth);
+
+/**
+ * @brief Loads a frozen trie that was saved via `ldoc_trie_frz_save` by memory mapping it.
+ *
+ * The mapping is shared and read-only, so that processes that load the same
+ * file share its memory. It is released by `ldoc_trie_frz_free`.
+ *
+ * @param pth Path of the file to load.
+ * @return Frozen trie, or NULL if the file could not be mapped or is not a valid frozen trie.
+ */
+ldoc_trie_frz_t* ldoc_trie_frz_load_mmap(const char* pth);
+
+/**
+ * @brief Looks up a string in a frozen trie.
+ *
+ * @param frz Frozen trie.
+ * @param string String to search for.
+ * @param prefixes When true, then strings that are only prefixes of strings in the trie are found as well (see `ldoc_trie_lookup`); their annotation has category 0 and payload offset `UINT64_MAX`.
+ * @param anno Set to the string's annotation if it is found (may be NULL).
+ * @return True if `string` was found.
+ */
+bool ldoc_trie_frz_lookup(ldoc_trie_frz_t* frz, const char* string, bool prefixes, ldoc_trie_frz_anno_t* anno);
+
 #pragma mark - Summarization
     
 /**
@@ -323,7 +593,7 @@ ldoc_trie_nde_t* ldoc_trie_lookup(ldoc_trie_t* trie, const char* string, bool pr
  *
  * @param trie Trie whose strings should be listed.
  * @param sep Separator to use between strings in the list.
- * @return List of all strings in `trie` separated by `sep`.
+ * @return List of all strings in `trie` separated by `sep`, or NULL if the trie is empty or memory could not be allocated.
  */
 char* ldoc_trie_collect(ldoc_trie_t* trie, const char* sep);
 
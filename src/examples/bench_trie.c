@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2021 Joachim Baran
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at: http://mozilla.org/MPL/2.0/
+ */
+
+#include <time.h>
+
+#include <trie.h>
+
+/*
+ * Micro-benchmarks for trie additions, lookups, collection and deallocation.
+ *
+ * Usage: libdocument-bench-trie [number of strings] [length of long strings]
+ *
+ * Runs each operation on short (4-11 characters) and long strings, in both
+ * plain and path-compressed tries, and reports the time taken in ms.
+ */
+
+static double bench_ms(struct timespec* t0)
+{
+    struct timespec t1;
+    
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    
+    double ms = (t1.tv_sec - t0->tv_sec) * 1e3 + (t1.tv_nsec - t0->tv_nsec) / 1e6;
+    
+    *t0 = t1;
+    
+    return ms;
+}
+
+static char** bench_strs(size_t cnt, size_t min, size_t max)
+{
+    char** strs = (char**)malloc(cnt * sizeof(char*));
+    
+    if (!strs)
+        exit(1);
+    
+    size_t i = 0;
+    for (; i < cnt; i++)
+    {
+        size_t len = min + (size_t)rand() % (max - min + 1);
+        
+        strs[i] = (char*)malloc(len + 1);
+        
+        if (!strs[i])
+            exit(1);
+        
+        size_t j = 0;
+        for (; j < len; j++)
+            strs[i][j] = "abcdefghijklmnopqrstuvwxyz"[rand() % 26];
+        
+        strs[i][len] = 0;
+    }
+    
+    return strs;
+}
+
+static void bench_run(const char* nme, bool rdx, char** strs, size_t cnt)
+{
+    struct timespec t0;
+    size_t fnd = 0;
+    ldoc_trie_anno_t anno = { 1, NULL };
+    
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    
+    ldoc_trie_t* trie = rdx ? ldoc_trie_new_rdx() : ldoc_trie_new();
+    
+    size_t i = 0;
+    for (; i < cnt; i++)
+        ldoc_trie_add(trie, strs[i], ASCII, anno);
+    
+    double add = bench_ms(&t0);
+    
+    for (i = 0; i < cnt; i++)
+        fnd += ldoc_trie_lookup(trie, strs[i], false) != NULL;
+    
+    double lkp = bench_ms(&t0);
+    
+    char* str = ldoc_trie_collect(trie, ",");
+    
+    double cll = bench_ms(&t0);
+    
+    ldoc_trie_free(trie);
+    
+    double fre = bench_ms(&t0);
+    
+    printf("%-12s %-6s add %9.1f  lookup %9.1f  collect %9.1f  free %9.1f  (%zu found)\n", nme, rdx ? "radix" : "plain", add, lkp, cll, fre, fnd);
+    
+    free(str);
+}
+
+int main(int argc, char** argv)
+{
+    size_t cnt = argc > 1 ? (size_t)atol(argv[1]) : 500000;
+    size_t llen = argc > 2 ? (size_t)atol(argv[2]) : 100000;
+    
+    srand(1);
+    
+    char** shrt = bench_strs(cnt, 4, 11);
+    char** lng = bench_strs(16, llen, llen);
+    
+    bench_run("short", false, shrt, cnt);
+    bench_run("short", true, shrt, cnt);
+    bench_run("long", false, lng, 16);
+    bench_run("long", true, lng, 16);
+    
+    return 0;
+}
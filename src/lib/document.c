@@ -9,6 +9,11 @@
 
 #include "document.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #pragma mark - Null Constants for Structs
 
 ldoc_doc_t* LDOC_DOC_NULL = NULL;
@@ -73,8 +78,8 @@ static const char* ldoc_cnst_json_lcls = "]";
 #pragma mark - Declarations Outside of Header
 
 #ifndef LDOC_NOPYTHON
-static ldoc_nde_t* ldoc_pydict2doc_dict(PyObject* lbl, PyObject* dict);
-static ldoc_nde_t* ldoc_pydict2doc_lst(PyObject* lbl, PyObject* dict);
+static ldoc_nde_t* ldoc_pydict2doc_dict(ldoc_doc_t* doc, PyObject* lbl, PyObject* dict);
+static ldoc_nde_t* ldoc_pydict2doc_lst(ldoc_doc_t* doc, PyObject* lbl, PyObject* dict);
 #endif // #ifndef LDOC_NOPYTHON
 
 ldoc_res_t* ldoc_find_anno_nde(ldoc_nde_t* nde, char** pth, size_t plen);
@@ -93,27 +98,65 @@ char* ldoc_py2str(PyObject* obj)
     return s;
 }
 
-inline static ldoc_ent_t* ldoc_pydict2doc_str(PyObject* str)
+static inline char* ldoc_pydict2doc_strdup(ldoc_doc_t* doc, PyObject* str)
+{
+    Py_ssize_t len;
+    const char* s = PyUnicode_AsUTF8AndSize(str, &len);
+    
+    return ldoc_doc_strndup(doc, s, len);
+}
+
+inline static ldoc_ent_t* ldoc_pydict2doc_str(ldoc_doc_t* doc, PyObject* str)
 {
-    ldoc_ent_t* ent = ldoc_ent_new(LDOC_ENT_TXT);
+    ldoc_ent_t* ent = ldoc_doc_ent_new(doc, LDOC_ENT_TXT);
     
-    ent->pld.str = strdup(PyUnicode_AsUTF8(str));
+    ent->pld.str = ldoc_pydict2doc_strdup(doc, str);
     
     return ent;
 }
 
-inline static ldoc_ent_t* ldoc_pydict2doc_num(PyObject* str)
+// Binary representation of Python integers and floats; integers beyond 64 bits
+// are kept as strings:
+inline static void ldoc_pydict2doc_num_pld(ldoc_doc_t* doc, ldoc_ent_t* ent, ldoc_anno_pld_t* pld, PyObject* num)
+{
+    int ovf = 0;
+    
+    if (PyFloat_CheckExact(num))
+    {
+        pld->f64 = PyFloat_AsDouble(num);
+        ent->rep |= LDOC_REP_F64;
+        
+        return;
+    }
+    
+    long long i64 = PyLong_AsLongLongAndOverflow(num, &ovf);
+    
+    if (!ovf)
+    {
+        pld->i64 = i64;
+        ent->rep |= LDOC_REP_I64;
+        
+        return;
+    }
+    
+    PyObject* tmp = PyObject_Str(num);
+    pld->str = ldoc_pydict2doc_strdup(doc, tmp);
+    Py_DECREF(tmp);
+}
+
+inline static ldoc_ent_t* ldoc_pydict2doc_num(ldoc_doc_t* doc, PyObject* str)
 {
-    ldoc_ent_t* ent = ldoc_ent_new(LDOC_ENT_NUM);
+    ldoc_ent_t* ent = ldoc_doc_ent_new(doc, LDOC_ENT_NUM);
     
-    ent->pld.str = strdup(PyUnicode_AsUTF8(PyObject_Str(str)));
+    // Same layout as `ldoc_anno_pld_t` for numbers and strings:
+    ldoc_pydict2doc_num_pld(doc, ent, (ldoc_anno_pld_t*)&(ent->pld), str);
     
     return ent;
 }
 
-inline static ldoc_ent_t* ldoc_pydict2doc_bl(PyObject* str)
+inline static ldoc_ent_t* ldoc_pydict2doc_bl(ldoc_doc_t* doc, PyObject* str)
 {
-    ldoc_ent_t* ent = ldoc_ent_new(LDOC_ENT_BL);
+    ldoc_ent_t* ent = ldoc_doc_ent_new(doc, LDOC_ENT_BL);
     
     if (str == Py_True)
         ent->pld.bl = true;
@@ -123,17 +166,16 @@ inline static ldoc_ent_t* ldoc_pydict2doc_bl(PyObject* str)
     return ent;
 }
 
-inline static ldoc_ent_t* ldoc_pydict2doc_anno(PyObject* lbl, ldoc_content_t tpe, PyObject* obj)
+inline static ldoc_ent_t* ldoc_pydict2doc_anno(ldoc_doc_t* doc, PyObject* lbl, ldoc_content_t tpe, PyObject* obj)
 {
-    ldoc_ent_t* ent = ldoc_ent_new(tpe);
+    ldoc_ent_t* ent = ldoc_doc_ent_new(doc, tpe);
     
     if (lbl)
     {
-        char* clbl = strdup(PyUnicode_AsUTF8(lbl));
+        char* clbl = ldoc_pydict2doc_strdup(doc, lbl);
         ent->pld.pair.anno.str = clbl;
     }
     
-    PyObject* tmp;
     switch (tpe)
     {
         case LDOC_ENT_BR:
@@ -143,12 +185,10 @@ inline static ldoc_ent_t* ldoc_pydict2doc_anno(PyObject* lbl, ldoc_content_t tpe
                 ent->pld.pair.dtm.bl = false;
             break;
         case LDOC_ENT_NR:
-            tmp = PyObject_Str(obj);
-            ent->pld.pair.dtm.str = strdup(PyUnicode_AsUTF8(tmp));
-            Py_DECREF(tmp);
+            ldoc_pydict2doc_num_pld(doc, ent, &(ent->pld.pair.dtm), obj);
             break;
         case LDOC_ENT_OR:
-            ent->pld.pair.dtm.str = strdup(PyUnicode_AsUTF8(obj));
+            ent->pld.pair.dtm.str = ldoc_pydict2doc_strdup(doc, obj);
             break;
         default:
             // TODO Internal error.
@@ -159,13 +199,13 @@ inline static ldoc_ent_t* ldoc_pydict2doc_anno(PyObject* lbl, ldoc_content_t tpe
     return ent;
 }
 
-inline static ldoc_nde_t* ldoc_pydict2doc_lst(PyObject* lbl, PyObject* lst)
+inline static ldoc_nde_t* ldoc_pydict2doc_lst(ldoc_doc_t* doc, PyObject* lbl, PyObject* lst)
 {
-    ldoc_nde_t* nde = ldoc_nde_new(LDOC_NDE_OL);
+    ldoc_nde_t* nde = ldoc_doc_nde_new(doc, LDOC_NDE_OL);
     
     if (lbl)
     {
-        char* clbl = strdup(PyUnicode_AsUTF8(lbl));
+        char* clbl = ldoc_pydict2doc_strdup(doc, lbl);
         nde->mkup.anno.str = clbl;
     }
     
@@ -181,31 +221,31 @@ inline static ldoc_nde_t* ldoc_pydict2doc_lst(PyObject* lbl, PyObject* lst)
         
         if (PyDict_CheckExact(val))
         {
-            dsc = ldoc_pydict2doc_dict(NULL, val);
+            dsc = ldoc_pydict2doc_dict(doc, NULL, val);
             
             ldoc_nde_dsc_push(nde, dsc);
         }
         else if (PyList_CheckExact(val))
         {
-            dsc = ldoc_pydict2doc_lst(NULL, val);
+            dsc = ldoc_pydict2doc_lst(doc, NULL, val);
             
             ldoc_nde_dsc_push(nde, dsc);
         }
         else if (PyUnicode_CheckExact(val))
         {
-            ent = ldoc_pydict2doc_str(val);
+            ent = ldoc_pydict2doc_str(doc, val);
             
             ldoc_nde_ent_push(nde, ent);
         }
         else if (PyLong_CheckExact(val) || PyFloat_CheckExact(val))
         {
-            ent = ldoc_pydict2doc_num(val);
+            ent = ldoc_pydict2doc_num(doc, val);
             
             ldoc_nde_ent_push(nde, ent);
         }
         else if (PyBool_Check(val))
         {
-            ent = ldoc_pydict2doc_bl(val);
+            ent = ldoc_pydict2doc_bl(doc, val);
             
             ldoc_nde_ent_push(nde, ent);
         }
@@ -218,16 +258,8 @@ inline static ldoc_nde_t* ldoc_pydict2doc_lst(PyObject* lbl, PyObject* lst)
     return nde;
 }
 
-inline static ldoc_nde_t* ldoc_pydict2doc_dict(PyObject* lbl, PyObject* dict)
+inline static void ldoc_pydict2doc_dict_fill(ldoc_doc_t* doc, ldoc_nde_t* nde, PyObject* dict)
 {
-    ldoc_nde_t* nde = ldoc_nde_new(LDOC_NDE_UA);
-    
-    if (lbl)
-    {
-        char* clbl = strdup(PyUnicode_AsUTF8(lbl));
-        nde->mkup.anno.str = clbl;
-    }
-    
     PyObject* ky;
     PyObject* val;
     Py_ssize_t pos = 0;
@@ -238,31 +270,31 @@ inline static ldoc_nde_t* ldoc_pydict2doc_dict(PyObject* lbl, PyObject* dict)
     {
         if (PyDict_CheckExact(val))
         {
-            dsc = ldoc_pydict2doc_dict(ky, val);
+            dsc = ldoc_pydict2doc_dict(doc, ky, val);
             
             ldoc_nde_dsc_push(nde, dsc);
         }
         else if (PyList_CheckExact(val))
         {
-            dsc = ldoc_pydict2doc_lst(ky, val);
+            dsc = ldoc_pydict2doc_lst(doc, ky, val);
             
             ldoc_nde_dsc_push(nde, dsc);
         }
         else if (PyUnicode_CheckExact(val))
         {
-            ent = ldoc_pydict2doc_anno(ky, LDOC_ENT_OR, val);
+            ent = ldoc_pydict2doc_anno(doc, ky, LDOC_ENT_OR, val);
             
             ldoc_nde_ent_push(nde, ent);
         }
         else if (PyLong_CheckExact(val) || PyFloat_CheckExact(val))
         {
-            ent = ldoc_pydict2doc_anno(ky, LDOC_ENT_NR, val);
+            ent = ldoc_pydict2doc_anno(doc, ky, LDOC_ENT_NR, val);
             
             ldoc_nde_ent_push(nde, ent);
         }
         else if (PyBool_Check(val))
         {
-            ent = ldoc_pydict2doc_anno(ky, LDOC_ENT_BR, val);
+            ent = ldoc_pydict2doc_anno(doc, ky, LDOC_ENT_BR, val);
             
             ldoc_nde_ent_push(nde, ent);
         }
@@ -271,6 +303,19 @@ inline static ldoc_nde_t* ldoc_pydict2doc_dict(PyObject* lbl, PyObject* dict)
             // TODO Passed custom type -- which is not supported.
         }
     }
+}
+
+inline static ldoc_nde_t* ldoc_pydict2doc_dict(ldoc_doc_t* doc, PyObject* lbl, PyObject* dict)
+{
+    ldoc_nde_t* nde = ldoc_doc_nde_new(doc, LDOC_NDE_UA);
+    
+    if (lbl)
+    {
+        char* clbl = ldoc_pydict2doc_strdup(doc, lbl);
+        nde->mkup.anno.str = clbl;
+    }
+    
+    ldoc_pydict2doc_dict_fill(doc, nde, dict);
     
     return nde;
 }
@@ -279,9 +324,19 @@ ldoc_doc_t* ldoc_pydict2doc(PyObject* dict)
 {
     ldoc_doc_t* doc = ldoc_doc_new();
     
-    free(doc->rt);
-    doc->rt = ldoc_pydict2doc_dict(NULL, dict);
-    doc->rt->tpe = LDOC_NDE_RT;
+    ldoc_pydict2doc_dict_fill(doc, doc->rt, dict);
+    
+    return doc;
+}
+
+ldoc_doc_t* ldoc_pydict2doc_arena(PyObject* dict, size_t hnt)
+{
+    ldoc_doc_t* doc = ldoc_doc_new_arena(hnt);
+    
+    if (!doc)
+        return LDOC_DOC_NULL;
+    
+    ldoc_pydict2doc_dict_fill(doc, doc->rt, dict);
     
     return doc;
 }
@@ -289,6 +344,59 @@ ldoc_doc_t* ldoc_pydict2doc(PyObject* dict)
 
 #pragma mark - Type Utilities
 
+static inline uint64_t ldoc_str_hsh(const char* str, size_t len)
+{
+    // FNV-1a:
+    uint64_t hsh = 0xcbf29ce484222325ULL;
+    
+    for (size_t i = 0; i < len; i++)
+        hsh = (hsh ^ (uint8_t)str[i]) * 0x100000001b3ULL;
+    
+    return hsh;
+}
+
+// Entity types whose payload is an annotation pair:
+static inline bool ldoc_ent_pair(ldoc_content_t tpe)
+{
+    return tpe == LDOC_ENT_BR || tpe == LDOC_ENT_NR || tpe == LDOC_ENT_OR;
+}
+
+static inline size_t ldoc_i64_fmt(int64_t i64, char* buf)
+{
+    // Digits in reverse order; the magnitude of INT64_MIN does not fit into an int64_t:
+    char dgts[20];
+    uint64_t u64 = i64 < 0 ? -(uint64_t)i64 : (uint64_t)i64;
+    size_t n = 0;
+    size_t len = 0;
+    
+    do
+    {
+        dgts[n++] = '0' + u64 % 10;
+        u64 /= 10;
+    } while (u64);
+    
+    if (i64 < 0)
+        buf[len++] = '-';
+    
+    while (n)
+        buf[len++] = dgts[--n];
+    
+    buf[len] = 0;
+    
+    return len;
+}
+
+static inline size_t ldoc_f64_fmt(double f64, char* buf)
+{
+    // Shortest of the two precisions that reads back as the same number:
+    int len = snprintf(buf, LDOC_NUM_LEN, "%.15g", f64);
+    
+    if (strtod(buf, NULL) != f64)
+        len = snprintf(buf, LDOC_NUM_LEN, "%.17g", f64);
+    
+    return len;
+}
+
 static inline bool ldoc_isfloat(char* str)
 {
     bool flt = false;
@@ -373,10 +481,8 @@ inline void ldoc_ser_free(ldoc_ser_t* ser)
     free(ser);
 }
 
-static inline ldoc_nde_t* ldoc_nde_new_(ldoc_struct_t tpe)
+static inline ldoc_nde_t* ldoc_nde_init(ldoc_nde_t* nde, ldoc_struct_t tpe)
 {
-    ldoc_nde_t* nde = (ldoc_nde_t*)malloc(sizeof(ldoc_nde_t));
-    
     if (!nde)
     {
         // TODO
@@ -386,212 +492,1545 @@ static inline ldoc_nde_t* ldoc_nde_new_(ldoc_struct_t tpe)
     nde->tpe = tpe;
     nde->prnt = LDOC_NDE_NULL;
     nde->mkup = LDOC_ANNO_NULL;
+    nde->rep = LDOC_REP_STR;
     nde->ent_cnt = 0;
     nde->dsc_cnt = 0;
+    nde->idx = NULL;
+    nde->pos = 0;
     TAILQ_INIT(&(nde->ents));
     TAILQ_INIT(&(nde->dscs));
     
     return nde;
 }
 
-#pragma mark - Serialization Utilities
-
-static inline void ldoc_ser_concat_str(ldoc_ser_t* ser1, ldoc_ser_t* ser2)
+static inline ldoc_nde_t* ldoc_nde_new_(ldoc_struct_t tpe)
 {
-    size_t len2 = strlen(ser2->pld.str);
-    
-    // Nothing to concatenate:
-    if (!len2)
-        return;
-    
-    size_t len1 = strlen(ser1->pld.str);
-    size_t len = len1 + len2 + 1;
-    
-    ser1->pld.str = realloc(ser1->pld.str, len);
-    
-    strncat(ser1->pld.str, ser2->pld.str, len2);
+    return ldoc_nde_init((ldoc_nde_t*)malloc(sizeof(ldoc_nde_t)), tpe);
 }
 
-#ifndef LDOC_NOPYTHON
-static inline void ldoc_ser_concat_py_str(ldoc_ser_t* ser1, ldoc_ser_t* ser2)
+static inline ldoc_ent_t* ldoc_ent_init(ldoc_ent_t* ent, ldoc_content_t tpe)
 {
-    PyObject* ccat = PyUnicode_Concat(ser1->pld.py.dtm, ser2->pld.py.dtm);
+    if (!ent)
+    {
+        // TODO
+        return LDOC_ENT_NULL;
+    }
     
-    Py_DECREF(ser1->pld.py.dtm);
-    Py_DECREF(ser2->pld.py.dtm);
+    ent->prnt = NULL;
+    ent->tpe = tpe;
+    ent->pld.str = NULL;
+    ent->rep = LDOC_REP_STR;
     
-    ser1->pld.py.dtm = ccat;
+    return ent;
 }
 
-static inline void ldoc_ser_concat_py_dct(ldoc_ser_t* ser1, ldoc_ser_t* ser2)
+#pragma mark - Arenas
+
+// Alignment of arena allocations; sufficient for any payload type:
+#define LDOC_ARNA_ALGN 16
+// Block data areas never grow beyond this size, unless a single allocation needs more room:
+#define LDOC_ARNA_MAX (1 << 20)
+// Offset of a block's data area (header size, rounded up to the alignment):
+#define LDOC_ARNA_HDR ((sizeof(ldoc_arna_blk_t) + LDOC_ARNA_ALGN - 1) & ~(size_t)(LDOC_ARNA_ALGN - 1))
+
+static inline ldoc_arna_blk_t* ldoc_arna_blk_new(size_t max)
 {
-    switch (ser2->tpe)
-    {
-        case LDOC_SER_PY_BL:
-        case LDOC_SER_PY_FLT:
-        case LDOC_SER_PY_STR:
-        case LDOC_SER_PY_DCT:
-        case LDOC_SER_PY_LST:
-            PyDict_SetItem(ser1->pld.py.dtm, ser2->pld.py.anno, ser2->pld.py.dtm);
-            break;
-        default:
-            // TODO Internal error.
-            break;
-    }
+    ldoc_arna_blk_t* blk = (ldoc_arna_blk_t*)malloc(LDOC_ARNA_HDR + max);
+    
+    if (!blk)
+        return NULL;
+    
+    blk->nxt = NULL;
+    blk->len = 0;
+    blk->max = max;
+    
+    return blk;
 }
 
-static inline void ldoc_ser_concat_py_lst(ldoc_ser_t* ser1, ldoc_ser_t* ser2)
+ldoc_arna_t* ldoc_arna_new(size_t inc)
 {
-    switch (ser2->tpe)
+    ldoc_arna_t* arna = (ldoc_arna_t*)malloc(sizeof(ldoc_arna_t));
+    
+    if (!arna)
+        return NULL;
+    
+    arna->inc = inc ? inc : (size_t)getpagesize();
+    arna->blk = ldoc_arna_blk_new(arna->inc);
+    
+    if (!arna->blk)
     {
-        case LDOC_SER_PY_BL:
-        case LDOC_SER_PY_FLT:
-        case LDOC_SER_PY_STR:
-        case LDOC_SER_PY_DCT:
-        case LDOC_SER_PY_LST:
-            PyList_Append(ser1->pld.py.dtm, ser2->pld.py.dtm);
-            break;
-        default:
-            // TODO Internal error.
-            break;
+        free(arna);
+        
+        return NULL;
     }
+    
+    return arna;
 }
-#endif // #ifndef LDOC_NOPYTHON
 
-void ldoc_ser_concat(ldoc_ser_t* ser1, ldoc_ser_t* ser2)
+void ldoc_arna_free(ldoc_arna_t* arna)
 {
-    // Nothing to concatenate:
-    if (ser2 == LDOC_SER_NULL)
+    if (!arna)
         return;
     
-    // TODO Only strings supported right now.
+    ldoc_arna_blk_t* blk = arna->blk;
     
-    switch (ser1->tpe)
+    while (blk)
     {
-#ifndef LDOC_NOPYTHON
-        case LDOC_SER_PY_BL:
-        case LDOC_SER_PY_FLT:
-        case LDOC_SER_PY_INT:
-            // Things that cannot be concatenated.
-            
-            // TODO Internal error.
-            
-            break;
-        case LDOC_SER_PY_STR:
-            if (ser2->tpe == LDOC_SER_PY_STR)
-                ldoc_ser_concat_py_str(ser1, ser2);
-            else
-            {
-                // TODO Internal error. Second object is not a string.
-            }
-        case LDOC_SER_PY_DCT:
-            ldoc_ser_concat_py_dct(ser1, ser2);
-            break;
-        case LDOC_SER_PY_LST:
-            ldoc_ser_concat_py_lst(ser1, ser2);
-            break;
-#endif // #ifndef LDOC_NOPYTHON
-        case LDOC_SER_CSTR:
-            return ldoc_ser_concat_str(ser1, ser2);
-        default:
-            break;
+        ldoc_arna_blk_t* nxt = blk->nxt;
+        
+        free(blk);
+        
+        blk = nxt;
     }
+    
+    free(arna);
 }
 
-ldoc_pos_t* ldoc_pos_new(ldoc_nde_t* nde, uint64_t nde_off, uint64_t off)
+static inline void* ldoc_arna_alloc_(ldoc_arna_t* arna, size_t sz, size_t algn)
 {
-    ldoc_pos_t* pos = (ldoc_pos_t*)malloc(sizeof(ldoc_pos_t));
+    ldoc_arna_blk_t* blk = arna->blk;
+    size_t off = (blk->len + algn - 1) & ~(algn - 1);
     
-    if (!pos)
+    if (off > blk->max || blk->max - off < sz)
     {
-        // TODO
+        // Oversized allocation: give it a block of its own, but keep filling the current block:
+        if (sz > arna->inc)
+        {
+            ldoc_arna_blk_t* big = ldoc_arna_blk_new(sz);
+            
+            if (!big)
+                return NULL;
+            
+            big->len = sz;
+            big->nxt = blk->nxt;
+            blk->nxt = big;
+            
+            return (char*)big + LDOC_ARNA_HDR;
+        }
+        
+        // Geometric growth, so that documents larger than the size hint only need a few blocks:
+        if (arna->inc < LDOC_ARNA_MAX)
+            arna->inc *= 2;
+        
+        blk = ldoc_arna_blk_new(arna->inc);
+        
+        if (!blk)
+            return NULL;
+        
+        blk->nxt = arna->blk;
+        arna->blk = blk;
+        off = 0;
     }
     
-    pos->nde = nde;
-    pos->nde_off = nde_off;
-    pos->off = off;
+    blk->len = off + sz;
     
-    return pos;
+    return (char*)blk + LDOC_ARNA_HDR + off;
 }
 
-void ldoc_pos_free(ldoc_pos_t* pos)
+void* ldoc_arna_alloc(ldoc_arna_t* arna, size_t sz)
 {
-    free(pos);
+    return ldoc_arna_alloc_(arna, sz, LDOC_ARNA_ALGN);
 }
 
-ldoc_doc_t* ldoc_doc_new()
+static inline char* ldoc_arna_strndup(ldoc_arna_t* arna, const char* str, size_t len)
 {
-    ldoc_doc_t* doc = (ldoc_doc_t*)malloc(sizeof(ldoc_doc_t));
+    len = strnlen(str, len);
     
-    if (!doc)
-    {
-        // TODO Error.
-    }
+    // Strings are packed without alignment:
+    char* s = (char*)ldoc_arna_alloc_(arna, len + 1, 1);
     
-    ldoc_nde_t* rt = ldoc_nde_new_(LDOC_NDE_RT);
+    if (!s)
+        return NULL;
     
-    if (!rt)
+    memcpy(s, str, len);
+    s[len] = 0;
+    
+    return s;
+}
+
+ldoc_nde_t* ldoc_doc_nde_new(ldoc_doc_t* doc, ldoc_struct_t tpe)
+{
+    if (!doc->arna)
+        return ldoc_nde_new(tpe);
+    
+    if (tpe == LDOC_NDE_RT)
     {
-        free(doc);
         // TODO Error.
+        return LDOC_NDE_NULL;
     }
     
-    doc->rt = rt;
+    return ldoc_nde_init((ldoc_nde_t*)ldoc_arna_alloc(doc->arna, sizeof(ldoc_nde_t)), tpe);
+}
+
+ldoc_ent_t* ldoc_doc_ent_new(ldoc_doc_t* doc, ldoc_content_t tpe)
+{
+    if (!doc->arna)
+        return ldoc_ent_new(tpe);
     
-    return doc;
+    return ldoc_ent_init((ldoc_ent_t*)ldoc_arna_alloc(doc->arna, sizeof(ldoc_ent_t)), tpe);
 }
 
-void ldoc_doc_free(ldoc_doc_t* doc)
+char* ldoc_doc_strndup(ldoc_doc_t* doc, const char* str, size_t len)
 {
-    ldoc_nde_free(doc->rt);
+    if (!doc->arna)
+        return strndup(str, len);
     
-    free(doc);
+    return ldoc_arna_strndup(doc->arna, str, len);
 }
 
-ldoc_vis_nde_ord_t* ldoc_vis_nde_ord_new()
+#pragma mark - Binary Format
+
+// Binary documents: a header, followed by the node table in pre-order, the
+// entity table (entities of each node, in node order) and the string pool.
+#define LDOC_BIN_MGC "LDOC"
+#define LDOC_BIN_VER 1
+// Byte order mark:
+#define LDOC_BIN_BOM 0x01020304
+// Pool offset of null strings:
+#define LDOC_BIN_NULL UINT64_MAX
+
+typedef struct ldoc_bin_hdr_t
 {
-    ldoc_vis_nde_ord_t* vis = (ldoc_vis_nde_ord_t*)malloc(sizeof(ldoc_vis_nde_ord_t));
+    char mgc[4];
+    uint32_t ver;
+    uint32_t bom;
+    uint32_t rsv;
+    uint64_t nde_cnt;
+    uint64_t ent_cnt;
+    uint64_t pool_len;
+} ldoc_bin_hdr_t;
+
+// String (pool offset and length), or a boolean/number in `off`:
+typedef struct ldoc_bin_pld_t
+{
+    uint64_t off;
+    uint64_t len;
+} ldoc_bin_pld_t;
+
+typedef struct ldoc_bin_nde_t
+{
+    uint32_t tpe;
+    uint32_t rep;
+    // Index of the parent node, which precedes the node; the root's own index is 0:
+    uint64_t prnt;
+    ldoc_bin_pld_t anno;
+} ldoc_bin_nde_t;
+
+typedef struct ldoc_bin_ent_t
+{
+    uint32_t tpe;
+    uint32_t rep;
+    uint64_t prnt;
+    ldoc_bin_pld_t anno;
+    ldoc_bin_pld_t dtm;
+} ldoc_bin_ent_t;
+
+// Write state: output, pre-order node index and string pool length:
+typedef struct ldoc_bin_wrt_t
+{
+    FILE* fle;
+    uint64_t idx;
+    uint64_t pool_len;
+    bool ok;
+} ldoc_bin_wrt_t;
+
+// Datums without a string, which are stored in place:
+static inline bool ldoc_bin_val(ldoc_ent_t* ent)
+{
+    return ent->tpe == LDOC_ENT_BL || ent->tpe == LDOC_ENT_BR || (ent->rep & (LDOC_REP_I64 | LDOC_REP_F64));
+}
+
+static inline ldoc_bin_pld_t ldoc_bin_str(ldoc_bin_wrt_t* wrt, const char* str, size_t len)
+{
+    ldoc_bin_pld_t pld = { LDOC_BIN_NULL, 0 };
     
-    if (!vis)
-    {
-        // TODO.
-    }
+    if (!str)
+        return pld;
     
-    // Assign NULL pointers to all callbacks:
-    memset(vis, 0, sizeof(ldoc_vis_nde_ord_t));
+    pld.off = wrt->pool_len;
+    pld.len = len;
+    wrt->pool_len += len + 1;
     
-    return vis;
+    return pld;
 }
 
-void ldoc_vis_nde_ord_free(ldoc_vis_nde_ord_t* vis_nde)
+static inline void ldoc_bin_wrt(ldoc_bin_wrt_t* wrt, const void* dat, size_t len)
 {
-    free(vis_nde);
+    if (wrt->ok && len && fwrite(dat, len, 1, wrt->fle) != 1)
+        wrt->ok = false;
 }
 
-ldoc_vis_ent_t* ldoc_vis_ent_new()
+static inline void ldoc_bin_wrt_str(ldoc_bin_wrt_t* wrt, const char* str, size_t len)
 {
-    ldoc_vis_ent_t* vis = (ldoc_vis_ent_t*)malloc(sizeof(ldoc_vis_ent_t));
-    
-    if (!vis)
-    {
-        // TODO.
-    }
-    
-    // Assign NULL pointers to all callbacks:
-    memset(vis, 0, sizeof(ldoc_vis_ent_t));
+    if (!str)
+        return;
     
-    return vis;
+    ldoc_bin_wrt(wrt, str, len);
+    ldoc_bin_wrt(wrt, "", 1);
 }
 
-void ldoc_vis_ent_free(ldoc_vis_ent_t* vis_ent)
+static void ldoc_bin_cnt(ldoc_nde_t* nde, ldoc_bin_hdr_t* hdr)
 {
-    free(vis_ent);
+    hdr->nde_cnt++;
+    hdr->ent_cnt += nde->ent_cnt;
+    
+    ldoc_nde_t* dsc;
+    TAILQ_FOREACH(dsc, &(nde->dscs), ldoc_nde_entries)
+        ldoc_bin_cnt(dsc, hdr);
 }
 
-void ldoc_vis_nde_uni(ldoc_vis_nde_t* vis, ldoc_ser_t* (*vis_uni)(ldoc_nde_t* nde, ldoc_coord_t* coord))
+static void ldoc_bin_wrt_ndes(ldoc_bin_wrt_t* wrt, ldoc_nde_t* nde, uint64_t prnt)
 {
-    vis->vis_anc = vis_uni;
-    vis->vis_h1 = vis_uni;
+    size_t len;
+    const char* str = ldoc_nde_anno_str(nde, &len);
+    uint64_t idx = wrt->idx++;
+    ldoc_bin_nde_t rec = { nde->tpe, nde->rep & ~LDOC_REP_RAW, prnt, ldoc_bin_str(wrt, str, len) };
+    
+    ldoc_bin_wrt(wrt, &rec, sizeof(rec));
+    
+    ldoc_nde_t* dsc;
+    TAILQ_FOREACH(dsc, &(nde->dscs), ldoc_nde_entries)
+        ldoc_bin_wrt_ndes(wrt, dsc, idx);
+}
+
+static void ldoc_bin_wrt_ents(ldoc_bin_wrt_t* wrt, ldoc_nde_t* nde)
+{
+    uint64_t idx = wrt->idx++;
+    size_t len;
+    const char* str;
+    
+    ldoc_ent_t* ent;
+    TAILQ_FOREACH(ent, &(nde->ents), ldoc_ent_entries)
+    {
+        bool pair = ldoc_ent_pair(ent->tpe);
+        ldoc_anno_pld_t* dtm = pair ? &(ent->pld.pair.dtm) : (ldoc_anno_pld_t*)&(ent->pld);
+        ldoc_bin_ent_t rec = { ent->tpe, ent->rep & ~LDOC_REP_RAW, idx, { LDOC_BIN_NULL, 0 }, { 0, 0 } };
+        
+        if (pair)
+        {
+            str = ldoc_ent_anno_str(ent, &len);
+            rec.anno = ldoc_bin_str(wrt, str, len);
+        }
+        
+        if (ent->rep & LDOC_REP_I64)
+            rec.dtm.off = (uint64_t)dtm->i64;
+        else if (ent->rep & LDOC_REP_F64)
+            memcpy(&rec.dtm.off, &(dtm->f64), sizeof(double));
+        else if (ldoc_bin_val(ent))
+            rec.dtm.off = dtm->bl;
+        else
+        {
+            str = ldoc_ent_dtm_str(ent, &len);
+            rec.dtm = ldoc_bin_str(wrt, str, len);
+        }
+        
+        ldoc_bin_wrt(wrt, &rec, sizeof(rec));
+    }
+    
+    ldoc_nde_t* dsc;
+    TAILQ_FOREACH(dsc, &(nde->dscs), ldoc_nde_entries)
+        ldoc_bin_wrt_ents(wrt, dsc);
+}
+
+// Same order as the string offsets of the node and entity tables:
+static void ldoc_bin_wrt_pool(ldoc_bin_wrt_t* wrt, ldoc_nde_t* nde, bool ents)
+{
+    size_t len;
+    const char* str;
+    
+    if (!ents)
+    {
+        str = ldoc_nde_anno_str(nde, &len);
+        ldoc_bin_wrt_str(wrt, str, len);
+    }
+    else
+    {
+        ldoc_ent_t* ent;
+        TAILQ_FOREACH(ent, &(nde->ents), ldoc_ent_entries)
+        {
+            if (ldoc_ent_pair(ent->tpe))
+            {
+                str = ldoc_ent_anno_str(ent, &len);
+                ldoc_bin_wrt_str(wrt, str, len);
+            }
+            
+            if (!ldoc_bin_val(ent))
+            {
+                str = ldoc_ent_dtm_str(ent, &len);
+                ldoc_bin_wrt_str(wrt, str, len);
+            }
+        }
+    }
+    
+    ldoc_nde_t* dsc;
+    TAILQ_FOREACH(dsc, &(nde->dscs), ldoc_nde_entries)
+        ldoc_bin_wrt_pool(wrt, dsc, ents);
+}
+
+bool ldoc_doc_save(ldoc_doc_t* doc, const char* pth)
+{
+    ldoc_bin_hdr_t hdr = { LDOC_BIN_MGC, LDOC_BIN_VER, LDOC_BIN_BOM, 0, 0, 0, 0 };
+    ldoc_bin_wrt_t wrt = { fopen(pth, "wb"), 0, 0, true };
+    
+    if (!wrt.fle)
+        return false;
+    
+    ldoc_bin_cnt(doc->rt, &hdr);
+    
+    // The pool length is only known after the tables were written:
+    ldoc_bin_wrt(&wrt, &hdr, sizeof(hdr));
+    ldoc_bin_wrt_ndes(&wrt, doc->rt, 0);
+    wrt.idx = 0;
+    ldoc_bin_wrt_ents(&wrt, doc->rt);
+    ldoc_bin_wrt_pool(&wrt, doc->rt, false);
+    ldoc_bin_wrt_pool(&wrt, doc->rt, true);
+    
+    hdr.pool_len = wrt.pool_len;
+    
+    if (wrt.ok && (fseek(wrt.fle, 0, SEEK_SET) || fwrite(&hdr, sizeof(hdr), 1, wrt.fle) != 1))
+        wrt.ok = false;
+    
+    if (fclose(wrt.fle))
+        wrt.ok = false;
+    
+    return wrt.ok;
+}
+
+// Pool string of a loaded document; the pool's strings are null-terminated:
+static inline bool ldoc_bin_ld_str(ldoc_bin_pld_t* pld, char* pool, uint64_t pool_len, char** str)
+{
+    if (pld->off == LDOC_BIN_NULL)
+    {
+        *str = NULL;
+        
+        return true;
+    }
+    
+    if (pld->off >= pool_len || pool_len - pld->off <= pld->len || pool[pld->off + pld->len])
+        return false;
+    
+    *str = pool + pld->off;
+    
+    return true;
+}
+
+ldoc_doc_t* ldoc_doc_load_mmap(const char* pth)
+{
+    int fd = open(pth, O_RDONLY);
+    
+    if (fd < 0)
+        return LDOC_DOC_NULL;
+    
+    struct stat st;
+    
+    if (fstat(fd, &st) || (size_t)st.st_size < sizeof(ldoc_bin_hdr_t))
+    {
+        close(fd);
+        
+        return LDOC_DOC_NULL;
+    }
+    
+    size_t len = st.st_size;
+    char* map = (char*)mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    
+    // The mapping stays valid after closing the file:
+    close(fd);
+    
+    if (map == MAP_FAILED)
+        return LDOC_DOC_NULL;
+    
+    ldoc_bin_hdr_t* hdr = (ldoc_bin_hdr_t*)map;
+    size_t tbls = sizeof(ldoc_bin_hdr_t);
+    
+    // Sizes are checked against the file length before multiplying, so that they cannot overflow:
+    if (memcmp(hdr->mgc, LDOC_BIN_MGC, 4) || hdr->ver != LDOC_BIN_VER || hdr->bom != LDOC_BIN_BOM ||
+        !hdr->nde_cnt || hdr->nde_cnt > len || hdr->ent_cnt > len ||
+        (tbls += hdr->nde_cnt * sizeof(ldoc_bin_nde_t) + hdr->ent_cnt * sizeof(ldoc_bin_ent_t)) > len ||
+        len - tbls != hdr->pool_len)
+    {
+        munmap(map, len);
+        
+        return LDOC_DOC_NULL;
+    }
+    
+    ldoc_doc_t* doc = ldoc_doc_new_arena(hdr->nde_cnt * sizeof(ldoc_nde_t) + hdr->ent_cnt * sizeof(ldoc_ent_t) + 1024);
+    ldoc_bin_nde_t* bndes = (ldoc_bin_nde_t*)(hdr + 1);
+    ldoc_bin_ent_t* bents = (ldoc_bin_ent_t*)(bndes + hdr->nde_cnt);
+    char* pool = map + tbls;
+    
+    if (!doc)
+    {
+        munmap(map, len);
+        
+        return LDOC_DOC_NULL;
+    }
+    
+    doc->map = map;
+    doc->map_len = len;
+    
+    // Nodes and entities in one block each; the root was created with the document:
+    ldoc_nde_t** ndes = (ldoc_nde_t**)malloc(hdr->nde_cnt * sizeof(ldoc_nde_t*));
+    ldoc_nde_t* nblk = hdr->nde_cnt > 1 ? (ldoc_nde_t*)ldoc_arna_alloc(doc->arna, (hdr->nde_cnt - 1) * sizeof(ldoc_nde_t)) : NULL;
+    ldoc_ent_t* eblk = hdr->ent_cnt ? (ldoc_ent_t*)ldoc_arna_alloc(doc->arna, hdr->ent_cnt * sizeof(ldoc_ent_t)) : NULL;
+    bool ok = ndes && (nblk || hdr->nde_cnt == 1) && (eblk || !hdr->ent_cnt) && bndes[0].tpe == LDOC_NDE_RT;
+    
+    for (uint64_t i = 0; ok && i < hdr->nde_cnt; i++)
+    {
+        ldoc_bin_nde_t* bnde = &bndes[i];
+        
+        // Types and representations are used as they are, so unknown ones are rejected
+        // (node representations are never saved as raw):
+        if (bnde->tpe > LDOC_NDE_OO || bnde->rep != LDOC_REP_STR)
+        {
+            ok = false;
+            
+            break;
+        }
+        
+        ldoc_nde_t* nde = i ? ldoc_nde_init(&nblk[i - 1], (ldoc_struct_t)bnde->tpe) : doc->rt;
+        
+        ndes[i] = nde;
+        nde->rep = LDOC_REP_STR;
+        ok = ldoc_bin_ld_str(&(bnde->anno), pool, hdr->pool_len, &(nde->mkup.anno.str));
+        
+        if (i && ok)
+        {
+            ok = bnde->prnt < i && bnde->tpe != LDOC_NDE_RT;
+            
+            if (ok)
+                ldoc_nde_dsc_push(ndes[bnde->prnt], nde);
+        }
+    }
+    
+    for (uint64_t i = 0; ok && i < hdr->ent_cnt; i++)
+    {
+        ldoc_bin_ent_t* bent = &bents[i];
+        
+        if (bent->tpe > LDOC_ENT_OR || (bent->rep & ~(uint32_t)(LDOC_REP_I64 | LDOC_REP_F64)))
+        {
+            ok = false;
+            
+            break;
+        }
+        
+        ldoc_ent_t* ent = ldoc_ent_init(&eblk[i], (ldoc_content_t)bent->tpe);
+        bool pair = ldoc_ent_pair(ent->tpe);
+        ldoc_anno_pld_t* dtm = pair ? &(ent->pld.pair.dtm) : (ldoc_anno_pld_t*)&(ent->pld);
+        
+        ent->rep = (uint8_t)bent->rep;
+        
+        if (bent->prnt >= hdr->nde_cnt)
+        {
+            ok = false;
+            
+            break;
+        }
+        
+        if (pair)
+            ok = ldoc_bin_ld_str(&(bent->anno), pool, hdr->pool_len, &(ent->pld.pair.anno.str));
+        
+        if (ent->rep & LDOC_REP_I64)
+            dtm->i64 = (int64_t)bent->dtm.off;
+        else if (ent->rep & LDOC_REP_F64)
+            memcpy(&(dtm->f64), &(bent->dtm.off), sizeof(double));
+        else if (ldoc_bin_val(ent))
+            dtm->bl = bent->dtm.off != 0;
+        else if (ok)
+            ok = ldoc_bin_ld_str(&(bent->dtm), pool, hdr->pool_len, &(dtm->str));
+        
+        ldoc_nde_ent_push(ndes[bent->prnt], ent);
+    }
+    
+    free(ndes);
+    
+    if (!ok)
+    {
+        ldoc_doc_free(doc);
+        
+        return LDOC_DOC_NULL;
+    }
+    
+    return doc;
+}
+
+#pragma mark - String Interning
+
+typedef struct ldoc_intn_slt_t
+{
+    uint64_t hsh;
+    char* str;
+    size_t len;
+} ldoc_intn_slt_t;
+
+// Open addressing with linear probing; strings live in an arena:
+struct ldoc_intn_t
+{
+    ldoc_arna_t* arna;
+    size_t cnt;
+    size_t msk;
+    ldoc_intn_slt_t* slts;
+};
+
+ldoc_intn_t* ldoc_intn_new(void)
+{
+    ldoc_intn_t* intn = (ldoc_intn_t*)malloc(sizeof(ldoc_intn_t));
+    
+    if (!intn)
+        return NULL;
+    
+    intn->arna = ldoc_arna_new(0);
+    intn->cnt = 0;
+    intn->msk = 255;
+    intn->slts = (ldoc_intn_slt_t*)calloc(intn->msk + 1, sizeof(ldoc_intn_slt_t));
+    
+    if (!intn->arna || !intn->slts)
+    {
+        ldoc_intn_free(intn);
+        
+        return NULL;
+    }
+    
+    return intn;
+}
+
+void ldoc_intn_free(ldoc_intn_t* intn)
+{
+    if (intn->arna)
+        ldoc_arna_free(intn->arna);
+    
+    free(intn->slts);
+    free(intn);
+}
+
+static inline ldoc_intn_slt_t* ldoc_intn_slt(ldoc_intn_t* intn, uint64_t hsh, const char* str, size_t len)
+{
+    size_t i = hsh & intn->msk;
+    
+    while (intn->slts[i].str)
+    {
+        ldoc_intn_slt_t* slt = &(intn->slts[i]);
+        
+        if (slt->hsh == hsh && slt->len == len && !memcmp(slt->str, str, len))
+            break;
+        
+        i = (i + 1) & intn->msk;
+    }
+    
+    return &(intn->slts[i]);
+}
+
+// Keeps the load factor at most one half:
+static inline bool ldoc_intn_grow(ldoc_intn_t* intn)
+{
+    size_t max = (intn->msk + 1) * 2;
+    ldoc_intn_slt_t* slts = (ldoc_intn_slt_t*)calloc(max, sizeof(ldoc_intn_slt_t));
+    
+    if (!slts)
+        return false;
+    
+    for (size_t i = 0; i <= intn->msk; i++)
+    {
+        if (!intn->slts[i].str)
+            continue;
+        
+        size_t j = intn->slts[i].hsh & (max - 1);
+        
+        while (slts[j].str)
+            j = (j + 1) & (max - 1);
+        
+        slts[j] = intn->slts[i];
+    }
+    
+    free(intn->slts);
+    intn->slts = slts;
+    intn->msk = max - 1;
+    
+    return true;
+}
+
+char* ldoc_intn_str(ldoc_intn_t* intn, const char* str, size_t len)
+{
+    uint64_t hsh = ldoc_str_hsh(str, len);
+    ldoc_intn_slt_t* slt = ldoc_intn_slt(intn, hsh, str, len);
+    
+    if (slt->str)
+        return slt->str;
+    
+    if ((intn->cnt + 1) * 2 > intn->msk + 1)
+    {
+        if (!ldoc_intn_grow(intn))
+            return NULL;
+        
+        slt = ldoc_intn_slt(intn, hsh, str, len);
+    }
+    
+    // Strings are packed without alignment:
+    char* cpy = (char*)ldoc_arna_alloc_(intn->arna, len + 1, 1);
+    
+    if (!cpy)
+        return NULL;
+    
+    memcpy(cpy, str, len);
+    cpy[len] = 0;
+    
+    slt->hsh = hsh;
+    slt->str = cpy;
+    slt->len = len;
+    intn->cnt++;
+    
+    return cpy;
+}
+
+char* ldoc_intn_get(ldoc_intn_t* intn, const char* str, size_t len)
+{
+    return ldoc_intn_slt(intn, ldoc_str_hsh(str, len), str, len)->str;
+}
+
+size_t ldoc_intn_cnt(ldoc_intn_t* intn)
+{
+    return intn->cnt;
+}
+
+#pragma mark - Annotation Indices
+
+// Open addressing with linear probing; entries with equal annotations are
+// found in insertion order, because there are no deletions:
+typedef struct ldoc_nde_idx_slt_t
+{
+    uint64_t hsh;
+    ldoc_info_t info;
+    bool nde;
+} ldoc_nde_idx_slt_t;
+
+typedef struct ldoc_nde_idx_t
+{
+    size_t cnt;
+    size_t msk;
+    ldoc_nde_idx_slt_t* slts;
+} ldoc_nde_idx_t;
+
+static inline void ldoc_nde_idx_drop(ldoc_nde_t* nde)
+{
+    if (!nde->idx)
+        return;
+    
+    free(nde->idx->slts);
+    free(nde->idx);
+    nde->idx = NULL;
+}
+
+static void ldoc_nde_idx_free_all(ldoc_nde_t* nde)
+{
+    ldoc_nde_idx_drop(nde);
+    
+    ldoc_nde_t* dsc;
+    TAILQ_FOREACH(dsc, &(nde->dscs), ldoc_nde_entries)
+        ldoc_nde_idx_free_all(dsc);
+}
+
+static inline void ldoc_nde_idx_put(ldoc_nde_idx_t* idx, uint64_t hsh, ldoc_info_t info, bool nde)
+{
+    size_t i = hsh & idx->msk;
+    
+    while (idx->slts[i].info.nde)
+        i = (i + 1) & idx->msk;
+    
+    idx->slts[i].hsh = hsh;
+    idx->slts[i].info = info;
+    idx->slts[i].nde = nde;
+    idx->cnt++;
+}
+
+// Makes room for one more entry, keeping the load factor at most one half:
+static inline bool ldoc_nde_idx_grow(ldoc_nde_idx_t* idx)
+{
+    if ((idx->cnt + 1) * 2 <= idx->msk + 1)
+        return true;
+    
+    size_t max = (idx->msk + 1) * 2;
+    ldoc_nde_idx_slt_t* slts = (ldoc_nde_idx_slt_t*)calloc(max, sizeof(ldoc_nde_idx_slt_t));
+    
+    if (!slts)
+        return false;
+    
+    ldoc_nde_idx_t cpy = { 0, max - 1, slts };
+    
+    // Re-inserting in slot order keeps equal annotations in insertion order:
+    for (size_t i = 0; i <= idx->msk; i++)
+    {
+        // Start at an empty slot, so that probe sequences are not split:
+        if (!idx->slts[i].info.nde)
+        {
+            for (size_t j = 1; j <= idx->msk + 1; j++)
+            {
+                ldoc_nde_idx_slt_t* slt = &(idx->slts[(i + j) & idx->msk]);
+                
+                if (slt->info.nde)
+                    ldoc_nde_idx_put(&cpy, slt->hsh, slt->info, slt->nde);
+            }
+            
+            break;
+        }
+    }
+    
+    free(idx->slts);
+    *idx = cpy;
+    
+    return true;
+}
+
+static inline bool ldoc_nde_idx_add(ldoc_nde_t* nde, const char* anno, size_t len, ldoc_info_t info, bool isnde)
+{
+    // Unannotated children cannot be found:
+    if (!anno)
+        return true;
+    
+    if (!ldoc_nde_idx_grow(nde->idx))
+    {
+        ldoc_nde_idx_drop(nde);
+        
+        return false;
+    }
+    
+    ldoc_nde_idx_put(nde->idx, ldoc_str_hsh(anno, len), info, isnde);
+    
+    return true;
+}
+
+static inline bool ldoc_nde_idx_ent(ldoc_nde_t* nde, ldoc_ent_t* ent)
+{
+    size_t len;
+    ldoc_info_t info;
+    
+    if (!ldoc_ent_pair(ent->tpe))
+        return true;
+    
+    const char* anno = ldoc_ent_anno_str(ent, &len);
+    
+    info.ent = ent;
+    
+    return ldoc_nde_idx_add(nde, anno, len, info, false);
+}
+
+static inline bool ldoc_nde_idx_dsc(ldoc_nde_t* nde, ldoc_nde_t* dsc)
+{
+    size_t len;
+    ldoc_info_t info;
+    
+    const char* anno = ldoc_nde_anno_str(dsc, &len);
+    
+    info.nde = dsc;
+    
+    return ldoc_nde_idx_add(nde, anno, len, info, true);
+}
+
+static bool ldoc_nde_idx_bld(ldoc_nde_t* nde)
+{
+    nde->idx = (ldoc_nde_idx_t*)malloc(sizeof(ldoc_nde_idx_t));
+    
+    if (!nde->idx)
+        return false;
+    
+    size_t max = 16;
+    
+    while (max < (size_t)(nde->ent_cnt + nde->dsc_cnt) * 2)
+        max *= 2;
+    
+    nde->idx->cnt = 0;
+    nde->idx->msk = max - 1;
+    nde->idx->slts = (ldoc_nde_idx_slt_t*)calloc(max, sizeof(ldoc_nde_idx_slt_t));
+    
+    if (!nde->idx->slts)
+    {
+        free(nde->idx);
+        nde->idx = NULL;
+        
+        return false;
+    }
+    
+    ldoc_ent_t* ent;
+    TAILQ_FOREACH(ent, &(nde->ents), ldoc_ent_entries)
+        if (!ldoc_nde_idx_ent(nde, ent))
+            return false;
+    
+    ldoc_nde_t* dsc;
+    TAILQ_FOREACH(dsc, &(nde->dscs), ldoc_nde_entries)
+        if (!ldoc_nde_idx_dsc(nde, dsc))
+            return false;
+    
+    return true;
+}
+
+static inline bool ldoc_nde_idx_wide(ldoc_nde_t* nde)
+{
+    return nde->ent_cnt + nde->dsc_cnt >= LDOC_NDE_IDX_MIN;
+}
+
+static bool ldoc_doc_index_nde(ldoc_nde_t* nde)
+{
+    if (!nde->idx && ldoc_nde_idx_wide(nde) && !ldoc_nde_idx_bld(nde))
+        return false;
+    
+    ldoc_nde_t* dsc;
+    TAILQ_FOREACH(dsc, &(nde->dscs), ldoc_nde_entries)
+        if (!ldoc_doc_index_nde(dsc))
+            return false;
+    
+    return true;
+}
+
+bool ldoc_doc_index(ldoc_doc_t* doc)
+{
+    doc->idx = true;
+    
+    return ldoc_doc_index_nde(doc->rt);
+}
+
+#pragma mark - Offset Indices
+
+static inline uint64_t ldoc_nde_ent_skip(ldoc_nde_t* nde, uint64_t off)
+{
+    ldoc_ent_t* ent;
+    size_t len;
+    char num[LDOC_NUM_LEN];
+    TAILQ_FOREACH(ent, &(nde->ents), ldoc_ent_entries)
+    {
+        // Entities without text (booleans, null values) take up no room:
+        if (ldoc_ent_dtm_fmt(ent, num, &len))
+            off += len;
+    }
+    
+    return off;
+}
+
+// Nodes in pre-order with the text lengths of their own entities, and a
+// Fenwick tree over these lengths (1-based), whose prefix sums are the
+// offsets at which the nodes' texts end:
+typedef struct ldoc_pos_idx_t
+{
+    size_t cnt;
+    size_t top;
+    ldoc_nde_t** ndes;
+    uint64_t* lens;
+    uint64_t* fen;
+} ldoc_pos_idx_t;
+
+static size_t ldoc_pos_idx_cnt(ldoc_nde_t* nde)
+{
+    size_t cnt = 1;
+    
+    ldoc_nde_t* dsc;
+    TAILQ_FOREACH(dsc, &(nde->dscs), ldoc_nde_entries)
+        cnt += ldoc_pos_idx_cnt(dsc);
+    
+    return cnt;
+}
+
+static void ldoc_pos_idx_fill(ldoc_pos_idx_t* pidx, ldoc_nde_t* nde, size_t* k)
+{
+    nde->pos = (uint32_t)*k;
+    pidx->ndes[*k] = nde;
+    pidx->lens[*k] = ldoc_nde_ent_skip(nde, 0);
+    (*k)++;
+    
+    ldoc_nde_t* dsc;
+    TAILQ_FOREACH(dsc, &(nde->dscs), ldoc_nde_entries)
+        ldoc_pos_idx_fill(pidx, dsc, k);
+}
+
+static void ldoc_pos_idx_free(ldoc_pos_idx_t* pidx)
+{
+    if (!pidx)
+        return;
+    
+    free(pidx->ndes);
+    free(pidx->lens);
+    free(pidx->fen);
+    free(pidx);
+}
+
+static ldoc_pos_idx_t* ldoc_pos_idx_new(ldoc_nde_t* rt)
+{
+    size_t cnt = ldoc_pos_idx_cnt(rt);
+    
+    // Node numbers have to fit into `ldoc_nde_t.pos`:
+    if (cnt >= UINT32_MAX)
+        return NULL;
+    
+    ldoc_pos_idx_t* pidx = (ldoc_pos_idx_t*)malloc(sizeof(ldoc_pos_idx_t));
+    
+    if (!pidx)
+        return NULL;
+    
+    pidx->cnt = cnt;
+    pidx->ndes = (ldoc_nde_t**)malloc(cnt * sizeof(ldoc_nde_t*));
+    pidx->lens = (uint64_t*)malloc(cnt * sizeof(uint64_t));
+    pidx->fen = (uint64_t*)malloc((cnt + 1) * sizeof(uint64_t));
+    
+    if (!pidx->ndes || !pidx->lens || !pidx->fen)
+    {
+        ldoc_pos_idx_free(pidx);
+        
+        return NULL;
+    }
+    
+    size_t k = 0;
+    ldoc_pos_idx_fill(pidx, rt, &k);
+    
+    // Linear construction: each entry adds itself to its parent range:
+    pidx->fen[0] = 0;
+    
+    for (size_t i = 1; i <= cnt; i++)
+        pidx->fen[i] = pidx->lens[i - 1];
+    
+    for (size_t i = 1; i <= cnt; i++)
+    {
+        size_t j = i + (i & -i);
+        
+        if (j <= cnt)
+            pidx->fen[j] += pidx->fen[i];
+    }
+    
+    for (pidx->top = 1; pidx->top * 2 <= cnt; pidx->top *= 2);
+    
+    return pidx;
+}
+
+void ldoc_doc_pos_drop(ldoc_doc_t* doc)
+{
+    ldoc_pos_idx_free(doc->pos);
+    doc->pos = NULL;
+}
+
+bool ldoc_doc_pos_index(ldoc_doc_t* doc)
+{
+    ldoc_doc_pos_drop(doc);
+    
+    doc->pos = ldoc_pos_idx_new(doc->rt);
+    
+    return doc->pos;
+}
+
+// Documents can change without their index noticing, so that an index is only
+// kept if it was asked for (see `ldoc_doc_pos_index`); otherwise, a temporary
+// index is built, which is released by `ldoc_pos_idx_rls`:
+static inline ldoc_pos_idx_t* ldoc_pos_idx_get(ldoc_doc_t* doc)
+{
+    return doc->pos ? doc->pos : ldoc_pos_idx_new(doc->rt);
+}
+
+static inline void ldoc_pos_idx_rls(ldoc_doc_t* doc, ldoc_pos_idx_t* pidx)
+{
+    if (pidx != doc->pos)
+        ldoc_pos_idx_free(pidx);
+}
+
+void ldoc_doc_pos_upd(ldoc_doc_t* doc, ldoc_nde_t* nde)
+{
+    ldoc_pos_idx_t* pidx = doc->pos;
+    
+    if (!pidx)
+        return;
+    
+    // A node that is not indexed changed the document's structure:
+    if (nde->pos >= pidx->cnt || pidx->ndes[nde->pos] != nde)
+    {
+        ldoc_doc_pos_drop(doc);
+        
+        return;
+    }
+    
+    size_t k = nde->pos;
+    uint64_t len = ldoc_nde_ent_skip(nde, 0);
+    
+    // Unsigned wrap-around adds negative differences as well:
+    uint64_t dlt = len - pidx->lens[k];
+    
+    pidx->lens[k] = len;
+    
+    for (size_t i = k + 1; i <= pidx->cnt; i += i & -i)
+        pidx->fen[i] += dlt;
+}
+
+// First node in pre-order whose text ends at or after `off` (`cnt` if
+// there is none); `rem` is set to the offset within that node:
+static inline size_t ldoc_pos_idx_k(ldoc_pos_idx_t* pidx, uint64_t off, uint64_t* rem)
+{
+    size_t k = 0;
+    
+    *rem = off;
+    
+    for (size_t b = pidx->top; b; b >>= 1)
+    {
+        if (k + b <= pidx->cnt && pidx->fen[k + b] < *rem)
+        {
+            k += b;
+            *rem -= pidx->fen[k];
+        }
+    }
+    
+    return k;
+}
+
+// Offset at which the text of node `k` begins:
+static inline uint64_t ldoc_pos_idx_off(ldoc_pos_idx_t* pidx, size_t k)
+{
+    uint64_t off = 0;
+    
+    for (; k; k -= k & -k)
+        off += pidx->fen[k];
+    
+    return off;
+}
+
+static ldoc_pos_t* ldoc_pos_idx_find(ldoc_pos_idx_t* pidx, uint64_t off)
+{
+    uint64_t rem;
+    size_t k = ldoc_pos_idx_k(pidx, off, &rem);
+    
+    if (k == pidx->cnt)
+        return LDOC_POS_NULL;
+    
+    return ldoc_pos_new(pidx->ndes[k], off - rem, rem);
+}
+
+#pragma mark - Serialization Utilities
+
+static inline void ldoc_ser_concat_str(ldoc_ser_t* ser1, ldoc_ser_t* ser2)
+{
+    size_t len2 = strlen(ser2->pld.str);
+    
+    // Nothing to concatenate:
+    if (!len2)
+        return;
+    
+    size_t len1 = strlen(ser1->pld.str);
+    size_t len = len1 + len2 + 1;
+    
+    ser1->pld.str = realloc(ser1->pld.str, len);
+    
+    strncat(ser1->pld.str, ser2->pld.str, len2);
+}
+
+#ifndef LDOC_NOPYTHON
+static inline void ldoc_ser_concat_py_str(ldoc_ser_t* ser1, ldoc_ser_t* ser2)
+{
+    PyObject* ccat = PyUnicode_Concat(ser1->pld.py.dtm, ser2->pld.py.dtm);
+    
+    Py_DECREF(ser1->pld.py.dtm);
+    Py_DECREF(ser2->pld.py.dtm);
+    
+    ser1->pld.py.dtm = ccat;
+}
+
+static inline void ldoc_ser_concat_py_dct(ldoc_ser_t* ser1, ldoc_ser_t* ser2)
+{
+    switch (ser2->tpe)
+    {
+        case LDOC_SER_PY_BL:
+        case LDOC_SER_PY_FLT:
+        case LDOC_SER_PY_STR:
+        case LDOC_SER_PY_DCT:
+        case LDOC_SER_PY_LST:
+            PyDict_SetItem(ser1->pld.py.dtm, ser2->pld.py.anno, ser2->pld.py.dtm);
+            break;
+        default:
+            // TODO Internal error.
+            break;
+    }
+}
+
+static inline void ldoc_ser_concat_py_lst(ldoc_ser_t* ser1, ldoc_ser_t* ser2)
+{
+    switch (ser2->tpe)
+    {
+        case LDOC_SER_PY_BL:
+        case LDOC_SER_PY_FLT:
+        case LDOC_SER_PY_STR:
+        case LDOC_SER_PY_DCT:
+        case LDOC_SER_PY_LST:
+            PyList_Append(ser1->pld.py.dtm, ser2->pld.py.dtm);
+            break;
+        default:
+            // TODO Internal error.
+            break;
+    }
+}
+#endif // #ifndef LDOC_NOPYTHON
+
+void ldoc_ser_concat(ldoc_ser_t* ser1, ldoc_ser_t* ser2)
+{
+    // Nothing to concatenate:
+    if (ser2 == LDOC_SER_NULL)
+        return;
+    
+    // TODO Only strings supported right now.
+    
+    switch (ser1->tpe)
+    {
+#ifndef LDOC_NOPYTHON
+        case LDOC_SER_PY_BL:
+        case LDOC_SER_PY_FLT:
+        case LDOC_SER_PY_INT:
+            // Things that cannot be concatenated.
+            
+            // TODO Internal error.
+            
+            break;
+        case LDOC_SER_PY_STR:
+            if (ser2->tpe == LDOC_SER_PY_STR)
+                ldoc_ser_concat_py_str(ser1, ser2);
+            else
+            {
+                // TODO Internal error. Second object is not a string.
+            }
+        case LDOC_SER_PY_DCT:
+            ldoc_ser_concat_py_dct(ser1, ser2);
+            break;
+        case LDOC_SER_PY_LST:
+            ldoc_ser_concat_py_lst(ser1, ser2);
+            break;
+#endif // #ifndef LDOC_NOPYTHON
+        case LDOC_SER_CSTR:
+            return ldoc_ser_concat_str(ser1, ser2);
+        default:
+            break;
+    }
+}
+
+#pragma mark - Sinks
+
+static inline ldoc_snk_t* ldoc_snk_new_(size_t max)
+{
+    ldoc_snk_t* snk = (ldoc_snk_t*)malloc(sizeof(ldoc_snk_t));
+    
+    if (!snk)
+        return NULL;
+    
+    snk->init = max ? max : (size_t)getpagesize();
+    snk->max = snk->init;
+    snk->buf = (char*)malloc(snk->max);
+    
+    if (!snk->buf)
+    {
+        free(snk);
+        
+        return NULL;
+    }
+    
+    snk->buf[0] = 0;
+    snk->len = 0;
+    snk->wrt = NULL;
+    snk->ctx = NULL;
+    snk->tot = 0;
+    snk->err = false;
+    
+    return snk;
+}
+
+ldoc_snk_t* ldoc_snk_new(size_t max)
+{
+    return ldoc_snk_new_(max);
+}
+
+ldoc_snk_t* ldoc_snk_new_wrt(bool (*wrt)(void* ctx, const char* str, size_t len), void* ctx, size_t max)
+{
+    ldoc_snk_t* snk = ldoc_snk_new_(max);
+    
+    if (!snk)
+        return NULL;
+    
+    snk->wrt = wrt;
+    snk->ctx = ctx;
+    
+    return snk;
+}
+
+void ldoc_snk_free(ldoc_snk_t* snk)
+{
+    if (!snk)
+        return;
+    
+    free(snk->buf);
+    free(snk);
+}
+
+bool ldoc_snk_flsh(ldoc_snk_t* snk)
+{
+    if (snk->err)
+        return false;
+    
+    if (!snk->wrt || !snk->len)
+        return true;
+    
+    if (!snk->wrt(snk->ctx, snk->buf, snk->len))
+        snk->err = true;
+    
+    snk->len = 0;
+    
+    if (snk->buf)
+        snk->buf[0] = 0;
+    
+    return !snk->err;
+}
+
+void ldoc_snk_appnd(ldoc_snk_t* snk, const char* str, size_t len)
+{
+    if (snk->err || !len)
+        return;
+    
+    snk->tot += len;
+    
+    // The buffer was taken; start over with a fresh one:
+    if (!snk->buf)
+    {
+        snk->max = snk->init;
+        snk->buf = (char*)malloc(snk->max);
+        
+        if (!snk->buf)
+        {
+            snk->err = true;
+            snk->max = 0;
+            
+            return;
+        }
+    }
+    
+    // Buffer would overflow: either make room by writing out the buffer, or grow it:
+    if (snk->len + len + 1 > snk->max)
+    {
+        if (snk->wrt)
+        {
+            if (!ldoc_snk_flsh(snk))
+                return;
+            
+            // Fragments that exceed the buffer are written out directly:
+            if (len + 1 > snk->max)
+            {
+                if (!snk->wrt(snk->ctx, str, len))
+                    snk->err = true;
+                
+                return;
+            }
+        }
+        else
+        {
+            size_t max = snk->max;
+            
+            // Double each time round:
+            while (snk->len + len + 1 > max)
+                max *= 2;
+            
+            char* buf = (char*)realloc(snk->buf, max);
+            
+            if (!buf)
+            {
+                snk->err = true;
+                
+                return;
+            }
+            
+            snk->buf = buf;
+            snk->max = max;
+        }
+    }
+    
+    memcpy(snk->buf + snk->len, str, len);
+    snk->len += len;
+    snk->buf[snk->len] = 0;
+}
+
+char* ldoc_snk_take(ldoc_snk_t* snk)
+{
+    if (snk->err)
+        return NULL;
+    
+    // Nothing was appended since the buffer was last taken:
+    if (!snk->buf)
+    {
+        char* str = (char*)malloc(1);
+        
+        if (!str)
+            snk->err = true;
+        else
+            str[0] = 0;
+        
+        return str;
+    }
+    
+    char* str = snk->buf;
+    
+    // Hand out the buffer itself; a new one is only allocated on the next append:
+    snk->buf = NULL;
+    snk->len = 0;
+    snk->max = 0;
+    
+    return str;
+}
+
+static inline void ldoc_snk_ser(ldoc_snk_t* snk, ldoc_ser_t* ser)
+{
+    // Nothing to append:
+    if (ser == LDOC_SER_NULL)
+        return;
+    
+    if (ser->tpe != LDOC_SER_CSTR)
+    {
+        // Only strings can be streamed:
+        snk->err = true;
+    }
+    else if (ser->pld.str)
+        ldoc_snk_appnd(snk, ser->pld.str, strlen(ser->pld.str));
+    
+    ldoc_ser_free(ser);
+}
+
+ldoc_pos_t* ldoc_pos_new(ldoc_nde_t* nde, uint64_t nde_off, uint64_t off)
+{
+    ldoc_pos_t* pos = (ldoc_pos_t*)malloc(sizeof(ldoc_pos_t));
+    
+    if (!pos)
+    {
+        // TODO
+    }
+    
+    pos->nde = nde;
+    pos->nde_off = nde_off;
+    pos->off = off;
+    
+    return pos;
+}
+
+void ldoc_pos_free(ldoc_pos_t* pos)
+{
+    free(pos);
+}
+
+ldoc_doc_t* ldoc_doc_new()
+{
+    ldoc_doc_t* doc = (ldoc_doc_t*)malloc(sizeof(ldoc_doc_t));
+    
+    if (!doc)
+    {
+        // TODO Error.
+    }
+    
+    ldoc_nde_t* rt = ldoc_nde_new_(LDOC_NDE_RT);
+    
+    if (!rt)
+    {
+        free(doc);
+        // TODO Error.
+    }
+    
+    doc->rt = rt;
+    doc->arna = NULL;
+    doc->map = NULL;
+    doc->map_len = 0;
+    doc->idx = false;
+    doc->intn = NULL;
+    doc->pos = NULL;
+    
+    return doc;
+}
+
+ldoc_doc_t* ldoc_doc_new_arena(size_t hnt)
+{
+    ldoc_arna_t* arna = ldoc_arna_new(hnt);
+    
+    if (!arna)
+        return LDOC_DOC_NULL;
+    
+    // The document itself lives in the arena too:
+    ldoc_doc_t* doc = (ldoc_doc_t*)ldoc_arna_alloc(arna, sizeof(ldoc_doc_t));
+    ldoc_nde_t* rt = ldoc_nde_init((ldoc_nde_t*)ldoc_arna_alloc(arna, sizeof(ldoc_nde_t)), LDOC_NDE_RT);
+    
+    if (!doc || !rt)
+    {
+        ldoc_arna_free(arna);
+        
+        return LDOC_DOC_NULL;
+    }
+    
+    doc->rt = rt;
+    doc->arna = arna;
+    doc->map = NULL;
+    doc->map_len = 0;
+    doc->idx = false;
+    doc->intn = NULL;
+    doc->pos = NULL;
+    
+    return doc;
+}
+
+void ldoc_doc_free(ldoc_doc_t* doc)
+{
+    ldoc_doc_pos_drop(doc);
+    
+    // The document may live in its arena:
+    if (doc->map)
+        munmap(doc->map, doc->map_len);
+    
+    if (doc->arna)
+    {
+        // Indices are not arena allocated, since they grow and get dropped:
+        if (doc->idx)
+            ldoc_nde_idx_free_all(doc->rt);
+        
+        ldoc_arna_free(doc->arna);
+        
+        return;
+    }
+    
+    ldoc_nde_free(doc->rt);
+    
+    free(doc);
+}
+
+ldoc_vis_nde_ord_t* ldoc_vis_nde_ord_new()
+{
+    ldoc_vis_nde_ord_t* vis = (ldoc_vis_nde_ord_t*)malloc(sizeof(ldoc_vis_nde_ord_t));
+    
+    if (!vis)
+    {
+        // TODO.
+    }
+    
+    // Assign NULL pointers to all callbacks:
+    memset(vis, 0, sizeof(ldoc_vis_nde_ord_t));
+    
+    return vis;
+}
+
+void ldoc_vis_nde_ord_free(ldoc_vis_nde_ord_t* vis_nde)
+{
+    free(vis_nde);
+}
+
+ldoc_vis_ent_t* ldoc_vis_ent_new()
+{
+    ldoc_vis_ent_t* vis = (ldoc_vis_ent_t*)malloc(sizeof(ldoc_vis_ent_t));
+    
+    if (!vis)
+    {
+        // TODO.
+    }
+    
+    // Assign NULL pointers to all callbacks:
+    memset(vis, 0, sizeof(ldoc_vis_ent_t));
+    
+    return vis;
+}
+
+void ldoc_vis_ent_free(ldoc_vis_ent_t* vis_ent)
+{
+    free(vis_ent);
+}
+
+void ldoc_vis_nde_uni(ldoc_vis_nde_t* vis, ldoc_ser_t* (*vis_uni)(ldoc_nde_t* nde, ldoc_coord_t* coord))
+{
+    vis->vis_anc = vis_uni;
+    vis->vis_h1 = vis_uni;
     vis->vis_h2 = vis_uni;
     vis->vis_h3 = vis_uni;
     vis->vis_h4 = vis_uni;
@@ -607,44 +2046,1040 @@ void ldoc_vis_nde_uni(ldoc_vis_nde_t* vis, ldoc_ser_t* (*vis_uni)(ldoc_nde_t* nd
 }
 
 
-void ldoc_vis_ent_uni(ldoc_vis_ent_t* vis, ldoc_ser_t* (*vis_uni)(ldoc_nde_t* nde, ldoc_ent_t* ent, ldoc_coord_t* coord))
+void ldoc_vis_ent_uni(ldoc_vis_ent_t* vis, ldoc_ser_t* (*vis_uni)(ldoc_nde_t* nde, ldoc_ent_t* ent, ldoc_coord_t* coord))
+{
+    vis->vis_bl = vis_uni;
+    vis->vis_br = vis_uni;
+    vis->vis_em1 = vis_uni;
+    vis->vis_em2 = vis_uni;
+    vis->vis_num = vis_uni;
+    vis->vis_nr = vis_uni;
+    vis->vis_or = vis_uni;
+    vis->vis_ref = vis_uni;
+    vis->vis_txt = vis_uni;
+    vis->vis_uri = vis_uni;
+}
+
+static inline ldoc_ser_t* ldoc_vis_ent(ldoc_nde_t* nde, ldoc_ent_t* ent, ldoc_coord_t* coord, ldoc_vis_ent_t* vis)
+{
+    switch (ent->tpe)
+    {
+        case LDOC_ENT_BL:
+            return vis->vis_bl(nde, ent, coord);
+        case LDOC_ENT_BR:
+            return vis->vis_br(nde, ent, coord);
+        case LDOC_ENT_EM1:
+            return vis->vis_em1(nde, ent, coord);
+        case LDOC_ENT_EM2:
+            return vis->vis_em2(nde, ent, coord);
+        case LDOC_ENT_NUM:
+            return vis->vis_num(nde, ent, coord);
+        case LDOC_ENT_NR:
+            return vis->vis_nr(nde, ent, coord);
+        case LDOC_ENT_OR:
+            return vis->vis_or(nde, ent, coord);
+        case LDOC_ENT_REF:
+            return vis->vis_ref(nde, ent, coord);
+        case LDOC_ENT_TXT:
+            return vis->vis_txt(nde, ent, coord);
+        case LDOC_ENT_URI:
+            return vis->vis_uri(nde, ent, coord);
+        default:
+            // TODO Error.
+            break;
+    }
+    
+    return LDOC_SER_NULL;
+}
+
+char* ldoc_qry_ent_fst(ldoc_nde_t* nde)
+{
+    if (!nde->ent_cnt)
+    {
+        // TODO Error.
+    }
+    
+    ldoc_ent_t* ent = TAILQ_FIRST(&(nde->ents));
+    size_t str_len;
+    char num[LDOC_NUM_LEN];
+    const char* ent_str = ldoc_ent_dtm_fmt(ent, num, &str_len);
+    char* str = (char*)malloc(str_len + 1);
+    strncpy(str, ent_str, str_len);
+    str[str_len] = 0;
+    
+    if (!str)
+    {
+        // TODO Error.
+    }
+    
+    return str;
+}
+
+char* ldoc_qry_ent_unq(ldoc_nde_t* nde)
+{
+    if (nde->ent_cnt != 1)
+    {
+        // TODO Error.
+    }
+
+    return ldoc_qry_ent_fst(nde);
+}
+
+char* ldoc_cnv_ent_html(ldoc_ent_t* ent)
+{
+    char* html;
+    size_t html_len;
+    size_t str_len;
+    char num[LDOC_NUM_LEN];
+    const char* str = ldoc_ent_dtm_fmt(ent, num, &str_len);
+    
+    switch (ent->tpe) {
+        case LDOC_ENT_BL:
+            // TODO
+            break;
+        case LDOC_ENT_BR:
+            // TODO
+            break;
+        case LDOC_ENT_EM1:
+            html_len = strlen(ldoc_cnst_html_em1_opn) + str_len + strlen(ldoc_cnst_html_em1_cls) + 1;
+            html = (char*)malloc(html_len + 1);
+            snprintf(html, html_len, "%s%.*s%s", ldoc_cnst_html_em1_opn, (int)str_len, str, ldoc_cnst_html_em1_cls);
+            return html;
+        case LDOC_ENT_EM2:
+            html_len = strlen(ldoc_cnst_html_em2_opn) + str_len + strlen(ldoc_cnst_html_em2_cls) + 1;
+            html = (char*)malloc(html_len + 1);
+            snprintf(html, html_len, "%s%.*s%s", ldoc_cnst_html_em2_opn, (int)str_len, str, ldoc_cnst_html_em2_cls);
+            return html;
+        case LDOC_ENT_NR:
+            // TODO
+            break;
+        case LDOC_ENT_OR:
+            // TODO
+            break;
+        case LDOC_ENT_REF:
+            // TODO
+            break;
+        case LDOC_ENT_NUM:
+        case LDOC_ENT_TXT:
+            html_len = str_len;
+            html = (char*)malloc(html_len + 1);
+            strncpy(html, str, html_len);
+            html[html_len] = 0;
+            return html;
+        case LDOC_ENT_URI:
+            // TODO
+            break;
+        default:
+            // TODO Error.
+            break;
+    }
+    
+    // Note; Hardly optimal, but currently no idea how to
+    //       implement it better.
+    html = (char*)calloc(1, 1);
+    
+    return html;
+}
+
+char* ldoc_cnv_nde_html_opn(ldoc_nde_t* nde)
+{
+    char* pld;
+    char* html;
+    size_t html_len;
+    
+    switch (nde->tpe) {
+        case LDOC_NDE_ANC:
+            pld = ldoc_qry_ent_unq(nde);
+            html_len = 15 + strlen(pld) + 1;
+            html = (char*)malloc(html_len + 1);
+            snprintf(html, html_len, "<a name=\"%s\"></a>", pld);
+            free(pld);
+            return html;
+        case LDOC_NDE_H1:
+            html_len = strlen(ldoc_cnst_html_h1_opn);
+            html = (char*)malloc(html_len + 1);
+            strcpy(html, ldoc_cnst_html_h1_opn);
+            return html;
+        case LDOC_NDE_H2:
+            html_len = strlen(ldoc_cnst_html_h2_opn);
+            html = (char*)malloc(html_len + 1);
+            strcpy(html, ldoc_cnst_html_h2_opn);
+            return html;
+        case LDOC_NDE_H3:
+            html_len = strlen(ldoc_cnst_html_h3_opn);
+            html = (char*)malloc(html_len + 1);
+            strcpy(html, ldoc_cnst_html_h3_opn);
+            return html;
+        case LDOC_NDE_H4:
+            html_len = strlen(ldoc_cnst_html_h4_opn);
+            html = (char*)malloc(html_len + 1);
+            strcpy(html, ldoc_cnst_html_h4_opn);
+            return html;
+        case LDOC_NDE_H5:
+            html_len = strlen(ldoc_cnst_html_h5_opn);
+            html = (char*)malloc(html_len + 1);
+            strcpy(html, ldoc_cnst_html_h5_opn);
+            return html;
+        case LDOC_NDE_H6:
+            html_len = strlen(ldoc_cnst_html_h6_opn);
+            html = (char*)malloc(html_len + 1);
+            strcpy(html, ldoc_cnst_html_h6_opn);
+            return html;
+        case LDOC_NDE_NN:
+            break;
+        case LDOC_NDE_OL:
+            break;
+        case LDOC_NDE_OO:
+            break;
+        case LDOC_NDE_PAR:
+            html_len = strlen(ldoc_cnst_html_par_opn);
+            html = (char*)malloc(html_len + 1);
+            strcpy(html, ldoc_cnst_html_par_opn);
+            return html;
+        case LDOC_NDE_RT:
+            break;
+        case LDOC_NDE_UA:
+            break;
+        case LDOC_NDE_UL:
+            break;
+        default:
+            // TODO Error.
+            break;
+    }
+    
+    // Note; Hardly optimal, but currently no idea how to
+    //       implement it better.
+    html = (char*)calloc(1, 1);
+    
+    return html;
+}
+
+char* ldoc_cnv_nde_html_cls(ldoc_nde_t* nde)
+{
+    char* html;
+    size_t html_len;
+    
+    switch (nde->tpe) {
+        case LDOC_NDE_ANC:
+            break;
+        case LDOC_NDE_H1:
+            html_len = strlen(ldoc_cnst_html_h1_cls);
+            html = (char*)malloc(html_len + 1);
+            strcpy(html, ldoc_cnst_html_h1_cls);
+            return html;
+        case LDOC_NDE_H2:
+            html_len = strlen(ldoc_cnst_html_h2_cls);
+            html = (char*)malloc(html_len + 1);
+            strcpy(html, ldoc_cnst_html_h2_cls);
+            return html;
+        case LDOC_NDE_H3:
+            html_len = strlen(ldoc_cnst_html_h3_cls);
+            html = (char*)malloc(html_len + 1);
+            strcpy(html, ldoc_cnst_html_h3_cls);
+            return html;
+        case LDOC_NDE_H4:
+            html_len = strlen(ldoc_cnst_html_h4_cls);
+            html = (char*)malloc(html_len + 1);
+            strcpy(html, ldoc_cnst_html_h4_cls);
+            return html;
+        case LDOC_NDE_H5:
+            html_len = strlen(ldoc_cnst_html_h5_cls);
+            html = (char*)malloc(html_len + 1);
+            strcpy(html, ldoc_cnst_html_h5_cls);
+            return html;
+        case LDOC_NDE_H6:
+            html_len = strlen(ldoc_cnst_html_h6_cls);
+            html = (char*)malloc(html_len + 1);
+            strcpy(html, ldoc_cnst_html_h6_cls);
+            return html;
+        case LDOC_NDE_NN:
+            break;
+        case LDOC_NDE_OL:
+            break;
+        case LDOC_NDE_OO:
+            break;
+        case LDOC_NDE_PAR:
+            html_len = strlen(ldoc_cnst_html_par_cls);
+            html = (char*)malloc(html_len + 1);
+            strcpy(html, ldoc_cnst_html_par_cls);
+            return html;
+        case LDOC_NDE_UA:
+            break;
+        case LDOC_NDE_UL:
+            break;
+        default:
+            // TODO Error.
+            break;
+    }
+    
+    // Note; Hardly optimal, but currently no idea how to
+    //       implement it better.
+    html = (char*)calloc(1, 1);
+    
+    return html;
+}
+
+static inline void ldoc_strcat(ldoc_ser_t* ser, char* s1)
+{
+    size_t len1;
+    
+    if (!s1)
+        len1 = 0;
+    else
+        len1 = strlen(s1);
+    
+    ser->pld.str = (char*)malloc(len1 + 1);
+    
+    // If you do not know why the next line needs to be there, then
+    // you have not read the man page of strncpy.
+    ser->pld.str[len1] = 0;
+    
+    if (len1)
+        strncpy(ser->pld.str, s1, len1);
+}
+
+static inline void ldoc_strcat2(ldoc_ser_t* ser, char* s1, char* s2)
+{
+    size_t len1 = strlen(s1);
+    size_t len2 = strlen(s2);
+
+    ser->pld.str = (char*)malloc(len1 + len2 + 1);
+    
+    // If you do not know why the next line needs to be there, then
+    // you have not read the man page of strncpy.
+    ser->pld.str[len1] = 0;
+    strncpy(ser->pld.str, s1, len1);
+    strncat(ser->pld.str, s2, len2);
+}
+
+static inline void ldoc_strcat3(ldoc_ser_t* ser, char* s1, char* s2, char* s3)
+{
+    size_t len1 = strlen(s1);
+    size_t len2 = strlen(s2);
+    size_t len3 = strlen(s3);
+    ser->pld.str = (char*)malloc(len1 + len2 + len3 + 1);
+
+    // If you do not know why the next line needs to be there, then
+    // you have not read the man page of strncpy.
+    ser->pld.str[len1] = 0;
+    strncpy(ser->pld.str, s1, len1);
+    strncat(ser->pld.str, s2, len2);
+    strncat(ser->pld.str, s3, len3);
+}
+
+#pragma mark - HTML Formatting
+
+ldoc_ser_t* ldoc_vis_ent_html(ldoc_nde_t* nde, ldoc_ent_t* ent, ldoc_coord_t* coord)
+{
+    // TODO Only strings supported right now.
+    ldoc_ser_t* ser = ldoc_ser_new(LDOC_SER_CSTR);
+    ser->pld.str = ldoc_cnv_ent_html(ent);
+    
+    return ser;
+}
+
+ldoc_ser_t* ldoc_vis_setup_html(void)
+{
+    ldoc_ser_t* ser = ldoc_ser_new(LDOC_SER_CSTR);
+    
+    ser->pld.str = (char*)malloc(strlen(ldoc_cnst_html_doc_opn) + 1);
+    strcpy(ser->pld.str, ldoc_cnst_html_doc_opn);
+    
+    return ser;
+}
+
+ldoc_ser_t* ldoc_vis_teardown_html(void)
+{
+    ldoc_ser_t* ser = ldoc_ser_new(LDOC_SER_CSTR);
+    
+    ser->pld.str = (char*)malloc(strlen(ldoc_cnst_html_doc_cls) + 1);
+    strcpy(ser->pld.str, ldoc_cnst_html_doc_cls);
+    
+    return ser;
+}
+
+ldoc_ser_t* ldoc_vis_nde_pre_html(ldoc_nde_t* nde, ldoc_coord_t* coord)
+{
+    size_t idnt_len = coord->lvl ? 2 * (coord->lvl) + 2 : 0;
+    char* idnt = (char*)malloc(idnt_len + 1);
+    
+    memset(idnt, ' ', idnt_len);
+    idnt[idnt_len] = 0;
+    
+    char* html = ldoc_cnv_nde_html_opn(nde);
+    
+    ldoc_ser_t* ser = ldoc_ser_new(LDOC_SER_CSTR);
+    ldoc_strcat2(ser, idnt, html);
+    
+    return ser;
+}
+
+static ldoc_ser_t* ldoc_vis_nde_cls_html(ldoc_nde_t* nde, ldoc_coord_t* coord, bool indent)
+{
+    char* idnt = NULL;
+    if (indent)
+    {
+        size_t idnt_len = coord->lvl ? 2 * (coord->lvl) + 2 : 0;
+        char* idnt = (char*)malloc(idnt_len + 1);
+        memset(idnt, ' ', idnt_len);
+        idnt[idnt_len] = 0;
+    }
+    
+    char* html = ldoc_cnv_nde_html_cls(nde);
+    
+    ldoc_ser_t* ser = ldoc_ser_new(LDOC_SER_CSTR);
+    
+    if (idnt)
+        ldoc_strcat2(ser, idnt, html);
+    else
+        ldoc_strcat(ser, html);
+    
+    return ser;
+}
+
+ldoc_ser_t* ldoc_vis_nde_infx_html(ldoc_nde_t* nde, ldoc_coord_t* coord)
+{
+    switch (nde->tpe) {
+        case LDOC_NDE_PAR:
+            // Will be handled in post call.
+            return LDOC_SER_NULL;
+        default:
+            // Fall through for all other cases.
+            break;
+    }
+    
+    return ldoc_vis_nde_cls_html(nde, coord, false);
+}
+
+ldoc_ser_t* ldoc_vis_nde_post_html(ldoc_nde_t* nde, ldoc_coord_t* coord)
+{
+    switch (nde->tpe) {
+        case LDOC_NDE_H1:
+        case LDOC_NDE_H2:
+        case LDOC_NDE_H3:
+        case LDOC_NDE_H4:
+        case LDOC_NDE_H5:
+        case LDOC_NDE_H6:
+            // Already closed in infix call.
+            return LDOC_SER_NULL;
+        default:
+            // Fall through for all other cases.
+            break;
+    }
+    
+    return ldoc_vis_nde_cls_html(nde, coord, true);
+}
+
+#pragma mark - JSON Formatting
+
+ldoc_ser_t* ldoc_vis_setup_json(void)
+{
+    ldoc_ser_t* ser = ldoc_ser_new(LDOC_SER_CSTR);
+    
+    ser->pld.str = (char*)malloc(strlen(ldoc_cnst_json_opn) + 1);
+    strcpy(ser->pld.str, ldoc_cnst_json_opn);
+    
+    return ser;
+}
+
+ldoc_ser_t* ldoc_vis_teardown_json(void)
+{
+    ldoc_ser_t* ser = ldoc_ser_new(LDOC_SER_CSTR);
+    
+    ser->pld.str = (char*)malloc(strlen(ldoc_cnst_json_cls) + 1);
+    strcpy(ser->pld.str, ldoc_cnst_json_cls);
+    
+    return ser;
+}
+
+ldoc_ser_t* ldoc_vis_nde_pre_json(ldoc_nde_t* nde, ldoc_coord_t* coord)
+{
+    ldoc_ser_t* ser;
+    
+    if (!coord->lvl)
+    {
+        ser = ldoc_ser_new(LDOC_SER_CSTR);
+        
+        // TODO Error handling.
+        
+        ser->pld.str = (char*)calloc(1, 1);
+        
+        // TODO Error handling.
+        
+        return ser;
+    }
+    
+    char sep[2];
+    
+    if (coord->pln > 0 || nde->prnt->ent_cnt)
+    {
+        sep[0] = ',';
+        sep[1] = 0;
+    }
+    else
+    {
+        sep[0] = 0;
+    }
+    
+    size_t lbl_len;
+    char* lbl;
+    const char* anno = ldoc_nde_anno_str(nde, &lbl_len);
+    
+    if (nde->prnt->tpe == LDOC_NDE_OL)
+        lbl = calloc(1, 1);
+    else if (anno != NULL)
+    {
+        lbl = strndup(anno, lbl_len);
+    }
+    else
+    {
+        size_t lbl_len = strlen(ldoc_cnst_json_nde) + 17;
+        lbl = (char*)malloc(lbl_len + 1);
+        snprintf(lbl, lbl_len, "%s-%llx", ldoc_cnst_json_nde, (unsigned long long)nde);
+    }
+    
+    const char* opn;
+    if (nde->tpe == LDOC_NDE_OL)
+        opn = ldoc_cnst_json_lopn;
+    else
+        opn = ldoc_cnst_json_opn;
+    
+    ser = ldoc_ser_new(LDOC_SER_CSTR);
+    size_t ser_len = strlen(lbl) + 5 + 1;
+    
+    //if (nde->prnt->tpe == LDOC_NDE_OL)
+    //    ser_len++;
+    
+    ser->pld.str = (char*)malloc(ser_len + 1);
+    
+    // TODO Error handling.
+    
+    // If we are in an ordered list, then do not include a node's label:
+    if (nde->prnt->tpe == LDOC_NDE_OL)
+        snprintf(ser->pld.str, ser_len, "%s%s", sep, opn);
+    else
+        snprintf(ser->pld.str, ser_len, "%s\"%s\":%s", sep, lbl, opn);
+    
+    free(lbl);
+    
+    return ser;
+}
+
+ldoc_ser_t* ldoc_vis_nde_infx_json(ldoc_nde_t* nde, ldoc_coord_t* coord)
+{
+    return LDOC_SER_NULL;
+}
+
+ldoc_ser_t* ldoc_vis_nde_post_json(ldoc_nde_t* nde, ldoc_coord_t* coord)
+{
+    char* json;
+    
+    if (!coord->lvl)
+    {
+        json = (char*)calloc(1, 1);
+    }
+    else if (nde->tpe == LDOC_NDE_OL)
+    {
+        json = strdup(ldoc_cnst_json_lcls);
+    }
+    else
+    {
+        json = strdup(ldoc_cnst_json_cls);
+    }
+    
+    ldoc_ser_t* ser = ldoc_ser_new(LDOC_SER_CSTR);
+    
+    if (nde->prnt && nde->prnt->tpe == LDOC_NDE_OL)
+    {
+        size_t clen = strlen(json) + 1;
+        ser->pld.str = (char*)malloc(clen + 1);
+        
+        // TODO Error handling.
+        
+        snprintf(ser->pld.str, clen, "%s", json);
+        
+        free(json);
+    }
+    else
+        ser->pld.str = json;
+    
+    return ser;
+}
+
+char* ldoc_vis_ent_json_val(ldoc_ent_t* ent, ldoc_coord_t* coord, size_t* len)
+{
+    size_t val_len;
+    char* val;
+    size_t str_len = 0;
+    char num[LDOC_NUM_LEN];
+    const char* str = ldoc_ent_dtm_fmt(ent, num, &str_len);
+    
+    // Note that LDOC_ENT_BR is not in this list: ent->pld.pair.dtm.bl is always either true/false!
+    if (ent->tpe != LDOC_ENT_BR &&
+        ent->tpe != LDOC_ENT_BL &&
+        !str)
+    {
+        val_len = strlen(ldoc_cnst_json_null);
+        val = strdup(ldoc_cnst_json_null);
+    }
+    else
+        // TODO Check why val_len is one larger than required (???) some times.
+        switch (ent->tpe)
+        {
+            case LDOC_ENT_BL:
+                if (ent->pld.bl)
+                    val = strdup(ldoc_cnst_json_true);
+                else
+                    val = strdup(ldoc_cnst_json_false);
+                val_len = strlen(val);
+                break;
+            case LDOC_ENT_BR:
+                if (ent->pld.pair.dtm.bl)
+                    val = strdup(ldoc_cnst_json_true);
+                else
+                    val = strdup(ldoc_cnst_json_false);
+                val_len = strlen(val);
+                break;
+            case LDOC_ENT_NUM:
+                val_len = str_len;
+                val = strndup(str, str_len);
+                break;
+            case LDOC_ENT_NR:
+                val_len = str_len + 1;
+                val = strndup(str, str_len);
+                break;
+            default:
+                val_len = str_len + 3;
+                val = (char*)malloc(val_len + 1);
+                snprintf(val, val_len, "\"%.*s\"", (int)str_len, str);
+                break;
+        }
+    
+    if (!val)
+    {
+        // TODO Error handling.
+        *len = 0;
+    }
+    
+    *len = val_len;
+    
+    return val;
+}
+
+ldoc_ser_t* ldoc_vis_ent_json(ldoc_nde_t* nde, ldoc_ent_t* ent, ldoc_coord_t* coord)
+{
+    size_t json_len;
+    char* json = ldoc_vis_ent_json_val(ent, coord, &json_len);
+    
+    ldoc_ser_t* ser = ldoc_ser_new(LDOC_SER_CSTR);
+    
+    if (!ser)
+    {
+        // TODO Error handling.
+    }
+    
+    size_t lbl_len = 0;
+    char* lbl = NULL;
+    size_t anno_len;
+    const char* anno;
+    if (nde->tpe == LDOC_NDE_OL)
+        switch (ent->tpe)
+        {
+            case LDOC_ENT_BR:
+            case LDOC_ENT_NR:
+            case LDOC_ENT_OR:
+                anno = ldoc_ent_anno_str(ent, &anno_len);
+                lbl_len = anno_len + json_len + 6;
+                lbl = (char*)malloc(lbl_len + 1);
+                // TODO Error handling.
+                snprintf(lbl, lbl_len, "{\"%.*s\":%s}", (int)anno_len, anno, json);
+                free(json);
+                json_len = 0;
+                json = NULL;
+                break;
+            default:
+                break;
+        }
+    else
+        switch (ent->tpe)
+        {
+            case LDOC_ENT_BL:
+                lbl_len = strlen(ldoc_cnst_json_bl) + 5 + 1;
+                lbl = (char*)malloc(lbl_len);
+                // TODO Error handling.
+                snprintf(lbl, lbl_len, "\"%s-%llx\":", ldoc_cnst_json_bl, (unsigned long long)ent);
+                break;
+            case LDOC_ENT_EM1:
+                lbl_len = strlen(ldoc_cnst_json_em1) + 20 + 1;
+                lbl = (char*)malloc(lbl_len);
+                // TODO Error handling.
+                snprintf(lbl, lbl_len, "\"%s-%llx\":", ldoc_cnst_json_em1, (unsigned long long)ent);
+                break;
+            case LDOC_ENT_EM2:
+                lbl_len = strlen(ldoc_cnst_json_em2) + 20 + 1;
+                lbl = (char*)malloc(lbl_len);
+                // TODO Error handling.
+                snprintf(lbl, lbl_len, "\"%s-%llx\":", ldoc_cnst_json_em2, (unsigned long long)ent);
+                break;
+            case LDOC_ENT_NUM:
+                lbl_len = strlen(ldoc_cnst_json_num) + 20 + 1;
+                lbl = (char*)malloc(lbl_len);
+                // TODO Error handling.
+                snprintf(lbl, lbl_len, "\"%s-%llx\":", ldoc_cnst_json_num, (unsigned long long)ent);
+                break;
+            case LDOC_ENT_BR:
+            case LDOC_ENT_NR:
+            case LDOC_ENT_OR:
+                anno = ldoc_ent_anno_str(ent, &anno_len);
+                lbl_len = anno_len + 4;
+                lbl = (char*)malloc(lbl_len + 1);
+                // TODO Error handling.
+                snprintf(lbl, lbl_len, "\"%.*s\":", (int)anno_len, anno);
+                break;
+            case LDOC_ENT_REF:
+                // TODO
+                break;
+            case LDOC_ENT_TXT:
+                lbl_len = strlen(ldoc_cnst_json_txt) + 21;
+                lbl = (char*)malloc(lbl_len + 1);
+                // TODO Error handling.
+                snprintf(lbl, lbl_len, "\"%s-%llx\":", ldoc_cnst_json_txt, (unsigned long long)ent);
+                break;
+            case LDOC_ENT_URI:
+                // TODO
+                break;
+            default:
+                // TODO Error handling.
+                lbl = NULL;
+                break;
+        }
+    
+    size_t lbl_len_act;
+    
+    if (lbl)
+        lbl_len_act = strlen(lbl);
+    else
+        lbl_len_act = lbl_len;
+    
+    size_t clen = lbl_len_act + json_len + (coord->pln ? 1 : 0);
+    
+    ser->pld.str = (char*)malloc(clen + 1);
+    
+    if (coord->pln)
+    {
+        ser->pld.str[0] = ',';
+        strncpy(&ser->pld.str[1], lbl, lbl_len_act);
+        strncpy(&ser->pld.str[lbl_len_act + 1], json, json_len);
+        ser->pld.str[clen] = 0;
+    }
+    else
+    {
+        strncpy(&ser->pld.str[0], lbl, lbl_len_act);
+        strncpy(&ser->pld.str[lbl_len_act], json, json_len);
+        ser->pld.str[clen] = 0;
+    }
+    
+    if (lbl)
+        free(lbl);
+    if (json)
+        free(json);
+    
+    return ser;
+}
+
+#ifndef LDOC_NOPYTHON
+
+#pragma mark - Python-Dict Formatting
+
+ldoc_ser_t* ldoc_vis_setup_py(void)
+{
+    return LDOC_SER_NULL;
+}
+
+ldoc_ser_t* ldoc_vis_teardown_py(void)
+{
+    return LDOC_SER_NULL;
+}
+
+ldoc_ser_t* ldoc_vis_nde_pre_py(ldoc_nde_t* nde, ldoc_coord_t* coord)
+{
+    ldoc_ser_t* ser;
+    
+    if (!coord->lvl)
+    {
+        ser = ldoc_ser_new(LDOC_SER_PY_DCT);
+        
+        ser->pld.py.anno = NULL;
+        ser->pld.py.dtm = PyDict_New();
+        
+        return ser;
+    }
+    
+    PyObject* lbl;
+    size_t anno_len;
+    const char* anno = ldoc_nde_anno_str(nde, &anno_len);
+    
+    if (nde->prnt->tpe == LDOC_NDE_OL)
+    {
+        lbl = NULL;
+    }
+    else if (anno != NULL)
+    {
+        lbl = PyUnicode_FromStringAndSize(anno, anno_len);
+    }
+    else
+    {
+        size_t lbl_len = strlen(ldoc_cnst_json_nde) + 17;
+        char* clbl = (char*)malloc(lbl_len + 1);
+        snprintf(clbl, lbl_len, "%s-%llx", ldoc_cnst_json_nde, (unsigned long long)nde);
+        
+        lbl = PyUnicode_FromString(clbl);
+        
+        free(clbl);
+    }
+
+    if (nde->tpe == LDOC_NDE_OL)
+        ser = ldoc_ser_new(LDOC_SER_PY_LST);
+    else
+        ser = ldoc_ser_new(LDOC_SER_PY_DCT);
+    
+    // TODO Error handling.
+    
+    ser->pld.py.anno = lbl;
+    
+    if (nde->tpe == LDOC_NDE_OL)
+        ser->pld.py.dtm = PyList_New(0);
+    else
+        ser->pld.py.dtm = PyDict_New();
+    
+    return ser;
+}
+
+ldoc_ser_t* ldoc_vis_nde_infx_py(ldoc_nde_t* nde, ldoc_coord_t* coord)
+{
+    return LDOC_SER_NULL;
+}
+
+ldoc_ser_t* ldoc_vis_nde_post_py(ldoc_nde_t* nde, ldoc_coord_t* coord)
+{
+    return LDOC_SER_NULL;
+}
+
+PyObject* ldoc_vis_ent_py_val(ldoc_ent_t* ent, ldoc_coord_t* coord, size_t* len)
+{
+    PyObject* val;
+    char* num;
+    size_t str_len = 0;
+    const char* str = ldoc_ent_dtm_str(ent, &str_len);
+    bool nr = ent->tpe == LDOC_ENT_NR;
+    
+    // Binary numbers:
+    if (ent->rep & LDOC_REP_I64)
+        val = PyLong_FromLongLong(nr ? ent->pld.pair.dtm.i64 : ent->pld.i64);
+    else if (ent->rep & LDOC_REP_F64)
+        val = PyFloat_FromDouble(nr ? ent->pld.pair.dtm.f64 : ent->pld.f64);
+    else if (ent->tpe != LDOC_ENT_BR && ent->tpe != LDOC_ENT_BL && !str)
+    {
+        val = Py_None;
+    }
+    else
+        // TODO Check why val_len is one larger than required (???) some times.
+        switch (ent->tpe)
+        {
+            case LDOC_ENT_BL:
+                if (ent->pld.bl)
+                    val = Py_True;
+                else
+                    val = Py_False;
+                break;
+            case LDOC_ENT_BR:
+                if (ent->pld.pair.dtm.bl)
+                    val = Py_True;
+                else
+                    val = Py_False;
+                break;
+            case LDOC_ENT_NUM:
+                // Raw numbers are not null-terminated:
+                num = strndup(str, str_len);
+                if (ldoc_isfloat(num))
+                    val = PyFloat_FromDouble(strtod(num, NULL));
+                else
+                    val = PyLong_FromLong(strtol(num, NULL, 10));
+                free(num);
+                break;
+            case LDOC_ENT_NR:
+                num = strndup(str, str_len);
+                val = PyLong_FromLong(strtol(num, NULL, 10));
+                free(num);
+                break;
+            default:
+                val = PyUnicode_FromStringAndSize(str, str_len);
+                break;
+        }
+    
+    return val;
+}
+
+ldoc_ser_t* ldoc_vis_ent_py(ldoc_nde_t* nde, ldoc_ent_t* ent, ldoc_coord_t* coord)
+{
+    PyObject* json = ldoc_vis_ent_py_val(ent, coord, NULL);
+    
+    ldoc_ser_t* ser;
+    
+    if (ent->tpe == LDOC_ENT_NUM)
+    {
+        if (PyFloat_Check(json))
+            ser = ldoc_ser_new(LDOC_SER_PY_FLT);
+        else
+            ser = ldoc_ser_new(LDOC_SER_PY_INT);
+    }
+    else if (ent->tpe == LDOC_ENT_BL)
+        ser = ldoc_ser_new(LDOC_SER_PY_BL);
+    else
+        ser = ldoc_ser_new(LDOC_SER_PY_STR);
+    
+    if (!ser)
+    {
+        // TODO Error handling.
+    }
+    
+    size_t lbl_len;
+    char* clbl;
+    PyObject* lbl = NULL;
+    size_t anno_len;
+    const char* anno;
+    if (nde->tpe == LDOC_NDE_OL)
+        switch (ent->tpe)
+        {
+            case LDOC_ENT_BR:
+            case LDOC_ENT_NR:
+            case LDOC_ENT_OR:
+                anno = ldoc_ent_anno_str(ent, &anno_len);
+                ser->pld.py.anno = PyUnicode_FromStringAndSize(anno, anno_len);
+                ser->pld.py.dtm = json;
+                
+                return ser;
+            default:
+                break;
+        }
+    else
+        switch (ent->tpe)
+        {
+            case LDOC_ENT_BL:
+                lbl_len = strlen(ldoc_cnst_json_bl) + 17 + 1;
+                clbl = (char*)malloc(lbl_len);
+                // TODO Error handling.
+                snprintf(clbl, lbl_len, "%s-%llx", ldoc_cnst_json_bl, (unsigned long long)ent);
+                
+                lbl = PyUnicode_FromString(clbl);
+                
+                free(clbl);
+                break;
+            case LDOC_ENT_EM1:
+                lbl_len = strlen(ldoc_cnst_json_em1) + 17 + 1;
+                clbl = (char*)malloc(lbl_len);
+                // TODO Error handling.
+                snprintf(clbl, lbl_len, "%s-%llx", ldoc_cnst_json_em1, (unsigned long long)ent);
+                
+                lbl = PyUnicode_FromString(clbl);
+                
+                free(clbl);
+                break;
+            case LDOC_ENT_EM2:
+                lbl_len = strlen(ldoc_cnst_json_em2) + 17 + 1;
+                clbl = (char*)malloc(lbl_len);
+                // TODO Error handling.
+                snprintf(clbl, lbl_len, "%s-%llx", ldoc_cnst_json_em2, (unsigned long long)ent);
+                
+                lbl = PyUnicode_FromString(clbl);
+                
+                free(clbl);
+                break;
+            case LDOC_ENT_NUM:
+                lbl_len = strlen(ldoc_cnst_json_num) + 17 + 1;
+                clbl = (char*)malloc(lbl_len);
+                // TODO Error handling.
+                snprintf(clbl, lbl_len, "%s-%llx", ldoc_cnst_json_num, (unsigned long long)ent);
+                
+                lbl = PyUnicode_FromString(clbl);
+                
+                free(clbl);
+                break;
+            case LDOC_ENT_BR:
+            case LDOC_ENT_NR:
+            case LDOC_ENT_OR:
+                anno = ldoc_ent_anno_str(ent, &anno_len);
+                lbl = PyUnicode_FromStringAndSize(anno, anno_len);
+                break;
+            case LDOC_ENT_REF:
+                // TODO
+                break;
+            case LDOC_ENT_TXT:
+                lbl_len = strlen(ldoc_cnst_json_txt) + 18; // TODO Why is this 18 when everything else is +17?
+                clbl = (char*)malloc(lbl_len + 1);
+                // TODO Error handling.
+                snprintf(clbl, lbl_len, "%s-%llx", ldoc_cnst_json_txt, (unsigned long long)ent);
+                
+                lbl = PyUnicode_FromString(clbl);
+                
+                free(clbl);
+                break;
+            case LDOC_ENT_URI:
+                // TODO
+                break;
+            default:
+                // TODO Error handling.
+                lbl = NULL;
+                break;
+        }
+    
+    ser->pld.py.anno = lbl;
+    ser->pld.py.dtm = json;
+    
+    return ser;
+}
+
+#endif // #ifndef LDOC_NOPYTHON
+
+#pragma mark - Visitor
+
+ldoc_ser_t* ldoc_vis_dmp(ldoc_nde_t* nde, ldoc_ent_t* ent, ldoc_coord_t* coord)
 {
-    vis->vis_bl = vis_uni;
-    vis->vis_br = vis_uni;
-    vis->vis_em1 = vis_uni;
-    vis->vis_em2 = vis_uni;
-    vis->vis_num = vis_uni;
-    vis->vis_nr = vis_uni;
-    vis->vis_or = vis_uni;
-    vis->vis_ref = vis_uni;
-    vis->vis_txt = vis_uni;
-    vis->vis_uri = vis_uni;
+    return LDOC_SER_NULL;
 }
 
-static inline ldoc_ser_t* ldoc_vis_ent(ldoc_nde_t* nde, ldoc_ent_t* ent, ldoc_coord_t* coord, ldoc_vis_ent_t* vis)
+static inline ldoc_ser_t* ldoc_vis_nde_tpe(ldoc_nde_t* nde, ldoc_coord_t* coord, ldoc_vis_nde_t* vis)
 {
-    switch (ent->tpe)
+    switch (nde->tpe)
     {
-        case LDOC_ENT_BL:
-            return vis->vis_bl(nde, ent, coord);
-        case LDOC_ENT_BR:
-            return vis->vis_br(nde, ent, coord);
-        case LDOC_ENT_EM1:
-            return vis->vis_em1(nde, ent, coord);
-        case LDOC_ENT_EM2:
-            return vis->vis_em2(nde, ent, coord);
-        case LDOC_ENT_NUM:
-            return vis->vis_num(nde, ent, coord);
-        case LDOC_ENT_NR:
-            return vis->vis_nr(nde, ent, coord);
-        case LDOC_ENT_OR:
-            return vis->vis_or(nde, ent, coord);
-        case LDOC_ENT_REF:
-            return vis->vis_ref(nde, ent, coord);
-        case LDOC_ENT_TXT:
-            return vis->vis_txt(nde, ent, coord);
-        case LDOC_ENT_URI:
-            return vis->vis_uri(nde, ent, coord);
+        case LDOC_NDE_ANC:
+            return vis->vis_anc(nde, coord);
+        case LDOC_NDE_H1:
+            return vis->vis_h1(nde, coord);
+        case LDOC_NDE_H2:
+            return vis->vis_h2(nde, coord);
+        case LDOC_NDE_H3:
+            return vis->vis_h3(nde, coord);
+        case LDOC_NDE_H4:
+            return vis->vis_h4(nde, coord);
+        case LDOC_NDE_H5:
+            return vis->vis_h5(nde, coord);
+        case LDOC_NDE_H6:
+            return vis->vis_h6(nde, coord);
+        case LDOC_NDE_NN:
+            return vis->vis_nn(nde, coord);
+        case LDOC_NDE_OL:
+            return vis->vis_ol(nde, coord);
+        case LDOC_NDE_OO:
+            return vis->vis_oo(nde, coord);
+        case LDOC_NDE_PAR:
+            return vis->vis_par(nde, coord);
+        case LDOC_NDE_RT:
+            return vis->vis_rt(nde, coord);
+        case LDOC_NDE_UA:
+            return vis->vis_ua(nde, coord);
+        case LDOC_NDE_UL:
+            return vis->vis_ul(nde, coord);
         default:
             // TODO Error.
             break;
@@ -653,1456 +3088,1857 @@ static inline ldoc_ser_t* ldoc_vis_ent(ldoc_nde_t* nde, ldoc_ent_t* ent, ldoc_co
     return LDOC_SER_NULL;
 }
 
-char* ldoc_qry_ent_fst(ldoc_nde_t* nde)
+static ldoc_ser_t* ldoc_vis_nde(ldoc_nde_t* nde, ldoc_coord_t* coord, ldoc_vis_nde_ord_t* vis_nde, ldoc_vis_ent_t* vis_ent)
 {
-    if (!nde->ent_cnt)
+    ldoc_ser_t* ser = ldoc_vis_nde_tpe(nde, coord, &(vis_nde->pre));
+
+    // Always set plane to zero when entering a new node:
+    // - Bug? Was beforehand:
+    //     Remember which plane the node is on:
+    //     uint32_t pln = coord->pln;
+    uint32_t pln = 0;
+    
+    // Descendants (entities) will get the plane reported relative to this node:
+    coord->pln = 0;
+    
+    ldoc_ent_t* ent;
+    TAILQ_FOREACH(ent, &(nde->ents), ldoc_ent_entries)
     {
-        // TODO Error.
+        ldoc_ser_t* ser_ent = ldoc_vis_ent(nde, ent, coord, vis_ent);
+        ldoc_ser_concat(ser, ser_ent);
+        ldoc_ser_free(ser_ent);
+        
+        coord->pln++;
     }
+
+    ldoc_ser_t* ser_infx = ldoc_vis_nde_tpe(nde, coord, &(vis_nde->infx));
+    ldoc_ser_concat(ser, ser_infx);
+    ldoc_ser_free(ser_infx);
     
-    ldoc_ent_t* ent = TAILQ_FIRST(&(nde->ents));
-    size_t str_len = strlen(ent->pld.str);
-    char* str = (char*)malloc(str_len + 1);
-    strncpy(str, ent->pld.str, str_len);
-    str[str_len] = 0;
+    // Reset plane -- for node visits:
+    coord->pln = pln;
     
-    if (!str)
+    // Increase level for following node visits:
+    coord->lvl++;
+
+    ldoc_nde_t* dsc;
+    TAILQ_FOREACH(dsc, &(nde->dscs), ldoc_nde_entries)
     {
-        // TODO Error.
+        ldoc_ser_t* ser_nde = ldoc_vis_nde(dsc, coord, vis_nde, vis_ent);
+        ldoc_ser_concat(ser, ser_nde);
+        ldoc_ser_free(ser_nde);
+        
+        coord->pln++;
     }
     
-    return str;
+    // Decrease level after visit:
+    // TODO Probably not working like this... check with binary tree (n >= 2).
+    coord->lvl--;
+    
+    ldoc_ser_t* ser_post = ldoc_vis_nde_tpe(nde, coord, &(vis_nde->post));
+    ldoc_ser_concat(ser, ser_post);
+    ldoc_ser_free(ser_post);
+    
+    return ser;
 }
 
-char* ldoc_qry_ent_unq(ldoc_nde_t* nde)
+/**
+ * Same traversal as `ldoc_vis_nde`, but fragments are appended to a sink as soon
+ * as they are returned by the visitors.
+ */
+static void ldoc_vis_nde_snk(ldoc_nde_t* nde, ldoc_coord_t* coord, ldoc_vis_nde_ord_t* vis_nde, ldoc_vis_ent_t* vis_ent, ldoc_snk_t* snk)
 {
-    if (nde->ent_cnt != 1)
+    ldoc_snk_ser(snk, ldoc_vis_nde_tpe(nde, coord, &(vis_nde->pre)));
+    
+    uint32_t pln = 0;
+    
+    // Descendants (entities) will get the plane reported relative to this node:
+    coord->pln = 0;
+    
+    ldoc_ent_t* ent;
+    TAILQ_FOREACH(ent, &(nde->ents), ldoc_ent_entries)
+    {
+        ldoc_snk_ser(snk, ldoc_vis_ent(nde, ent, coord, vis_ent));
+        
+        if (snk->err)
+            break;
+        
+        coord->pln++;
+    }
+    
+    ldoc_snk_ser(snk, ldoc_vis_nde_tpe(nde, coord, &(vis_nde->infx)));
+    
+    // Reset plane -- for node visits:
+    coord->pln = pln;
+    
+    // Increase level for following node visits:
+    coord->lvl++;
+    
+    ldoc_nde_t* dsc;
+    TAILQ_FOREACH(dsc, &(nde->dscs), ldoc_nde_entries)
+    {
+        ldoc_vis_nde_snk(dsc, coord, vis_nde, vis_ent, snk);
+        
+        if (snk->err)
+            break;
+        
+        coord->pln++;
+    }
+    
+    // Decrease level after visit:
+    coord->lvl--;
+    
+    ldoc_snk_ser(snk, ldoc_vis_nde_tpe(nde, coord, &(vis_nde->post)));
+}
+
+ldoc_ent_t* ldoc_ent_new(ldoc_content_t tpe)
+{
+    return ldoc_ent_init((ldoc_ent_t*)malloc(sizeof(ldoc_ent_t)), tpe);
+}
+
+void ldoc_ent_free(ldoc_ent_t* ent)
+{
+    // TODO -- update: this should be it; no more to-do?
+    
+    free(ent);
+}
+
+ldoc_nde_t* ldoc_nde_new(ldoc_struct_t tpe)
+{
+    if (tpe == LDOC_NDE_RT)
     {
         // TODO Error.
+        return LDOC_NDE_NULL;
     }
+    
+    return ldoc_nde_new_(tpe);
+}
 
-    return ldoc_qry_ent_fst(nde);
+void ldoc_nde_free(ldoc_nde_t* nde)
+{
+    ldoc_ent_t* ent;
+    
+    while ((ent = TAILQ_FIRST(&(nde->ents))))
+    {
+        TAILQ_REMOVE(&(nde->ents), ent, ldoc_ent_entries);
+        
+        ldoc_ent_free(ent);
+    }
+    
+    ldoc_nde_t* dsc;
+    
+    while ((dsc = TAILQ_FIRST(&(nde->dscs))))
+    {
+        TAILQ_REMOVE(&(nde->dscs), dsc, ldoc_nde_entries);
+        
+        ldoc_nde_free(dsc);
+    }
+    
+    ldoc_nde_idx_drop(nde);
+    
+    free(nde);
+}
+
+static inline const char* ldoc_anno_pld_str(ldoc_anno_pld_t* pld, uint8_t rep, size_t* len)
+{
+    if (rep & LDOC_REP_RAW)
+    {
+        *len = pld->raw.len;
+        
+        return (const char*)pld->raw.pld;
+    }
+    
+    *len = pld->str ? strlen(pld->str) : 0;
+    
+    return pld->str;
+}
+
+const char* ldoc_nde_anno_str(ldoc_nde_t* nde, size_t* len)
+{
+    return ldoc_anno_pld_str(&(nde->mkup.anno), nde->rep, len);
+}
+
+const char* ldoc_ent_anno_str(ldoc_ent_t* ent, size_t* len)
+{
+    return ldoc_anno_pld_str(&(ent->pld.pair.anno), ent->rep, len);
 }
 
-char* ldoc_cnv_ent_html(ldoc_ent_t* ent)
+const char* ldoc_ent_dtm_str(ldoc_ent_t* ent, size_t* len)
 {
-    char* html;
-    size_t html_len;
+    // Binary datums have no string form:
+    if (ent->rep & (LDOC_REP_I64 | LDOC_REP_F64) || ent->tpe == LDOC_ENT_BL || ent->tpe == LDOC_ENT_BR)
+    {
+        *len = 0;
+        
+        return NULL;
+    }
     
-    switch (ent->tpe) {
-        case LDOC_ENT_BL:
-            // TODO
-            break;
-        case LDOC_ENT_BR:
-            // TODO
-            break;
-        case LDOC_ENT_EM1:
-            html_len = strlen(ldoc_cnst_html_em1_opn) + strlen(ent->pld.str) + strlen(ldoc_cnst_html_em1_cls) + 1;
-            html = (char*)malloc(html_len + 1);
-            snprintf(html, html_len, "%s%s%s", ldoc_cnst_html_em1_opn, ent->pld.str, ldoc_cnst_html_em1_cls);
-            return html;
-        case LDOC_ENT_EM2:
-            html_len = strlen(ldoc_cnst_html_em2_opn) + strlen(ent->pld.str) + strlen(ldoc_cnst_html_em2_cls) + 1;
-            html = (char*)malloc(html_len + 1);
-            snprintf(html, html_len, "%s%s%s", ldoc_cnst_html_em2_opn, ent->pld.str, ldoc_cnst_html_em2_cls);
-            return html;
-        case LDOC_ENT_NUM:
-            // TODO
-            break;
+    switch (ent->tpe)
+    {
         case LDOC_ENT_NR:
-            // TODO
-            break;
         case LDOC_ENT_OR:
-            // TODO
-            break;
-        case LDOC_ENT_REF:
-            // TODO
-            break;
-        case LDOC_ENT_TXT:
-            html_len = strlen(ent->pld.str);
-            html = (char*)malloc(html_len + 1);
-            strncpy(html, ent->pld.str, html_len);
-            html[html_len] = 0;
-            return html;
-        case LDOC_ENT_URI:
-            // TODO
-            break;
+            return ldoc_anno_pld_str(&(ent->pld.pair.dtm), ent->rep, len);
         default:
-            // TODO Error.
             break;
     }
     
-    // Note; Hardly optimal, but currently no idea how to
-    //       implement it better.
-    html = (char*)calloc(1, 1);
+    if (ent->rep & LDOC_REP_RAW)
+    {
+        *len = ent->pld.raw.len;
+        
+        return (const char*)ent->pld.raw.pld;
+    }
     
-    return html;
+    *len = ent->pld.str ? strlen(ent->pld.str) : 0;
+    
+    return ent->pld.str;
 }
 
-char* ldoc_cnv_nde_html_opn(ldoc_nde_t* nde)
+const char* ldoc_ent_dtm_fmt(ldoc_ent_t* ent, char* buf, size_t* len)
 {
-    char* pld;
-    char* html;
-    size_t html_len;
+    if (!(ent->rep & (LDOC_REP_I64 | LDOC_REP_F64)))
+        return ldoc_ent_dtm_str(ent, len);
     
-    switch (nde->tpe) {
-        case LDOC_NDE_ANC:
-            pld = ldoc_qry_ent_unq(nde);
-            html_len = 15 + strlen(pld) + 1;
-            html = (char*)malloc(html_len + 1);
-            snprintf(html, html_len, "<a name=\"%s\"></a>", pld);
-            free(pld);
-            return html;
-        case LDOC_NDE_H1:
-            html_len = strlen(ldoc_cnst_html_h1_opn);
-            html = (char*)malloc(html_len + 1);
-            strcpy(html, ldoc_cnst_html_h1_opn);
-            return html;
-        case LDOC_NDE_H2:
-            html_len = strlen(ldoc_cnst_html_h2_opn);
-            html = (char*)malloc(html_len + 1);
-            strcpy(html, ldoc_cnst_html_h2_opn);
-            return html;
-        case LDOC_NDE_H3:
-            html_len = strlen(ldoc_cnst_html_h3_opn);
-            html = (char*)malloc(html_len + 1);
-            strcpy(html, ldoc_cnst_html_h3_opn);
-            return html;
-        case LDOC_NDE_H4:
-            html_len = strlen(ldoc_cnst_html_h4_opn);
-            html = (char*)malloc(html_len + 1);
-            strcpy(html, ldoc_cnst_html_h4_opn);
-            return html;
-        case LDOC_NDE_H5:
-            html_len = strlen(ldoc_cnst_html_h5_opn);
-            html = (char*)malloc(html_len + 1);
-            strcpy(html, ldoc_cnst_html_h5_opn);
-            return html;
-        case LDOC_NDE_H6:
-            html_len = strlen(ldoc_cnst_html_h6_opn);
-            html = (char*)malloc(html_len + 1);
-            strcpy(html, ldoc_cnst_html_h6_opn);
-            return html;
-        case LDOC_NDE_NN:
-            break;
-        case LDOC_NDE_OL:
-            break;
-        case LDOC_NDE_OO:
-            break;
-        case LDOC_NDE_PAR:
-            html_len = strlen(ldoc_cnst_html_par_opn);
-            html = (char*)malloc(html_len + 1);
-            strcpy(html, ldoc_cnst_html_par_opn);
-            return html;
-        case LDOC_NDE_RT:
-            break;
-        case LDOC_NDE_UA:
-            break;
-        case LDOC_NDE_UL:
-            break;
-        default:
-            // TODO Error.
-            break;
-    }
+    bool nr = ent->tpe == LDOC_ENT_NR;
     
-    // Note; Hardly optimal, but currently no idea how to
-    //       implement it better.
-    html = (char*)calloc(1, 1);
+    if (ent->rep & LDOC_REP_I64)
+        *len = ldoc_i64_fmt(nr ? ent->pld.pair.dtm.i64 : ent->pld.i64, buf);
+    else
+        *len = ldoc_f64_fmt(nr ? ent->pld.pair.dtm.f64 : ent->pld.f64, buf);
     
-    return html;
+    return buf;
 }
 
-char* ldoc_cnv_nde_html_cls(ldoc_nde_t* nde)
+void ldoc_nde_ent_push(ldoc_nde_t* nde, ldoc_ent_t* ent)
 {
-    char* html;
-    size_t html_len;
-    
-    switch (nde->tpe) {
-        case LDOC_NDE_ANC:
-            break;
-        case LDOC_NDE_H1:
-            html_len = strlen(ldoc_cnst_html_h1_cls);
-            html = (char*)malloc(html_len + 1);
-            strcpy(html, ldoc_cnst_html_h1_cls);
-            return html;
-        case LDOC_NDE_H2:
-            html_len = strlen(ldoc_cnst_html_h2_cls);
-            html = (char*)malloc(html_len + 1);
-            strcpy(html, ldoc_cnst_html_h2_cls);
-            return html;
-        case LDOC_NDE_H3:
-            html_len = strlen(ldoc_cnst_html_h3_cls);
-            html = (char*)malloc(html_len + 1);
-            strcpy(html, ldoc_cnst_html_h3_cls);
-            return html;
-        case LDOC_NDE_H4:
-            html_len = strlen(ldoc_cnst_html_h4_cls);
-            html = (char*)malloc(html_len + 1);
-            strcpy(html, ldoc_cnst_html_h4_cls);
-            return html;
-        case LDOC_NDE_H5:
-            html_len = strlen(ldoc_cnst_html_h5_cls);
-            html = (char*)malloc(html_len + 1);
-            strcpy(html, ldoc_cnst_html_h5_cls);
-            return html;
-        case LDOC_NDE_H6:
-            html_len = strlen(ldoc_cnst_html_h6_cls);
-            html = (char*)malloc(html_len + 1);
-            strcpy(html, ldoc_cnst_html_h6_cls);
-            return html;
-        case LDOC_NDE_NN:
-            break;
-        case LDOC_NDE_OL:
-            break;
-        case LDOC_NDE_OO:
-            break;
-        case LDOC_NDE_PAR:
-            html_len = strlen(ldoc_cnst_html_par_cls);
-            html = (char*)malloc(html_len + 1);
-            strcpy(html, ldoc_cnst_html_par_cls);
-            return html;
-        case LDOC_NDE_UA:
-            break;
-        case LDOC_NDE_UL:
-            break;
-        default:
-            // TODO Error.
-            break;
-    }
-    
-    // Note; Hardly optimal, but currently no idea how to
-    //       implement it better.
-    html = (char*)calloc(1, 1);
+    ent->prnt = nde;
+    TAILQ_INSERT_TAIL(&(nde->ents), ent, ldoc_ent_entries);
+    nde->ent_cnt++;
     
-    return html;
+    if (nde->idx)
+        ldoc_nde_idx_ent(nde, ent);
 }
 
-static inline void ldoc_strcat(ldoc_ser_t* ser, char* s1)
+ldoc_ent_t* ldoc_nde_ent_pop(ldoc_nde_t* nde)
 {
-    size_t len1;
-    
-    if (!s1)
-        len1 = 0;
-    else
-        len1 = strlen(s1);
+    // TODO
     
-    ser->pld.str = (char*)malloc(len1 + 1);
+    return LDOC_ENT_NULL;
+}
+
+void ldoc_nde_ent_shift(ldoc_nde_t* nde, ldoc_ent_t* ent)
+{
+    // Indices list equal annotations in insertion order:
+    ldoc_nde_idx_drop(nde);
     
-    // If you do not know why the next line needs to be there, then
-    // you have not read the man page of strncpy.
-    ser->pld.str[len1] = 0;
+    ent->prnt = nde;
+    TAILQ_INSERT_HEAD(&(nde->ents), ent, ldoc_ent_entries);
+    nde->ent_cnt++;
+}
+
+ldoc_ent_t* ldoc_nde_ent_unshift(ldoc_nde_t* nde)
+{
+    // TODO
     
-    if (len1)
-        strncpy(ser->pld.str, s1, len1);
+    return LDOC_ENT_NULL;
 }
 
-static inline void ldoc_strcat2(ldoc_ser_t* ser, char* s1, char* s2)
+void ldoc_nde_ent_ins(ldoc_ent_t* ent, ldoc_ent_t* ent_ref)
 {
-    size_t len1 = strlen(s1);
-    size_t len2 = strlen(s2);
+    // TODO
+}
 
-    ser->pld.str = (char*)malloc(len1 + len2 + 1);
+void ldoc_ent_rm(ldoc_ent_t* ent)
+{
+    // TODO Common error handling with ldoc_nde_rm.
     
-    // If you do not know why the next line needs to be there, then
-    // you have not read the man page of strncpy.
-    ser->pld.str[len1] = 0;
-    strncpy(ser->pld.str, s1, len1);
-    strncat(ser->pld.str, s2, len2);
+    TAILQ_REMOVE(&(ent->prnt->ents), ent, ldoc_ent_entries);
+    
+    ent->prnt->ent_cnt--;
+    ldoc_nde_idx_drop(ent->prnt);
 }
 
-static inline void ldoc_strcat3(ldoc_ser_t* ser, char* s1, char* s2, char* s3)
+void ldoc_nde_dsc_push(ldoc_nde_t* nde, ldoc_nde_t* dsc)
 {
-    size_t len1 = strlen(s1);
-    size_t len2 = strlen(s2);
-    size_t len3 = strlen(s3);
-    ser->pld.str = (char*)malloc(len1 + len2 + len3 + 1);
+    dsc->prnt = nde;
+    TAILQ_INSERT_TAIL(&(nde->dscs), dsc, ldoc_nde_entries);
+    nde->dsc_cnt++;
+    
+    if (nde->idx)
+        ldoc_nde_idx_dsc(nde, dsc);
+}
 
-    // If you do not know why the next line needs to be there, then
-    // you have not read the man page of strncpy.
-    ser->pld.str[len1] = 0;
-    strncpy(ser->pld.str, s1, len1);
-    strncat(ser->pld.str, s2, len2);
-    strncat(ser->pld.str, s3, len3);
+ldoc_nde_t* ldoc_nde_dsc_pop(ldoc_nde_t* nde)
+{
+    // TODO
 }
 
-#pragma mark - HTML Formatting
+void ldoc_nde_dsc_shift(ldoc_nde_t* nde, ldoc_nde_t* dsc)
+{
+    ldoc_nde_idx_drop(nde);
+    
+    dsc->prnt = nde;
+    TAILQ_INSERT_HEAD(&(nde->dscs), dsc, ldoc_nde_entries);
+    nde->dsc_cnt++;
+}
 
-ldoc_ser_t* ldoc_vis_ent_html(ldoc_nde_t* nde, ldoc_ent_t* ent, ldoc_coord_t* coord)
+ldoc_nde_t* ldoc_nde_dsc_unshift(ldoc_nde_t* nde)
 {
-    // TODO Only strings supported right now.
-    ldoc_ser_t* ser = ldoc_ser_new(LDOC_SER_CSTR);
-    ser->pld.str = ldoc_cnv_ent_html(ent);
-    
-    return ser;
+    // TODO
 }
 
-ldoc_ser_t* ldoc_vis_setup_html(void)
+void ldoc_nde_dsc_ins(ldoc_nde_t* dsc, ldoc_nde_t* nde_ref)
 {
-    ldoc_ser_t* ser = ldoc_ser_new(LDOC_SER_CSTR);
-    
-    ser->pld.str = (char*)malloc(strlen(ldoc_cnst_html_doc_opn) + 1);
-    strcpy(ser->pld.str, ldoc_cnst_html_doc_opn);
-    
-    return ser;
+    // TODO
 }
 
-ldoc_ser_t* ldoc_vis_teardown_html(void)
+void ldoc_nde_rm(ldoc_nde_t* nde)
 {
-    ldoc_ser_t* ser = ldoc_ser_new(LDOC_SER_CSTR);
+    // TODO Common error handling with ldoc_ent_rm.
     
-    ser->pld.str = (char*)malloc(strlen(ldoc_cnst_html_doc_cls) + 1);
-    strcpy(ser->pld.str, ldoc_cnst_html_doc_cls);
+    // TODO Check that nde is not the root node. Cannot remove the root node.
     
-    return ser;
+    TAILQ_REMOVE(&(nde->prnt->dscs), nde, ldoc_nde_entries);
+    
+    nde->prnt->dsc_cnt--;
+    ldoc_nde_idx_drop(nde->prnt);
 }
 
-ldoc_ser_t* ldoc_vis_nde_pre_html(ldoc_nde_t* nde, ldoc_coord_t* coord)
+uint16_t ldoc_nde_lvl(ldoc_nde_t* nde)
 {
-    size_t idnt_len = coord->lvl ? 2 * (coord->lvl) + 2 : 0;
-    char* idnt = (char*)malloc(idnt_len + 1);
-    
-    memset(idnt, ' ', idnt_len);
-    idnt[idnt_len] = 0;
-    
-    char* html = ldoc_cnv_nde_html_opn(nde);
+    uint16_t lvl = 0;
     
-    ldoc_ser_t* ser = ldoc_ser_new(LDOC_SER_CSTR);
-    ldoc_strcat2(ser, idnt, html);
+    while (nde->prnt)
+    {
+        nde = nde->prnt;
+        lvl++;
+    }
     
-    return ser;
+    return lvl;
 }
 
-static ldoc_ser_t* ldoc_vis_nde_cls_html(ldoc_nde_t* nde, ldoc_coord_t* coord, bool indent)
+ldoc_nde_qstk_t* ldoc_nde_qstk_new(uint64_t inc)
 {
-    char* idnt = NULL;
-    if (indent)
+    ldoc_nde_qstk_t* qstk = (ldoc_nde_qstk_t*)malloc(sizeof(ldoc_nde_qstk_t));
+    
+    if (!qstk)
     {
-        size_t idnt_len = coord->lvl ? 2 * (coord->lvl) + 2 : 0;
-        char* idnt = (char*)malloc(idnt_len + 1);
-        memset(idnt, ' ', idnt_len);
-        idnt[idnt_len] = 0;
+        // TODO Error.
     }
     
-    char* html = ldoc_cnv_nde_html_cls(nde);
+    qstk->nds = (ldoc_nde_t**)malloc(sizeof(ldoc_nde_t*) * inc);
     
-    ldoc_ser_t* ser = ldoc_ser_new(LDOC_SER_CSTR);
+    if (!qstk->nds)
+    {
+        free(qstk);
+        // TODO Error.
+    }
     
-    if (idnt)
-        ldoc_strcat2(ser, idnt, html);
-    else
-        ldoc_strcat(ser, html);
+    qstk->rptr = 0;
+    qstk->wptr = 0;
+    qstk->max = inc;
+    qstk->inc = inc;
     
-    return ser;
+    return qstk;
 }
 
-ldoc_ser_t* ldoc_vis_nde_infx_html(ldoc_nde_t* nde, ldoc_coord_t* coord)
+void ldoc_nde_qstk_push(ldoc_nde_qstk_t* qstk, ldoc_nde_t* nde)
 {
-    switch (nde->tpe) {
-        case LDOC_NDE_PAR:
-            // Will be handled in post call.
-            return LDOC_SER_NULL;
-        default:
-            // Fall through for all other cases.
-            break;
-    }
+    // Write pointer is always on an empty spot: so fill it immediately!
+    qstk->nds[qstk->wptr] = nde;
     
-    return ldoc_vis_nde_cls_html(nde, coord, false);
+    if (LDOC_QSTK_FULL(qstk))
+    {
+        // Expand stack (increase array size):
+        ldoc_nde_t** nnds = (ldoc_nde_t**)realloc(qstk->nds, sizeof(ldoc_nde_t*) * (qstk->max + qstk->inc));
+        
+        if (!nnds)
+        {
+            // TODO Error.
+        }
+        
+        // Copy stack contents that are just before the write pointer into
+        // the newly allocated space:
+        if (!qstk->rptr)
+        {
+            // No action necessary. The newly allocated space can be written to "as is".
+            qstk->wptr++;
+        }
+        else if (qstk->rptr < qstk->inc)
+        {
+            // Everything up to the read pointer (sic) can be moved into the additionally
+            // created space. The new space increment might not be completely filled.
+            // Note that the read pointer will always be greater than zero in this case.
+            memcpy(LDOC_QSTK_NDE_ADDR(qstk, qstk->max), LDOC_QSTK_NDE_ADDR(qstk, 0), sizeof(ldoc_nde_t*) * qstk->rptr);
+            qstk->wptr = qstk->max + qstk->rptr;
+        }
+        else
+        {
+            // Move up:
+            memcpy(LDOC_QSTK_NDE_ADDR(qstk, qstk->max), LDOC_QSTK_NDE_ADDR(qstk, 0), sizeof(ldoc_nde_t*) * qstk->inc);
+            // Move down:
+            memcpy(LDOC_QSTK_NDE_ADDR(qstk, 0), LDOC_QSTK_NDE_ADDR(qstk, qstk->inc), sizeof(ldoc_nde_t*) * (qstk->rptr - qstk->inc));
+            qstk->wptr -= qstk->inc;
+        }
+        
+        qstk->max = qstk->max + qstk->inc;
+    }
+    else
+    {
+        qstk->wptr = (qstk->wptr + 1) % qstk->max;
+    }
 }
 
-ldoc_ser_t* ldoc_vis_nde_post_html(ldoc_nde_t* nde, ldoc_coord_t* coord)
+ldoc_nde_t* ldoc_nde_qstk_pop(ldoc_nde_qstk_t* qstk)
 {
-    switch (nde->tpe) {
-        case LDOC_NDE_H1:
-        case LDOC_NDE_H2:
-        case LDOC_NDE_H3:
-        case LDOC_NDE_H4:
-        case LDOC_NDE_H5:
-        case LDOC_NDE_H6:
-            // Already closed in infix call.
-            return LDOC_SER_NULL;
-        default:
-            // Fall through for all other cases.
-            break;
+    if (qstk->rptr == qstk->wptr)
+    {
+        // Stack empty. Sorry.
+        return LDOC_NDE_NULL;
     }
+
+    ldoc_nde_t* nde = qstk->nds[qstk->rptr];
     
-    return ldoc_vis_nde_cls_html(nde, coord, true);
+    qstk->rptr = (qstk->rptr + 1) % qstk->max;
+    
+    return nde;
 }
 
-#pragma mark - JSON Formatting
-
-ldoc_ser_t* ldoc_vis_setup_json(void)
+ldoc_ser_t* ldoc_lkahead(ldoc_doc_t* doc, uint64_t off, uint16_t ln)
 {
-    ldoc_ser_t* ser = ldoc_ser_new(LDOC_SER_CSTR);
+    ldoc_pos_idx_t* pidx = ldoc_pos_idx_get(doc);
+    char* str = pidx ? (char*)malloc(ln + 1) : NULL;
     
-    ser->pld.str = (char*)malloc(strlen(ldoc_cnst_json_opn) + 1);
-    strcpy(ser->pld.str, ldoc_cnst_json_opn);
+    if (!str)
+    {
+        ldoc_pos_idx_rls(doc, pidx);
+        
+        return LDOC_SER_NULL;
+    }
+    
+    size_t wr = 0;
+    uint64_t rem;
+    size_t k = ldoc_pos_idx_k(pidx, off, &rem);
+    uint64_t cur = off - rem;
+    char num[LDOC_NUM_LEN];
+    
+    for (; k < pidx->cnt && wr < ln; k++)
+    {
+        ldoc_ent_t* ent;
+        TAILQ_FOREACH(ent, &(pidx->ndes[k]->ents), ldoc_ent_entries)
+        {
+            size_t len;
+            const char* txt = ldoc_ent_dtm_fmt(ent, num, &len);
+            
+            if (!txt)
+                continue;
+            
+            size_t skp = off > cur ? (size_t)(off - cur) : 0;
+            
+            if (skp < len)
+            {
+                size_t cpy = len - skp < ln - wr ? len - skp : ln - wr;
+                
+                memcpy(str + wr, txt + skp, cpy);
+                wr += cpy;
+            }
+            
+            cur += len;
+            
+            if (wr == ln)
+                break;
+        }
+    }
+    
+    str[wr] = 0;
+    
+    ldoc_pos_idx_rls(doc, pidx);
+    
+    ldoc_ser_t* ser = ldoc_ser_new(LDOC_SER_CSTR);
+    ser->pld.str = str;
     
     return ser;
 }
 
-ldoc_ser_t* ldoc_vis_teardown_json(void)
+static inline bool ldoc_format_snk(ldoc_doc_t* doc, ldoc_vis_nde_ord_t* vis_nde, ldoc_vis_ent_t* vis_ent, ldoc_ser_t* opn, ldoc_snk_t* snk)
 {
-    ldoc_ser_t* ser = ldoc_ser_new(LDOC_SER_CSTR);
+    ldoc_coord_t coord = { 0, 0 };
     
-    ser->pld.str = (char*)malloc(strlen(ldoc_cnst_json_cls) + 1);
-    strcpy(ser->pld.str, ldoc_cnst_json_cls);
+    ldoc_snk_ser(snk, opn);
     
-    return ser;
+    ldoc_vis_nde_snk(doc->rt, &coord, vis_nde, vis_ent, snk);
+    
+    ldoc_snk_ser(snk, vis_nde->vis_teardown());
+    
+    return ldoc_snk_flsh(snk);
 }
 
-ldoc_ser_t* ldoc_vis_nde_pre_json(ldoc_nde_t* nde, ldoc_coord_t* coord)
+bool ldoc_format_to(ldoc_doc_t* doc, ldoc_vis_nde_ord_t* vis_nde, ldoc_vis_ent_t* vis_ent, ldoc_snk_t* snk)
 {
-    ldoc_ser_t* ser;
+    return ldoc_format_snk(doc, vis_nde, vis_ent, vis_nde->vis_setup(), snk);
+}
+
+ldoc_ser_t* ldoc_format(ldoc_doc_t* doc, ldoc_vis_nde_ord_t* vis_nde, ldoc_vis_ent_t* vis_ent)
+{
+    ldoc_coord_t coord = { 0, 0 };
     
-    if (!coord->lvl)
+    ldoc_ser_t* opn = vis_nde->vis_setup();
+    
+    // String serializations are streamed into a single buffer, which avoids
+    // re-measuring and re-allocating the output for every fragment:
+    if (opn != LDOC_SER_NULL && opn->tpe == LDOC_SER_CSTR)
     {
-        ser = ldoc_ser_new(LDOC_SER_CSTR);
+        ldoc_snk_t* snk = ldoc_snk_new(0);
         
-        // TODO Error handling.
+        if (!snk)
+        {
+            // TODO Error handling.
+            ldoc_ser_free(opn);
+            
+            return LDOC_SER_NULL;
+        }
         
-        ser->pld.str = (char*)calloc(1, 1);
+        ldoc_ser_t* ser = LDOC_SER_NULL;
         
-        // TODO Error handling.
+        if (ldoc_format_snk(doc, vis_nde, vis_ent, opn, snk))
+        {
+            ser = ldoc_ser_new(LDOC_SER_CSTR);
+            ser->pld.str = ldoc_snk_take(snk);
+        }
+        
+        ldoc_snk_free(snk);
         
         return ser;
     }
     
-    char sep[2];
-    
-    if (coord->pln > 0 || nde->prnt->ent_cnt)
-    {
-        sep[0] = ',';
-        sep[1] = 0;
-    }
-    else
-    {
-        sep[0] = 0;
-    }
-    
-    size_t lbl_len;
-    char* lbl;
-    
-    if (nde->prnt->tpe == LDOC_NDE_OL)
-        lbl = calloc(1, 1);
-    else if (nde->mkup.anno.str != NULL)
-    {
-        lbl_len = strlen(nde->mkup.anno.str);
-        lbl = strdup(nde->mkup.anno.str);
-    }
-    else
-    {
-        size_t lbl_len = strlen(ldoc_cnst_json_nde) + 17;
-        lbl = (char*)malloc(lbl_len + 1);
-        snprintf(lbl, lbl_len, "%s-%llx", ldoc_cnst_json_nde, (unsigned long long)nde);
-    }
-    
-    const char* opn;
-    if (nde->tpe == LDOC_NDE_OL)
-        opn = ldoc_cnst_json_lopn;
-    else
-        opn = ldoc_cnst_json_opn;
-    
-    ser = ldoc_ser_new(LDOC_SER_CSTR);
-    size_t ser_len = strlen(lbl) + 5 + 1;
+    ldoc_ser_t* ser = ldoc_vis_nde(doc->rt, &coord, vis_nde, vis_ent);
     
-    //if (nde->prnt->tpe == LDOC_NDE_OL)
-    //    ser_len++;
+    ldoc_ser_t* cls = vis_nde->vis_teardown();
     
-    ser->pld.str = (char*)malloc(ser_len + 1);
+    // Opening can be omitted, in which case the root node serialization will
+    // start the serialization:
+    if (opn == LDOC_SER_NULL)
+        opn = ser;
+    else
+    {
+        ldoc_ser_concat(opn, ser);
+        ldoc_ser_free(ser);
+    }
     
-    // TODO Error handling.
+    ldoc_ser_concat(opn, cls);
+    ldoc_ser_free(cls);
     
-    // If we are in an ordered list, then do not include a node's label:
-    if (nde->prnt->tpe == LDOC_NDE_OL)
-        snprintf(ser->pld.str, ser_len, "%s%s", sep, opn);
-    else
-        snprintf(ser->pld.str, ser_len, "%s\"%s\":%s", sep, lbl, opn);
+    return opn;
+}
+
+static inline void ldoc_vis_json(ldoc_vis_nde_ord_t** vis_nde, ldoc_vis_ent_t** vis_ent)
+{
+    *vis_nde = ldoc_vis_nde_ord_new();
+    (*vis_nde)->vis_setup = ldoc_vis_setup_json;
+    (*vis_nde)->vis_teardown = ldoc_vis_teardown_json;
+    ldoc_vis_nde_uni(&((*vis_nde)->pre), ldoc_vis_nde_pre_json);
+    ldoc_vis_nde_uni(&((*vis_nde)->infx), ldoc_vis_nde_infx_json);
+    ldoc_vis_nde_uni(&((*vis_nde)->post), ldoc_vis_nde_post_json);
+    
+    *vis_ent = ldoc_vis_ent_new();
+    ldoc_vis_ent_uni(*vis_ent, ldoc_vis_ent_json);
+}
+
+ldoc_ser_t* ldoc_format_json(ldoc_doc_t* doc)
+{
+    ldoc_vis_nde_ord_t* vis_nde;
+    ldoc_vis_ent_t* vis_ent;
+    ldoc_vis_json(&vis_nde, &vis_ent);
     
-    free(lbl);
+    ldoc_ser_t* ser = ldoc_format(doc, vis_nde, vis_ent);
+
+    ldoc_vis_nde_ord_free(vis_nde);
+    ldoc_vis_ent_free(vis_ent);
     
     return ser;
 }
 
-ldoc_ser_t* ldoc_vis_nde_infx_json(ldoc_nde_t* nde, ldoc_coord_t* coord)
+bool ldoc_format_json_to(ldoc_doc_t* doc, ldoc_snk_t* snk)
 {
-    return LDOC_SER_NULL;
+    ldoc_vis_nde_ord_t* vis_nde;
+    ldoc_vis_ent_t* vis_ent;
+    ldoc_vis_json(&vis_nde, &vis_ent);
+    
+    bool ok = ldoc_format_to(doc, vis_nde, vis_ent, snk);
+    
+    ldoc_vis_nde_ord_free(vis_nde);
+    ldoc_vis_ent_free(vis_ent);
+    
+    return ok;
 }
 
-ldoc_ser_t* ldoc_vis_nde_post_json(ldoc_nde_t* nde, ldoc_coord_t* coord)
+ldoc_pos_t* ldoc_find_pos_trv(ldoc_nde_t* nde, uint64_t* cur, u_int64_t off)
 {
-    char* json;
+    uint64_t end = ldoc_nde_ent_skip(nde, *cur);
     
-    if (!coord->lvl)
-    {
-        json = (char*)calloc(1, 1);
-    }
-    else if (nde->tpe == LDOC_NDE_OL)
-    {
-        json = strdup(ldoc_cnst_json_lcls);
-    }
-    else
+    if (*cur <= off && off <= end)
     {
-        json = strdup(ldoc_cnst_json_cls);
+        ldoc_pos_t* pos = ldoc_pos_new(nde, *cur, off - *cur);
+        
+        if (!pos)
+        {
+            // TODO Error.
+        }
+        
+        return pos;
     }
     
-    ldoc_ser_t* ser = ldoc_ser_new(LDOC_SER_CSTR);
+    *cur = end;
     
-    if (nde->prnt && nde->prnt->tpe == LDOC_NDE_OL)
+    ldoc_nde_t* dsc;
+    TAILQ_FOREACH(dsc, &(nde->dscs), ldoc_nde_entries)
     {
-        size_t clen = strlen(json) + 1;
-        ser->pld.str = (char*)malloc(clen + 1);
-        
-        // TODO Error handling.
-        
-        snprintf(ser->pld.str, clen, "%s", json);
+        ldoc_pos_t* pos = ldoc_find_pos_trv(dsc, cur, off);
         
-        free(json);
+        if (pos)
+            return pos;
     }
-    else
-        ser->pld.str = json;
     
-    return ser;
+    return LDOC_POS_NULL;
 }
 
-char* ldoc_vis_ent_json_val(ldoc_ent_t* ent, ldoc_coord_t* coord, size_t* len)
+static inline bool ldoc_anno_eq(const char* anno, size_t len, const char* str)
 {
-    size_t val_len;
-    char* val;
-    
-    // Note that LDOC_ENT_BR is not in this list: ent->pld.pair.dtm.bl is always either true/false!
-    if ((ent->tpe == LDOC_ENT_NR && !ent->pld.pair.dtm.str) ||
-        (ent->tpe == LDOC_ENT_OR && !ent->pld.pair.dtm.str) ||
-        (ent->tpe != LDOC_ENT_BR &&
-         ent->tpe != LDOC_ENT_OR &&
-         ent->tpe != LDOC_ENT_BL &&
-         !ent->pld.str))
-    {
-        val_len = strlen(ldoc_cnst_json_null);
-        val = strdup(ldoc_cnst_json_null);
-    }
-    else
-        // TODO Check why val_len is one larger than required (???) some times.
-        switch (ent->tpe)
-        {
-            case LDOC_ENT_BL:
-                if (ent->pld.bl)
-                    val = strdup(ldoc_cnst_json_true);
-                else
-                    val = strdup(ldoc_cnst_json_false);
-                val_len = strlen(val);
-                break;
-            case LDOC_ENT_BR:
-                if (ent->pld.pair.dtm.bl)
-                    val = strdup(ldoc_cnst_json_true);
-                else
-                    val = strdup(ldoc_cnst_json_false);
-                val_len = strlen(val);
-                break;
-            case LDOC_ENT_NUM:
-                val_len = strlen(ent->pld.str);
-                val = strdup(ent->pld.str);
-                break;
-            case LDOC_ENT_NR:
-                val_len = strlen(ent->pld.pair.dtm.str) + 1;
-                val = strdup(ent->pld.pair.dtm.str);
-                break;
-            case LDOC_ENT_OR:
-                val_len = strlen(ent->pld.pair.dtm.str) + 3;
-                val = (char*)malloc(val_len + 1);
-                snprintf(val, val_len, "\"%s\"", ent->pld.pair.dtm.str);
-                break;
-            default:
-                val_len = strlen(ent->pld.str) + 3;
-                val = (char*)malloc(val_len + 1);
-                snprintf(val, val_len, "\"%s\"", ent->pld.str);
-                break;
-        }
+    return anno && !strncmp(anno, str, len) && !str[len];
+}
+
+// Search path; lengths and hashes of its elements are precomputed by
+// compiled queries (NULL otherwise), and interned annotations (`ptr`)
+// are compared by their pointers:
+typedef struct ldoc_srch_pth_t
+{
+    char** pth;
+    size_t plen;
+    size_t* lens;
+    uint64_t* hshs;
+    bool ptr;
+} ldoc_srch_pth_t;
+
+static inline bool ldoc_srch_eq(ldoc_srch_pth_t* sp, size_t i, const char* anno, size_t len)
+{
+    if (sp->ptr)
+        return anno == sp->pth[i];
     
-    if (!val)
-    {
-        // TODO Error handling.
-        *len = 0;
-    }
+    if (sp->lens)
+        return anno && len == sp->lens[i] && !memcmp(anno, sp->pth[i], len);
     
-    *len = val_len;
+    return ldoc_anno_eq(anno, len, sp->pth[i]);
+}
+
+static inline bool ldoc_nde_anno_eq(ldoc_nde_t* nde, ldoc_srch_pth_t* sp, size_t i)
+{
+    size_t len;
+    const char* anno = ldoc_nde_anno_str(nde, &len);
     
-    return val;
+    return ldoc_srch_eq(sp, i, anno, len);
 }
 
-ldoc_ser_t* ldoc_vis_ent_json(ldoc_nde_t* nde, ldoc_ent_t* ent, ldoc_coord_t* coord)
+static inline bool ldoc_ent_anno_eq(ldoc_ent_t* ent, ldoc_srch_pth_t* sp, size_t i)
 {
-    size_t json_len;
-    char* json = ldoc_vis_ent_json_val(ent, coord, &json_len);
+    size_t len;
+    const char* anno = ldoc_ent_anno_str(ent, &len);
     
-    ldoc_ser_t* ser = ldoc_ser_new(LDOC_SER_CSTR);
+    return ldoc_srch_eq(sp, i, anno, len);
+}
+
+static ldoc_res_t* ldoc_find_anno_nde_(ldoc_doc_t* doc, ldoc_nde_t* nde, ldoc_srch_pth_t* sp, size_t i);
+
+// Matching descendant of an indexed node for path element `i`:
+static inline ldoc_res_t* ldoc_find_anno_idx(ldoc_doc_t* doc, ldoc_nde_t* nde, ldoc_srch_pth_t* sp, size_t i, bool ent)
+{
+    ldoc_nde_idx_t* idx = nde->idx;
+    uint64_t hsh = sp->hshs ? sp->hshs[i] : ldoc_str_hsh(sp->pth[i], strlen(sp->pth[i]));
+    ldoc_res_t* res;
     
-    if (!ser)
+    for (size_t j = hsh & idx->msk; idx->slts[j].info.nde; j = (j + 1) & idx->msk)
     {
-        // TODO Error handling.
-    }
-    
-    size_t lbl_len = 0;
-    char* lbl = NULL;
-    if (nde->tpe == LDOC_NDE_OL)
-        switch (ent->tpe)
+        ldoc_nde_idx_slt_t* slt = &(idx->slts[j]);
+        
+        if (slt->hsh != hsh || slt->nde == ent)
+            continue;
+        
+        if (ent)
         {
-            case LDOC_ENT_BR:
-            case LDOC_ENT_NR:
-            case LDOC_ENT_OR:
-                lbl_len = strlen(ent->pld.pair.anno.str) + json_len + 6;
-                lbl = (char*)malloc(lbl_len + 1);
-                // TODO Error handling.
-                snprintf(lbl, lbl_len, "{\"%s\":%s}", ent->pld.pair.anno.str, json);
-                free(json);
-                json_len = 0;
-                json = NULL;
-                break;
-            default:
-                break;
+            if (ldoc_ent_anno_eq(slt->info.ent, sp, i))
+                return ldoc_srch_new(NULL, slt->info.ent);
         }
-    else
-        switch (ent->tpe)
+        else if (ldoc_nde_anno_eq(slt->info.nde, sp, i))
         {
-            case LDOC_ENT_BL:
-                lbl_len = strlen(ldoc_cnst_json_bl) + 5 + 1;
-                lbl = (char*)malloc(lbl_len);
-                // TODO Error handling.
-                snprintf(lbl, lbl_len, "\"%s-%llx\":", ldoc_cnst_json_bl, (unsigned long long)ent);
-                break;
-            case LDOC_ENT_EM1:
-                lbl_len = strlen(ldoc_cnst_json_em1) + 20 + 1;
-                lbl = (char*)malloc(lbl_len);
-                // TODO Error handling.
-                snprintf(lbl, lbl_len, "\"%s-%llx\":", ldoc_cnst_json_em1, (unsigned long long)ent);
-                break;
-            case LDOC_ENT_EM2:
-                lbl_len = strlen(ldoc_cnst_json_em2) + 20 + 1;
-                lbl = (char*)malloc(lbl_len);
-                // TODO Error handling.
-                snprintf(lbl, lbl_len, "\"%s-%llx\":", ldoc_cnst_json_em2, (unsigned long long)ent);
-                break;
-            case LDOC_ENT_NUM:
-                lbl_len = strlen(ldoc_cnst_json_num) + 20 + 1;
-                lbl = (char*)malloc(lbl_len);
-                // TODO Error handling.
-                snprintf(lbl, lbl_len, "\"%s-%llx\":", ldoc_cnst_json_num, (unsigned long long)ent);
-                break;
-            case LDOC_ENT_BR:
-            case LDOC_ENT_NR:
-            case LDOC_ENT_OR:
-                lbl_len = strlen(ent->pld.pair.anno.str) + 4;
-                lbl = (char*)malloc(lbl_len + 1);
-                // TODO Error handling.
-                snprintf(lbl, lbl_len, "\"%s\":", ent->pld.pair.anno.str);
-                break;
-            case LDOC_ENT_REF:
-                // TODO
-                break;
-            case LDOC_ENT_TXT:
-                lbl_len = strlen(ldoc_cnst_json_txt) + 21;
-                lbl = (char*)malloc(lbl_len + 1);
-                // TODO Error handling.
-                snprintf(lbl, lbl_len, "\"%s-%llx\":", ldoc_cnst_json_txt, (unsigned long long)ent);
-                break;
-            case LDOC_ENT_URI:
-                // TODO
-                break;
-            default:
-                // TODO Error handling.
-                lbl = NULL;
-                break;
+            if (i + 1 == sp->plen)
+                return ldoc_srch_new(slt->info.nde, NULL);
+            
+            res = ldoc_find_anno_nde_(doc, slt->info.nde, sp, i + 1);
+            
+            if (res != LDOC_RES_NULL)
+                return res;
         }
+    }
     
-    size_t lbl_len_act;
-    
-    if (lbl)
-        lbl_len_act = strlen(lbl);
-    else
-        lbl_len_act = lbl_len;
-    
-    size_t clen = lbl_len_act + json_len + (coord->pln ? 1 : 0);
-    
-    ser->pld.str = (char*)malloc(clen + 1);
+    return LDOC_RES_NULL;
+}
+
+static inline ldoc_res_t* ldoc_find_anno_dsc(ldoc_doc_t* doc, ldoc_nde_t* nde, ldoc_srch_pth_t* sp, size_t i)
+{
+    if (nde->idx)
+        return ldoc_find_anno_idx(doc, nde, sp, i, false);
     
-    if (coord->pln)
-    {
-        ser->pld.str[0] = ',';
-        strncpy(&ser->pld.str[1], lbl, lbl_len_act);
-        strncpy(&ser->pld.str[lbl_len_act + 1], json, json_len);
-        ser->pld.str[clen] = 0;
-    }
-    else
+    ldoc_res_t* res;
+    ldoc_nde_t* dsc;
+    TAILQ_FOREACH(dsc, &(nde->dscs), ldoc_nde_entries)
     {
-        strncpy(&ser->pld.str[0], lbl, lbl_len_act);
-        strncpy(&ser->pld.str[lbl_len_act], json, json_len);
-        ser->pld.str[clen] = 0;
+        if (ldoc_nde_anno_eq(dsc, sp, i))
+        {
+            if (i + 1 < sp->plen)
+            {
+                res = ldoc_find_anno_nde_(doc, dsc, sp, i + 1);
+                
+                if (res != LDOC_RES_NULL)
+                    return res;
+            }
+            else
+                return ldoc_srch_new(dsc, NULL);
+        }
     }
     
-    if (lbl)
-        free(lbl);
-    if (json)
-        free(json);
-    
-    return ser;
-}
-
-#ifndef LDOC_NOPYTHON
-
-#pragma mark - Python-Dict Formatting
+    return LDOC_RES_NULL;
+}
 
-ldoc_ser_t* ldoc_vis_setup_py(void)
+static inline ldoc_res_t* ldoc_find_anno_ent_(ldoc_nde_t* nde, ldoc_srch_pth_t* sp, size_t i)
 {
-    return LDOC_SER_NULL;
+    if (nde->idx)
+        return ldoc_find_anno_idx(NULL, nde, sp, i, true);
+    
+    ldoc_ent_t* ent;
+    TAILQ_FOREACH(ent, &(nde->ents), ldoc_ent_entries)
+    {
+        if ((ent->tpe == LDOC_ENT_OR ||
+             ent->tpe == LDOC_ENT_NR ||
+             ent->tpe == LDOC_ENT_BR) &&
+            ldoc_ent_anno_eq(ent, sp, i))
+            return ldoc_srch_new(NULL, ent);
+    }
+    
+    return LDOC_RES_NULL;
 }
 
-ldoc_ser_t* ldoc_vis_teardown_py(void)
+inline ldoc_res_t* ldoc_find_anno_ent(ldoc_nde_t* nde, char* leaf)
 {
-    return LDOC_SER_NULL;
+    ldoc_srch_pth_t sp = { &leaf, 1, NULL, NULL, false };
+    
+    return ldoc_find_anno_ent_(nde, &sp, 0);
 }
 
-ldoc_ser_t* ldoc_vis_nde_pre_py(ldoc_nde_t* nde, ldoc_coord_t* coord)
+// Searches for path elements `i` onwards; builds indices on the way if a
+// document is given:
+static ldoc_res_t* ldoc_find_anno_nde_(ldoc_doc_t* doc, ldoc_nde_t* nde, ldoc_srch_pth_t* sp, size_t i)
 {
-    ldoc_ser_t* ser;
+    if (i >= sp->plen)
+        return LDOC_RES_NULL;
     
-    if (!coord->lvl)
+    if (doc && !nde->idx && ldoc_nde_idx_wide(nde))
     {
-        ser = ldoc_ser_new(LDOC_SER_PY_DCT);
-        
-        ser->pld.py.anno = NULL;
-        ser->pld.py.dtm = PyDict_New();
-        
-        return ser;
+        // Without an index, the node is simply scanned:
+        doc->idx = true;
+        ldoc_nde_idx_bld(nde);
     }
     
-    PyObject* lbl;
+    ldoc_res_t* res;
     
-    if (nde->prnt->tpe == LDOC_NDE_OL)
-    {
-        lbl = NULL;
-    }
-    else if (nde->mkup.anno.str != NULL)
+    // If the remaining path is longer than one element, then it cannot be
+    // an entity at this level (search only node descendants):
+    if (i + 1 < sp->plen)
     {
-        lbl = PyUnicode_FromString(nde->mkup.anno.str);
+        res = ldoc_find_anno_dsc(doc, nde, sp, i);
     }
     else
     {
-        size_t lbl_len = strlen(ldoc_cnst_json_nde) + 17;
-        char* clbl = (char*)malloc(lbl_len + 1);
-        snprintf(clbl, lbl_len, "%s-%llx", ldoc_cnst_json_nde, (unsigned long long)nde);
+        // Note: this is the last path element here!
         
-        lbl = PyUnicode_FromString(clbl);
+        // Search entities first, because it is more likely
+        // that the user is looking for a leaf in the document
+        // tree:
+        res = ldoc_find_anno_ent_(nde, sp, i);
         
-        free(clbl);
+        if (res == LDOC_RES_NULL)
+            res = ldoc_find_anno_dsc(doc, nde, sp, i);
     }
-
-    if (nde->tpe == LDOC_NDE_OL)
-        ser = ldoc_ser_new(LDOC_SER_PY_LST);
-    else
-        ser = ldoc_ser_new(LDOC_SER_PY_DCT);
     
-    // TODO Error handling.
-    
-    ser->pld.py.anno = lbl;
-    
-    if (nde->tpe == LDOC_NDE_OL)
-        ser->pld.py.dtm = PyList_New(0);
-    else
-        ser->pld.py.dtm = PyDict_New();
-    
-    return ser;
+    return res;
 }
 
-ldoc_ser_t* ldoc_vis_nde_infx_py(ldoc_nde_t* nde, ldoc_coord_t* coord)
+inline ldoc_res_t* ldoc_find_anno_nde(ldoc_nde_t* nde, char** pth, size_t plen)
 {
-    return LDOC_SER_NULL;
+    ldoc_srch_pth_t sp = { pth, plen, NULL, NULL, false };
+    
+    return ldoc_find_anno_nde_(NULL, nde, &sp, 0);
 }
 
-ldoc_ser_t* ldoc_vis_nde_post_py(ldoc_nde_t* nde, ldoc_coord_t* coord)
-{
-    return LDOC_SER_NULL;
-}
+// Path elements that fit on the stack when translated to interned strings:
+#define LDOC_FIND_PTH_MAX 32
 
-PyObject* ldoc_vis_ent_py_val(ldoc_ent_t* ent, ldoc_coord_t* coord, size_t* len)
+ldoc_res_t* ldoc_find_anno(ldoc_doc_t* doc, char** pth, size_t plen)
 {
-    PyObject* val;
+    ldoc_srch_pth_t sp = { pth, plen, NULL, NULL, false };
     
-    if ((ent->tpe == LDOC_ENT_NR && !ent->pld.pair.dtm.str) ||
-        (ent->tpe == LDOC_ENT_OR && !ent->pld.pair.dtm.str) ||
-        (ent->tpe != LDOC_ENT_BR && ent->tpe != LDOC_ENT_OR && !ent->pld.str))
-    {
-        val = Py_None;
-    }
-    else
-        // TODO Check why val_len is one larger than required (???) some times.
-        switch (ent->tpe)
-        {
-            case LDOC_ENT_BL:
-                if (ent->pld.bl)
-                    val = Py_True;
-                else
-                    val = Py_False;
-                break;
-            case LDOC_ENT_BR:
-                if (ent->pld.pair.dtm.bl)
-                    val = Py_True;
-                else
-                    val = Py_False;
-                break;
-            case LDOC_ENT_NUM:
-                if (ldoc_isfloat(ent->pld.str))
-                    val = PyFloat_FromDouble(strtod(ent->pld.str, NULL));
-                else
-                    val = PyLong_FromLong(strtol(ent->pld.str, NULL, 10));
-                break;
-            case LDOC_ENT_NR:
-                val = PyLong_FromLong(strtol(ent->pld.pair.dtm.str, NULL, 10));
-                break;
-            case LDOC_ENT_OR:
-                val = PyUnicode_FromString(ent->pld.pair.dtm.str);
-                break;
-            default:
-                val = PyUnicode_FromString(ent->pld.str);
-                break;
-        }
+    if (!doc->intn)
+        return ldoc_find_anno_nde_(doc, doc->rt, &sp, 0);
     
-    return val;
-}
-
-ldoc_ser_t* ldoc_vis_ent_py(ldoc_nde_t* nde, ldoc_ent_t* ent, ldoc_coord_t* coord)
-{
-    PyObject* json = ldoc_vis_ent_py_val(ent, coord, NULL);
+    // Annotations are interned, so that a path element that was never
+    // interned cannot match, and all others match by pointer:
+    char* stk[LDOC_FIND_PTH_MAX];
+    char** ipth = plen <= LDOC_FIND_PTH_MAX ? stk : (char**)malloc(plen * sizeof(char*));
+    ldoc_res_t* res = LDOC_RES_NULL;
+    size_t i;
     
-    ldoc_ser_t* ser;
+    if (!ipth)
+        return LDOC_RES_NULL;
     
-    if (ent->tpe == LDOC_ENT_NUM)
+    for (i = 0; i < plen; i++)
     {
-        if (ldoc_isfloat(ent->pld.str))
-            ser = ldoc_ser_new(LDOC_SER_PY_FLT);
-        else
-            ser = ldoc_ser_new(LDOC_SER_PY_INT);
+        if (!(ipth[i] = ldoc_intn_get(doc->intn, pth[i], strlen(pth[i]))))
+            break;
     }
-    else if (ent->tpe == LDOC_ENT_BL)
-        ser = ldoc_ser_new(LDOC_SER_PY_BL);
-    else
-        ser = ldoc_ser_new(LDOC_SER_PY_STR);
     
-    if (!ser)
+    if (i == plen)
     {
-        // TODO Error handling.
+        sp.pth = ipth;
+        sp.ptr = true;
+        res = ldoc_find_anno_nde_(doc, doc->rt, &sp, 0);
     }
     
-    size_t lbl_len;
-    char* clbl;
-    PyObject* lbl = NULL;
-    if (nde->tpe == LDOC_NDE_OL)
-        switch (ent->tpe)
-        {
-            case LDOC_ENT_BR:
-            case LDOC_ENT_NR:
-            case LDOC_ENT_OR:
-                ser->pld.py.anno = PyUnicode_FromString(ent->pld.pair.anno.str);
-                ser->pld.py.dtm = json;
-                
-                return ser;
-            default:
-                break;
-        }
-    else
-        switch (ent->tpe)
-        {
-            case LDOC_ENT_BL:
-                lbl_len = strlen(ldoc_cnst_json_bl) + 17 + 1;
-                clbl = (char*)malloc(lbl_len);
-                // TODO Error handling.
-                snprintf(clbl, lbl_len, "%s-%llx", ldoc_cnst_json_bl, (unsigned long long)ent);
-                
-                lbl = PyUnicode_FromString(clbl);
-                
-                free(clbl);
-                break;
-            case LDOC_ENT_EM1:
-                lbl_len = strlen(ldoc_cnst_json_em1) + 17 + 1;
-                clbl = (char*)malloc(lbl_len);
-                // TODO Error handling.
-                snprintf(clbl, lbl_len, "%s-%llx", ldoc_cnst_json_em1, (unsigned long long)ent);
-                
-                lbl = PyUnicode_FromString(clbl);
-                
-                free(clbl);
-                break;
-            case LDOC_ENT_EM2:
-                lbl_len = strlen(ldoc_cnst_json_em2) + 17 + 1;
-                clbl = (char*)malloc(lbl_len);
-                // TODO Error handling.
-                snprintf(clbl, lbl_len, "%s-%llx", ldoc_cnst_json_em2, (unsigned long long)ent);
-                
-                lbl = PyUnicode_FromString(clbl);
-                
-                free(clbl);
-                break;
-            case LDOC_ENT_NUM:
-                lbl_len = strlen(ldoc_cnst_json_num) + 17 + 1;
-                clbl = (char*)malloc(lbl_len);
-                // TODO Error handling.
-                snprintf(clbl, lbl_len, "%s-%llx", ldoc_cnst_json_num, (unsigned long long)ent);
-                
-                lbl = PyUnicode_FromString(clbl);
-                
-                free(clbl);
-                break;
-            case LDOC_ENT_BR:
-            case LDOC_ENT_NR:
-            case LDOC_ENT_OR:
-                lbl = PyUnicode_FromString(ent->pld.pair.anno.str);
-                break;
-            case LDOC_ENT_REF:
-                // TODO
-                break;
-            case LDOC_ENT_TXT:
-                lbl_len = strlen(ldoc_cnst_json_txt) + 18; // TODO Why is this 18 when everything else is +17?
-                clbl = (char*)malloc(lbl_len + 1);
-                // TODO Error handling.
-                snprintf(clbl, lbl_len, "%s-%llx", ldoc_cnst_json_txt, (unsigned long long)ent);
-                
-                lbl = PyUnicode_FromString(clbl);
-                
-                free(clbl);
-                break;
-            case LDOC_ENT_URI:
-                // TODO
-                break;
-            default:
-                // TODO Error handling.
-                lbl = NULL;
-                break;
-        }
-    
-    ser->pld.py.anno = lbl;
-    ser->pld.py.dtm = json;
+    if (ipth != stk)
+        free(ipth);
     
-    return ser;
+    return res;
 }
 
-#endif // #ifndef LDOC_NOPYTHON
+ldoc_pos_t* ldoc_find_pos(ldoc_doc_t* doc, uint64_t off)
+{
+    if (doc->pos)
+        return ldoc_pos_idx_find(doc->pos, off);
+    
+    // Without an index, the document is traversed:
+    uint64_t cur = 0;
+    
+    return ldoc_find_pos_trv(doc->rt, &cur, off);
+}
 
-#pragma mark - Visitor
+// Boyer-Moore-Horspool; `skp` holds the shift for each last byte of a window:
+typedef struct ldoc_kw_t
+{
+    const unsigned char* str;
+    size_t len;
+    size_t skp[256];
+} ldoc_kw_t;
 
-ldoc_ser_t* ldoc_vis_dmp(ldoc_nde_t* nde, ldoc_ent_t* ent, ldoc_coord_t* coord)
+static inline void ldoc_kw_init(ldoc_kw_t* kw, const char* str, size_t len)
 {
-    return LDOC_SER_NULL;
+    kw->str = (const unsigned char*)str;
+    kw->len = len;
+    
+    for (size_t i = 0; i < 256; i++)
+        kw->skp[i] = len;
+    
+    for (size_t i = 0; i + 1 < len; i++)
+        kw->skp[kw->str[i]] = len - 1 - i;
 }
 
-static inline ldoc_ser_t* ldoc_vis_nde_tpe(ldoc_nde_t* nde, ldoc_coord_t* coord, ldoc_vis_nde_t* vis)
+// First match within `txt`, or NULL:
+static inline const char* ldoc_kw_srch(ldoc_kw_t* kw, const char* txt, size_t len)
 {
-    switch (nde->tpe)
+    size_t m = kw->len;
+    
+    // Single bytes are left to the (vectorized) C library:
+    if (m == 1)
+        return (const char*)memchr(txt, kw->str[0], len);
+    
+    const unsigned char* utxt = (const unsigned char*)txt;
+    unsigned char lst = kw->str[m - 1];
+    
+    for (size_t i = 0; i + m <= len; i += kw->skp[utxt[i + m - 1]])
     {
-        case LDOC_NDE_ANC:
-            return vis->vis_anc(nde, coord);
-        case LDOC_NDE_H1:
-            return vis->vis_h1(nde, coord);
-        case LDOC_NDE_H2:
-            return vis->vis_h2(nde, coord);
-        case LDOC_NDE_H3:
-            return vis->vis_h3(nde, coord);
-        case LDOC_NDE_H4:
-            return vis->vis_h4(nde, coord);
-        case LDOC_NDE_H5:
-            return vis->vis_h5(nde, coord);
-        case LDOC_NDE_H6:
-            return vis->vis_h6(nde, coord);
-        case LDOC_NDE_NN:
-            return vis->vis_nn(nde, coord);
-        case LDOC_NDE_OL:
-            return vis->vis_ol(nde, coord);
-        case LDOC_NDE_OO:
-            return vis->vis_oo(nde, coord);
-        case LDOC_NDE_PAR:
-            return vis->vis_par(nde, coord);
-        case LDOC_NDE_RT:
-            return vis->vis_rt(nde, coord);
-        case LDOC_NDE_UA:
-            return vis->vis_ua(nde, coord);
-        case LDOC_NDE_UL:
-            return vis->vis_ul(nde, coord);
-        default:
-            // TODO Error.
-            break;
+        if (utxt[i + m - 1] == lst && !memcmp(utxt + i, kw->str, m - 1))
+            return txt + i;
     }
     
-    return LDOC_SER_NULL;
+    return NULL;
 }
 
-static ldoc_ser_t* ldoc_vis_nde(ldoc_nde_t* nde, ldoc_coord_t* coord, ldoc_vis_nde_ord_t* vis_nde, ldoc_vis_ent_t* vis_ent)
+// Deepest node that contains both nodes:
+static inline ldoc_nde_t* ldoc_nde_lca(ldoc_nde_t* a, ldoc_nde_t* b)
 {
-    ldoc_ser_t* ser = ldoc_vis_nde_tpe(nde, coord, &(vis_nde->pre));
-
-    // Always set plane to zero when entering a new node:
-    // - Bug? Was beforehand:
-    //     Remember which plane the node is on:
-    //     uint32_t pln = coord->pln;
-    uint32_t pln = 0;
+    uint16_t la = ldoc_nde_lvl(a);
+    uint16_t lb = ldoc_nde_lvl(b);
     
-    // Descendants (entities) will get the plane reported relative to this node:
-    coord->pln = 0;
+    for (; la > lb; la--)
+        a = a->prnt;
     
-    ldoc_ent_t* ent;
-    TAILQ_FOREACH(ent, &(nde->ents), ldoc_ent_entries)
+    for (; lb > la; lb--)
+        b = b->prnt;
+    
+    while (a != b)
     {
-        ldoc_ser_t* ser_ent = ldoc_vis_ent(nde, ent, coord, vis_ent);
-        ldoc_ser_concat(ser, ser_ent);
-        ldoc_ser_free(ser_ent);
-        
-        coord->pln++;
+        a = a->prnt;
+        b = b->prnt;
     }
+    
+    return a;
+}
 
-    ldoc_ser_t* ser_infx = ldoc_vis_nde_tpe(nde, coord, &(vis_nde->infx));
-    ldoc_ser_concat(ser, ser_infx);
-    ldoc_ser_free(ser_infx);
+// Node that captures the span [`mtch`, `mtch` + `len`):
+static inline void ldoc_pos_idx_span(ldoc_pos_idx_t* pidx, uint64_t mtch, size_t len, ldoc_pos_t* pos)
+{
+    uint64_t rem;
+    ldoc_nde_t* fst = pidx->ndes[ldoc_pos_idx_k(pidx, mtch + 1, &rem)];
+    ldoc_nde_t* lst = pidx->ndes[ldoc_pos_idx_k(pidx, mtch + len, &rem)];
     
-    // Reset plane -- for node visits:
-    coord->pln = pln;
+    pos->nde = ldoc_nde_lca(fst, lst);
+    pos->nde_off = ldoc_pos_idx_off(pidx, pos->nde->pos);
+    pos->off = mtch - pos->nde_off;
+}
+
+static inline ldoc_pos_t* ldoc_find_kw_pos(ldoc_pos_idx_t* pidx, uint64_t mtch, size_t len)
+{
+    ldoc_pos_t spn;
     
-    // Increase level for following node visits:
-    coord->lvl++;
+    ldoc_pos_idx_span(pidx, mtch, len, &spn);
+    
+    return ldoc_pos_new(spn.nde, spn.nde_off, spn.off);
+}
 
-    ldoc_nde_t* dsc;
-    TAILQ_FOREACH(dsc, &(nde->dscs), ldoc_nde_entries)
+// Bytes that fit on the stack for matches across entities:
+#define LDOC_KW_STK 256
+
+ldoc_pos_t* ldoc_find_kw(ldoc_doc_t* doc, uint64_t off, char* str)
+{
+    size_t m = strlen(str);
+    
+    if (!m)
+        return ldoc_find_pos(doc, off);
+    
+    ldoc_pos_idx_t* pidx = ldoc_pos_idx_get(doc);
+    
+    if (!pidx)
+        return LDOC_POS_NULL;
+    
+    ldoc_kw_t kw;
+    ldoc_kw_init(&kw, str, m);
+    
+    // The last `m` - 1 bytes of the text so far (`cry`), followed by the
+    // first bytes of the next entity, are searched for matches that span
+    // entities and nodes:
+    char stk[LDOC_KW_STK];
+    char* jn = 2 * m <= LDOC_KW_STK ? stk : (char*)malloc(2 * m);
+    size_t cry = 0;
+    ldoc_pos_t* pos = LDOC_POS_NULL;
+    
+    if (!jn)
     {
-        ldoc_ser_t* ser_nde = ldoc_vis_nde(dsc, coord, vis_nde, vis_ent);
-        ldoc_ser_concat(ser, ser_nde);
-        ldoc_ser_free(ser_nde);
+        ldoc_pos_idx_rls(doc, pidx);
         
-        coord->pln++;
+        return LDOC_POS_NULL;
     }
     
-    // Decrease level after visit:
-    // TODO Probably not working like this... check with binary tree (n >= 2).
-    coord->lvl--;
+    // Resume at the node that contains the cursor:
+    uint64_t rem;
+    size_t k = ldoc_pos_idx_k(pidx, off, &rem);
+    uint64_t cur = off - rem;
+    char num[LDOC_NUM_LEN];
     
-    ldoc_ser_t* ser_post = ldoc_vis_nde_tpe(nde, coord, &(vis_nde->post));
-    ldoc_ser_concat(ser, ser_post);
-    ldoc_ser_free(ser_post);
+    for (; k < pidx->cnt && !pos; k++)
+    {
+        ldoc_ent_t* ent;
+        TAILQ_FOREACH(ent, &(pidx->ndes[k]->ents), ldoc_ent_entries)
+        {
+            size_t len;
+            const char* txt = ldoc_ent_dtm_fmt(ent, num, &len);
+            
+            if (!txt || !len)
+                continue;
+            
+            // Matches that begin before this entity:
+            if (cry)
+            {
+                size_t add = len < m - 1 ? len : m - 1;
+                uint64_t jn_off = cur - cry;
+                size_t skp = off > jn_off ? (size_t)(off - jn_off) : 0;
+                
+                memcpy(jn + cry, txt, add);
+                
+                const char* hit = skp < cry ? ldoc_kw_srch(&kw, jn + skp, cry + add - skp) : NULL;
+                
+                if (hit && (size_t)(hit - jn) < cry)
+                {
+                    pos = ldoc_find_kw_pos(pidx, jn_off + (hit - jn), m);
+                    break;
+                }
+            }
+            
+            // Matches within this entity:
+            size_t skp = off > cur ? (size_t)(off - cur) : 0;
+            const char* hit = skp < len ? ldoc_kw_srch(&kw, txt + skp, len - skp) : NULL;
+            
+            if (hit)
+            {
+                pos = ldoc_find_kw_pos(pidx, cur + (hit - txt), m);
+                break;
+            }
+            
+            // Keep the text's last `m` - 1 bytes:
+            if (len >= m - 1)
+            {
+                cry = m - 1;
+                memcpy(jn, txt + len - cry, cry);
+            }
+            else
+            {
+                size_t drp = cry + len > m - 1 ? cry + len - (m - 1) : 0;
+                
+                memmove(jn, jn + drp, cry - drp);
+                memcpy(jn + cry - drp, txt, len);
+                cry = cry - drp + len;
+            }
+            
+            cur += len;
+        }
+    }
     
-    return ser;
-}
-
-ldoc_ent_t* ldoc_ent_new(ldoc_content_t tpe)
-{
-    ldoc_ent_t* ent = (ldoc_ent_t*)malloc(sizeof(ldoc_ent_t));
+    if (jn != stk)
+        free(jn);
     
-    ent->prnt = NULL;
-    ent->tpe = tpe;
-    ent->pld.str = NULL;
+    ldoc_pos_idx_rls(doc, pidx);
     
-    return ent;
+    return pos;
 }
 
-void ldoc_ent_free(ldoc_ent_t* ent)
+// Initial capacity of match arrays, which double when full:
+#define LDOC_MTCH_ARR_INIT 64
+
+typedef struct ldoc_find_mtchs_ctx_t
 {
-    // TODO -- update: this should be it; no more to-do?
-    
-    free(ent);
-}
+    ldoc_pos_idx_t* pidx;
+    ldoc_mtch_arr_t* arr;
+    uint64_t cur;
+    bool err;
+} ldoc_find_mtchs_ctx_t;
 
-ldoc_nde_t* ldoc_nde_new(ldoc_struct_t tpe)
+static void ldoc_find_mtchs_hit(void* ctx, size_t end, ldoc_trie_nde_t* nde, uint16_t len)
 {
-    if (tpe == LDOC_NDE_RT)
+    ldoc_find_mtchs_ctx_t* mctx = (ldoc_find_mtchs_ctx_t*)ctx;
+    ldoc_mtch_arr_t* arr = mctx->arr;
+    
+    if (arr->wptr == arr->max)
     {
-        // TODO Error.
-        return LDOC_NDE_NULL;
+        ldoc_mtch_t* mtchs = (ldoc_mtch_t*)realloc(arr->mtchs, arr->max * 2 * sizeof(ldoc_mtch_t));
+        
+        if (!mtchs)
+        {
+            mctx->err = true;
+            
+            return;
+        }
+        
+        arr->mtchs = mtchs;
+        arr->max *= 2;
     }
     
-    return ldoc_nde_new_(tpe);
+    ldoc_mtch_t* mtch = &(arr->mtchs[arr->wptr++]);
+    
+    ldoc_pos_idx_span(mctx->pidx, mctx->cur + end - len, len, &(mtch->pos));
+    mtch->len = len;
+    mtch->anno = nde->anno;
 }
 
-void ldoc_nde_free(ldoc_nde_t* nde)
+ldoc_mtch_arr_t* ldoc_find_mtchs(ldoc_doc_t* doc, uint64_t off, ldoc_trie_t* trie)
 {
-    ldoc_ent_t* ent;
+    if (!trie->ac && !ldoc_trie_ac_bld(trie))
+        return NULL;
     
-    TAILQ_FOREACH(ent, &(nde->ents), ldoc_ent_entries)
+    ldoc_mtch_arr_t* arr = (ldoc_mtch_arr_t*)malloc(sizeof(ldoc_mtch_arr_t));
+    
+    if (!arr)
+        return NULL;
+    
+    arr->wptr = 0;
+    arr->max = LDOC_MTCH_ARR_INIT;
+    arr->mtchs = (ldoc_mtch_t*)malloc(arr->max * sizeof(ldoc_mtch_t));
+    
+    ldoc_find_mtchs_ctx_t ctx = { arr->mtchs ? ldoc_pos_idx_get(doc) : NULL, arr, 0, false };
+    
+    if (!ctx.pidx)
     {
-        TAILQ_REMOVE(&(nde->ents), ent, ldoc_ent_entries);
+        free(arr->mtchs);
+        free(arr);
         
-        ldoc_ent_free(ent);
+        return NULL;
     }
     
-    ldoc_nde_t* dsc;
     
-    TAILQ_FOREACH(dsc, &(nde->dscs), ldoc_nde_entries)
+    // The automaton's state carries over from entity to entity, so that
+    // matches can span entities and nodes:
+    uint32_t st = LDOC_TRIE_ST_RT;
+    uint64_t rem;
+    size_t k = ldoc_pos_idx_k(ctx.pidx, off, &rem);
+    uint64_t cur = off - rem;
+    char num[LDOC_NUM_LEN];
+    
+    for (; k < ctx.pidx->cnt && !ctx.err; k++)
     {
-        TAILQ_REMOVE(&(nde->dscs), dsc, ldoc_nde_entries);
+        ldoc_ent_t* ent;
+        TAILQ_FOREACH(ent, &(ctx.pidx->ndes[k]->ents), ldoc_ent_entries)
+        {
+            size_t len;
+            const char* txt = ldoc_ent_dtm_fmt(ent, num, &len);
+            
+            if (!txt)
+                continue;
+            
+            // Matches begin at the cursor or after it:
+            size_t skp = off > cur ? (size_t)(off - cur) : 0;
+            
+            if (skp < len)
+            {
+                ctx.cur = cur + skp;
+                st = ldoc_trie_scan(trie, st, txt + skp, len - skp, ldoc_find_mtchs_hit, &ctx);
+                
+                if (st == LDOC_TRIE_ST_ERR)
+                {
+                    ctx.err = true;
+                    
+                    break;
+                }
+            }
+            
+            cur += len;
+        }
+    }
+    
+    ldoc_pos_idx_rls(doc, ctx.pidx);
+    
+    if (ctx.err)
+    {
+        ldoc_mtch_arr_free(arr);
         
-        ldoc_nde_free(dsc);
+        return NULL;
     }
     
-    free(nde);
+    return arr;
 }
 
-void ldoc_nde_ent_push(ldoc_nde_t* nde, ldoc_ent_t* ent)
+void ldoc_mtch_arr_free(ldoc_mtch_arr_t* arr)
 {
-    ent->prnt = nde;
-    TAILQ_INSERT_TAIL(&(nde->ents), ent, ldoc_ent_entries);
-    nde->ent_cnt++;
+    free(arr->mtchs);
+    free(arr);
 }
 
-ldoc_ent_t* ldoc_nde_ent_pop(ldoc_nde_t* nde)
+#pragma mark - Compiled Queries
+
+// Kinds of path segments; wildcards only in queries from `ldoc_qry_glob`:
+#define LDOC_QRY_KY 0
+#define LDOC_QRY_ANY 1
+#define LDOC_QRY_DSC 2
+
+// Path elements, their lengths, hashes, and kinds, and the path's interned
+// counterpart for the interning table that it was last resolved in:
+struct ldoc_qry_t
 {
-    // TODO
+    ldoc_srch_pth_t sp;
+    ldoc_srch_pth_t isp;
+    uint8_t* knds;
+    bool glob;
+    ldoc_intn_t* intn;
+    size_t cnt;
+    bool miss;
+};
+
+static ldoc_qry_t* ldoc_qry_new_(char** pth, size_t plen, bool glob)
+{
+    // Query, arrays, and strings share one allocation:
+    size_t sz = sizeof(ldoc_qry_t) + plen * (2 * sizeof(char*) + sizeof(size_t) + sizeof(uint64_t) + 1);
+    size_t i;
     
-    return LDOC_ENT_NULL;
+    for (i = 0; i < plen; i++)
+        sz += strlen(pth[i]) + 1;
+    
+    ldoc_qry_t* qry = (ldoc_qry_t*)malloc(sz);
+    
+    if (!qry)
+        return NULL;
+    
+    qry->sp.pth = (char**)(qry + 1);
+    qry->sp.plen = 0;
+    qry->sp.hshs = (uint64_t*)(qry->sp.pth + plen);
+    qry->sp.lens = (size_t*)(qry->sp.hshs + plen);
+    qry->sp.ptr = false;
+    
+    qry->isp = qry->sp;
+    qry->isp.pth = (char**)(qry->sp.lens + plen);
+    qry->isp.ptr = true;
+    
+    qry->knds = (uint8_t*)(qry->isp.pth + plen);
+    qry->glob = glob;
+    qry->intn = NULL;
+    qry->cnt = 0;
+    qry->miss = false;
+    
+    char* str = (char*)(qry->knds + plen);
+    size_t j = 0;
+    
+    for (i = 0; i < plen; i++)
+    {
+        size_t len = strlen(pth[i]);
+        uint8_t knd = LDOC_QRY_KY;
+        
+        if (glob && !strcmp(pth[i], "*"))
+            knd = LDOC_QRY_ANY;
+        else if (glob && !strcmp(pth[i], "**"))
+            knd = LDOC_QRY_DSC;
+        
+        // Consecutive "**" match the same as a single one:
+        if (knd == LDOC_QRY_DSC && j && qry->knds[j - 1] == LDOC_QRY_DSC)
+            continue;
+        
+        memcpy(str, pth[i], len + 1);
+        
+        qry->sp.pth[j] = str;
+        qry->sp.lens[j] = len;
+        qry->sp.hshs[j] = ldoc_str_hsh(str, len);
+        qry->isp.pth[j] = NULL;
+        qry->knds[j] = knd;
+        
+        str += len + 1;
+        j++;
+    }
+    
+    qry->sp.plen = qry->isp.plen = j;
+    
+    return qry;
 }
 
-void ldoc_nde_ent_shift(ldoc_nde_t* nde, ldoc_ent_t* ent)
+ldoc_qry_t* ldoc_qry_new(char** pth, size_t plen)
 {
-    ent->prnt = nde;
-    TAILQ_INSERT_HEAD(&(nde->ents), ent, ldoc_ent_entries);
-    nde->ent_cnt++;
+    return ldoc_qry_new_(pth, plen, false);
 }
 
-ldoc_ent_t* ldoc_nde_ent_unshift(ldoc_nde_t* nde)
+ldoc_qry_t* ldoc_qry_glob(char** pth, size_t plen)
 {
-    // TODO
-    
-    return LDOC_ENT_NULL;
+    return ldoc_qry_new_(pth, plen, true);
 }
 
-void ldoc_nde_ent_ins(ldoc_ent_t* ent, ldoc_ent_t* ent_ref)
+void ldoc_qry_free(ldoc_qry_t* qry)
 {
-    // TODO
+    free(qry);
 }
 
-void ldoc_ent_rm(ldoc_ent_t* ent)
+// Interned strings never move, so that only keys that were missing need
+// to be looked up again after the table grew:
+static inline void ldoc_qry_intn(ldoc_qry_t* qry, ldoc_intn_t* intn)
 {
-    // TODO Common error handling with ldoc_nde_rm.
+    if (qry->intn != intn)
+    {
+        for (size_t i = 0; i < qry->sp.plen; i++)
+            qry->isp.pth[i] = NULL;
+        
+        qry->intn = intn;
+    }
     
-    TAILQ_REMOVE(&(ent->prnt->ents), ent, ldoc_ent_entries);
+    qry->cnt = intn->cnt;
+    qry->miss = false;
     
-    ent->prnt->ent_cnt--;
+    for (size_t i = 0; i < qry->sp.plen; i++)
+    {
+        if (qry->isp.pth[i] || qry->knds[i] != LDOC_QRY_KY)
+            continue;
+        
+        qry->isp.pth[i] = ldoc_intn_slt(intn, qry->sp.hshs[i], qry->sp.pth[i], qry->sp.lens[i])->str;
+        
+        if (!qry->isp.pth[i])
+            qry->miss = true;
+    }
 }
 
-void ldoc_nde_dsc_push(ldoc_nde_t* nde, ldoc_nde_t* dsc)
+// Search path for a document, or NULL if a key was never interned in
+// the document's table and therefore cannot match:
+static inline ldoc_srch_pth_t* ldoc_qry_pth(ldoc_qry_t* qry, ldoc_doc_t* doc)
 {
-    dsc->prnt = nde;
-    TAILQ_INSERT_TAIL(&(nde->dscs), dsc, ldoc_nde_entries);
-    nde->dsc_cnt++;
+    if (!doc->intn)
+        return &(qry->sp);
+    
+    if (doc->intn != qry->intn || (qry->miss && doc->intn->cnt != qry->cnt))
+        ldoc_qry_intn(qry, doc->intn);
+    
+    return qry->miss ? NULL : &(qry->isp);
 }
 
-ldoc_nde_t* ldoc_nde_dsc_pop(ldoc_nde_t* nde)
+ldoc_res_t* ldoc_qry_exec(ldoc_qry_t* qry, ldoc_doc_t* doc)
 {
-    // TODO
+    if (qry->glob)
+    {
+        ldoc_qry_itr_t itr;
+        ldoc_res_t* res = LDOC_RES_NULL;
+        
+        ldoc_qry_itr_init(&itr, qry, doc);
+        
+        ldoc_res_t* hit = ldoc_qry_itr_nxt(&itr);
+        
+        if (hit)
+            res = ldoc_srch_new(hit->nde ? hit->info.nde : NULL, hit->nde ? NULL : hit->info.ent);
+        
+        ldoc_qry_itr_fin(&itr);
+        
+        return res;
+    }
+    
+    ldoc_srch_pth_t* sp = ldoc_qry_pth(qry, doc);
+    
+    return sp ? ldoc_find_anno_nde_(doc, doc->rt, sp, 0) : LDOC_RES_NULL;
 }
 
-void ldoc_nde_dsc_shift(ldoc_nde_t* nde, ldoc_nde_t* dsc)
+// Entities are only tested where the frame's segment is the last one:
+static inline bool ldoc_qry_itr_push(ldoc_qry_itr_t* itr, ldoc_nde_t* nde, size_t i)
 {
-    dsc->prnt = nde;
-    TAILQ_INSERT_HEAD(&(nde->dscs), dsc, ldoc_nde_entries);
-    nde->dsc_cnt++;
+    if (itr->cnt == itr->max)
+    {
+        size_t max = itr->max * 2;
+        ldoc_qry_frm_t* frms = (ldoc_qry_frm_t*)malloc(max * sizeof(ldoc_qry_frm_t));
+        
+        if (!frms)
+        {
+            itr->fail = true;
+            
+            return false;
+        }
+        
+        memcpy(frms, itr->frms, itr->cnt * sizeof(ldoc_qry_frm_t));
+        
+        if (itr->frms != itr->stk)
+            free(itr->frms);
+        
+        itr->frms = frms;
+        itr->max = max;
+    }
+    
+    ldoc_qry_frm_t* frm = &(itr->frms[itr->cnt++]);
+    
+    frm->nde = nde;
+    frm->ent = i + 1 == itr->qry->sp.plen ? TAILQ_FIRST(&(nde->ents)) : NULL;
+    frm->dsc = TAILQ_FIRST(&(nde->dscs));
+    frm->i = i;
+    frm->zro = false;
+    
+    return true;
 }
 
-ldoc_nde_t* ldoc_nde_dsc_unshift(ldoc_nde_t* nde)
+void ldoc_qry_itr_init(ldoc_qry_itr_t* itr, ldoc_qry_t* qry, ldoc_doc_t* doc)
 {
-    // TODO
+    ldoc_srch_pth_t* sp = ldoc_qry_pth(qry, doc);
+    
+    itr->qry = qry;
+    itr->ptr = sp && sp->ptr;
+    itr->frms = itr->stk;
+    itr->cnt = 0;
+    itr->max = LDOC_QRY_STK;
+    itr->fail = false;
+    
+    if (sp && sp->plen)
+        ldoc_qry_itr_push(itr, doc->rt, 0);
+}
+
+ldoc_res_t* ldoc_qry_itr_nxt(ldoc_qry_itr_t* itr)
+{
+    ldoc_qry_t* qry = itr->qry;
+    ldoc_srch_pth_t* sp = itr->ptr ? &(qry->isp) : &(qry->sp);
+    
+    while (itr->cnt)
+    {
+        ldoc_qry_frm_t* frm = &(itr->frms[itr->cnt - 1]);
+        size_t i = frm->i;
+        uint8_t knd = qry->knds[i];
+        bool lst = i + 1 == sp->plen;
+        
+        // "**" first matches the rest of the path at the node itself:
+        if (knd == LDOC_QRY_DSC && !lst && !frm->zro)
+        {
+            frm->zro = true;
+            
+            if (!ldoc_qry_itr_push(itr, frm->nde, i + 1))
+                break;
+            
+            continue;
+        }
+        
+        if (frm->ent)
+        {
+            ldoc_ent_t* ent = frm->ent;
+            
+            frm->ent = TAILQ_NEXT(ent, ldoc_ent_entries);
+            
+            if (knd != LDOC_QRY_KY ||
+                ((ent->tpe == LDOC_ENT_OR ||
+                  ent->tpe == LDOC_ENT_NR ||
+                  ent->tpe == LDOC_ENT_BR) &&
+                 ldoc_ent_anno_eq(ent, sp, i)))
+            {
+                itr->res.nde = false;
+                itr->res.info.ent = ent;
+                
+                return &(itr->res);
+            }
+            
+            continue;
+        }
+        
+        if (frm->dsc)
+        {
+            ldoc_nde_t* dsc = frm->dsc;
+            
+            frm->dsc = TAILQ_NEXT(dsc, ldoc_nde_entries);
+            
+            if (knd == LDOC_QRY_DSC)
+            {
+                // The node itself is only a match for a trailing "**":
+                if (!ldoc_qry_itr_push(itr, dsc, i))
+                    break;
+            }
+            else if (knd == LDOC_QRY_ANY || ldoc_nde_anno_eq(dsc, sp, i))
+            {
+                if (!lst && !ldoc_qry_itr_push(itr, dsc, i + 1))
+                    break;
+            }
+            else
+                continue;
+            
+            if (lst)
+            {
+                itr->res.nde = true;
+                itr->res.info.nde = dsc;
+                
+                return &(itr->res);
+            }
+            
+            continue;
+        }
+        
+        itr->cnt--;
+    }
+    
+    // Done, or a frame could not be pushed (see `fail`):
+    itr->cnt = 0;
+    
+    return LDOC_RES_NULL;
 }
 
-void ldoc_nde_dsc_ins(ldoc_nde_t* dsc, ldoc_nde_t* nde_ref)
+void ldoc_qry_itr_fin(ldoc_qry_itr_t* itr)
 {
-    // TODO
+    if (itr->frms != itr->stk)
+        free(itr->frms);
+    
+    itr->frms = itr->stk;
+    itr->cnt = 0;
 }
 
-void ldoc_nde_rm(ldoc_nde_t* nde)
+size_t ldoc_qry_all(ldoc_qry_t* qry, ldoc_doc_t* doc, ldoc_res_t* buf, size_t max)
 {
-    // TODO Common error handling with ldoc_ent_rm.
+    ldoc_qry_itr_t itr;
+    ldoc_res_t* res;
+    size_t cnt = 0;
     
-    // TODO Check that nde is not the root node. Cannot remove the root node.
+    ldoc_qry_itr_init(&itr, qry, doc);
     
-    TAILQ_REMOVE(&(nde->prnt->dscs), nde, ldoc_nde_entries);
+    while ((res = ldoc_qry_itr_nxt(&itr)))
+    {
+        if (cnt < max)
+            buf[cnt] = *res;
+        
+        cnt++;
+    }
     
-    nde->prnt->dsc_cnt--;
+    ldoc_qry_itr_fin(&itr);
+    
+    return itr.fail ? SIZE_MAX : cnt;
 }
 
-uint16_t ldoc_nde_lvl(ldoc_nde_t* nde)
+#pragma mark - Frozen Documents
+
+// Sizes of the node/entity arrays and the string pool:
+static void ldoc_frz_cnt(ldoc_nde_t* nde, uint64_t* ndes, uint64_t* ents, size_t* pool)
 {
-    uint16_t lvl = 0;
+    size_t len;
     
-    while (nde->prnt)
+    (*ndes)++;
+    *ents += nde->ent_cnt;
+    
+    if (ldoc_nde_anno_str(nde, &len))
+        *pool += len + 1;
+    
+    ldoc_ent_t* ent;
+    TAILQ_FOREACH(ent, &(nde->ents), ldoc_ent_entries)
     {
-        nde = nde->prnt;
-        lvl++;
+        if (ldoc_ent_pair(ent->tpe) && ldoc_ent_anno_str(ent, &len))
+            *pool += len + 1;
+        
+        if (!ldoc_bin_val(ent) && ldoc_ent_dtm_str(ent, &len))
+            *pool += len + 1;
     }
     
-    return lvl;
+    ldoc_nde_t* dsc;
+    TAILQ_FOREACH(dsc, &(nde->dscs), ldoc_nde_entries)
+        ldoc_frz_cnt(dsc, ndes, ents, pool);
 }
 
-ldoc_nde_qstk_t* ldoc_nde_qstk_new(uint64_t inc)
+static inline ldoc_raw_t ldoc_frz_str(char** pool, const char* str, size_t len)
 {
-    ldoc_nde_qstk_t* qstk = (ldoc_nde_qstk_t*)malloc(sizeof(ldoc_nde_qstk_t));
-    
-    if (!qstk)
-    {
-        // TODO Error.
-    }
-    
-    qstk->nds = (ldoc_nde_t**)malloc(sizeof(ldoc_nde_t*) * inc);
+    ldoc_raw_t raw = { NULL, 0 };
     
-    if (!qstk->nds)
-    {
-        free(qstk);
-        // TODO Error.
-    }
+    if (!str)
+        return raw;
     
-    qstk->rptr = 0;
-    qstk->wptr = 0;
-    qstk->max = inc;
-    qstk->inc = inc;
+    raw.pld = (uint8_t*)*pool;
+    raw.len = len;
+    memcpy(*pool, str, len);
+    (*pool)[len] = 0;
+    *pool += len + 1;
     
-    return qstk;
+    return raw;
 }
 
-void ldoc_nde_qstk_push(ldoc_nde_qstk_t* qstk, ldoc_nde_t* nde)
+// Fills in node `idx` and its subtree; returns the index that follows the subtree:
+static uint32_t ldoc_frz_fill(ldoc_frz_t* frz, ldoc_nde_t* nde, uint32_t idx, uint32_t prnt, uint32_t* ent, char** pool)
 {
-    // Write pointer is always on an empty spot: so fill it immediately!
-    qstk->nds[qstk->wptr] = nde;
-    
-    if (LDOC_QSTK_FULL(qstk))
+    size_t len;
+    const char* str = ldoc_nde_anno_str(nde, &len);
+    
+    frz->tpe[idx] = nde->tpe;
+    frz->prnt[idx] = prnt;
+    frz->fst[idx] = LDOC_FRZ_NULL;
+    frz->nxt[idx] = LDOC_FRZ_NULL;
+    frz->ents[idx] = *ent;
+    frz->anno[idx] = ldoc_frz_str(pool, str, len);
+    
+    ldoc_ent_t* e;
+    TAILQ_FOREACH(e, &(nde->ents), ldoc_ent_entries)
     {
-        // Expand stack (increase array size):
-        ldoc_nde_t** nnds = (ldoc_nde_t**)realloc(qstk->nds, sizeof(ldoc_nde_t*) * (qstk->max + qstk->inc));
+        uint32_t i = (*ent)++;
+        bool pair = ldoc_ent_pair(e->tpe);
+        ldoc_anno_pld_t* dtm = pair ? &(e->pld.pair.dtm) : (ldoc_anno_pld_t*)&(e->pld);
         
-        if (!nnds)
-        {
-            // TODO Error.
-        }
+        frz->ent_tpe[i] = e->tpe;
+        frz->ent_rep[i] = (e->rep & (LDOC_REP_I64 | LDOC_REP_F64)) | LDOC_REP_RAW;
+        frz->ent_anno[i] = (ldoc_raw_t){ NULL, 0 };
         
-        // Copy stack contents that are just before the write pointer into
-        // the newly allocated space:
-        if (!qstk->rptr)
-        {
-            // No action necessary. The newly allocated space can be written to "as is".
-            qstk->wptr++;
-        }
-        else if (qstk->rptr < qstk->inc)
+        if (pair)
         {
-            // Everything up to the read pointer (sic) can be moved into the additionally
-            // created space. The new space increment might not be completely filled.
-            // Note that the read pointer will always be greater than zero in this case.
-            memcpy(LDOC_QSTK_NDE_ADDR(qstk, qstk->max), LDOC_QSTK_NDE_ADDR(qstk, 0), sizeof(ldoc_nde_t*) * qstk->rptr);
-            qstk->wptr = qstk->max + qstk->rptr;
+            str = ldoc_ent_anno_str(e, &len);
+            frz->ent_anno[i] = ldoc_frz_str(pool, str, len);
         }
+        
+        if (ldoc_bin_val(e))
+            frz->ent_dtm[i] = *dtm;
         else
         {
-            // Move up:
-            memcpy(LDOC_QSTK_NDE_ADDR(qstk, qstk->max), LDOC_QSTK_NDE_ADDR(qstk, 0), sizeof(ldoc_nde_t*) * qstk->inc);
-            // Move down:
-            memcpy(LDOC_QSTK_NDE_ADDR(qstk, 0), LDOC_QSTK_NDE_ADDR(qstk, qstk->inc), sizeof(ldoc_nde_t*) * (qstk->rptr - qstk->inc));
-            qstk->wptr -= qstk->inc;
+            str = ldoc_ent_dtm_str(e, &len);
+            frz->ent_dtm[i].raw = ldoc_frz_str(pool, str, len);
         }
-        
-        qstk->max = qstk->max + qstk->inc;
     }
-    else
+    
+    uint32_t nxt = idx + 1;
+    uint32_t prv = LDOC_FRZ_NULL;
+    
+    ldoc_nde_t* dsc;
+    TAILQ_FOREACH(dsc, &(nde->dscs), ldoc_nde_entries)
     {
-        qstk->wptr = (qstk->wptr + 1) % qstk->max;
+        if (prv == LDOC_FRZ_NULL)
+            frz->fst[idx] = nxt;
+        else
+            frz->nxt[prv] = nxt;
+        
+        prv = nxt;
+        nxt = ldoc_frz_fill(frz, dsc, nxt, idx, ent, pool);
     }
+    
+    return nxt;
 }
 
-ldoc_nde_t* ldoc_nde_qstk_pop(ldoc_nde_qstk_t* qstk)
+ldoc_frz_t* ldoc_frz_new(ldoc_doc_t* doc)
 {
-    if (qstk->rptr == qstk->wptr)
+    uint64_t ndes = 0;
+    uint64_t ents = 0;
+    size_t pool = 0;
+    
+    ldoc_frz_cnt(doc->rt, &ndes, &ents, &pool);
+    
+    if (ndes >= LDOC_FRZ_NULL || ents >= LDOC_FRZ_NULL)
+        return NULL;
+    
+    ldoc_frz_t* frz = (ldoc_frz_t*)calloc(1, sizeof(ldoc_frz_t));
+    
+    if (!frz)
+        return NULL;
+    
+    frz->nde_cnt = (uint32_t)ndes;
+    frz->ent_cnt = (uint32_t)ents;
+    frz->tpe = (uint8_t*)malloc(ndes);
+    frz->prnt = (uint32_t*)malloc(ndes * sizeof(uint32_t));
+    frz->fst = (uint32_t*)malloc(ndes * sizeof(uint32_t));
+    frz->nxt = (uint32_t*)malloc(ndes * sizeof(uint32_t));
+    frz->ents = (uint32_t*)malloc((ndes + 1) * sizeof(uint32_t));
+    frz->anno = (ldoc_raw_t*)malloc(ndes * sizeof(ldoc_raw_t));
+    frz->ent_tpe = (uint8_t*)malloc(ents + 1);
+    frz->ent_rep = (uint8_t*)malloc(ents + 1);
+    frz->ent_anno = (ldoc_raw_t*)malloc((ents + 1) * sizeof(ldoc_raw_t));
+    frz->ent_dtm = (ldoc_anno_pld_t*)malloc((ents + 1) * sizeof(ldoc_anno_pld_t));
+    frz->pool = (char*)malloc(pool + 1);
+    
+    if (!frz->tpe || !frz->prnt || !frz->fst || !frz->nxt || !frz->ents || !frz->anno ||
+        !frz->ent_tpe || !frz->ent_rep || !frz->ent_anno || !frz->ent_dtm || !frz->pool)
     {
-        // Stack empty. Sorry.
-        return LDOC_NDE_NULL;
+        ldoc_frz_free(frz);
+        
+        return NULL;
     }
-
-    ldoc_nde_t* nde = qstk->nds[qstk->rptr];
     
-    qstk->rptr = (qstk->rptr + 1) % qstk->max;
+    uint32_t ent = 0;
+    char* str = frz->pool;
     
-    return nde;
+    ldoc_frz_fill(frz, doc->rt, 0, LDOC_FRZ_NULL, &ent, &str);
+    frz->ents[ndes] = ent;
+    
+    return frz;
 }
 
-ldoc_ser_t* ldoc_lkahead(ldoc_doc_t* doc, uint64_t off, uint16_t ln)
+void ldoc_frz_free(ldoc_frz_t* frz)
 {
-    return LDOC_SER_NULL;
+    free(frz->tpe);
+    free(frz->prnt);
+    free(frz->fst);
+    free(frz->nxt);
+    free(frz->ents);
+    free(frz->anno);
+    free(frz->ent_tpe);
+    free(frz->ent_rep);
+    free(frz->ent_anno);
+    free(frz->ent_dtm);
+    free(frz->pool);
+    free(frz);
 }
 
-ldoc_ser_t* ldoc_format(ldoc_doc_t* doc, ldoc_vis_nde_ord_t* vis_nde, ldoc_vis_ent_t* vis_ent)
+static inline bool ldoc_frz_anno_eq(ldoc_raw_t* anno, const char* str)
 {
-    ldoc_coord_t coord = { 0, 0 };
-    
-    ldoc_ser_t* opn = vis_nde->vis_setup();
-    
-    ldoc_ser_t* ser = ldoc_vis_nde(doc->rt, &coord, vis_nde, vis_ent);
-    
-    ldoc_ser_t* cls = vis_nde->vis_teardown();
-    
-    // Opening can be omitted, in which case the root node serialization will
-    // start the serialization:
-    if (opn == LDOC_SER_NULL)
-        opn = ser;
-    else
+    return ldoc_anno_eq((const char*)anno->pld, anno->len, str);
+}
+
+// Same search order as `ldoc_find_anno_nde`: entities at the leaf first, then
+// node descendants, backtracking over equally annotated siblings:
+static uint32_t ldoc_frz_find_anno_nde(ldoc_frz_t* frz, uint32_t nde, char** pth, size_t plen, bool* isnde)
+{
+    if (plen == 1)
     {
-        ldoc_ser_concat(opn, ser);
-        ldoc_ser_free(ser);
+        for (uint32_t e = frz->ents[nde]; e < frz->ents[nde + 1]; e++)
+        {
+            if (ldoc_ent_pair(frz->ent_tpe[e]) && ldoc_frz_anno_eq(&(frz->ent_anno[e]), *pth))
+            {
+                *isnde = false;
+                
+                return e;
+            }
+        }
     }
     
-    ldoc_ser_concat(opn, cls);
-    ldoc_ser_free(cls);
+    for (uint32_t dsc = frz->fst[nde]; dsc != LDOC_FRZ_NULL; dsc = frz->nxt[dsc])
+    {
+        if (!ldoc_frz_anno_eq(&(frz->anno[dsc]), *pth))
+            continue;
+        
+        if (plen == 1)
+        {
+            *isnde = true;
+            
+            return dsc;
+        }
+        
+        uint32_t res = ldoc_frz_find_anno_nde(frz, dsc, &pth[1], plen - 1, isnde);
+        
+        if (res != LDOC_FRZ_NULL)
+            return res;
+    }
     
-    return opn;
+    return LDOC_FRZ_NULL;
 }
 
-ldoc_ser_t* ldoc_format_json(ldoc_doc_t* doc)
+uint32_t ldoc_frz_find_anno(ldoc_frz_t* frz, char** pth, size_t plen, bool* nde)
 {
-    ldoc_vis_nde_ord_t* vis_nde = ldoc_vis_nde_ord_new();
-    vis_nde->vis_setup = ldoc_vis_setup_json;
-    vis_nde->vis_teardown = ldoc_vis_teardown_json;
-    ldoc_vis_nde_uni(&(vis_nde->pre), ldoc_vis_nde_pre_json);
-    ldoc_vis_nde_uni(&(vis_nde->infx), ldoc_vis_nde_infx_json);
-    ldoc_vis_nde_uni(&(vis_nde->post), ldoc_vis_nde_post_json);
-    
-    ldoc_vis_ent_t* vis_ent = ldoc_vis_ent_new();
-    ldoc_vis_ent_uni(vis_ent, ldoc_vis_ent_json);
+    if (!plen)
+        return LDOC_FRZ_NULL;
     
-    ldoc_ser_t* ser = ldoc_format(doc, vis_nde, vis_ent);
+    return ldoc_frz_find_anno_nde(frz, 0, pth, plen, nde);
+}
 
-    ldoc_vis_nde_ord_free(vis_nde);
-    ldoc_vis_ent_free(vis_ent);
+static inline void ldoc_frz_json_lbl(ldoc_snk_t* snk, const char* pfx, uint32_t idx)
+{
+    char lbl[LDOC_NUM_LEN + 8];
+    int len = snprintf(lbl, sizeof(lbl), "\"%s-%x\":", pfx, idx);
     
-    return ser;
+    ldoc_snk_appnd(snk, lbl, len);
 }
 
-static inline uint64_t ldoc_nde_ent_skip(ldoc_nde_t* nde, uint64_t off)
+static inline void ldoc_frz_json_str(ldoc_snk_t* snk, ldoc_raw_t* raw)
 {
-    ldoc_ent_t* ent;
-    TAILQ_FOREACH(ent, &(nde->ents), ldoc_ent_entries)
-    {
-        // TODO Assumes entity type string.
-        if (ent->pld.str)
-            off += strlen(ent->pld.str);
-    }
-    
-    return off;
+    ldoc_snk_appnd(snk, "\"", 1);
+    ldoc_snk_appnd(snk, (const char*)raw->pld, raw->len);
+    ldoc_snk_appnd(snk, "\"", 1);
 }
 
-ldoc_pos_t* ldoc_find_pos_trv(ldoc_nde_t* nde, uint64_t* cur, u_int64_t off)
+// Entity `ent` of node `nde`; equivalent to `ldoc_vis_ent_json`:
+static inline void ldoc_frz_json_ent(ldoc_frz_t* frz, uint32_t nde, uint32_t ent, ldoc_snk_t* snk)
 {
-    uint64_t end = ldoc_nde_ent_skip(nde, *cur);
+    uint8_t tpe = frz->ent_tpe[ent];
+    uint8_t rep = frz->ent_rep[ent];
+    ldoc_anno_pld_t* dtm = &(frz->ent_dtm[ent]);
+    bool ol = frz->tpe[nde] == LDOC_NDE_OL;
+    bool pair = ldoc_ent_pair(tpe);
     
-    if (*cur <= off && off <= end)
+    if (ent > frz->ents[nde])
+        ldoc_snk_appnd(snk, ",", 1);
+    
+    // Labels:
+    if (pair)
     {
-        ldoc_pos_t* pos = ldoc_pos_new(nde, cur, off);
+        if (ol)
+            ldoc_snk_appnd(snk, "{", 1);
         
-        if (!pos)
+        ldoc_frz_json_str(snk, &(frz->ent_anno[ent]));
+        ldoc_snk_appnd(snk, ":", 1);
+    }
+    else if (!ol)
+        switch (tpe)
         {
-            // TODO Error.
+            case LDOC_ENT_BL:
+                ldoc_frz_json_lbl(snk, ldoc_cnst_json_bl, ent);
+                break;
+            case LDOC_ENT_EM1:
+                ldoc_frz_json_lbl(snk, ldoc_cnst_json_em1, ent);
+                break;
+            case LDOC_ENT_EM2:
+                ldoc_frz_json_lbl(snk, ldoc_cnst_json_em2, ent);
+                break;
+            case LDOC_ENT_NUM:
+                ldoc_frz_json_lbl(snk, ldoc_cnst_json_num, ent);
+                break;
+            case LDOC_ENT_TXT:
+                ldoc_frz_json_lbl(snk, ldoc_cnst_json_txt, ent);
+                break;
+            default:
+                break;
         }
-        
-        return pos;
-    }
     
-    ldoc_nde_t* dsc;
-    TAILQ_FOREACH(dsc, &(nde->dscs), ldoc_nde_entries)
+    // Values:
+    char num[LDOC_NUM_LEN];
+    
+    if (tpe == LDOC_ENT_BL || tpe == LDOC_ENT_BR)
     {
-        ldoc_pos_t* pos = ldoc_find_pos_trv(dsc, cur, off);
+        const char* bl = dtm->bl ? ldoc_cnst_json_true : ldoc_cnst_json_false;
         
-        if (pos)
-            return pos;
+        ldoc_snk_appnd(snk, bl, strlen(bl));
     }
+    else if (rep & LDOC_REP_I64)
+        ldoc_snk_appnd(snk, num, ldoc_i64_fmt(dtm->i64, num));
+    else if (rep & LDOC_REP_F64)
+        ldoc_snk_appnd(snk, num, ldoc_f64_fmt(dtm->f64, num));
+    else if (!dtm->raw.pld)
+        ldoc_snk_appnd(snk, ldoc_cnst_json_null, strlen(ldoc_cnst_json_null));
+    else if (tpe == LDOC_ENT_NUM || tpe == LDOC_ENT_NR)
+        ldoc_snk_appnd(snk, (const char*)dtm->raw.pld, dtm->raw.len);
+    else
+        ldoc_frz_json_str(snk, &(dtm->raw));
     
-    return LDOC_POS_NULL;
+    if (pair && ol)
+        ldoc_snk_appnd(snk, "}", 1);
 }
 
-static inline ldoc_res_t* ldoc_find_anno_dsc(ldoc_nde_t* nde, char** pth, size_t plen)
+// Opening of node `nde` (not the root); equivalent to `ldoc_vis_nde_pre_json`:
+static inline void ldoc_frz_json_pre(ldoc_frz_t* frz, uint32_t nde, ldoc_snk_t* snk)
 {
-    ldoc_res_t* res;
-    ldoc_nde_t* dsc;
-    TAILQ_FOREACH(dsc, &(nde->dscs), ldoc_nde_entries)
+    uint32_t prnt = frz->prnt[nde];
+    
+    if (frz->fst[prnt] != nde || frz->ents[prnt] != frz->ents[prnt + 1])
+        ldoc_snk_appnd(snk, ",", 1);
+    
+    if (frz->tpe[prnt] != LDOC_NDE_OL)
     {
-        if (dsc->mkup.anno.str && !strcmp(dsc->mkup.anno.str, *pth))
+        if (frz->anno[nde].pld)
         {
-            if (plen > 1)
-            {
-                res = ldoc_find_anno_nde(dsc, &pth[1], plen - 1);
-                
-                if (res != LDOC_RES_NULL)
-                    return res;
-            }
-            else
-                return ldoc_srch_new(dsc, NULL);
+            ldoc_frz_json_str(snk, &(frz->anno[nde]));
+            ldoc_snk_appnd(snk, ":", 1);
         }
+        else
+            ldoc_frz_json_lbl(snk, ldoc_cnst_json_nde, nde);
     }
     
-    return LDOC_RES_NULL;
-}
-
-inline ldoc_res_t* ldoc_find_anno_ent(ldoc_nde_t* nde, char* leaf)
-{
-    ldoc_ent_t* ent;
-    TAILQ_FOREACH(ent, &(nde->ents), ldoc_ent_entries)
-    {
-        if ((ent->tpe == LDOC_ENT_OR ||
-             ent->tpe == LDOC_ENT_NR ||
-             ent->tpe == LDOC_ENT_BR) &&
-            !strcmp(ent->pld.pair.anno.str, leaf))
-            return ldoc_srch_new(NULL, ent);
-    }
-    
-    return LDOC_RES_NULL;
+    ldoc_snk_appnd(snk, frz->tpe[nde] == LDOC_NDE_OL ? ldoc_cnst_json_lopn : ldoc_cnst_json_opn, 1);
 }
 
-inline ldoc_res_t* ldoc_find_anno_nde(ldoc_nde_t* nde, char** pth, size_t plen)
+bool ldoc_frz_format_json_to(ldoc_frz_t* frz, ldoc_snk_t* snk)
 {
-    if (!plen)
-        return LDOC_RES_NULL;
+    uint32_t nde = 0;
     
-    ldoc_res_t* res;
+    ldoc_snk_appnd(snk, ldoc_cnst_json_opn, 1);
     
-    // If path length is greater than one, then it cannot be an entity
-    // at this level (search only node descendants):
-    if (plen > 1)
-    {
-        res = ldoc_find_anno_dsc(nde, pth, plen);
-    }
-    else
+    // Iterative pre-order traversal along the first-child/next-sibling links:
+    while (true)
     {
-        // Note: plen has to be 1 here!
+        if (nde)
+            ldoc_frz_json_pre(frz, nde, snk);
         
-        // Search entities first, because it is more likely
-        // that the user is looking for a leaf in the document
-        // tree:
-        res = ldoc_find_anno_ent(nde, *pth);
+        for (uint32_t ent = frz->ents[nde]; ent < frz->ents[nde + 1]; ent++)
+            ldoc_frz_json_ent(frz, nde, ent, snk);
         
-        if (res == LDOC_RES_NULL)
-            res = ldoc_find_anno_dsc(nde, pth, plen);
+        if (frz->fst[nde] != LDOC_FRZ_NULL)
+        {
+            nde = frz->fst[nde];
+            
+            continue;
+        }
+        
+        // Close nodes until one with a next sibling is found:
+        while (nde && frz->nxt[nde] == LDOC_FRZ_NULL)
+        {
+            ldoc_snk_appnd(snk, frz->tpe[nde] == LDOC_NDE_OL ? ldoc_cnst_json_lcls : ldoc_cnst_json_cls, 1);
+            nde = frz->prnt[nde];
+        }
+        
+        if (!nde)
+            break;
+        
+        ldoc_snk_appnd(snk, frz->tpe[nde] == LDOC_NDE_OL ? ldoc_cnst_json_lcls : ldoc_cnst_json_cls, 1);
+        nde = frz->nxt[nde];
     }
     
-    return res;
-}
-
-ldoc_res_t* ldoc_find_anno(ldoc_doc_t* doc, char** pth, size_t plen)
-{
-    return ldoc_find_anno_nde(doc->rt, pth, plen);
-}
-
-ldoc_pos_t* ldoc_find_pos(ldoc_doc_t* doc, uint64_t off)
-{
-    uint64_t cur = 0;
+    ldoc_snk_appnd(snk, ldoc_cnst_json_cls, 1);
     
-    return ldoc_find_pos_trv(doc->rt, &cur, off);
-}
-
-ldoc_pos_t* ldoc_find_kw(ldoc_doc_t* doc, uint64_t off, char* str)
-{
-    return LDOC_POS_NULL;
+    return ldoc_snk_flsh(snk);
 }
 
-ldoc_trie_nde_arr_t* ldoc_find_mtchs(ldoc_doc_t* doc, uint64_t off, ldoc_trie_t* trie)
+ldoc_ser_t* ldoc_frz_format_json(ldoc_frz_t* frz)
 {
-    ldoc_trie_nde_arr_t* arr = ldoc_trie_nde_arr_new();
+    ldoc_snk_t* snk = ldoc_snk_new(0);
     
-    ldoc_ser_t* ser = ldoc_lkahead(doc, off, trie->max);
+    if (!snk)
+        return LDOC_SER_NULL;
     
-    ldoc_trie_lookup(trie, ser->pld.str, false);
+    ldoc_ser_t* ser = LDOC_SER_NULL;
     
-    return NULL;
+    if (ldoc_frz_format_json_to(frz, snk))
+    {
+        ser = ldoc_ser_new(LDOC_SER_CSTR);
+        ser->pld.str = ldoc_snk_take(snk);
+    }
+    
+    ldoc_snk_free(snk);
+    
+    return ser;
 }
@@ -9,18 +9,521 @@
 
 #include "json.h"
 
-static inline ldoc_json_prs_err_t ldoc_json_val(ldoc_nde_t* nde, char* ky, char** str, size_t* len);
-static inline ldoc_json_prs_err_t ldoc_json_arr(ldoc_nde_t* nde, char** str, size_t* len);
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LDOC_JSON_X86
+#elif defined(__aarch64__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define LDOC_JSON_NEON
+#endif
+
+// Path projection: the paths whose values are parsed, the current depth and
+// the paths whose prefixes match the keys up to that depth (one bit per path).
+typedef struct ldoc_json_prj_t
+{
+    char*** pths;
+    size_t* plens;
+    size_t dpt;
+    uint64_t act;
+} ldoc_json_prj_t;
+
+// Parser state: the consumer of parsing events and an optional path projection.
+typedef struct ldoc_json_ctx_t
+{
+    const ldoc_json_sax_t* sax;
+    void* usr;
+    ldoc_json_prj_t* prj;
+} ldoc_json_ctx_t;
+
+// Tree builder state: the document that is being populated, the node that
+// values are added to, the key of the next value (objects only) and whether
+// string payloads are copied or referenced as raw slices of the input (view mode).
+typedef struct ldoc_json_bld_t
+{
+    ldoc_doc_t* doc;
+    ldoc_nde_t* nde;
+    ldoc_raw_t ky;
+    bool kyd;
+    bool view;
+} ldoc_json_bld_t;
+
+static inline ldoc_json_prs_err_t ldoc_json_val(ldoc_json_ctx_t* ctx, char** str, size_t* len);
+static inline ldoc_json_prs_err_t ldoc_json_arr(ldoc_json_ctx_t* ctx, char** str, size_t* len);
+static ldoc_json_prs_err_t ldoc_json_prj_val(ldoc_json_ctx_t* ctx, ldoc_raw_t* ky, char** str, size_t* len);
+
+// Array elements that are objects or arrays are labelled "NA":
+static char ldoc_json_na[] = "NA";
+
+#pragma mark - Scanning Kernels
+
+// Each kernel pair returns the offset of the first non-whitespace character
+// (ws) or of the first quote or backslash (qstr) in `str`, or `len` if there
+// is none.
+//
+// Block kernels (blk) classify the 64 bytes of a block for the structural
+// index; bit i of a mask refers to byte i of the block.
+
+typedef struct ldoc_json_blk_t
+{
+    // Quotes:
+    uint64_t qt;
+    // Backslashes:
+    uint64_t bs;
+    // Whitespace:
+    uint64_t ws;
+    // Operators: '{', '}', '[', ']', ':', ',':
+    uint64_t op;
+} ldoc_json_blk_t;
+
+static inline bool ldoc_json_isws(char c)
+{
+    return c == ' ' || c == '\r' || c == '\n' || c == '\t';
+}
+
+static size_t ldoc_json_ws_scl(const char* str, size_t len)
+{
+    size_t i = 0;
+    
+    while (i < len && ldoc_json_isws(str[i]))
+        i++;
+    
+    return i;
+}
+
+static size_t ldoc_json_qstr_scl(const char* str, size_t len)
+{
+    size_t i = 0;
+    
+    while (i < len && str[i] != '"' && str[i] != '\\')
+        i++;
+    
+    return i;
+}
+
+static void ldoc_json_blk_scl(const char* str, ldoc_json_blk_t* blk)
+{
+    blk->qt = blk->bs = blk->ws = blk->op = 0;
+    
+    for (int i = 0; i < 64; i++)
+    {
+        uint64_t bit = 1ULL << i;
+        
+        switch (str[i])
+        {
+            case '"':
+                blk->qt |= bit;
+                break;
+            case '\\':
+                blk->bs |= bit;
+                break;
+            case ' ':
+            case '\r':
+            case '\n':
+            case '\t':
+                blk->ws |= bit;
+                break;
+            case '{':
+            case '}':
+            case '[':
+            case ']':
+            case ':':
+            case ',':
+                blk->op |= bit;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+#ifdef LDOC_JSON_X86
+
+__attribute__((target("sse2")))
+static size_t ldoc_json_ws_sse2(const char* str, size_t len)
+{
+    const __m128i sp = _mm_set1_epi8(' ');
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i nl = _mm_set1_epi8('\n');
+    const __m128i tb = _mm_set1_epi8('\t');
+    
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(str + i));
+        __m128i ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, sp), _mm_cmpeq_epi8(v, cr)),
+                                  _mm_or_si128(_mm_cmpeq_epi8(v, nl), _mm_cmpeq_epi8(v, tb)));
+        uint32_t msk = ~(uint32_t)_mm_movemask_epi8(ws) & 0xffff;
+        
+        if (msk)
+            return i + __builtin_ctz(msk);
+    }
+    
+    return i + ldoc_json_ws_scl(str + i, len - i);
+}
+
+__attribute__((target("sse2")))
+static size_t ldoc_json_qstr_sse2(const char* str, size_t len)
+{
+    const __m128i qt = _mm_set1_epi8('"');
+    const __m128i bs = _mm_set1_epi8('\\');
+    
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(str + i));
+        uint32_t msk = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, qt), _mm_cmpeq_epi8(v, bs)));
+        
+        if (msk)
+            return i + __builtin_ctz(msk);
+    }
+    
+    return i + ldoc_json_qstr_scl(str + i, len - i);
+}
+
+__attribute__((target("avx2")))
+static size_t ldoc_json_ws_avx2(const char* str, size_t len)
+{
+    const __m256i sp = _mm256_set1_epi8(' ');
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i nl = _mm256_set1_epi8('\n');
+    const __m256i tb = _mm256_set1_epi8('\t');
+    
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(str + i));
+        __m256i ws = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, sp), _mm256_cmpeq_epi8(v, cr)),
+                                     _mm256_or_si256(_mm256_cmpeq_epi8(v, nl), _mm256_cmpeq_epi8(v, tb)));
+        uint32_t msk = ~(uint32_t)_mm256_movemask_epi8(ws);
+        
+        if (msk)
+            return i + __builtin_ctz(msk);
+    }
+    
+    return i + ldoc_json_ws_sse2(str + i, len - i);
+}
+
+__attribute__((target("avx2")))
+static size_t ldoc_json_qstr_avx2(const char* str, size_t len)
+{
+    const __m256i qt = _mm256_set1_epi8('"');
+    const __m256i bs = _mm256_set1_epi8('\\');
+    
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(str + i));
+        uint32_t msk = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, qt), _mm256_cmpeq_epi8(v, bs)));
+        
+        if (msk)
+            return i + __builtin_ctz(msk);
+    }
+    
+    return i + ldoc_json_qstr_sse2(str + i, len - i);
+}
+
+__attribute__((target("sse2")))
+static void ldoc_json_blk_sse2(const char* str, ldoc_json_blk_t* blk)
+{
+    const __m128i qt = _mm_set1_epi8('"');
+    const __m128i bs = _mm_set1_epi8('\\');
+    const __m128i sp = _mm_set1_epi8(' ');
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i nl = _mm_set1_epi8('\n');
+    const __m128i tb = _mm_set1_epi8('\t');
+    const __m128i lc = _mm_set1_epi8(0x20);
+    const __m128i ob = _mm_set1_epi8('{');
+    const __m128i cb = _mm_set1_epi8('}');
+    const __m128i cl = _mm_set1_epi8(':');
+    const __m128i cm = _mm_set1_epi8(',');
+    
+    blk->qt = blk->bs = blk->ws = blk->op = 0;
+    
+    for (int i = 0; i < 64; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(str + i));
+        // '[' and ']' turn into '{' and '}' when setting bit 5:
+        __m128i l = _mm_or_si128(v, lc);
+        __m128i ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, sp), _mm_cmpeq_epi8(v, cr)),
+                                  _mm_or_si128(_mm_cmpeq_epi8(v, nl), _mm_cmpeq_epi8(v, tb)));
+        __m128i op = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(l, ob), _mm_cmpeq_epi8(l, cb)),
+                                  _mm_or_si128(_mm_cmpeq_epi8(v, cl), _mm_cmpeq_epi8(v, cm)));
+        
+        blk->qt |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, qt)) << i;
+        blk->bs |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, bs)) << i;
+        blk->ws |= (uint64_t)(uint16_t)_mm_movemask_epi8(ws) << i;
+        blk->op |= (uint64_t)(uint16_t)_mm_movemask_epi8(op) << i;
+    }
+}
+
+__attribute__((target("avx2")))
+static void ldoc_json_blk_avx2(const char* str, ldoc_json_blk_t* blk)
+{
+    const __m256i qt = _mm256_set1_epi8('"');
+    const __m256i bs = _mm256_set1_epi8('\\');
+    const __m256i sp = _mm256_set1_epi8(' ');
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i nl = _mm256_set1_epi8('\n');
+    const __m256i tb = _mm256_set1_epi8('\t');
+    const __m256i lc = _mm256_set1_epi8(0x20);
+    const __m256i ob = _mm256_set1_epi8('{');
+    const __m256i cb = _mm256_set1_epi8('}');
+    const __m256i cl = _mm256_set1_epi8(':');
+    const __m256i cm = _mm256_set1_epi8(',');
+    
+    blk->qt = blk->bs = blk->ws = blk->op = 0;
+    
+    for (int i = 0; i < 64; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(str + i));
+        // '[' and ']' turn into '{' and '}' when setting bit 5:
+        __m256i l = _mm256_or_si256(v, lc);
+        __m256i ws = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, sp), _mm256_cmpeq_epi8(v, cr)),
+                                     _mm256_or_si256(_mm256_cmpeq_epi8(v, nl), _mm256_cmpeq_epi8(v, tb)));
+        __m256i op = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(l, ob), _mm256_cmpeq_epi8(l, cb)),
+                                     _mm256_or_si256(_mm256_cmpeq_epi8(v, cl), _mm256_cmpeq_epi8(v, cm)));
+        
+        blk->qt |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, qt)) << i;
+        blk->bs |= (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, bs)) << i;
+        blk->ws |= (uint64_t)(uint32_t)_mm256_movemask_epi8(ws) << i;
+        blk->op |= (uint64_t)(uint32_t)_mm256_movemask_epi8(op) << i;
+    }
+}
+
+#endif // #ifdef LDOC_JSON_X86
+
+#ifdef LDOC_JSON_NEON
+
+// Narrows a byte mask (0x00/0xff per lane) to 4 bits per lane, so that the
+// position of the first set lane is the number of trailing zeros divided by 4:
+static inline uint64_t ldoc_json_neon_msk(uint8x16_t v)
+{
+    return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(v), 4)), 0);
+}
+
+static size_t ldoc_json_ws_neon(const char* str, size_t len)
+{
+    const uint8x16_t sp = vdupq_n_u8(' ');
+    const uint8x16_t cr = vdupq_n_u8('\r');
+    const uint8x16_t nl = vdupq_n_u8('\n');
+    const uint8x16_t tb = vdupq_n_u8('\t');
+    
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        uint8x16_t v = vld1q_u8((const uint8_t*)(str + i));
+        uint8x16_t ws = vorrq_u8(vorrq_u8(vceqq_u8(v, sp), vceqq_u8(v, cr)),
+                                 vorrq_u8(vceqq_u8(v, nl), vceqq_u8(v, tb)));
+        uint64_t msk = ~ldoc_json_neon_msk(ws);
+        
+        if (msk)
+            return i + (__builtin_ctzll(msk) >> 2);
+    }
+    
+    return i + ldoc_json_ws_scl(str + i, len - i);
+}
+
+static size_t ldoc_json_qstr_neon(const char* str, size_t len)
+{
+    const uint8x16_t qt = vdupq_n_u8('"');
+    const uint8x16_t bs = vdupq_n_u8('\\');
+    
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16)
+    {
+        uint8x16_t v = vld1q_u8((const uint8_t*)(str + i));
+        uint64_t msk = ldoc_json_neon_msk(vorrq_u8(vceqq_u8(v, qt), vceqq_u8(v, bs)));
+        
+        if (msk)
+            return i + (__builtin_ctzll(msk) >> 2);
+    }
+    
+    return i + ldoc_json_qstr_scl(str + i, len - i);
+}
+
+// Turns four byte masks (0x00/0xff per lane) into one 64-bit mask:
+static inline uint64_t ldoc_json_neon_msk64(uint8x16_t m0, uint8x16_t m1, uint8x16_t m2, uint8x16_t m3)
+{
+    const uint8x16_t bit = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80,
+                             0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80 };
+    
+    uint8x16_t s0 = vpaddq_u8(vandq_u8(m0, bit), vandq_u8(m1, bit));
+    uint8x16_t s1 = vpaddq_u8(vandq_u8(m2, bit), vandq_u8(m3, bit));
+    
+    s0 = vpaddq_u8(s0, s1);
+    s0 = vpaddq_u8(s0, s0);
+    
+    return vgetq_lane_u64(vreinterpretq_u64_u8(s0), 0);
+}
+
+static void ldoc_json_blk_neon(const char* str, ldoc_json_blk_t* blk)
+{
+    const uint8x16_t lc = vdupq_n_u8(0x20);
+    uint8x16_t qt[4], bs[4], ws[4], op[4];
+    
+    for (int i = 0; i < 4; i++)
+    {
+        uint8x16_t v = vld1q_u8((const uint8_t*)(str + 16 * i));
+        // '[' and ']' turn into '{' and '}' when setting bit 5:
+        uint8x16_t l = vorrq_u8(v, lc);
+        
+        qt[i] = vceqq_u8(v, vdupq_n_u8('"'));
+        bs[i] = vceqq_u8(v, vdupq_n_u8('\\'));
+        ws[i] = vorrq_u8(vorrq_u8(vceqq_u8(v, vdupq_n_u8(' ')), vceqq_u8(v, vdupq_n_u8('\r'))),
+                         vorrq_u8(vceqq_u8(v, vdupq_n_u8('\n')), vceqq_u8(v, vdupq_n_u8('\t'))));
+        op[i] = vorrq_u8(vorrq_u8(vceqq_u8(l, vdupq_n_u8('{')), vceqq_u8(l, vdupq_n_u8('}'))),
+                         vorrq_u8(vceqq_u8(v, vdupq_n_u8(':')), vceqq_u8(v, vdupq_n_u8(','))));
+    }
+    
+    blk->qt = ldoc_json_neon_msk64(qt[0], qt[1], qt[2], qt[3]);
+    blk->bs = ldoc_json_neon_msk64(bs[0], bs[1], bs[2], bs[3]);
+    blk->ws = ldoc_json_neon_msk64(ws[0], ws[1], ws[2], ws[3]);
+    blk->op = ldoc_json_neon_msk64(op[0], op[1], op[2], op[3]);
+}
+
+#endif // #ifdef LDOC_JSON_NEON
+
+static size_t ldoc_json_ws_dsp(const char* str, size_t len);
+static size_t ldoc_json_qstr_dsp(const char* str, size_t len);
+static void ldoc_json_blk_dsp(const char* str, ldoc_json_blk_t* blk);
+
+// Kernels in use; they point to the dispatchers until the kernels are picked.
+// Accesses are atomic, since readers on other threads (see
+// `ldoc_ldjson_read_btch`) may load them while they are being picked:
+static size_t (* _Atomic ldoc_json_ws_krnl)(const char* str, size_t len) = ldoc_json_ws_dsp;
+static size_t (* _Atomic ldoc_json_qstr_krnl)(const char* str, size_t len) = ldoc_json_qstr_dsp;
+static void (* _Atomic ldoc_json_blk_krnl)(const char* str, ldoc_json_blk_t* blk) = ldoc_json_blk_dsp;
+
+static pthread_once_t ldoc_json_krnl_once = PTHREAD_ONCE_INIT;
+
+static inline size_t ldoc_json_ws(const char* str, size_t len)
+{
+    return atomic_load_explicit(&ldoc_json_ws_krnl, memory_order_relaxed)(str, len);
+}
+
+static inline size_t ldoc_json_qstr_scn(const char* str, size_t len)
+{
+    return atomic_load_explicit(&ldoc_json_qstr_krnl, memory_order_relaxed)(str, len);
+}
+
+static inline void ldoc_json_blk(const char* str, ldoc_json_blk_t* blk)
+{
+    atomic_load_explicit(&ldoc_json_blk_krnl, memory_order_relaxed)(str, blk);
+}
+
+static inline void ldoc_json_krnl_set(size_t (*ws)(const char* str, size_t len), size_t (*qstr)(const char* str, size_t len), void (*blk)(const char* str, ldoc_json_blk_t* blk))
+{
+    atomic_store_explicit(&ldoc_json_ws_krnl, ws, memory_order_relaxed);
+    atomic_store_explicit(&ldoc_json_qstr_krnl, qstr, memory_order_relaxed);
+    atomic_store_explicit(&ldoc_json_blk_krnl, blk, memory_order_relaxed);
+}
+
+static bool ldoc_json_krnl_sel(ldoc_json_krnl_t krnl)
+{
+    switch (krnl)
+    {
+        case LDOC_JSON_KRNL_AUTO:
+#if defined(LDOC_JSON_X86)
+            return ldoc_json_krnl_sel(__builtin_cpu_supports("avx2") ? LDOC_JSON_KRNL_AVX2 : LDOC_JSON_KRNL_SSE2);
+#elif defined(LDOC_JSON_NEON)
+            return ldoc_json_krnl_sel(LDOC_JSON_KRNL_NEON);
+#else
+            return ldoc_json_krnl_sel(LDOC_JSON_KRNL_SCL);
+#endif
+        case LDOC_JSON_KRNL_SCL:
+            ldoc_json_krnl_set(ldoc_json_ws_scl, ldoc_json_qstr_scl, ldoc_json_blk_scl);
+            return true;
+#ifdef LDOC_JSON_X86
+        case LDOC_JSON_KRNL_SSE2:
+            if (!__builtin_cpu_supports("sse2"))
+                return false;
+            ldoc_json_krnl_set(ldoc_json_ws_sse2, ldoc_json_qstr_sse2, ldoc_json_blk_sse2);
+            return true;
+        case LDOC_JSON_KRNL_AVX2:
+            if (!__builtin_cpu_supports("avx2"))
+                return false;
+            ldoc_json_krnl_set(ldoc_json_ws_avx2, ldoc_json_qstr_avx2, ldoc_json_blk_avx2);
+            return true;
+#endif // #ifdef LDOC_JSON_X86
+#ifdef LDOC_JSON_NEON
+        case LDOC_JSON_KRNL_NEON:
+            ldoc_json_krnl_set(ldoc_json_ws_neon, ldoc_json_qstr_neon, ldoc_json_blk_neon);
+            return true;
+#endif // #ifdef LDOC_JSON_NEON
+        default:
+            return false;
+    }
+}
+
+static void ldoc_json_krnl_auto(void)
+{
+    ldoc_json_krnl_sel(LDOC_JSON_KRNL_AUTO);
+}
+
+// Picks the best kernels exactly once, however many threads get here first:
+static inline void ldoc_json_krnl_init(void)
+{
+    pthread_once(&ldoc_json_krnl_once, ldoc_json_krnl_auto);
+}
+
+bool ldoc_json_krnl(ldoc_json_krnl_t krnl)
+{
+    // Kernels picked here must not be overridden by the automatic pick:
+    ldoc_json_krnl_init();
+    
+    return ldoc_json_krnl_sel(krnl);
+}
+
+static size_t ldoc_json_ws_dsp(const char* str, size_t len)
+{
+    ldoc_json_krnl_init();
+    
+    return ldoc_json_ws(str, len);
+}
+
+static size_t ldoc_json_qstr_dsp(const char* str, size_t len)
+{
+    ldoc_json_krnl_init();
+    
+    return ldoc_json_qstr_scn(str, len);
+}
+
+static void ldoc_json_blk_dsp(const char* str, ldoc_json_blk_t* blk)
+{
+    ldoc_json_krnl_init();
+    
+    ldoc_json_blk(str, blk);
+}
+
+#pragma mark - Parser
 
 static inline char* ldoc_json_skpws(char* str, size_t* len)
 {
-    while ((*str == ' ' || *str == '\r' || *str == '\n' || *str == '\t') && *len)
+    // Tokens are mostly separated by no or a single whitespace character; only
+    // hand longer runs (indentation) to the kernel:
+    if (!*len || !ldoc_json_isws(*str))
+        return str;
+    
+    if (*len == 1 || !ldoc_json_isws(str[1]))
     {
-        str++;
         (*len)--;
+        
+        return str + 1;
     }
     
-    return str;
+    size_t n = ldoc_json_ws(str, *len);
+    
+    *len -= n;
+    
+    return str + n;
 }
 
 static inline bool ldoc_json_iter(char** str, size_t* len)
@@ -85,7 +588,7 @@ static inline bool ldoc_json_dgts(char** str, size_t* len)
     return true;
 }
 
-static inline char* ldoc_json_num(char** str, size_t* len)
+static inline bool ldoc_json_num(char** str, size_t* len, ldoc_raw_t* raw)
 {
     char* bgn = *str;
     
@@ -98,7 +601,7 @@ static inline char* ldoc_json_num(char** str, size_t* len)
 
     // Digits before a decimal point:
     if (!ldoc_json_dgts(str, len))
-        return NULL;
+        return false;
     
     // Decimal point:
     if (*len && **str == '.')
@@ -108,7 +611,7 @@ static inline char* ldoc_json_num(char** str, size_t* len)
         
         // Digits after a decimal point:
         if (!ldoc_json_dgts(str, len))
-            return NULL;
+            return false;
     }
     
     // Exponent:
@@ -126,53 +629,54 @@ static inline char* ldoc_json_num(char** str, size_t* len)
         
         // Digits in the exponent:
         if (!ldoc_json_dgts(str, len))
-            return NULL;
+            return false;
     }
     
     if (*len)
     {
-        char* s = strndup(bgn, *str - bgn);
-        
-        // TODO Error handling.
+        raw->pld = (uint8_t*)bgn;
+        raw->len = *str - bgn;
         
-        return s;
+        return true;
     }
     
-    return NULL;
+    return false;
 }
 
-static inline char* ldoc_json_qstr(char** str, size_t* len)
+static inline bool ldoc_json_qstr(char** str, size_t* len, ldoc_raw_t* raw)
 {
     // Skip '"':
     (*str)++;
     (*len)--;
     
     char* bgn = *str;
-    while (*len && **str != '"')
+    while (*len)
     {
-        if (**str == '\\')
+        // Skip to the next quote or backslash:
+        size_t n = ldoc_json_qstr_scn(*str, *len);
+        
+        *str += n;
+        *len -= n;
+        
+        if (!*len || **str == '"')
+            break;
+        
+        // Backslash:
+        (*str)++;
+        (*len)--;
+        
+        // Premature end of string:
+        if (!*len)
+            return false;
+        
+        // Unicode escape:
+        if (**str == 'u')
         {
-            (*str)++;
-            (*len)--;
-            
-            // Premature end of string:
-            if (!*len)
-                return NULL;
+            if (*len < 4)
+                return false;
             
-            // Unicode escape:
-            if (**str == 'u')
-            {
-                if (*len < 4)
-                    return NULL;
-                
-                *str += 4;
-                *len -= 4;
-            }
-            else
-            {
-                (*str)++;
-                (*len)--;
-            }
+            *str += 4;
+            *len -= 4;
         }
         else
         {
@@ -183,295 +687,2021 @@ static inline char* ldoc_json_qstr(char** str, size_t* len)
     
     if (*len && **str == '"')
     {
-        char* s = strndup(bgn, *str - bgn);
-        
-        // TODO Error handling.
+        raw->pld = (uint8_t*)bgn;
+        raw->len = *str - bgn;
         
         // Skip '"':
         (*str)++;
         (*len)--;
         
-        return s;
+        return true;
     }
     
-    return NULL;
+    return false;
 }
 
-static inline ldoc_json_prs_err_t ldoc_json_obj(ldoc_nde_t* nde, char** str, size_t* len)
+static inline bool ldoc_json_anno(ldoc_json_bld_t* bld, ldoc_anno_pld_t* pld, ldoc_raw_t* raw)
 {
-    // Skip '{':
-    (*str)++;
-    (*len)--;
-    
-    do
+    if (bld->view)
     {
-        *str = ldoc_json_skpws(*str, len);
+        pld->raw = *raw;
         
-        if (len && **str == '}')
-        {
-            // Skip '}':
-            (*str)++;
-            (*len)--;
+        return true;
+    }
+    
+    pld->str = ldoc_doc_strndup(bld->doc, (char*)raw->pld, raw->len);
+    
+    return pld->str;
+}
 
-            return LDOC_JSON_OK;
-        }
-        
-        if (!len || **str != '"')
-            return LDOC_JSON_INV;
-        
-        char* ky = ldoc_json_qstr(str, len);
-        
-        *str = ldoc_json_skpws(*str, len);
-        
-        // Colon (key/value separator):
-        if (!*len || **str != ':')
-            return LDOC_JSON_INV;
-        
-        // Skip ':':
-        (*str)++;
-        (*len)--;
+// Keys are interned if the document has an interning table:
+static inline bool ldoc_json_ky(ldoc_json_bld_t* bld, ldoc_anno_pld_t* pld, ldoc_raw_t* raw)
+{
+    if (!bld->doc->intn)
+        return ldoc_json_anno(bld, pld, raw);
+    
+    char* str = ldoc_intn_str(bld->doc->intn, (char*)raw->pld, raw->len);
+    
+    if (!str)
+        return false;
+    
+    if (bld->view)
+        pld->raw = (ldoc_raw_t){ (uint8_t*)str, raw->len };
+    else
+        pld->str = str;
+    
+    return true;
+}
 
-        *str = ldoc_json_skpws(*str, len);
-        
-        if (!*len)
-            return LDOC_JSON_INV;
+static inline bool ldoc_json_pld(ldoc_json_bld_t* bld, ldoc_pld_t* pld, ldoc_raw_t* raw)
+{
+    if (bld->view)
+    {
+        pld->raw = *raw;
         
-        // Object type (object/array) or some primitive?
-        if (**str == '{' || **str == '[')
-        {
-            ldoc_nde_t* dsc = ldoc_nde_new(**str == '{' ? LDOC_NDE_UA : LDOC_NDE_OL);
-            
-            // TODO Error handling.
-            
-            dsc->mkup.anno.str = ky;
-            
-            ldoc_json_prs_err_t err;
-            if (**str == '{')
-                err = ldoc_json_obj(dsc, str, len);
-            else
-                err = ldoc_json_arr(dsc, str, len);
+        return true;
+    }
+    
+    pld->str = ldoc_doc_strndup(bld->doc, (char*)raw->pld, raw->len);
+    
+    return pld->str;
+}
+
+#pragma mark - Tree Building
+
+// The tree builder is a consumer of parsing events; both parser backends
+// emit the same events, so that they create identical documents.
+
+// Key of the value at hand, which is used up by it:
+static inline ldoc_raw_t* ldoc_json_bld_ky_(ldoc_json_bld_t* bld)
+{
+    if (!bld->kyd)
+        return NULL;
+    
+    bld->kyd = false;
+    
+    return &(bld->ky);
+}
+
+static inline bool ldoc_json_bld_dsc(ldoc_json_bld_t* bld, bool obj)
+{
+    ldoc_raw_t* ky = ldoc_json_bld_ky_(bld);
+    ldoc_nde_t* dsc = ldoc_doc_nde_new(bld->doc, obj ? LDOC_NDE_UA : LDOC_NDE_OL);
+    
+    // Returning false makes the reader fail and release the document:
+    if (!dsc)
+        return false;
+    
+    ldoc_raw_t na = { (uint8_t*)ldoc_json_na, 2 };
+    dsc->rep = bld->view ? LDOC_REP_RAW : LDOC_REP_STR;
+    
+    if (!ldoc_json_ky(bld, &(dsc->mkup.anno), ky ? ky : &na))
+    {
+        // Arena allocations are released with the document:
+        if (!bld->doc->arna)
+            ldoc_nde_free(dsc);
+        
+        return false;
+    }
+    
+    // Attach first, so that partially parsed nodes are released with the document:
+    ldoc_nde_dsc_push(bld->nde, dsc);
+    bld->nde = dsc;
+    
+    return true;
+}
+
+// Exactly representable powers of ten for the fast path of number conversion:
+static const double ldoc_json_pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Converts a validated JSON number into its binary value (`LDOC_REP_I64` or
+// `LDOC_REP_F64`), or returns `LDOC_REP_STR` if it is kept as text, which is the
+// case for integers beyond 64 bits and for numbers beyond double precision range:
+static inline uint8_t ldoc_json_num_val(const char* str, size_t len, int64_t* i64, double* f64)
+{
+    const char* end = str + len;
+    const char* c = str;
+    bool neg = *c == '-';
+    uint64_t mnt = 0;
+    size_t dgts = 0;
+    int64_t exp = 0;
+    bool flt = false;
+    
+    if (neg)
+        c++;
+    
+    // Mantissa digits, of which at most 19 are accumulated:
+    for (; c < end && *c >= '0' && *c <= '9'; c++)
+    {
+        if (dgts < 19)
+            mnt = mnt * 10 + (*c - '0');
+        else
+            exp++;
+        
+        if (mnt)
+            dgts++;
+    }
+    
+    if (c < end && *c == '.')
+    {
+        flt = true;
+        
+        for (c++; c < end && *c >= '0' && *c <= '9'; c++)
+        {
+            if (dgts < 19)
+            {
+                mnt = mnt * 10 + (*c - '0');
+                exp--;
+            }
+            
+            if (mnt)
+                dgts++;
+        }
+    }
+    
+    if (c < end && (*c == 'e' || *c == 'E'))
+    {
+        flt = true;
+        c++;
+        
+        bool eneg = *c == '-';
+        int64_t e = 0;
+        
+        if (*c == '-' || *c == '+')
+            c++;
+        
+        for (; c < end && *c >= '0' && *c <= '9'; c++)
+            if (e < 100000)
+                e = e * 10 + (*c - '0');
+        
+        exp += eneg ? -e : e;
+    }
+    
+    // Integers; negative zero is only representable as a double:
+    if (!flt)
+    {
+        if (neg && !mnt)
+        {
+            *f64 = -0.0;
+            
+            return LDOC_REP_F64;
+        }
+        
+        if (exp || mnt > (uint64_t)INT64_MAX + neg)
+            return LDOC_REP_STR;
+        
+        *i64 = neg ? (int64_t)(0 - mnt) : (int64_t)mnt;
+        
+        return LDOC_REP_I64;
+    }
+    
+    // Fast path: mantissa and power of ten are exact doubles, so that a
+    // single correctly rounded operation yields the correctly rounded result:
+    if (dgts <= 19 && mnt <= (1ULL << 53) && exp >= -22 && exp <= 22)
+    {
+        double d = (double)mnt;
+        
+        d = exp < 0 ? d / ldoc_json_pow10[-exp] : d * ldoc_json_pow10[exp];
+        *f64 = neg ? -d : d;
+        
+        return LDOC_REP_F64;
+    }
+    
+    // Slow path; the input is not null-terminated, so it is copied (onto the
+    // heap for long literals):
+    char sbuf[64];
+    char* buf = len < sizeof(sbuf) ? sbuf : (char*)malloc(len + 1);
+    
+    if (!buf)
+        return LDOC_REP_STR;
+    
+    memcpy(buf, str, len);
+    buf[len] = 0;
+    
+    double d = strtod(buf, NULL);
+    
+    if (buf != sbuf)
+        free(buf);
+    
+    if (!isfinite(d))
+        return LDOC_REP_STR;
+    
+    *f64 = d;
+    
+    return LDOC_REP_F64;
+}
+
+// Attaches a completed entity, or releases it if its payload could not be allocated:
+static inline bool ldoc_json_bld_ent_push(ldoc_json_bld_t* bld, ldoc_ent_t* ent, uint8_t rep, bool ok)
+{
+    if (!ok)
+    {
+        // Arena allocations are released with the document:
+        if (!bld->doc->arna)
+            ldoc_ent_free(ent);
+        
+        return false;
+    }
+    
+    ent->rep |= rep;
+    
+    ldoc_nde_ent_push(bld->nde, ent);
+    
+    return true;
+}
+
+static inline bool ldoc_json_bld_ent(ldoc_json_bld_t* bld, const char* str, size_t len, bool num)
+{
+    ldoc_raw_t* ky = ldoc_json_bld_ky_(bld);
+    ldoc_raw_t val = { (uint8_t*)str, len };
+    ldoc_ent_t* ent;
+    
+    if (num)
+        ent = ldoc_doc_ent_new(bld->doc, ky ? LDOC_ENT_NR : LDOC_ENT_NUM);
+    else
+        ent = ldoc_doc_ent_new(bld->doc, ky ? LDOC_ENT_OR : LDOC_ENT_TXT);
+    
+    if (!ent)
+        return false;
+    
+    ent->rep = bld->view ? LDOC_REP_RAW : LDOC_REP_STR;
+    
+    int64_t i64 = 0;
+    double f64 = 0;
+    uint8_t nrep = num ? ldoc_json_num_val(str, len, &i64, &f64) : LDOC_REP_STR;
+    ldoc_anno_pld_t* dtm = ky ? &(ent->pld.pair.dtm) : NULL;
+    bool ok = true;
+    
+    if (ky && !ldoc_json_ky(bld, &(ent->pld.pair.anno), ky))
+        return ldoc_json_bld_ent_push(bld, ent, nrep, false);
+    
+    if (nrep == LDOC_REP_I64)
+    {
+        if (dtm)
+            dtm->i64 = i64;
+        else
+            ent->pld.i64 = i64;
+    }
+    else if (nrep == LDOC_REP_F64)
+    {
+        if (dtm)
+            dtm->f64 = f64;
+        else
+            ent->pld.f64 = f64;
+    }
+    else if (dtm)
+        ok = ldoc_json_anno(bld, dtm, &val);
+    else
+        ok = ldoc_json_pld(bld, &(ent->pld), &val);
+    
+    return ldoc_json_bld_ent_push(bld, ent, nrep, ok);
+}
+
+static inline bool ldoc_json_bld_kw(ldoc_json_bld_t* bld, ldoc_json_kwval_t kwval)
+{
+    ldoc_raw_t* ky = ldoc_json_bld_ky_(bld);
+    ldoc_content_t tpe;
+    
+    if (kwval == LDOC_JSON_NULL)
+        tpe = ky ? LDOC_ENT_OR : LDOC_ENT_TXT;
+    else
+        tpe = ky ? LDOC_ENT_BR : LDOC_ENT_BL;
+    
+    ldoc_ent_t* ent = ldoc_doc_ent_new(bld->doc, tpe);
+    
+    if (!ent)
+        return false;
+    
+    ent->rep = bld->view ? LDOC_REP_RAW : LDOC_REP_STR;
+    
+    if (ky && !ldoc_json_ky(bld, &(ent->pld.pair.anno), ky))
+        return ldoc_json_bld_ent_push(bld, ent, LDOC_REP_STR, false);
+    
+    switch (kwval)
+    {
+        case LDOC_JSON_NULL:
+            // Also clears raw lengths:
+            if (ky)
+                ent->pld.pair.dtm.raw = (ldoc_raw_t){ NULL, 0 };
+            else
+                ent->pld.raw = (ldoc_raw_t){ NULL, 0 };
+            break;
+        case LDOC_JSON_FALSE:
+            if (ky)
+                ent->pld.pair.dtm.bl = false;
+            else
+                ent->pld.bl = false;
+            break;
+        case LDOC_JSON_TRUE:
+            if (ky)
+                ent->pld.pair.dtm.bl = true;
+            else
+                ent->pld.bl = true;
+            break;
+        default:
+            // TODO This would be an internal error.
+            break;
+    }
+    
+    return ldoc_json_bld_ent_push(bld, ent, LDOC_REP_STR, true);
+}
+
+static inline bool ldoc_json_bld_obj_bgn(void* usr)
+{
+    ldoc_json_bld_t* bld = (ldoc_json_bld_t*)usr;
+    
+    // The outermost object is the document's root:
+    if (!bld->nde)
+    {
+        bld->nde = bld->doc->rt;
+        
+        return true;
+    }
+    
+    return ldoc_json_bld_dsc(bld, true);
+}
+
+static inline bool ldoc_json_bld_obj_end(void* usr)
+{
+    ldoc_json_bld_t* bld = (ldoc_json_bld_t*)usr;
+    
+    bld->nde = bld->nde->prnt;
+    
+    return true;
+}
+
+static inline bool ldoc_json_bld_arr_bgn(void* usr)
+{
+    return ldoc_json_bld_dsc((ldoc_json_bld_t*)usr, false);
+}
+
+static inline bool ldoc_json_bld_arr_end(void* usr)
+{
+    return ldoc_json_bld_obj_end(usr);
+}
+
+static inline bool ldoc_json_bld_ky(void* usr, const char* str, size_t len)
+{
+    ldoc_json_bld_t* bld = (ldoc_json_bld_t*)usr;
+    
+    bld->ky.pld = (uint8_t*)str;
+    bld->ky.len = len;
+    bld->kyd = true;
+    
+    return true;
+}
+
+static inline bool ldoc_json_bld_str(void* usr, const char* str, size_t len)
+{
+    return ldoc_json_bld_ent((ldoc_json_bld_t*)usr, str, len, false);
+}
+
+static inline bool ldoc_json_bld_num(void* usr, const char* str, size_t len)
+{
+    return ldoc_json_bld_ent((ldoc_json_bld_t*)usr, str, len, true);
+}
+
+static inline bool ldoc_json_bld_bl(void* usr, bool bl)
+{
+    return ldoc_json_bld_kw((ldoc_json_bld_t*)usr, bl ? LDOC_JSON_TRUE : LDOC_JSON_FALSE);
+}
+
+static inline bool ldoc_json_bld_nll(void* usr)
+{
+    return ldoc_json_bld_kw((ldoc_json_bld_t*)usr, LDOC_JSON_NULL);
+}
+
+static const ldoc_json_sax_t ldoc_json_bld_sax =
+{
+    ldoc_json_bld_obj_bgn,
+    ldoc_json_bld_obj_end,
+    ldoc_json_bld_arr_bgn,
+    ldoc_json_bld_arr_end,
+    ldoc_json_bld_ky,
+    ldoc_json_bld_str,
+    ldoc_json_bld_num,
+    ldoc_json_bld_bl,
+    ldoc_json_bld_nll
+};
+
+// Emits an event; true unless the consumer stops parsing. Events for the tree
+// builder are not dispatched through function pointers, so that they can be
+// inlined:
+#define LDOC_JSON_EVT(ctx, evt, ...) \
+    ((ctx)->sax == &ldoc_json_bld_sax ? \
+        ldoc_json_bld_##evt((ctx)->usr, ##__VA_ARGS__) : \
+        (!(ctx)->sax->evt || (ctx)->sax->evt((ctx)->usr, ##__VA_ARGS__)))
+
+// Keywords other than `LDOC_JSON_NKW`:
+static inline ldoc_json_prs_err_t ldoc_json_kw_evt(ldoc_json_ctx_t* ctx, ldoc_json_kwval_t kwval)
+{
+    bool cnt;
+    
+    switch (kwval)
+    {
+        case LDOC_JSON_NULL:
+            cnt = LDOC_JSON_EVT(ctx, nll);
+            break;
+        case LDOC_JSON_FALSE:
+        case LDOC_JSON_TRUE:
+            cnt = LDOC_JSON_EVT(ctx, bl, kwval == LDOC_JSON_TRUE);
+            break;
+        default:
+            return LDOC_JSON_INV;
+    }
+    
+    return cnt ? LDOC_JSON_OK : LDOC_JSON_STOP;
+}
+
+#pragma mark - Recursive Descent Parser
+
+static inline ldoc_json_prs_err_t ldoc_json_obj(ldoc_json_ctx_t* ctx, char** str, size_t* len)
+{
+    // Skip '{':
+    (*str)++;
+    (*len)--;
+    
+    if (!LDOC_JSON_EVT(ctx, obj_bgn))
+        return LDOC_JSON_STOP;
+    
+    do
+    {
+        *str = ldoc_json_skpws(*str, len);
+        
+        if (*len && **str == '}')
+            break;
+        
+        if (!*len || **str != '"')
+            return LDOC_JSON_INV;
+        
+        ldoc_raw_t ky;
+        
+        if (!ldoc_json_qstr(str, len, &ky))
+            return LDOC_JSON_INV;
+        
+        *str = ldoc_json_skpws(*str, len);
+        
+        // Colon (key/value separator):
+        if (!*len || **str != ':')
+            return LDOC_JSON_INV;
+        
+        // Skip ':':
+        (*str)++;
+        (*len)--;
+
+        *str = ldoc_json_skpws(*str, len);
+        
+        if (!*len)
+            return LDOC_JSON_INV;
+        
+        ldoc_json_prs_err_t err;
+        
+        if (ctx->prj)
+            err = ldoc_json_prj_val(ctx, &ky, str, len);
+        else if (LDOC_JSON_EVT(ctx, ky, (char*)ky.pld, ky.len))
+            err = ldoc_json_val(ctx, str, len);
+        else
+            err = LDOC_JSON_STOP;
+        
+        if (err)
+            return err;
+    } while (ldoc_json_iter(str, len));
+    
+    if (!*len || **str != '}')
+        return LDOC_JSON_INV;
+    
+    // Skip '}':
+    (*str)++;
+    (*len)--;
+    
+    return LDOC_JSON_EVT(ctx, obj_end) ? LDOC_JSON_OK : LDOC_JSON_STOP;
+}
+
+static inline ldoc_json_prs_err_t ldoc_json_arr(ldoc_json_ctx_t* ctx, char** str, size_t* len)
+{
+    // Skip '[':
+    (*str)++;
+    (*len)--;
+    
+    if (!LDOC_JSON_EVT(ctx, arr_bgn))
+        return LDOC_JSON_STOP;
+    
+    *str = ldoc_json_skpws(*str, len);
+    
+    if (!*len)
+        return LDOC_JSON_INV;
+    
+    // Empty array, skip ']', then return:
+    if (**str != ']')
+    {
+        do
+        {
+            ldoc_json_prs_err_t err = ctx->prj ? ldoc_json_prj_val(ctx, NULL, str, len) : ldoc_json_val(ctx, str, len);
+            
+            if (err)
+                return err;
+        } while (ldoc_json_iter(str, len));
+        
+        if (!*len || **str != ']')
+            return LDOC_JSON_INV;
+    }
+    
+    // Skip ']':
+    (*str)++;
+    (*len)--;
+    
+    return LDOC_JSON_EVT(ctx, arr_end) ? LDOC_JSON_OK : LDOC_JSON_STOP;
+}
+
+static inline ldoc_json_prs_err_t ldoc_json_val(ldoc_json_ctx_t* ctx, char** str, size_t* len)
+{
+    ldoc_raw_t val;
+    bool cnt;
+    
+    if (!*len)
+        return LDOC_JSON_INV;
+    
+    // Object type (object/array) or some primitive?
+    if (**str == '{')
+        return ldoc_json_obj(ctx, str, len);
+    else if (**str == '[')
+        return ldoc_json_arr(ctx, str, len);
+    else if (**str == '"')
+    {
+        if (!ldoc_json_qstr(str, len, &val))
+            return LDOC_JSON_INV;
+        
+        cnt = LDOC_JSON_EVT(ctx, str, (char*)val.pld, val.len);
+    }
+    else if (**str == '-' || (**str >= '0' && **str <= '9'))
+    {
+        if (!ldoc_json_num(str, len, &val))
+            return LDOC_JSON_INV;
+        
+        cnt = LDOC_JSON_EVT(ctx, num, (char*)val.pld, val.len);
+    }
+    else
+        return ldoc_json_kw_evt(ctx, ldoc_json_kwd(str, len));
+    
+    return cnt ? LDOC_JSON_OK : LDOC_JSON_STOP;
+}
+
+#pragma mark - Path Projection
+
+// Skips a value without emitting events; only strings and the nesting of
+// brackets are checked.
+static inline ldoc_json_prs_err_t ldoc_json_skp(char** str, size_t* len)
+{
+    size_t dpt = 0;
+    ldoc_raw_t raw;
+    
+    while (*len)
+    {
+        switch (**str)
+        {
+            case '"':
+                if (!ldoc_json_qstr(str, len, &raw))
+                    return LDOC_JSON_INV;
+                
+                if (!dpt)
+                    return LDOC_JSON_OK;
+                continue;
+            case '{':
+            case '[':
+                dpt++;
+                break;
+            case '}':
+            case ']':
+                // End of the enclosing object/array:
+                if (!dpt)
+                    return LDOC_JSON_OK;
+                
+                if (!--dpt)
+                {
+                    (*str)++;
+                    (*len)--;
+                    
+                    return LDOC_JSON_OK;
+                }
+                break;
+            case ',':
+            case ' ':
+            case '\r':
+            case '\n':
+            case '\t':
+                // End of a number or keyword:
+                if (!dpt)
+                    return LDOC_JSON_OK;
+                break;
+            default:
+                break;
+        }
+        
+        (*str)++;
+        (*len)--;
+    }
+    
+    return LDOC_JSON_INV;
+}
+
+// Value of an object member with key `ky`, or of an array element (`ky` is NULL),
+// which is parsed if it is on one of the paths, and skipped otherwise.
+static ldoc_json_prs_err_t ldoc_json_prj_val(ldoc_json_ctx_t* ctx, ldoc_raw_t* ky, char** str, size_t* len)
+{
+    ldoc_json_prj_t* prj = ctx->prj;
+    uint64_t act = prj->act;
+    uint64_t nxt = 0;
+    bool full = false;
+    // Array elements that are objects or arrays are labelled "NA":
+    const char* anno = ky ? (char*)ky->pld : ldoc_json_na;
+    size_t alen = ky ? ky->len : 2;
+    
+    for (uint64_t msk = act; msk; msk &= msk - 1)
+    {
+        size_t i = __builtin_ctzll(msk);
+        const char* cmp = prj->pths[i][prj->dpt];
+        
+        if (!strncmp(cmp, anno, alen) && !cmp[alen])
+        {
+            nxt |= 1ULL << i;
+            
+            // The whole value is on the path:
+            if (prj->plens[i] == prj->dpt + 1)
+                full = true;
+        }
+    }
+    
+    // Only objects and arrays can contain the rest of a path:
+    if (!nxt || (!full && **str != '{' && **str != '['))
+        return ldoc_json_skp(str, len);
+    
+    if (ky && !LDOC_JSON_EVT(ctx, ky, (char*)ky->pld, ky->len))
+        return LDOC_JSON_STOP;
+    
+    ldoc_json_prs_err_t err;
+    
+    if (full)
+    {
+        ctx->prj = NULL;
+        err = ldoc_json_val(ctx, str, len);
+        ctx->prj = prj;
+    }
+    else
+    {
+        prj->act = nxt;
+        prj->dpt++;
+        err = ldoc_json_val(ctx, str, len);
+        prj->dpt--;
+        prj->act = act;
+    }
+    
+    return err;
+}
+
+#pragma mark - Structural Index Parser
+
+// Stage 1 classifies the input 64 bytes at a time and records the offsets of
+// all structural characters: operators outside of strings, opening quotes and
+// the first characters of numbers/keywords. It also matches brackets, so that
+// malformed nesting is rejected before any node is allocated. Stage 2 builds
+// the tree by walking the offsets instead of the bytes.
+
+// Inline capacities of the index and the nesting stack; both grow on the heap:
+#define LDOC_JSON_IDX_POS 256
+#define LDOC_JSON_IDX_NST 16
+
+typedef struct ldoc_json_idx_t
+{
+    // Input, starting with the '{' of the object:
+    char* str;
+    // Offsets of structural characters relative to `str`:
+    uint32_t* pos;
+    size_t cnt;
+    size_t max;
+    // Nesting stack, one bit per level (set for objects):
+    uint64_t* nst;
+    size_t nmax;
+    // Stage 2 cursor:
+    size_t cur;
+    uint32_t pbuf[LDOC_JSON_IDX_POS];
+    uint64_t nbuf[LDOC_JSON_IDX_NST];
+} ldoc_json_idx_t;
+
+// Parser backend in use:
+static ldoc_json_prsr_t ldoc_json_prsr_cur = LDOC_JSON_PRSR_RD;
+
+static inline ldoc_json_prs_err_t ldoc_json_idx_val(ldoc_json_ctx_t* ctx, ldoc_json_idx_t* idx);
+
+void ldoc_json_prsr(ldoc_json_prsr_t prsr)
+{
+    ldoc_json_prsr_cur = prsr;
+}
+
+static inline void ldoc_json_idx_init(ldoc_json_idx_t* idx, char* str)
+{
+    idx->str = str;
+    idx->pos = idx->pbuf;
+    idx->cnt = 0;
+    idx->max = LDOC_JSON_IDX_POS;
+    idx->nst = idx->nbuf;
+    idx->nmax = LDOC_JSON_IDX_NST;
+    idx->cur = 0;
+}
+
+static inline void ldoc_json_idx_free(ldoc_json_idx_t* idx)
+{
+    if (idx->pos != idx->pbuf)
+        free(idx->pos);
+    
+    if (idx->nst != idx->nbuf)
+        free(idx->nst);
+}
+
+static bool ldoc_json_idx_grow(void** buf, void* ibuf, size_t* max, size_t sz)
+{
+    void* nbuf;
+    
+    if (*buf == ibuf)
+    {
+        nbuf = malloc(*max * 2 * sz);
+        
+        if (nbuf)
+            memcpy(nbuf, ibuf, *max * sz);
+    }
+    else
+        nbuf = realloc(*buf, *max * 2 * sz);
+    
+    if (!nbuf)
+        return false;
+    
+    *buf = nbuf;
+    *max *= 2;
+    
+    return true;
+}
+
+// Positions that are escaped by an odd number of backslashes; `odd` carries a
+// backslash sequence of odd length over into the next block:
+static inline uint64_t ldoc_json_idx_esc(uint64_t bs, uint64_t* odd)
+{
+    const uint64_t evn = 0x5555555555555555ULL;
+    
+    uint64_t strt = bs & ~(bs << 1);
+    uint64_t evn_strt_msk = evn ^ *odd;
+    uint64_t evn_strt = strt & evn_strt_msk;
+    uint64_t odd_strt = strt & ~evn_strt_msk;
+    uint64_t evn_crry = bs + evn_strt;
+    uint64_t odd_crry;
+    bool ovf = __builtin_add_overflow(bs, odd_strt, &odd_crry);
+    
+    odd_crry |= *odd;
+    *odd = ovf ? 1 : 0;
+    
+    uint64_t evn_end = evn_crry & ~bs;
+    uint64_t odd_end = odd_crry & ~bs;
+    
+    return (evn_end & ~evn) | (odd_end & evn);
+}
+
+// Sets all bits from an opening quote up to, but excluding, its closing quote:
+static inline uint64_t ldoc_json_idx_pxor(uint64_t qt)
+{
+    qt ^= qt << 1;
+    qt ^= qt << 2;
+    qt ^= qt << 4;
+    qt ^= qt << 8;
+    qt ^= qt << 16;
+    qt ^= qt << 32;
+    
+    return qt;
+}
+
+// Stage 1: indexes the object that `idx->str` starts with, up to and including
+// its closing '}'. On error, `*err` is set to the offending offset.
+static ldoc_json_prs_err_t ldoc_json_idx_bld(ldoc_json_idx_t* idx, size_t len, size_t* err)
+{
+    uint64_t odd = 0;
+    uint64_t instr = 0;
+    uint64_t scl = 0;
+    size_t dpt = 0;
+    
+    for (size_t bgn = 0; bgn < len; bgn += 64)
+    {
+        ldoc_json_blk_t blk;
+        
+        if (len - bgn >= 64)
+            ldoc_json_blk(idx->str + bgn, &blk);
+        else
+        {
+            // Pad the last block with whitespace:
+            char pad[64];
+            memset(pad, ' ', sizeof(pad));
+            memcpy(pad, idx->str + bgn, len - bgn);
+            ldoc_json_blk(pad, &blk);
+        }
+        
+        uint64_t qt = blk.qt & ~ldoc_json_idx_esc(blk.bs, &odd);
+        uint64_t str = ldoc_json_idx_pxor(qt) ^ instr;
+        instr = (uint64_t)((int64_t)str >> 63);
+        
+        // Numbers and keywords start after whitespace, operators or quotes:
+        uint64_t val = ~(blk.op | blk.ws | qt);
+        uint64_t vstrt = val & ~((val << 1) | scl);
+        scl = val >> 63;
+        
+        uint64_t stc = ((blk.op | vstrt) & ~str) | (qt & str);
+        
+        while (stc)
+        {
+            size_t off = bgn + __builtin_ctzll(stc);
+            stc &= stc - 1;
+            
+            if (idx->cnt == idx->max && !ldoc_json_idx_grow((void**)&idx->pos, idx->pbuf, &idx->max, sizeof(uint32_t)))
+            {
+                // TODO Error handling.
+                *err = off;
+                
+                return LDOC_JSON_INV;
+            }
+            
+            idx->pos[idx->cnt++] = (uint32_t)off;
+            
+            switch (idx->str[off])
+            {
+                case '{':
+                case '[':
+                    if (dpt == idx->nmax * 64 && !ldoc_json_idx_grow((void**)&idx->nst, idx->nbuf, &idx->nmax, sizeof(uint64_t)))
+                    {
+                        // TODO Error handling.
+                        *err = off;
+                        
+                        return LDOC_JSON_INV;
+                    }
+                    
+                    if (idx->str[off] == '{')
+                        idx->nst[dpt / 64] |= 1ULL << (dpt % 64);
+                    else
+                        idx->nst[dpt / 64] &= ~(1ULL << (dpt % 64));
+                    
+                    dpt++;
+                    break;
+                case '}':
+                case ']':
+                    if (!dpt || ((idx->nst[(dpt - 1) / 64] >> ((dpt - 1) % 64)) & 1) != (idx->str[off] == '}'))
+                    {
+                        *err = off;
+                        
+                        return LDOC_JSON_INV;
+                    }
+                    
+                    // End of the object:
+                    if (!--dpt)
+                        return LDOC_JSON_OK;
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+    
+    // Unterminated object or string:
+    *err = len;
+    
+    return LDOC_JSON_INV;
+}
+
+static inline char ldoc_json_idx_chr(ldoc_json_idx_t* idx)
+{
+    return idx->cur < idx->cnt ? idx->str[idx->pos[idx->cur]] : '\0';
+}
+
+// String at the cursor; its closing quote is the last non-whitespace character
+// before the next structural character:
+static inline bool ldoc_json_idx_qstr(ldoc_json_idx_t* idx, ldoc_raw_t* raw)
+{
+    if (idx->cur + 1 >= idx->cnt)
+        return false;
+    
+    char* bgn = idx->str + idx->pos[idx->cur] + 1;
+    char* end = idx->str + idx->pos[idx->cur + 1];
+    
+    while (end > bgn && ldoc_json_isws(end[-1]))
+        end--;
+    
+    if (end == bgn || end[-1] != '"')
+        return false;
+    
+    raw->pld = (uint8_t*)bgn;
+    raw->len = end - 1 - bgn;
+    
+    idx->cur++;
+    
+    return true;
+}
+
+// Number or keyword at the cursor; it has to span everything up to the next
+// structural character, apart from trailing whitespace:
+static inline ldoc_json_prs_err_t ldoc_json_idx_scl(ldoc_json_ctx_t* ctx, ldoc_json_idx_t* idx)
+{
+    if (idx->cur + 1 >= idx->cnt)
+        return LDOC_JSON_INV;
+    
+    char* str = idx->str + idx->pos[idx->cur];
+    char* end = idx->str + idx->pos[idx->cur + 1];
+    // The closing '}' of the object is indexed, so the scan ends before it:
+    size_t len = idx->str + idx->pos[idx->cnt - 1] + 1 - str;
+    ldoc_json_kwval_t kwval = LDOC_JSON_NKW;
+    ldoc_raw_t val;
+    
+    if (*str == '-' || (*str >= '0' && *str <= '9'))
+    {
+        if (!ldoc_json_num(&str, &len, &val))
+            return LDOC_JSON_INV;
+    }
+    else if (!(kwval = ldoc_json_kwd(&str, &len)))
+        return LDOC_JSON_INV;
+    
+    if (ldoc_json_skpws(str, &len) != end)
+        return LDOC_JSON_INV;
+    
+    idx->cur++;
+    
+    if (kwval)
+        return ldoc_json_kw_evt(ctx, kwval);
+    
+    return LDOC_JSON_EVT(ctx, num, (char*)val.pld, val.len) ? LDOC_JSON_OK : LDOC_JSON_STOP;
+}
+
+static inline ldoc_json_prs_err_t ldoc_json_idx_obj(ldoc_json_ctx_t* ctx, ldoc_json_idx_t* idx)
+{
+    // Skip '{':
+    idx->cur++;
+    
+    if (!LDOC_JSON_EVT(ctx, obj_bgn))
+        return LDOC_JSON_STOP;
+    
+    while (true)
+    {
+        char c = ldoc_json_idx_chr(idx);
+        
+        if (c == '}')
+        {
+            // Skip '}':
+            idx->cur++;
+            
+            return LDOC_JSON_EVT(ctx, obj_end) ? LDOC_JSON_OK : LDOC_JSON_STOP;
+        }
+        
+        ldoc_raw_t ky;
+        
+        if (c != '"' || !ldoc_json_idx_qstr(idx, &ky))
+            return LDOC_JSON_INV;
+        
+        // Colon (key/value separator):
+        if (ldoc_json_idx_chr(idx) != ':')
+            return LDOC_JSON_INV;
+        
+        if (!LDOC_JSON_EVT(ctx, ky, (char*)ky.pld, ky.len))
+            return LDOC_JSON_STOP;
+        
+        // Skip ':':
+        idx->cur++;
+        
+        ldoc_json_prs_err_t err = ldoc_json_idx_val(ctx, idx);
+        
+        if (err)
+            return err;
+        
+        c = ldoc_json_idx_chr(idx);
+        
+        if (c == ',')
+            idx->cur++;
+        else if (c != '}')
+            return LDOC_JSON_INV;
+    }
+}
+
+static inline ldoc_json_prs_err_t ldoc_json_idx_arr(ldoc_json_ctx_t* ctx, ldoc_json_idx_t* idx)
+{
+    // Skip '[':
+    idx->cur++;
+    
+    if (!LDOC_JSON_EVT(ctx, arr_bgn))
+        return LDOC_JSON_STOP;
+    
+    // Empty array:
+    char c = ldoc_json_idx_chr(idx);
+    
+    while (c != ']')
+    {
+        ldoc_json_prs_err_t err = ldoc_json_idx_val(ctx, idx);
+        
+        if (err)
+            return err;
+        
+        c = ldoc_json_idx_chr(idx);
+        
+        if (c == ',')
+            idx->cur++;
+        else if (c != ']')
+            return LDOC_JSON_INV;
+    }
+    
+    // Skip ']':
+    idx->cur++;
+    
+    return LDOC_JSON_EVT(ctx, arr_end) ? LDOC_JSON_OK : LDOC_JSON_STOP;
+}
+
+static inline ldoc_json_prs_err_t ldoc_json_idx_val(ldoc_json_ctx_t* ctx, ldoc_json_idx_t* idx)
+{
+    char c = ldoc_json_idx_chr(idx);
+    
+    // Object type (object/array) or some primitive?
+    if (c == '{')
+        return ldoc_json_idx_obj(ctx, idx);
+    else if (c == '[')
+        return ldoc_json_idx_arr(ctx, idx);
+    else if (c == '"')
+    {
+        ldoc_raw_t val;
+        
+        if (!ldoc_json_idx_qstr(idx, &val))
+            return LDOC_JSON_INV;
+        
+        return LDOC_JSON_EVT(ctx, str, (char*)val.pld, val.len) ? LDOC_JSON_OK : LDOC_JSON_STOP;
+    }
+    else if (!c || c == ',' || c == ':' || c == '}' || c == ']')
+        return LDOC_JSON_INV;
+    
+    return ldoc_json_idx_scl(ctx, idx);
+}
+
+// Counterpart of `ldoc_json_obj`: `*str` points to '{' and is advanced past the
+// closing '}', or to the position of an error.
+static ldoc_json_prs_err_t ldoc_json_idx(ldoc_json_ctx_t* ctx, char** str, size_t* len)
+{
+    ldoc_json_idx_t idx;
+    size_t off;
+    
+    ldoc_json_idx_init(&idx, *str);
+    
+    ldoc_json_prs_err_t err = ldoc_json_idx_bld(&idx, *len, &off);
+    
+    if (!err)
+    {
+        err = ldoc_json_idx_obj(ctx, &idx);
+        if (!err)
+            off = idx.pos[idx.cnt - 1] + 1;
+        else
+            off = idx.cur < idx.cnt ? idx.pos[idx.cur] : idx.pos[idx.cnt - 1];
+    }
+    
+    ldoc_json_idx_free(&idx);
+    
+    *str += off;
+    *len -= off;
+    
+    return err;
+}
+
+static inline bool ldoc_json_idx_use(size_t len)
+{
+    // Offsets are 32 bits wide:
+    return ldoc_json_prsr_cur == LDOC_JSON_PRSR_IDX && len <= UINT32_MAX;
+}
+
+static inline ldoc_json_prs_err_t ldoc_json_read_(ldoc_json_ctx_t* ctx, char* json, size_t len, off_t* err, off_t* nxt)
+{
+    off_t bgn = nxt ? *nxt : 0;
+    
+    if (bgn > (off_t)len)
+        bgn = len;
+    
+    len -= bgn;
+    
+    char* obj = ldoc_json_skpws(json + bgn, &len);
+    
+    if (!len || *obj != '{')
+    {
+        if (err)
+            *err = obj - json;
+        
+        return LDOC_JSON_INV;
+    }
+    
+    ldoc_json_prs_err_t prs;
+    
+    // Projections are only implemented by the recursive descent parser:
+    if (!ctx->prj && ldoc_json_idx_use(len))
+        prs = ldoc_json_idx(ctx, &obj, &len);
+    else
+        prs = ldoc_json_obj(ctx, &obj, &len);
+    
+    if (prs && err)
+        *err = obj - json;
+    
+    if (nxt)
+        *nxt = obj - json;
+    
+    return prs;
+}
+
+ldoc_json_prs_err_t ldoc_json_read_sax(const ldoc_json_sax_t* sax, void* usr, char* json, size_t len, off_t* err, off_t* nxt)
+{
+    ldoc_json_ctx_t ctx = { sax, usr, NULL };
+    
+    return ldoc_json_read_(&ctx, json, len, err, nxt);
+}
+
+bool ldoc_json_read_into(ldoc_doc_t* doc, char* json, size_t len, off_t* err, off_t* nxt)
+{
+    ldoc_json_bld_t bld = { doc, LDOC_NDE_NULL, { NULL, 0 }, false, false };
+    ldoc_json_ctx_t ctx = { &ldoc_json_bld_sax, &bld, NULL };
+    
+    return !ldoc_json_read_(&ctx, json, len, err, nxt);
+}
+
+ldoc_doc_t* ldoc_json_read_doc(char* json, size_t len, off_t* err, off_t* nxt)
+{
+    ldoc_doc_t* doc = ldoc_doc_new();
+    
+    if (!doc)
+        return LDOC_DOC_NULL;
+    
+    if (!ldoc_json_read_into(doc, json, len, err, nxt))
+    {
+        ldoc_doc_free(doc);
+        
+        return LDOC_DOC_NULL;
+    }
+    
+    return doc;
+}
+
+static inline ldoc_doc_t* ldoc_json_read_view_doc(char* json, size_t len, off_t* err, off_t* nxt)
+{
+    // Nodes and entities are arena allocated, string payloads are not allocated at all:
+    ldoc_json_bld_t bld = { ldoc_doc_new_arena(0), LDOC_NDE_NULL, { NULL, 0 }, false, true };
+    ldoc_json_ctx_t ctx = { &ldoc_json_bld_sax, &bld, NULL };
+    
+    if (!bld.doc)
+        return LDOC_DOC_NULL;
+    
+    if (ldoc_json_read_(&ctx, json, len, err, nxt))
+    {
+        ldoc_doc_free(bld.doc);
+        
+        return LDOC_DOC_NULL;
+    }
+    
+    return bld.doc;
+}
+
+static inline ldoc_doc_t* ldoc_json_read_intn_doc(char* json, size_t len, ldoc_intn_t* intn, off_t* err, off_t* nxt)
+{
+    ldoc_json_bld_t bld = { ldoc_doc_new_arena(0), LDOC_NDE_NULL, { NULL, 0 }, false, false };
+    ldoc_json_ctx_t ctx = { &ldoc_json_bld_sax, &bld, NULL };
+    
+    if (!bld.doc)
+        return LDOC_DOC_NULL;
+    
+    bld.doc->intn = intn;
+    
+    if (ldoc_json_read_(&ctx, json, len, err, nxt))
+    {
+        ldoc_doc_free(bld.doc);
+        
+        return LDOC_DOC_NULL;
+    }
+    
+    return bld.doc;
+}
+
+static inline ldoc_doc_t* ldoc_json_read_prj_doc(char* json, size_t len, char*** pths, size_t* plens, size_t pcnt, off_t* err, off_t* nxt)
+{
+    // Paths are tracked in a bit mask:
+    if (pcnt > 64)
+        return LDOC_DOC_NULL;
+    
+    ldoc_json_prj_t prj = { pths, plens, 0, 0 };
+    
+    for (size_t i = 0; i < pcnt; i++)
+    {
+        if (plens[i])
+            prj.act |= 1ULL << i;
+    }
+    
+    ldoc_json_bld_t bld = { ldoc_doc_new(), LDOC_NDE_NULL, { NULL, 0 }, false, false };
+    ldoc_json_ctx_t ctx = { &ldoc_json_bld_sax, &bld, &prj };
+    
+    if (!bld.doc)
+        return LDOC_DOC_NULL;
+    
+    if (ldoc_json_read_(&ctx, json, len, err, nxt))
+    {
+        ldoc_doc_free(bld.doc);
+        
+        return LDOC_DOC_NULL;
+    }
+    
+    return bld.doc;
+}
+
+ldoc_doc_t* ldoc_json_read(char* json, size_t len, off_t* err)
+{
+    return ldoc_json_read_doc(json, len, err, NULL);
+}
+
+// LDJSON readers return no more documents once `*nxt` reaches the end of the input:
+static inline bool ldoc_ldjson_end(size_t len, off_t* nxt)
+{
+    return (size_t)*nxt >= len;
+}
+
+ldoc_doc_t* ldoc_ldjson_read(char* ldj, size_t len, off_t* err, off_t* nxt)
+{
+    if (ldoc_ldjson_end(len, nxt))
+        return LDOC_DOC_NULL;
+    
+    return ldoc_json_read_doc(ldj, len, err, nxt);
+}
+
+ldoc_doc_t* ldoc_json_read_pths(char* json, size_t len, char*** pths, size_t* plens, size_t pcnt, off_t* err)
+{
+    return ldoc_json_read_prj_doc(json, len, pths, plens, pcnt, err, NULL);
+}
+
+ldoc_doc_t* ldoc_ldjson_read_pths(char* ldj, size_t len, char*** pths, size_t* plens, size_t pcnt, off_t* err, off_t* nxt)
+{
+    if (ldoc_ldjson_end(len, nxt))
+        return LDOC_DOC_NULL;
+    
+    return ldoc_json_read_prj_doc(ldj, len, pths, plens, pcnt, err, nxt);
+}
+
+ldoc_doc_t* ldoc_json_read_intn(char* json, size_t len, ldoc_intn_t* intn, off_t* err)
+{
+    return ldoc_json_read_intn_doc(json, len, intn, err, NULL);
+}
+
+ldoc_doc_t* ldoc_ldjson_read_intn(char* ldj, size_t len, ldoc_intn_t* intn, off_t* err, off_t* nxt)
+{
+    if (ldoc_ldjson_end(len, nxt))
+        return LDOC_DOC_NULL;
+    
+    return ldoc_json_read_intn_doc(ldj, len, intn, err, nxt);
+}
+
+ldoc_doc_t* ldoc_json_read_view(char* json, size_t len, off_t* err)
+{
+    return ldoc_json_read_view_doc(json, len, err, NULL);
+}
+
+ldoc_doc_t* ldoc_ldjson_read_view(char* ldj, size_t len, off_t* err, off_t* nxt)
+{
+    if (ldoc_ldjson_end(len, nxt))
+        return LDOC_DOC_NULL;
+    
+    return ldoc_json_read_view_doc(ldj, len, err, nxt);
+}
+
+#pragma mark - Batch Reading
+
+// Chunks per worker thread, so that threads that finish early can pick up more work:
+#define LDOC_JSON_BTCH_CHNKS 4
+
+// A range of complete lines and the documents parsed from it:
+typedef struct ldoc_json_chnk_t
+{
+    off_t bgn;
+    off_t end;
+    ldoc_doc_t** docs;
+    size_t cnt;
+    size_t max;
+    // Offset of a parsing error, or -1:
+    off_t err;
+} ldoc_json_chnk_t;
+
+typedef struct ldoc_json_btch_t
+{
+    char* ldj;
+    ldoc_json_chnk_t* chnks;
+    size_t cnt;
+    // Next chunk to be picked up by a worker:
+    size_t nxt;
+} ldoc_json_btch_t;
+
+static void ldoc_json_chnk_read(char* ldj, ldoc_json_chnk_t* chnk)
+{
+    off_t nxt = chnk->bgn;
+    
+    while (true)
+    {
+        // Skip the whitespace between records, so that trailing newlines do not count as errors:
+        size_t len = chnk->end - nxt;
+        char* str = ldoc_json_skpws(ldj + nxt, &len);
+        
+        if (!len)
+            return;
+        
+        nxt = str - ldj;
+        
+        if (chnk->cnt == chnk->max)
+        {
+            size_t max = chnk->max ? chnk->max * 2 : 64;
+            ldoc_doc_t** docs = (ldoc_doc_t**)realloc(chnk->docs, max * sizeof(ldoc_doc_t*));
+            
+            if (!docs)
+            {
+                // TODO Error handling.
+                chnk->err = nxt;
+                
+                return;
+            }
+            
+            chnk->docs = docs;
+            chnk->max = max;
+        }
+        
+        off_t err = 0;
+        ldoc_doc_t* doc = ldoc_json_read_doc(ldj, chnk->end, &err, &nxt);
+        
+        if (!doc)
+        {
+            chnk->err = err;
             
+            return;
+        }
+        
+        chnk->docs[chnk->cnt++] = doc;
+    }
+}
+
+static void* ldoc_json_btch_wrkr(void* arg)
+{
+    ldoc_json_btch_t* btch = (ldoc_json_btch_t*)arg;
+    size_t i;
+    
+    while ((i = __atomic_fetch_add(&btch->nxt, 1, __ATOMIC_RELAXED)) < btch->cnt)
+        ldoc_json_chnk_read(btch->ldj, &btch->chnks[i]);
+    
+    return NULL;
+}
+
+ldoc_doc_t** ldoc_ldjson_read_batch(char* ldj, size_t len, size_t thrds, size_t* cnt, off_t* err)
+{
+    *cnt = 0;
+    
+    if (!thrds)
+    {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        
+        thrds = n > 0 ? n : 1;
+    }
+    
+    // Pick the kernels up front rather than in the first worker:
+    ldoc_json_krnl_init();
+    
+    // Split at newlines; chunks are never empty:
+    size_t max = thrds * LDOC_JSON_BTCH_CHNKS;
+    size_t sz = len / max + 1;
+    ldoc_json_chnk_t* chnks = (ldoc_json_chnk_t*)calloc(max, sizeof(ldoc_json_chnk_t));
+    
+    if (!chnks)
+    {
+        // TODO Error handling.
+        return NULL;
+    }
+    
+    ldoc_json_btch_t btch = { ldj, chnks, 0, 0 };
+    
+    for (size_t bgn = 0; bgn < len; btch.cnt++)
+    {
+        size_t end = bgn + sz < len ? bgn + sz : len;
+        char* nl = (char*)memchr(ldj + end, '\n', len - end);
+        
+        end = nl ? (size_t)(nl - ldj) + 1 : len;
+        
+        chnks[btch.cnt].bgn = bgn;
+        chnks[btch.cnt].end = end;
+        chnks[btch.cnt].err = -1;
+        
+        bgn = end;
+    }
+    
+    if (thrds > btch.cnt)
+        thrds = btch.cnt;
+    
+    // The calling thread is one of the workers:
+    pthread_t* tids = thrds > 1 ? (pthread_t*)malloc((thrds - 1) * sizeof(pthread_t)) : NULL;
+    size_t strtd = 0;
+    
+    while (tids && strtd < thrds - 1 && !pthread_create(&tids[strtd], NULL, ldoc_json_btch_wrkr, &btch))
+        strtd++;
+    
+    ldoc_json_btch_wrkr(&btch);
+    
+    for (size_t i = 0; i < strtd; i++)
+        pthread_join(tids[i], NULL);
+    
+    free(tids);
+    
+    // Concatenate in input order, unless a record could not be parsed:
+    size_t tot = 0;
+    bool ok = true;
+    
+    for (size_t i = 0; i < btch.cnt && ok; i++)
+    {
+        tot += chnks[i].cnt;
+        
+        if (chnks[i].err >= 0)
+        {
             if (err)
-                return err;
+                *err = chnks[i].err;
             
-            ldoc_nde_dsc_push(nde, dsc);
+            ok = false;
+        }
+    }
+    
+    ldoc_doc_t** docs = ok ? (ldoc_doc_t**)malloc((tot ? tot : 1) * sizeof(ldoc_doc_t*)) : NULL;
+    
+    for (size_t i = 0; i < btch.cnt; i++)
+    {
+        if (docs)
+        {
+            memcpy(docs + *cnt, chnks[i].docs, chnks[i].cnt * sizeof(ldoc_doc_t*));
+            *cnt += chnks[i].cnt;
         }
         else
         {
-            ldoc_json_prs_err_t err = ldoc_json_val(nde, ky, str, len);
-            
-            if (err)
-                return err;
+            for (size_t j = 0; j < chnks[i].cnt; j++)
+                ldoc_doc_free(chnks[i].docs[j]);
         }
-    } while (ldoc_json_iter(str, len));
+        
+        free(chnks[i].docs);
+    }
     
-    if (!*len || **str != '}')
-        return LDOC_JSON_INV;
+    free(chnks);
     
-    // Skip '}':
-    (*str)++;
-    (*len)--;
+    return docs;
+}
+
+void ldoc_ldjson_batch_free(ldoc_doc_t** docs, size_t cnt)
+{
+    if (!docs)
+        return;
     
-    return LDOC_JSON_OK;
+    for (size_t i = 0; i < cnt; i++)
+        ldoc_doc_free(docs[i]);
+    
+    free(docs);
 }
 
-static inline ldoc_json_prs_err_t ldoc_json_arr(ldoc_nde_t* nde, char** str, size_t* len)
+#pragma mark - File Input
+
+// Consumed pages of LDJSON files are released in steps of this size:
+#define LDOC_JSON_FILE_RLS (64 << 20)
+
+struct ldoc_ldjson_file_t
 {
-    // Skip '[':
-    (*str)++;
-    (*len)--;
+    int fd;
+    char* map;
+    size_t len;
+    // Offset of the next record:
+    off_t nxt;
+    // Consumed pages up to this offset have been released:
+    off_t rls;
+};
+
+// Maps a file for reading from start to end; `*map` is NULL for empty files.
+static bool ldoc_json_map(const char* pth, int* fd, char** map, size_t* len)
+{
+    struct stat st;
     
-    *str = ldoc_json_skpws(*str, len);
+    *fd = open(pth, O_RDONLY);
     
-    if (!len)
-        return LDOC_JSON_INV;
+    if (*fd < 0)
+        return false;
     
-    // Empty array, skip ']', then return:
-    if (**str == ']')
+    if (fstat(*fd, &st) || st.st_size < 0)
     {
-        (*str)++;
-        (*len)--;
+        close(*fd);
         
-        return LDOC_JSON_OK;
+        return false;
     }
     
-    do
+    *len = st.st_size;
+    *map = NULL;
+    
+    if (!*len)
+        return true;
+    
+    // The parser does not write to its input, even though it takes `char*`:
+    *map = (char*)mmap(NULL, *len, PROT_READ, MAP_PRIVATE, *fd, 0);
+    
+    if (*map == MAP_FAILED)
     {
-        if (**str == '{' || **str == '[')
-        {
-            ldoc_nde_t* dsc = ldoc_nde_new(**str == '{' ? LDOC_NDE_UA : LDOC_NDE_OL);
-            
-            // TODO Error handling.
-            
-            dsc->mkup.anno.str = strdup("NA");
-            
-            if (**str == '{')
-                ldoc_json_obj(dsc, str, len);
-            else
-                ldoc_json_arr(dsc, str, len);
-            
-            ldoc_nde_dsc_push(nde, dsc);
-        }
-        else
-        {
-            ldoc_json_prs_err_t err = ldoc_json_val(nde, NULL, str, len);
-            
-            if (err)
-                return err;
-        }
-    } while (ldoc_json_iter(str, len));
-
-    if (!*len || **str != ']')
-        return LDOC_JSON_INV;
+        close(*fd);
+        
+        return false;
+    }
     
-    // Skip ']':
-    (*str)++;
-    (*len)--;
+    madvise(*map, *len, MADV_SEQUENTIAL);
     
-    return LDOC_JSON_OK;
+    return true;
 }
 
-static inline ldoc_json_prs_err_t ldoc_json_val(ldoc_nde_t* nde, char* ky, char** str, size_t* len)
+ldoc_doc_t* ldoc_json_read_file(const char* pth, off_t* err)
 {
-    ldoc_ent_t* ent;
+    int fd;
+    char* map;
+    size_t len;
     
-    if (**str == '"')
+    if (!ldoc_json_map(pth, &fd, &map, &len))
     {
-        char* val = ldoc_json_qstr(str, len);
-        
-        if (!val)
-            return LDOC_JSON_INV;
-        
-        ent = ldoc_ent_new(ky ? LDOC_ENT_OR : LDOC_ENT_TXT);
-        
         // TODO Error handling.
+        return LDOC_DOC_NULL;
+    }
+    
+    ldoc_doc_t* doc = LDOC_DOC_NULL;
+    
+    if (map)
+    {
+        doc = ldoc_json_read(map, len, err);
         
-        if (ky)
-        {
-            ent->pld.pair.anno.str = ky;
-            ent->pld.pair.dtm.str = val;
-        }
-        else
-            ent->pld.str = val;
+        munmap(map, len);
+    }
+    else if (err)
+        *err = 0;
+    
+    close(fd);
+    
+    return doc;
+}
+
+ldoc_ldjson_file_t* ldoc_ldjson_file_open(const char* pth)
+{
+    ldoc_ldjson_file_t* file = (ldoc_ldjson_file_t*)malloc(sizeof(ldoc_ldjson_file_t));
+    
+    if (!file)
+        return NULL;
+    
+    if (!ldoc_json_map(pth, &file->fd, &file->map, &file->len))
+    {
+        free(file);
         
-        ldoc_nde_ent_push(nde, ent);
+        return NULL;
+    }
+    
+    file->nxt = 0;
+    file->rls = 0;
+    
+    return file;
+}
+
+void ldoc_ldjson_file_close(ldoc_ldjson_file_t* file)
+{
+    if (!file)
+        return;
+    
+    if (file->map)
+        munmap(file->map, file->len);
+    
+    close(file->fd);
+    free(file);
+}
+
+bool ldoc_ldjson_file_eof(ldoc_ldjson_file_t* file)
+{
+    size_t len = file->len - file->nxt;
+    
+    // Trailing whitespace does not count as a record:
+    if (file->map)
+        file->nxt = ldoc_json_skpws(file->map + file->nxt, &len) - file->map;
+    
+    return !len;
+}
+
+ldoc_doc_t* ldoc_ldjson_file_read(ldoc_ldjson_file_t* file, off_t* err)
+{
+    if (ldoc_ldjson_file_eof(file))
+        return LDOC_DOC_NULL;
+    
+    off_t rec = file->nxt;
+    ldoc_doc_t* doc = ldoc_json_read_doc(file->map, file->len, err, &(file->nxt));
+    
+    // Skip the rest of an invalid record's line, so that reading can go on with the next record:
+    if (!doc)
+    {
+        char* eol = (char*)memchr(file->map + rec, '\n', file->len - rec);
         
-        return LDOC_JSON_OK;
+        file->nxt = eol ? eol - file->map + 1 : (off_t)file->len;
     }
-    else if (**str == '-' || (**str >= '0' && **str <= '9'))
+    
+    // Documents own copies of their strings, so consumed pages are not needed anymore:
+    if (file->nxt - file->rls >= LDOC_JSON_FILE_RLS)
     {
-        char* val = ldoc_json_num(str, len);
+        off_t rls = file->nxt & ~(off_t)(getpagesize() - 1);
         
-        if (!val)
-            return LDOC_JSON_INV;
+        madvise(file->map + file->rls, rls - file->rls, MADV_DONTNEED);
+        file->rls = rls;
+    }
+    
+    return doc;
+}
+
+#pragma mark - Push Parsing
+
+// Push parsers only scan records for their end (tracking nesting and strings)
+// until a record is complete, which is then parsed in one go. Bytes of
+// returned records are discarded on the next call of `ldoc_ldjson_psh_feed`.
+
+struct ldoc_ldjson_psh_t
+{
+    char* buf;
+    size_t len;
+    size_t max;
+    // Stream offset of `buf[0]`:
+    off_t base;
+    // Bytes before this offset have been consumed:
+    size_t bgn;
+    // Scanning position and the beginning of the current record:
+    size_t scn;
+    size_t rec;
+    // Nesting depth of the current record (0: between records) and the
+    // expected closing brackets:
+    size_t dpt;
+    char* nst;
+    size_t nmax;
+    // In a string, after a backslash in a string, skipping an invalid line:
+    bool str;
+    bool esc;
+    bool skp;
+    // Memory could not be allocated:
+    bool fail;
+};
+
+ldoc_ldjson_psh_t* ldoc_ldjson_psh_new(void)
+{
+    return (ldoc_ldjson_psh_t*)calloc(1, sizeof(ldoc_ldjson_psh_t));
+}
+
+void ldoc_ldjson_psh_free(ldoc_ldjson_psh_t* psh)
+{
+    if (!psh)
+        return;
+    
+    free(psh->buf);
+    free(psh->nst);
+    free(psh);
+}
+
+bool ldoc_ldjson_psh_feed(ldoc_ldjson_psh_t* psh, const char* chnk, size_t len)
+{
+    // Discard consumed bytes:
+    if (psh->bgn)
+    {
+        memmove(psh->buf, psh->buf + psh->bgn, psh->len - psh->bgn);
         
-        ent = ldoc_ent_new(ky ? LDOC_ENT_NR : LDOC_ENT_NUM);
+        psh->len -= psh->bgn;
+        psh->scn -= psh->bgn;
+        psh->rec = psh->rec > psh->bgn ? psh->rec - psh->bgn : 0;
+        psh->base += psh->bgn;
+        psh->bgn = 0;
+    }
+    
+    if (psh->len + len > psh->max)
+    {
+        size_t max = psh->max ? psh->max : (size_t)getpagesize();
         
-        // TODO Error handling.
+        while (max < psh->len + len)
+            max *= 2;
         
-        if (ky)
-        {
-            ent->pld.pair.anno.str = ky;
-            ent->pld.pair.dtm.str = val;
-        }
-        else
-            ent->pld.str = val;
+        char* buf = (char*)realloc(psh->buf, max);
         
-        ldoc_nde_ent_push(nde, ent);
+        if (!buf)
+            return false;
         
-        return LDOC_JSON_OK;
+        psh->buf = buf;
+        psh->max = max;
     }
-    else
+    
+    memcpy(psh->buf + psh->len, chnk, len);
+    psh->len += len;
+    
+    return true;
+}
+
+ldoc_json_prs_err_t ldoc_ldjson_psh_read(ldoc_ldjson_psh_t* psh, ldoc_doc_t** doc, off_t* err)
+{
+    *doc = LDOC_DOC_NULL;
+    
+    if (psh->fail)
+        return LDOC_JSON_MEM;
+    
+    while (psh->scn < psh->len)
     {
-        ldoc_json_kwval_t kwval = ldoc_json_kwd(str, len);
+        char c = psh->buf[psh->scn];
         
-        ldoc_content_t tpe;
-        switch (kwval)
+        if (psh->skp)
         {
-            case LDOC_JSON_NULL:
-                tpe = ky ? LDOC_ENT_OR : LDOC_ENT_TXT;
-                break;
-            case LDOC_JSON_FALSE:
-            case LDOC_JSON_TRUE:
-                tpe = ky ? LDOC_ENT_BR : LDOC_ENT_BL;
-                break;
-            default:
-                return LDOC_JSON_INV;
+            psh->skp = c != '\n';
+            psh->bgn = ++psh->scn;
+            
+            continue;
         }
         
-        ent = ldoc_ent_new(tpe);
+        if (!psh->dpt)
+        {
+            if (ldoc_json_isws(c))
+            {
+                psh->bgn = ++psh->scn;
+                
+                continue;
+            }
+            
+            // Not a record; skip the rest of the line:
+            if (c != '{')
+            {
+                if (err)
+                    *err = psh->base + psh->scn;
+                
+                psh->skp = true;
+                
+                return LDOC_JSON_INV;
+            }
+            
+            psh->rec = psh->scn;
+        }
+        else if (psh->str)
+        {
+            if (psh->esc)
+                psh->esc = false;
+            else
+            {
+                // Skip to the next quote or backslash:
+                psh->scn += ldoc_json_qstr_scn(psh->buf + psh->scn, psh->len - psh->scn);
+                
+                if (psh->scn == psh->len)
+                    break;
+                
+                if (psh->buf[psh->scn] == '\\')
+                    psh->esc = true;
+                else
+                    psh->str = false;
+            }
+            
+            psh->scn++;
+            
+            continue;
+        }
         
-        // TODO Error handling.
-
-        if (ky)
-            ent->pld.pair.anno.str = ky;
+        bool end = false;
         
-        switch (kwval)
+        switch (c)
         {
-            case LDOC_JSON_NULL:
-                if (ky)
-                    ent->pld.pair.dtm.str = NULL;
-                else
-                    ent->pld.str = NULL;
+            case '"':
+                psh->str = true;
                 break;
-            case LDOC_JSON_FALSE:
-                if (ky)
-                    ent->pld.pair.dtm.bl = false;
-                else
-                    ent->pld.bl = false;
+            case '{':
+            case '[':
+                if (psh->dpt == psh->nmax)
+                {
+                    size_t nmax = psh->nmax ? psh->nmax * 2 : 64;
+                    char* nst = (char*)realloc(psh->nst, nmax);
+                    
+                    if (!nst)
+                    {
+                        psh->fail = true;
+                        
+                        return LDOC_JSON_MEM;
+                    }
+                    
+                    psh->nst = nst;
+                    psh->nmax = nmax;
+                }
+                
+                psh->nst[psh->dpt++] = c == '{' ? '}' : ']';
                 break;
-            case LDOC_JSON_TRUE:
-                if (ky)
-                    ent->pld.pair.dtm.bl = true;
-                else
-                    ent->pld.bl = true;
+            case '}':
+            case ']':
+                // Mismatched brackets end the record as well, which then fails to parse:
+                end = psh->nst[--psh->dpt] != c || !psh->dpt;
                 break;
             default:
-                // TODO This would be an internal error.
                 break;
         }
         
-        ldoc_nde_ent_push(nde, ent);
+        psh->scn++;
         
-        return LDOC_JSON_OK;
+        if (end)
+        {
+            psh->dpt = 0;
+            
+            off_t off = 0;
+            
+            *doc = ldoc_json_read_doc(psh->buf + psh->rec, psh->scn - psh->rec, &off, NULL);
+            psh->bgn = psh->scn;
+            
+            if (!*doc)
+            {
+                if (err)
+                    *err = psh->base + psh->rec + off;
+                
+                return LDOC_JSON_INV;
+            }
+            
+            return LDOC_JSON_OK;
+        }
     }
     
-    return LDOC_JSON_INV;
+    return LDOC_JSON_MORE;
 }
 
-ldoc_doc_t* ldoc_json_read_doc(char* json, size_t len, off_t* err, off_t* nxt)
+size_t ldoc_ldjson_psh_pndg(ldoc_ldjson_psh_t* psh)
 {
-    char* obj = ldoc_json_skpws(json + (nxt ? *nxt : 0), &len);
+    return psh->dpt ? psh->len - psh->rec : 0;
+}
 
-    if (!len || *obj != '{')
+static inline int ldoc_json_hex(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    
+    return -1;
+}
+
+static inline int32_t ldoc_json_hex4(const char* str, size_t len)
+{
+    if (len < 4)
+        return -1;
+    
+    int32_t cp = 0;
+    for (int i = 0; i < 4; i++)
     {
-        if (err)
-            *err = obj - json;
+        int h = ldoc_json_hex(str[i]);
         
-        return LDOC_DOC_NULL;
+        if (h < 0)
+            return -1;
+        
+        cp = (cp << 4) | h;
     }
     
-    ldoc_doc_t* doc = ldoc_doc_new();
-    
-    // TODO Error handling.
-    
-    ldoc_json_obj(doc->rt, &obj, &len);
-    
-    if (nxt)
-        *nxt = obj - json;
-    
-    return doc;
+    return cp;
 }
 
-ldoc_doc_t* ldoc_json_read(char* json, size_t len, off_t* err)
+static inline char* ldoc_json_utf8(char* dst, uint32_t cp)
 {
-    return ldoc_json_read_doc(json, len, err, NULL);
+    if (cp < 0x80)
+        *dst++ = cp;
+    else if (cp < 0x800)
+    {
+        *dst++ = 0xc0 | (cp >> 6);
+        *dst++ = 0x80 | (cp & 0x3f);
+    }
+    else if (cp < 0x10000)
+    {
+        *dst++ = 0xe0 | (cp >> 12);
+        *dst++ = 0x80 | ((cp >> 6) & 0x3f);
+        *dst++ = 0x80 | (cp & 0x3f);
+    }
+    else
+    {
+        *dst++ = 0xf0 | (cp >> 18);
+        *dst++ = 0x80 | ((cp >> 12) & 0x3f);
+        *dst++ = 0x80 | ((cp >> 6) & 0x3f);
+        *dst++ = 0x80 | (cp & 0x3f);
+    }
+    
+    return dst;
 }
 
-ldoc_doc_t* ldoc_ldjson_read(char* ldj, size_t len, off_t* err, off_t* nxt)
+char* ldoc_json_unesc(const char* str, size_t len, size_t* ulen)
 {
-    if (*nxt >= len)
-        return LDOC_DOC_NULL;
+    // Unescaped strings are never longer than their escaped form:
+    char* s = (char*)malloc(len + 1);
     
-    return ldoc_json_read_doc(ldj, len, err, nxt);
+    if (!s)
+        return NULL;
+    
+    const char* bsl = (const char*)memchr(str, '\\', len);
+    
+    // Fast path: nothing to unescape.
+    if (!bsl)
+    {
+        memcpy(s, str, len);
+        s[len] = 0;
+        
+        if (ulen)
+            *ulen = len;
+        
+        return s;
+    }
+    
+    const char* end = str + len;
+    char* dst = s;
+    
+    while (bsl)
+    {
+        memcpy(dst, str, bsl - str);
+        dst += bsl - str;
+        str = bsl + 1;
+        
+        // A trailing backslash is kept as is:
+        if (str == end)
+        {
+            *dst++ = '\\';
+            break;
+        }
+        
+        int32_t cp;
+        switch (*str++)
+        {
+            case 'b':
+                *dst++ = '\b';
+                break;
+            case 'f':
+                *dst++ = '\f';
+                break;
+            case 'n':
+                *dst++ = '\n';
+                break;
+            case 'r':
+                *dst++ = '\r';
+                break;
+            case 't':
+                *dst++ = '\t';
+                break;
+            case 'u':
+                cp = ldoc_json_hex4(str, end - str);
+                
+                if (cp < 0)
+                {
+                    // Invalid escape sequence; keep it verbatim:
+                    *dst++ = '\\';
+                    *dst++ = 'u';
+                    break;
+                }
+                
+                str += 4;
+                
+                // Surrogate pair:
+                if (cp >= 0xd800 && cp <= 0xdbff && end - str >= 6 && str[0] == '\\' && str[1] == 'u')
+                {
+                    int32_t lo = ldoc_json_hex4(str + 2, end - str - 2);
+                    
+                    if (lo >= 0xdc00 && lo <= 0xdfff)
+                    {
+                        cp = 0x10000 + ((cp - 0xd800) << 10) + (lo - 0xdc00);
+                        str += 6;
+                    }
+                }
+                
+                dst = ldoc_json_utf8(dst, cp);
+                break;
+            default:
+                // '"', '\\', '/' and unknown escapes:
+                *dst++ = str[-1];
+                break;
+        }
+        
+        bsl = (const char*)memchr(str, '\\', end - str);
+    }
+    
+    memcpy(dst, str, end - str);
+    dst += end - str;
+    *dst = 0;
+    
+    if (ulen)
+        *ulen = dst - s;
+    
+    return s;
 }
@@ -9,7 +9,17 @@
 
 #include "trie.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 ldoc_trie_nde_t* LDOC_TRIE_NDE_NULL = NULL;
+static ldoc_trie_nde_t ldoc_trie_nde_pfx = { ASCII, LYT_N4, 0, 0, { NULL }, NULL, NULL, NDE_EMPTY, { 0, NULL } };
+ldoc_trie_nde_t* LDOC_TRIE_NDE_PFX = &ldoc_trie_nde_pfx;
 ldoc_trie_anno_t LDOC_TRIE_ANNO_NULL = { 0, NULL };
 
 static inline char* ldoc_sheap_ccatc(char* str, size_t* len, size_t* max, char chr)
@@ -59,6 +69,67 @@ static inline char* ldoc_sheap_ccat(char* str, size_t* len, size_t* max, char* s
     return str;
 }
 
+// Initial number of frames of an explicit traversal stack:
+#define LDOC_TRIE_STK_INIT 64
+
+// Frame of an explicit traversal stack: a node, the offset of its next
+// descendant to visit, and the length of the path before the node:
+typedef struct ldoc_trie_frm_t
+{
+    struct ldoc_trie_nde_t* nde;
+    uint16_t i;
+    size_t pend;
+} ldoc_trie_frm_t;
+
+// The first frames are part of the stack itself, so that shallow traversals
+// do not allocate memory:
+typedef struct ldoc_trie_stk_t
+{
+    size_t cnt;
+    size_t max;
+    ldoc_trie_frm_t* frms;
+    ldoc_trie_frm_t init[LDOC_TRIE_STK_INIT];
+} ldoc_trie_stk_t;
+
+static inline void ldoc_trie_stk_init(ldoc_trie_stk_t* stk)
+{
+    stk->cnt = 0;
+    stk->max = LDOC_TRIE_STK_INIT;
+    stk->frms = stk->init;
+}
+
+static inline void ldoc_trie_stk_free(ldoc_trie_stk_t* stk)
+{
+    if (stk->frms != stk->init)
+        free(stk->frms);
+}
+
+static inline bool ldoc_trie_stk_push(ldoc_trie_stk_t* stk, ldoc_trie_nde_t* nde, size_t pend)
+{
+    if (stk->cnt == stk->max)
+    {
+        size_t max = stk->max * 2;
+        ldoc_trie_frm_t* frms = (ldoc_trie_frm_t*)realloc(stk->frms == stk->init ? NULL : stk->frms, max * sizeof(ldoc_trie_frm_t));
+        
+        if (!frms)
+            return false;
+        
+        if (stk->frms == stk->init)
+            memcpy(frms, stk->init, sizeof(stk->init));
+        
+        stk->frms = frms;
+        stk->max = max;
+    }
+    
+    ldoc_trie_frm_t* frm = &(stk->frms[stk->cnt++]);
+    
+    frm->nde = nde;
+    frm->i = 0;
+    frm->pend = pend;
+    
+    return true;
+}
+
 /**
  *
  *
@@ -85,7 +156,7 @@ static inline char ldoc_trie_offset_en_inv(uint16_t off)
     else if (off == 26)
         return ' ';
     else if (off > 26 && off < 38)
-        return '0' + off;
+        return '0' + off - 27;
     
     // TODO Error.
     return LDOC_TRIE_RES_CHR;
@@ -100,11 +171,11 @@ static char ldoc_trie_char(ldoc_trie_nde_t* nde, uint16_t off)
             return ldoc_trie_offset_en_inv(off);
             break;
         case ASCII:
-            return nde->chr.c8[off];
+            return nde->lyt == LYT_N256 ? (char)off : nde->chr.c8[off];
         case UTF16:
-            return (char)nde->chr.c16[off];
+            return nde->lyt == LYT_N256 ? (char)off : (char)nde->chr.c16[off];
         case UTF32:
-            return (char)nde->chr.c32[off];
+            return nde->lyt == LYT_N256 ? (char)off : (char)nde->chr.c32[off];
         default:
             // TODO Error.
             return LDOC_TRIE_RES_CHR;
@@ -125,7 +196,7 @@ static void ldoc_trie_nde_dmp(ldoc_trie_nde_t* nde, char chr, uint16_t lvl)
         return;
     
     ldoc_trie_nde_ndnt(lvl);
-    printf("%c, type %u, size %u, category %u, payload %08llx\n", chr, nde->tpe, nde->size, nde->anno.cat, (uint64_t)nde->anno.pld);
+    printf("%c%.*s, type %u, size %u, category %u, payload %08llx\n", chr, nde->llen, nde->lbl, nde->tpe, nde->size, nde->anno.cat, (uint64_t)nde->anno.pld);
     
     uint16_t i = 0;
     for (; i < nde->size; i++)
@@ -140,11 +211,137 @@ void ldoc_trie_dmp(ldoc_trie_t* trie)
     ldoc_trie_nde_dmp(trie->root, '*', 0);
 }
 
-/**
- * Note: In order to work with `ldoc_trie_nde_free`, all types need to assign the
- *       descendents pointer-array memory allocated with `malloc`.
- */
-static inline ldoc_trie_nde_t* ldoc_trie_nde_new(ldoc_trie_ptr_t tpe, ldoc_trie_alloc_t alloc, ldoc_trie_anno_t anno)
+#pragma mark - Slab Allocation
+
+// Nodes, descendant and character arrays, and edge labels of a trie are
+// handed out from large blocks, which are only released with the trie.
+// Arrays that a node outgrows are kept in free lists by size (in steps of
+// the alignment), so that the next node with the same layout reuses them:
+typedef struct ldoc_trie_slab_t
+{
+    void* blk;
+    char* ptr;
+    char* end;
+    size_t inc;
+    void* fre[];
+} ldoc_trie_slab_t;
+
+#define LDOC_TRIE_SLAB_ALGN 8
+// Size of the first block's data area; blocks grow geometrically up to the maximum:
+#define LDOC_TRIE_SLAB_INIT 4096
+#define LDOC_TRIE_SLAB_MAX (1 << 20)
+// Sizes up to a `LYT_N256` descendant array have free lists:
+#define LDOC_TRIE_SLAB_CLS (256 * sizeof(ldoc_trie_nde_t*) / LDOC_TRIE_SLAB_ALGN + 1)
+// Offset of a block's data area (the header links the blocks):
+#define LDOC_TRIE_SLAB_HDR ((sizeof(void*) + LDOC_TRIE_SLAB_ALGN - 1) & ~(size_t)(LDOC_TRIE_SLAB_ALGN - 1))
+
+static ldoc_trie_slab_t* ldoc_trie_slab_new()
+{
+    size_t sz = sizeof(ldoc_trie_slab_t) + LDOC_TRIE_SLAB_CLS * sizeof(void*);
+    ldoc_trie_slab_t* slab = (ldoc_trie_slab_t*)malloc(sz);
+    
+    if (!slab)
+        return NULL;
+    
+    memset(slab, 0, sz);
+    slab->inc = LDOC_TRIE_SLAB_INIT;
+    
+    return slab;
+}
+
+static void ldoc_trie_slab_free(ldoc_trie_slab_t* slab)
+{
+    void* blk = slab->blk;
+    
+    while (blk)
+    {
+        void* nxt = *(void**)blk;
+        
+        free(blk);
+        
+        blk = nxt;
+    }
+    
+    free(slab);
+}
+
+static void* ldoc_trie_slab_alloc_(ldoc_trie_slab_t* slab, size_t sz, size_t algn)
+{
+    char* ptr = (char*)(((uintptr_t)slab->ptr + algn - 1) & ~(uintptr_t)(algn - 1));
+    
+    if (!slab->blk || ptr > slab->end || (size_t)(slab->end - ptr) < sz)
+    {
+        // Oversized allocation (long labels): give it a block of its own,
+        // but keep filling the current block:
+        if (sz > slab->inc && slab->blk)
+        {
+            void** big = (void**)malloc(LDOC_TRIE_SLAB_HDR + sz);
+            
+            if (!big)
+                return NULL;
+            
+            *big = *(void**)slab->blk;
+            *(void**)slab->blk = big;
+            
+            return (char*)big + LDOC_TRIE_SLAB_HDR;
+        }
+        
+        if (slab->blk && slab->inc < LDOC_TRIE_SLAB_MAX)
+            slab->inc *= 2;
+        
+        size_t max = sz > slab->inc ? sz : slab->inc;
+        void** blk = (void**)malloc(LDOC_TRIE_SLAB_HDR + max);
+        
+        if (!blk)
+            return NULL;
+        
+        *blk = slab->blk;
+        slab->blk = blk;
+        ptr = (char*)blk + LDOC_TRIE_SLAB_HDR;
+        slab->end = ptr + max;
+    }
+    
+    slab->ptr = ptr + sz;
+    
+    return ptr;
+}
+
+static inline void* ldoc_trie_slab_alloc(ldoc_trie_slab_t* slab, size_t sz)
+{
+    size_t cls = (sz + LDOC_TRIE_SLAB_ALGN - 1) / LDOC_TRIE_SLAB_ALGN;
+    
+    if (cls < LDOC_TRIE_SLAB_CLS && slab->fre[cls])
+    {
+        void* ptr = slab->fre[cls];
+        
+        slab->fre[cls] = *(void**)ptr;
+        
+        return ptr;
+    }
+    
+    return ldoc_trie_slab_alloc_(slab, cls * LDOC_TRIE_SLAB_ALGN, LDOC_TRIE_SLAB_ALGN);
+}
+
+// Labels are packed without alignment and never given back:
+static inline char* ldoc_trie_slab_chrs(ldoc_trie_slab_t* slab, size_t sz)
+{
+    return (char*)ldoc_trie_slab_alloc_(slab, sz, 1);
+}
+
+static inline void ldoc_trie_slab_rls(ldoc_trie_slab_t* slab, void* ptr, size_t sz)
+{
+    size_t cls = (sz + LDOC_TRIE_SLAB_ALGN - 1) / LDOC_TRIE_SLAB_ALGN;
+    
+    if (!ptr || cls >= LDOC_TRIE_SLAB_CLS)
+        return;
+    
+    *(void**)ptr = slab->fre[cls];
+    slab->fre[cls] = ptr;
+}
+
+#pragma mark - Trie Nodes
+
+static inline ldoc_trie_nde_t* ldoc_trie_nde_new(ldoc_trie_slab_t* slab, ldoc_trie_ptr_t tpe, ldoc_trie_alloc_t alloc, ldoc_trie_anno_t anno)
 {
     ldoc_trie_char_t chr;
     uint16_t size;
@@ -157,12 +354,10 @@ static inline ldoc_trie_nde_t* ldoc_trie_nde_new(ldoc_trie_ptr_t tpe, ldoc_trie_
             chr.c0 = NULL;
             size = 27;
             memsize = size * sizeof(ldoc_trie_nde_t*);
-            dscs = (ldoc_trie_nde_t**)malloc(memsize);
+            dscs = (ldoc_trie_nde_t**)ldoc_trie_slab_alloc(slab, memsize);
             
             if (!dscs)
-            {
-                // TODO Error.
-            }
+                return LDOC_TRIE_NDE_NULL;
             
             memset(dscs, 0, memsize);
             break;
@@ -170,12 +365,10 @@ static inline ldoc_trie_nde_t* ldoc_trie_nde_new(ldoc_trie_ptr_t tpe, ldoc_trie_
             chr.c0 = NULL;
             size = 37;
             memsize = size * sizeof(ldoc_trie_nde_t*);
-            dscs = (ldoc_trie_nde_t**)malloc(memsize);
+            dscs = (ldoc_trie_nde_t**)ldoc_trie_slab_alloc(slab, memsize);
             
             if (!dscs)
-            {
-                // TODO Error.
-            }
+                return LDOC_TRIE_NDE_NULL;
             
             memset(dscs, 0, memsize);
             break;
@@ -197,111 +390,72 @@ static inline ldoc_trie_nde_t* ldoc_trie_nde_new(ldoc_trie_ptr_t tpe, ldoc_trie_
             dscs = NULL;
             break;
         default:
-            // TODO Error.
-            break;
+            return LDOC_TRIE_NDE_NULL;
     }
     
-    ldoc_trie_nde_t* nde = (ldoc_trie_nde_t*)malloc(sizeof(ldoc_trie_nde_t));
+    ldoc_trie_nde_t* nde = (ldoc_trie_nde_t*)ldoc_trie_slab_alloc(slab, sizeof(ldoc_trie_nde_t));
     
     if (!nde)
     {
-        // TODO Error.
+        if (dscs)
+            ldoc_trie_slab_rls(slab, dscs, size * sizeof(ldoc_trie_nde_t*));
+        
+        return LDOC_TRIE_NDE_NULL;
     }
     
     nde->tpe = tpe;
+    nde->lyt = LYT_N4;
     nde->chr = chr;
     nde->size = size;
     nde->alloc = alloc;
     nde->anno = anno;
     nde->dscs = dscs;
+    nde->llen = 0;
+    nde->lbl = NULL;
     
     return nde;
 }
 
-static inline void ldoc_trie_dsc_add(ldoc_trie_nde_t* nde, ldoc_trie_nde_t* dsc, char chr)
+static inline uint16_t ldoc_trie_lyt_cap(ldoc_trie_lyt_t lyt)
 {
-    char* c8;
-    uint16_t* c16;
-    uint32_t* c32;
-    ldoc_trie_nde_t** dscs;
-    uint16_t nsize = nde->size + 1;
-    
-    switch (nde->tpe)
+    switch (lyt)
+    {
+        case LYT_N4:
+            return 4;
+        case LYT_N16:
+            return 16;
+        case LYT_N48:
+            return 48;
+        default:
+            return 256;
+    }
+}
+
+static inline size_t ldoc_trie_chr_size(ldoc_trie_ptr_t tpe)
+{
+    switch (tpe)
     {
-        case EN_ALPH:
-        case EN_ALPHNUM:
-            // TODO Error.
-            dscs = NULL;
-            break;
-        case ASCII:
-            if (nde->chr.c8)
-            {
-                c8 = realloc(nde->chr.c8, nsize * sizeof(char));
-                dscs = realloc(nde->dscs, nsize * sizeof(ldoc_trie_nde_t**));
-            }
-            else
-            {
-                c8 = malloc(nsize * sizeof(char));
-                dscs = malloc(nsize * sizeof(ldoc_trie_nde_t**));
-            }
-            // TODO Error handling.
-            nde->chr.c8 = c8;
-            nde->size = nsize;
-            nde->chr.c8[nsize - 1] = chr;
-            break;
         case UTF16:
-            if (nde->chr.c16)
-            {
-                c16 = realloc(nde->chr.c16, nsize * sizeof(uint16_t));
-                dscs = realloc(nde->dscs, nsize * sizeof(ldoc_trie_nde_t**));
-            }
-            else
-            {
-                c16 = malloc(nsize * sizeof(uint16_t));
-                dscs = malloc(nsize * sizeof(ldoc_trie_nde_t**));
-            }
-            // TODO Error handling.
-            nde->chr.c16 = c16;
-            nde->size = nsize;
-            nde->chr.c16[nsize - 1] = chr;
-            break;
+            return sizeof(uint16_t);
         case UTF32:
-            if (nde->chr.c32)
-            {
-                c32 = realloc(nde->chr.c32, nsize * sizeof(uint32_t));
-                dscs = realloc(nde->dscs, nsize * sizeof(ldoc_trie_nde_t**));
-            }
-            else
-            {
-                c32 = malloc(nsize * sizeof(uint32_t));
-                dscs = malloc(nsize * sizeof(ldoc_trie_nde_t**));
-            }
-            // TODO Error handling.
-            nde->chr.c32 = c32;
-            nde->size = nsize;
-            nde->chr.c32[nsize - 1] = chr;
-            break;
+            return sizeof(uint32_t);
         default:
-            // TODO Error.
-            break;
+            return sizeof(char);
     }
-    
-    nde->dscs = dscs;
-    nde->dscs[nsize - 1] = dsc;
 }
 
-static inline void ldoc_trie_nde_set(ldoc_trie_nde_t* nde, ldoc_trie_nde_t* dsc, char chr)
+static inline void ldoc_trie_chr_set(ldoc_trie_nde_t* nde, uint16_t off, char chr)
 {
     switch (nde->tpe)
     {
-        case EN_ALPH:
-        case EN_ALPHNUM:
-            nde->dscs[ldoc_trie_offset_en(chr)] = dsc;
-            break;
         case ASCII:
+            nde->chr.c8[off] = chr;
+            break;
         case UTF16:
+            nde->chr.c16[off] = chr;
+            break;
         case UTF32:
-            ldoc_trie_dsc_add(nde, dsc, chr);
+            nde->chr.c32[off] = chr;
             break;
         default:
             // TODO Error.
@@ -309,290 +463,1434 @@ static inline void ldoc_trie_nde_set(ldoc_trie_nde_t* nde, ldoc_trie_nde_t* dsc,
     }
 }
 
-ldoc_trie_t* ldoc_trie_new()
+// The index of layout `LYT_N48` follows its descendant pointers; entries are
+// one more than the offset of a character's descendant, or 0:
+static inline uint8_t* ldoc_trie_n48_idx(ldoc_trie_nde_t* nde)
+{
+    return (uint8_t*)(nde->dscs + 48);
+}
+
+// Moves the descendants of a node into the next larger layout (or allocates
+// the smallest one):
+static inline size_t ldoc_trie_lyt_dscs_size(ldoc_trie_lyt_t lyt)
+{
+    return ldoc_trie_lyt_cap(lyt) * sizeof(ldoc_trie_nde_t*) + (lyt == LYT_N48 ? 256 : 0);
+}
+
+static bool ldoc_trie_lyt_grow(ldoc_trie_slab_t* slab, ldoc_trie_nde_t* nde)
 {
-    ldoc_trie_nde_t* root = ldoc_trie_nde_new(UTF32, NDE_ROOT, LDOC_TRIE_ANNO_NULL);
+    ldoc_trie_lyt_t lyt = nde->dscs ? nde->lyt + 1 : LYT_N4;
+    size_t csz = ldoc_trie_chr_size(nde->tpe);
     
-    if (!root)
+    if (lyt == LYT_N256)
     {
-        // TODO Error.
+        ldoc_trie_nde_t** dscs = (ldoc_trie_nde_t**)ldoc_trie_slab_alloc(slab, ldoc_trie_lyt_dscs_size(lyt));
+        
+        if (!dscs)
+            return false;
+        
+        memset(dscs, 0, ldoc_trie_lyt_dscs_size(lyt));
+        
+        uint16_t i = 0;
+        for (; i < nde->size; i++)
+            dscs[(uint8_t)ldoc_trie_char(nde, i)] = nde->dscs[i];
+        
+        ldoc_trie_slab_rls(slab, nde->chr.c0, ldoc_trie_lyt_cap(nde->lyt) * csz);
+        ldoc_trie_slab_rls(slab, nde->dscs, ldoc_trie_lyt_dscs_size(nde->lyt));
+        
+        nde->chr.c0 = NULL;
+        nde->dscs = dscs;
+        nde->size = 256;
+        nde->lyt = LYT_N256;
+        
+        return true;
     }
     
-    ldoc_trie_t* trie = (ldoc_trie_t*)malloc(sizeof(ldoc_trie_t));
+    void* chr = ldoc_trie_slab_alloc(slab, ldoc_trie_lyt_cap(lyt) * csz);
+    ldoc_trie_nde_t** dscs = (ldoc_trie_nde_t**)ldoc_trie_slab_alloc(slab, ldoc_trie_lyt_dscs_size(lyt));
     
-    if (!trie)
+    if (!chr || !dscs)
     {
-        // TODO Error.
+        if (chr)
+            ldoc_trie_slab_rls(slab, chr, ldoc_trie_lyt_cap(lyt) * csz);
+        
+        if (dscs)
+            ldoc_trie_slab_rls(slab, dscs, ldoc_trie_lyt_dscs_size(lyt));
+        
+        return false;
     }
     
-    trie->min = 0;
-    trie->max = 0;
-    trie->root = root;
+    // Hand the smaller arrays on to the next node that needs them:
+    if (nde->dscs)
+    {
+        memcpy(chr, nde->chr.c0, nde->size * csz);
+        memcpy(dscs, nde->dscs, nde->size * sizeof(ldoc_trie_nde_t*));
+        
+        ldoc_trie_slab_rls(slab, nde->chr.c0, ldoc_trie_lyt_cap(nde->lyt) * csz);
+        ldoc_trie_slab_rls(slab, nde->dscs, ldoc_trie_lyt_dscs_size(nde->lyt));
+    }
     
-    return trie;
-}
-
-ldoc_trie_nde_t* ldoc_trie_dsc_iter(ldoc_trie_nde_t* nde, char chr)
-{
-    uint16_t i = 0;
-    for (; i < nde->size; i++)
+    nde->chr.c0 = chr;
+    nde->dscs = dscs;
+    nde->lyt = lyt;
+    
+    if (lyt == LYT_N48)
     {
-        char ci;
+        uint8_t* idx = ldoc_trie_n48_idx(nde);
         
-        switch (nde->tpe) {
-            case EN_ALPH:
-            case EN_ALPHNUM:
-                // TODO Error.
-                return LDOC_TRIE_NDE_NULL;
-            case ASCII:
-                ci = nde->chr.c8[i];
-                break;
-            case UTF16:
-                ci = nde->chr.c16[i];
-                break;
-            case UTF32:
-                ci = nde->chr.c32[i];
-                break;
-            default:
-                // TODO Error.
-                return LDOC_TRIE_NDE_NULL;
-        }
+        memset(idx, 0, 256);
         
-        if (chr == ci)
-            return nde->dscs[i];
+        uint16_t i = 0;
+        for (; i < nde->size; i++)
+            idx[(uint8_t)ldoc_trie_char(nde, i)] = i + 1;
     }
     
-    return LDOC_TRIE_NDE_NULL;
+    return true;
 }
 
-ldoc_trie_nde_t* ldoc_trie_dsc(ldoc_trie_nde_t* nde, char chr)
+static inline bool ldoc_trie_dsc_add(ldoc_trie_slab_t* slab, ldoc_trie_nde_t* nde, ldoc_trie_nde_t* dsc, char chr)
 {
-    if (!nde->size)
-        return LDOC_TRIE_NDE_NULL;
-    
     switch (nde->tpe)
     {
-        case EN_ALPH:
-        case EN_ALPHNUM:
-            return nde->dscs[ldoc_trie_offset_en(chr)];
         case ASCII:
         case UTF16:
         case UTF32:
-            return ldoc_trie_dsc_iter(nde, chr);
-        default:
-            // TODO Error.
             break;
+        default:
+            return false;
     }
     
-    return LDOC_TRIE_NDE_NULL;
+    // Grow into the next layout when the current one is full:
+    if (!nde->dscs || (nde->lyt != LYT_N256 && nde->size == ldoc_trie_lyt_cap(nde->lyt)))
+    {
+        if (!ldoc_trie_lyt_grow(slab, nde))
+            return false;
+    }
+    
+    if (nde->lyt == LYT_N256)
+    {
+        nde->dscs[(uint8_t)chr] = dsc;
+        
+        return true;
+    }
+    
+    if (nde->lyt == LYT_N48)
+        ldoc_trie_n48_idx(nde)[(uint8_t)chr] = nde->size + 1;
+    
+    ldoc_trie_chr_set(nde, nde->size, chr);
+    nde->dscs[nde->size++] = dsc;
+    
+    return true;
 }
 
-ldoc_trie_nde_t* ldoc_trie_dscn(ldoc_trie_nde_t* nde, uint16_t n)
+static inline bool ldoc_trie_nde_set(ldoc_trie_slab_t* slab, ldoc_trie_nde_t* nde, ldoc_trie_nde_t* dsc, char chr)
 {
-    if (!nde->size)
-        return LDOC_TRIE_NDE_NULL;
-    
     switch (nde->tpe)
     {
         case EN_ALPH:
-            return nde->dscs[n];
         case EN_ALPHNUM:
-            return nde->dscs[n];
+            nde->dscs[ldoc_trie_offset_en(chr)] = dsc;
+            return true;
         case ASCII:
-            return nde->dscs[n];
         case UTF16:
-            return nde->dscs[n];
         case UTF32:
-            return nde->dscs[n];
+            return ldoc_trie_dsc_add(slab, nde, dsc, chr);
         default:
-            // TODO Error.
-            break;
+            return false;
     }
-    
-    return LDOC_TRIE_NDE_NULL;
 }
 
-void ldoc_trie_nde_free(ldoc_trie_nde_t* nde)
+// Replaces the descendant of a node for a character:
+static inline void ldoc_trie_dsc_rpl(ldoc_trie_nde_t* nde, ldoc_trie_nde_t* dsc, char chr)
 {
-    // Deal with fixed size array nodes (s.a. EN_ALPH):
-    if (!nde)
-        return;
+    switch (nde->tpe)
+    {
+        case EN_ALPH:
+        case EN_ALPHNUM:
+            nde->dscs[ldoc_trie_offset_en(chr)] = dsc;
+            return;
+        default:
+            break;
+    }
+    
+    switch (nde->lyt)
+    {
+        case LYT_N48:
+            nde->dscs[ldoc_trie_n48_idx(nde)[(uint8_t)chr] - 1] = dsc;
+            return;
+        case LYT_N256:
+            nde->dscs[(uint8_t)chr] = dsc;
+            return;
+        default:
+            break;
+    }
     
-    // If the node has descendents, then free those too:
-    if (nde->size)
+    uint16_t i = 0;
+    for (; i < nde->size; i++)
     {
-        uint16_t n = 0;
-        for (; n < nde->size; n++)
+        if (ldoc_trie_char(nde, i) == chr)
         {
-            ldoc_trie_nde_t* dsc = ldoc_trie_dscn(nde, n);
-            ldoc_trie_nde_free(dsc);
+            nde->dscs[i] = dsc;
+            
+            return;
         }
     }
-    
-    free(nde->dscs);
-    
-    free(nde);
 }
 
-void ldoc_trie_free(ldoc_trie_t* trie)
+static inline bool ldoc_trie_lbl_set(ldoc_trie_slab_t* slab, ldoc_trie_nde_t* nde, const char* lbl, uint16_t llen)
 {
-    ldoc_trie_nde_free(trie->root);
+    if (!llen)
+        return true;
     
-    free(trie);
+    nde->lbl = ldoc_trie_slab_chrs(slab, llen);
+    
+    if (!nde->lbl)
+        return false;
+    
+    memcpy(nde->lbl, lbl, llen);
+    nde->llen = llen;
+    
+    return true;
 }
 
-ldoc_trie_nde_arr_t* ldoc_trie_nde_arr_new()
+// Splits the edge label of `dsc`, the descendant of `nde` for `chr`, after
+// `off` characters, and returns the new node at the split (NULL if memory
+// could not be allocated, in which case the trie is left unchanged):
+static ldoc_trie_nde_t* ldoc_trie_lbl_split(ldoc_trie_slab_t* slab, ldoc_trie_nde_t* nde, ldoc_trie_nde_t* dsc, char chr, uint16_t off, ldoc_trie_ptr_t tpe)
 {
-    ldoc_trie_nde_arr_t* arr = (ldoc_trie_nde_arr_t*)malloc(sizeof(ldoc_trie_nde_arr_t));
+    ldoc_trie_nde_t* mid = ldoc_trie_nde_new(slab, tpe, NDE_EMPTY, LDOC_TRIE_ANNO_NULL);
+    char dchr = dsc->lbl[off];
     
-    arr->wptr = 0;
-    arr->max = LDOC_TRIE_NDS_ARR_INIT;
+    if (!mid || !ldoc_trie_lbl_set(slab, mid, dsc->lbl, off) || !ldoc_trie_nde_set(slab, mid, dsc, dchr))
+        return LDOC_TRIE_NDE_NULL;
+    
+    // `dsc` keeps what follows its new character (in place):
+    dsc->llen -= off + 1;
+    memmove(dsc->lbl, dsc->lbl + off + 1, dsc->llen);
+    
+    ldoc_trie_dsc_rpl(nde, mid, chr);
+    
+    return mid;
+}
+
+#pragma mark - Multi-Pattern Matching
+
+// Aho-Corasick automaton: states in breadth-first order (root 0), with
+// their transitions sorted by character in one array (`fst` indexes the
+// first transition of each state). States with many transitions, which
+// are the ones close to the root, also have a full table (`dns`, indexed
+// by `dix`) that includes the failure transitions. `emt` is the first
+// annotated state to report in a state (the state itself or a suffix),
+// and `out` the next one:
+typedef struct ldoc_trie_ac_t
+{
+    uint32_t cnt;
+    uint32_t* fst;
+    unsigned char* chrs;
+    uint32_t* dsts;
+    uint32_t* fail;
+    uint32_t* emt;
+    uint32_t* out;
+    uint16_t* dpth;
+    ldoc_trie_nde_t** ndes;
+    uint32_t* dix;
+    uint32_t* dns;
+    uint32_t dcnt;
+    uint32_t dmax;
+} ldoc_trie_ac_t;
+
+// No state (for `out`), or no full table (for `dix`):
+#define LDOC_TRIE_ST_NULL UINT32_MAX
+
+// Transitions from which on a state gets a full table:
+#define LDOC_TRIE_AC_DNS 8
+
+static void ldoc_trie_ac_free(ldoc_trie_ac_t* ac)
+{
+    free(ac->fst);
+    free(ac->chrs);
+    free(ac->dsts);
+    free(ac->fail);
+    free(ac->emt);
+    free(ac->out);
+    free(ac->dpth);
+    free(ac->ndes);
+    free(ac->dix);
+    free(ac->dns);
+    free(ac);
+}
+
+static inline void ldoc_trie_ac_drop(ldoc_trie_t* trie)
+{
+    if (!trie->ac)
+        return;
+    
+    ldoc_trie_ac_free(trie->ac);
+    trie->ac = NULL;
+}
+
+// Edge labels have a state per character; returns 0 if memory could not
+// be allocated:
+static uint32_t ldoc_trie_ac_cnt(ldoc_trie_nde_t* nde)
+{
+    uint32_t cnt = 0;
+    ldoc_trie_stk_t stk;
+    
+    ldoc_trie_stk_init(&stk);
+    ldoc_trie_stk_push(&stk, nde, 0);
+    
+    while (stk.cnt)
+    {
+        nde = stk.frms[--stk.cnt].nde;
+        cnt += 1 + nde->llen;
+        
+        uint16_t i = 0;
+        for (; i < nde->size; i++)
+        {
+            if (nde->dscs[i] && !ldoc_trie_stk_push(&stk, nde->dscs[i], 0))
+            {
+                ldoc_trie_stk_free(&stk);
+                
+                return 0;
+            }
+        }
+    }
+    
+    ldoc_trie_stk_free(&stk);
+    
+    return cnt;
+}
+
+static inline uint32_t ldoc_trie_ac_goto(ldoc_trie_ac_t* ac, uint32_t st, unsigned char chr)
+{
+    uint32_t lo = ac->fst[st];
+    uint32_t hi = ac->fst[st + 1];
+    
+    // Most states have few transitions:
+    if (hi - lo <= 8)
+    {
+        for (; lo < hi; lo++)
+        {
+            if (ac->chrs[lo] == chr)
+                return ac->dsts[lo];
+        }
+        
+        return LDOC_TRIE_ST_NULL;
+    }
+    
+    while (lo < hi)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+        
+        if (ac->chrs[mid] < chr)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    
+    return lo < ac->fst[st + 1] && ac->chrs[lo] == chr ? ac->dsts[lo] : LDOC_TRIE_ST_NULL;
+}
+
+// Next state, following failure links where there is no transition; the
+// root has a full table, so that this always ends:
+static inline uint32_t ldoc_trie_ac_nxt(ldoc_trie_ac_t* ac, uint32_t st, unsigned char chr)
+{
+    for (;;)
+    {
+        if (ac->dix[st] != LDOC_TRIE_ST_NULL)
+            return ac->dns[(size_t)ac->dix[st] * 256 + chr];
+        
+        uint32_t g = ldoc_trie_ac_goto(ac, st, chr);
+        
+        if (g != LDOC_TRIE_ST_NULL)
+            return g;
+        
+        st = ac->fail[st];
+    }
+}
+
+static inline bool ldoc_trie_ac_dns(ldoc_trie_ac_t* ac, uint32_t st)
+{
+    if (ac->dcnt == ac->dmax)
+    {
+        uint32_t max = ac->dmax ? ac->dmax * 2 : 16;
+        uint32_t* dns = (uint32_t*)realloc(ac->dns, (size_t)max * 256 * sizeof(uint32_t));
+        
+        if (!dns)
+            return false;
+        
+        ac->dns = dns;
+        ac->dmax = max;
+    }
+    
+    uint32_t* tbl = &(ac->dns[(size_t)ac->dcnt * 256]);
+    
+    for (uint32_t chr = 0; chr < 256; chr++)
+    {
+        uint32_t g = ldoc_trie_ac_goto(ac, st, (unsigned char)chr);
+        
+        if (g == LDOC_TRIE_ST_NULL)
+            g = st ? ldoc_trie_ac_nxt(ac, ac->fail[st], (unsigned char)chr) : 0;
+        
+        tbl[chr] = g;
+    }
+    
+    ac->dix[st] = ac->dcnt++;
+    
+    return true;
+}
+
+bool ldoc_trie_ac_bld(ldoc_trie_t* trie)
+{
+    ldoc_trie_ac_drop(trie);
+    
+    ldoc_trie_ac_t* ac = (ldoc_trie_ac_t*)malloc(sizeof(ldoc_trie_ac_t));
+    
+    if (!ac)
+        return false;
+    
+    uint32_t cnt = ldoc_trie_ac_cnt(trie->root);
+    
+    if (!cnt)
+    {
+        free(ac);
+        
+        return false;
+    }
+    
+    ac->cnt = cnt;
+    ac->fst = (uint32_t*)malloc((cnt + 1) * sizeof(uint32_t));
+    ac->chrs = (unsigned char*)malloc(cnt);
+    ac->dsts = (uint32_t*)malloc(cnt * sizeof(uint32_t));
+    ac->fail = (uint32_t*)malloc(cnt * sizeof(uint32_t));
+    ac->emt = (uint32_t*)malloc(cnt * sizeof(uint32_t));
+    ac->out = (uint32_t*)malloc(cnt * sizeof(uint32_t));
+    ac->dpth = (uint16_t*)malloc(cnt * sizeof(uint16_t));
+    ac->ndes = (ldoc_trie_nde_t**)malloc(cnt * sizeof(ldoc_trie_nde_t*));
+    ac->dix = (uint32_t*)malloc(cnt * sizeof(uint32_t));
+    ac->dns = NULL;
+    ac->dcnt = 0;
+    ac->dmax = 0;
+    
+    // Position in the edge label of each state's node:
+    uint16_t* lpos = (uint16_t*)malloc(cnt * sizeof(uint16_t));
+    
+    if (!ac->fst || !ac->chrs || !ac->dsts || !ac->fail || !ac->emt || !ac->out || !ac->dpth || !ac->ndes || !ac->dix || !lpos)
+    {
+        free(lpos);
+        ldoc_trie_ac_free(ac);
+        
+        return false;
+    }
+    
+    memset(ac->dix, 0xff, cnt * sizeof(uint32_t));
+    
+    // States are numbered in the order in which they are queued, so that
+    // `ndes` doubles as the queue:
+    ac->ndes[0] = trie->root;
+    lpos[0] = 0;
+    ac->fail[0] = 0;
+    ac->emt[0] = LDOC_TRIE_ST_NULL;
+    ac->out[0] = LDOC_TRIE_ST_NULL;
+    ac->dpth[0] = 0;
+    
+    uint32_t nxt = 1;
+    uint32_t trn = 0;
+    
+    for (uint32_t st = 0; st < nxt; st++)
+    {
+        ldoc_trie_nde_t* nde = ac->ndes[st];
+        uint32_t lo = trn;
+        
+        ac->fst[st] = trn;
+        
+        // Within an edge label, the only transition is to the next character:
+        if (lpos[st] < nde->llen)
+        {
+            ac->chrs[trn] = (unsigned char)nde->lbl[lpos[st]];
+            ac->dsts[trn++] = nxt;
+            ac->ndes[nxt] = nde;
+            lpos[nxt++] = lpos[st] + 1;
+        }
+        
+        // Insertion sort by character:
+        uint16_t i = 0;
+        for (; lpos[st] == nde->llen && i < nde->size; i++)
+        {
+            if (!nde->dscs[i])
+                continue;
+            
+            unsigned char chr = (unsigned char)ldoc_trie_char(nde, i);
+            uint32_t j = trn++;
+            
+            for (; j > lo && ac->chrs[j - 1] > chr; j--)
+            {
+                ac->chrs[j] = ac->chrs[j - 1];
+                ac->dsts[j] = ac->dsts[j - 1];
+            }
+            
+            ac->chrs[j] = chr;
+            ac->dsts[j] = nxt;
+            ac->ndes[nxt] = nde->dscs[i];
+            lpos[nxt++] = 0;
+        }
+        
+        ac->fst[st + 1] = trn;
+        
+        // States closer to the root have all of their transitions already:
+        if ((!st || trn - lo >= LDOC_TRIE_AC_DNS) && !ldoc_trie_ac_dns(ac, st))
+        {
+            free(lpos);
+            ldoc_trie_ac_free(ac);
+            
+            return false;
+        }
+        
+        for (uint32_t t = lo; t < trn; t++)
+        {
+            uint32_t dst = ac->dsts[t];
+            
+            // Longest proper suffix that is a prefix in the trie:
+            ac->fail[dst] = st ? ldoc_trie_ac_nxt(ac, ac->fail[st], ac->chrs[t]) : 0;
+            
+            // Nearest annotated state on the failure chain:
+            uint32_t fl = ac->fail[dst];
+            
+            ac->out[dst] = ac->emt[fl];
+            ac->emt[dst] = ac->ndes[dst]->alloc == NDE_ANNO && lpos[dst] == ac->ndes[dst]->llen ? dst : ac->out[dst];
+            ac->dpth[dst] = ac->dpth[st] + 1;
+        }
+    }
+    
+    ac->fst[cnt] = trn;
+    trie->ac = ac;
+    
+    free(lpos);
+    
+    return true;
+}
+
+uint32_t ldoc_trie_scan(ldoc_trie_t* trie, uint32_t st, const char* txt, size_t len, void (*hit)(void* ctx, size_t end, ldoc_trie_nde_t* nde, uint16_t len), void* ctx)
+{
+    if (!trie->ac && !ldoc_trie_ac_bld(trie))
+        return LDOC_TRIE_ST_ERR;
+    
+    ldoc_trie_ac_t* ac = trie->ac;
+    const unsigned char* utxt = (const unsigned char*)txt;
+    
+    for (size_t i = 0; i < len; i++)
+    {
+        st = ldoc_trie_ac_nxt(ac, st, utxt[i]);
+        
+        // Report the state itself and all annotated suffixes:
+        uint32_t o = ac->emt[st];
+        
+        for (; o != LDOC_TRIE_ST_NULL; o = ac->out[o])
+            hit(ctx, i + 1, ac->ndes[o], ac->dpth[o]);
+    }
+    
+    return st;
+}
+
+ldoc_trie_t* ldoc_trie_new()
+{
+    ldoc_trie_slab_t* slab = ldoc_trie_slab_new();
+    
+    if (!slab)
+        return NULL;
+    
+    ldoc_trie_nde_t* root = ldoc_trie_nde_new(slab, UTF32, NDE_ROOT, LDOC_TRIE_ANNO_NULL);
+    ldoc_trie_t* trie = root ? (ldoc_trie_t*)malloc(sizeof(ldoc_trie_t)) : NULL;
+    
+    // The root lives in the slab, so freeing the slab frees it too:
+    if (!trie)
+    {
+        ldoc_trie_slab_free(slab);
+        
+        return NULL;
+    }
+    
+    trie->slab = slab;
+    trie->min = 0;
+    trie->max = 0;
+    trie->root = root;
+    trie->rdx = false;
+    trie->ac = NULL;
+    
+    return trie;
+}
+
+ldoc_trie_t* ldoc_trie_new_rdx()
+{
+    ldoc_trie_t* trie = ldoc_trie_new();
+    
+    if (trie)
+        trie->rdx = true;
+    
+    return trie;
+}
+
+ldoc_trie_nde_t* ldoc_trie_dsc_iter(ldoc_trie_nde_t* nde, char chr)
+{
+    switch (nde->lyt)
+    {
+        case LYT_N48:
+        {
+            uint8_t off = ldoc_trie_n48_idx(nde)[(uint8_t)chr];
+            
+            return off ? nde->dscs[off - 1] : LDOC_TRIE_NDE_NULL;
+        }
+        case LYT_N256:
+            return nde->dscs[(uint8_t)chr];
+        case LYT_N16:
+#ifdef __SSE2__
+            // Compare all characters at once; unused ones are masked out:
+            if (nde->tpe == ASCII)
+            {
+                __m128i cmp = _mm_cmpeq_epi8(_mm_set1_epi8(chr), _mm_loadu_si128((const __m128i*)nde->chr.c8));
+                int msk = _mm_movemask_epi8(cmp) & ((1 << nde->size) - 1);
+                
+                return msk ? nde->dscs[__builtin_ctz(msk)] : LDOC_TRIE_NDE_NULL;
+            }
+#endif
+            break;
+        default:
+            break;
+    }
+    
+    uint16_t i = 0;
+    for (; i < nde->size; i++)
+    {
+        char ci;
+        
+        switch (nde->tpe) {
+            case EN_ALPH:
+            case EN_ALPHNUM:
+                // TODO Error.
+                return LDOC_TRIE_NDE_NULL;
+            case ASCII:
+                ci = nde->chr.c8[i];
+                break;
+            case UTF16:
+                ci = nde->chr.c16[i];
+                break;
+            case UTF32:
+                ci = nde->chr.c32[i];
+                break;
+            default:
+                // TODO Error.
+                return LDOC_TRIE_NDE_NULL;
+        }
+        
+        if (chr == ci)
+            return nde->dscs[i];
+    }
+    
+    return LDOC_TRIE_NDE_NULL;
+}
+
+ldoc_trie_nde_t* ldoc_trie_dsc(ldoc_trie_nde_t* nde, char chr)
+{
+    if (!nde->size)
+        return LDOC_TRIE_NDE_NULL;
+    
+    switch (nde->tpe)
+    {
+        case EN_ALPH:
+        case EN_ALPHNUM:
+            return nde->dscs[ldoc_trie_offset_en(chr)];
+        case ASCII:
+        case UTF16:
+        case UTF32:
+            return ldoc_trie_dsc_iter(nde, chr);
+        default:
+            // TODO Error.
+            break;
+    }
+    
+    return LDOC_TRIE_NDE_NULL;
+}
+
+ldoc_trie_nde_t* ldoc_trie_dscn(ldoc_trie_nde_t* nde, uint16_t n)
+{
+    if (!nde->size)
+        return LDOC_TRIE_NDE_NULL;
+    
+    switch (nde->tpe)
+    {
+        case EN_ALPH:
+            return nde->dscs[n];
+        case EN_ALPHNUM:
+            return nde->dscs[n];
+        case ASCII:
+            return nde->dscs[n];
+        case UTF16:
+            return nde->dscs[n];
+        case UTF32:
+            return nde->dscs[n];
+        default:
+            // TODO Error.
+            break;
+    }
+    
+    return LDOC_TRIE_NDE_NULL;
+}
+
+void ldoc_trie_free(ldoc_trie_t* trie)
+{
+    ldoc_trie_ac_drop(trie);
+    
+    // Nodes are released along with the slab's blocks:
+    ldoc_trie_slab_free(trie->slab);
+    
+    free(trie);
+}
+
+ldoc_trie_nde_arr_t* ldoc_trie_nde_arr_new()
+{
+    ldoc_trie_nde_arr_t* arr = (ldoc_trie_nde_arr_t*)malloc(sizeof(ldoc_trie_nde_arr_t));
+    
+    arr->wptr = 0;
+    arr->max = LDOC_TRIE_NDS_ARR_INIT;
     
     arr->nds = (ldoc_trie_nde_t**)malloc(sizeof(ldoc_trie_nde_t*) * arr->max);
     
     return arr;
 }
 
-void ldoc_trie_nde_arr_free(ldoc_trie_nde_arr_t* arr)
+void ldoc_trie_nde_arr_free(ldoc_trie_nde_arr_t* arr)
+{
+    free(arr);
+}
+
+void ldoc_trie_nde_arr_appnd(ldoc_trie_nde_arr_t* arr, ldoc_trie_nde_t* nde)
+{
+    // Increment size of array, if necessary:
+    if (arr->wptr == arr->max)
+    {
+        arr->max += LDOC_TRIE_NDS_ARR_INC;
+        
+        ldoc_trie_nde_t** nds_inc = (ldoc_trie_nde_t**)malloc(sizeof(ldoc_trie_nde_t*) * arr->max);
+        
+        if (!nds_inc)
+        {
+            // TODO Error.
+        }
+        
+        arr->nds = nds_inc;
+    }
+    
+    arr->nds[arr->wptr++] = nde;
+}
+
+bool ldoc_trie_add_trv(ldoc_trie_slab_t* slab, ldoc_trie_nde_t* nde, const char* str, ldoc_trie_ptr_t tpe, ldoc_trie_anno_t anno)
+{
+    for (;; str++)
+    {
+        char chr = *str;
+        
+        // Watch out that the reserved character cannot be added:
+        if (chr == LDOC_TRIE_RES_CHR)
+        {
+            // TODO error
+        }
+        
+        // If the string has been consumed, place the user supplied contents (i.e., we are done):
+        if (!chr)
+        {
+            // Note: Should be obvious that this overwrites existing entries.
+            nde->anno = anno;
+            
+            // Now the node carries some annotations:
+            nde->alloc = NDE_ANNO;
+            
+            return true;
+        }
+        
+        ldoc_trie_nde_t* dsc = ldoc_trie_dsc(nde, chr);
+        
+        // If there is no descendent node available, create one now:
+        if (!dsc)
+        {
+            // Set category and payload to default values here, because this might not be
+            // the last node we are creating on the "way down".
+            dsc = ldoc_trie_nde_new(slab, tpe, NDE_EMPTY, LDOC_TRIE_ANNO_NULL);
+            
+            if (!dsc || !ldoc_trie_nde_set(slab, nde, dsc, chr))
+                return false;
+        }
+        
+        nde = dsc;
+    }
+}
+
+bool ldoc_trie_add_rdx(ldoc_trie_slab_t* slab, ldoc_trie_nde_t* nde, const char* str, ldoc_trie_ptr_t tpe, ldoc_trie_anno_t anno)
 {
-    free(arr);
+    for (;;)
+    {
+        char chr = *str;
+        
+        // If the string has been consumed, place the user supplied contents:
+        if (!chr)
+        {
+            nde->anno = anno;
+            nde->alloc = NDE_ANNO;
+            
+            return true;
+        }
+        
+        ldoc_trie_nde_t* dsc = ldoc_trie_dsc(nde, chr);
+        
+        str++;
+        
+        // The rest of the string goes into the label of a new node (or
+        // several, for very long strings):
+        if (!dsc)
+        {
+            uint16_t llen = (uint16_t)strnlen(str, UINT16_MAX);
+            
+            dsc = ldoc_trie_nde_new(slab, tpe, NDE_EMPTY, LDOC_TRIE_ANNO_NULL);
+            
+            if (!dsc || !ldoc_trie_lbl_set(slab, dsc, str, llen) || !ldoc_trie_nde_set(slab, nde, dsc, chr))
+                return false;
+            
+            nde = dsc;
+            str += llen;
+            
+            continue;
+        }
+        
+        uint16_t off = 0;
+        while (off < dsc->llen && str[off] == dsc->lbl[off])
+            off++;
+        
+        // The string branches off (or ends) within the label:
+        if (off < dsc->llen && !(dsc = ldoc_trie_lbl_split(slab, nde, dsc, chr, off, tpe)))
+            return false;
+        
+        nde = dsc;
+        str += off;
+    }
 }
 
-void ldoc_trie_nde_arr_appnd(ldoc_trie_nde_arr_t* arr, ldoc_trie_nde_t* nde)
+ldoc_trie_nde_t* ldoc_trie_lookup_trv(ldoc_trie_nde_t* nde, const char* string, bool prefixes)
 {
-    // Increment size of array, if necessary:
-    if (arr->wptr == arr->max)
+    for (;;)
     {
-        arr->max += LDOC_TRIE_NDS_ARR_INC;
+        char chr = *string;
         
-        ldoc_trie_nde_t** nds_inc = (ldoc_trie_nde_t**)malloc(sizeof(ldoc_trie_nde_t*) * arr->max);
+        // If the string has been consumed, then the entry has been found in the trie.
+        if (!chr)
+        {
+            if (prefixes)
+                return nde;
+            else if (nde->alloc == NDE_ANNO)
+                return nde;
+            else
+                return LDOC_TRIE_NDE_NULL;
+        }
         
-        if (!nds_inc)
+        nde = ldoc_trie_dsc(nde, chr);
+        
+        if (!nde)
+            return LDOC_TRIE_NDE_NULL;
+        
+        string++;
+        
+        // Match the edge label, if any:
+        uint16_t off = 0;
+        for (; off < nde->llen; off++)
         {
-            // TODO Error.
+            if (string[off] != nde->lbl[off])
+            {
+                if (!string[off] && prefixes)
+                    return LDOC_TRIE_NDE_PFX;
+                
+                return LDOC_TRIE_NDE_NULL;
+            }
         }
         
-        arr->nds = nds_inc;
+        string += off;
     }
+}
+
+bool ldoc_trie_add(ldoc_trie_t* trie, const char* str, ldoc_trie_ptr_t tpe, ldoc_trie_anno_t anno)
+{
+    ldoc_trie_ac_drop(trie);
     
-    arr->nds[arr->wptr++] = nde;
+    if (trie->rdx)
+        return ldoc_trie_add_rdx(trie->slab, trie->root, str, tpe, anno);
+    
+    return ldoc_trie_add_trv(trie->slab, trie->root, str, tpe, anno);
 }
 
-void ldoc_trie_add_trv(ldoc_trie_nde_t* nde, const char* str, ldoc_trie_ptr_t tpe, ldoc_trie_anno_t anno)
+ldoc_trie_nde_t* ldoc_trie_remove(ldoc_trie_t* trie, const char* str)
 {
-    char chr = *str;
+    ldoc_trie_nde_t* nde = ldoc_trie_lookup(trie, str, false);
     
-    // Watch out that the reserved character cannot be added:
-    if (chr == LDOC_TRIE_RES_CHR)
+    if (nde)
     {
-        // TODO error
+        nde->alloc = NDE_EMPTY;
+        ldoc_trie_ac_drop(trie);
     }
     
-    // If the string has been consumed, place the user supplied contents (i.e., we are done):
-    if (!chr)
+    return nde;
+}
+
+ldoc_trie_nde_t* ldoc_trie_lookup(ldoc_trie_t* trie, const char* string, bool prefixes)
+{
+    return ldoc_trie_lookup_trv(trie->root, string, prefixes);
+}
+
+#pragma mark - Frozen Tries
+
+// Frozen trie images: a header, followed by the slots, the annotation index
+// of each slot (padded to a multiple of 8 bytes) and the annotations.
+#define LDOC_TRIE_FRZ_MGC "LDTR"
+#define LDOC_TRIE_FRZ_VER 1
+// Byte order mark:
+#define LDOC_TRIE_FRZ_BOM 0x01020304
+// Slots that are passed over this often when placing descendants are given up
+// on, so that the search for free slots does not keep revisiting them:
+#define LDOC_TRIE_FRZ_FAILS 16
+
+typedef struct ldoc_trie_frz_hdr_t
+{
+    char mgc[4];
+    uint32_t ver;
+    uint32_t bom;
+    uint32_t rsv;
+    uint32_t cnt;
+    uint32_t anno_cnt;
+} ldoc_trie_frz_hdr_t;
+
+static inline size_t ldoc_trie_frz_idxs_off(uint32_t cnt)
+{
+    return sizeof(ldoc_trie_frz_hdr_t) + (size_t)cnt * sizeof(ldoc_trie_slt_t);
+}
+
+static inline size_t ldoc_trie_frz_annos_off(uint32_t cnt)
+{
+    return ldoc_trie_frz_idxs_off(cnt) + (((size_t)cnt * sizeof(uint32_t) + 7) & ~(size_t)7);
+}
+
+static inline size_t ldoc_trie_frz_len(uint32_t cnt, uint32_t anno_cnt)
+{
+    return ldoc_trie_frz_annos_off(cnt) + (size_t)anno_cnt * sizeof(ldoc_trie_frz_anno_t);
+}
+
+static ldoc_trie_frz_t* ldoc_trie_frz_init(void* img, size_t len, bool map)
+{
+    ldoc_trie_frz_t* frz = (ldoc_trie_frz_t*)malloc(sizeof(ldoc_trie_frz_t));
+    
+    if (!frz)
+        return NULL;
+    
+    ldoc_trie_frz_hdr_t* hdr = (ldoc_trie_frz_hdr_t*)img;
+    
+    frz->cnt = hdr->cnt;
+    frz->anno_cnt = hdr->anno_cnt;
+    frz->slts = (const ldoc_trie_slt_t*)(hdr + 1);
+    frz->idxs = (const uint32_t*)((char*)img + ldoc_trie_frz_idxs_off(hdr->cnt));
+    frz->annos = (const ldoc_trie_frz_anno_t*)((char*)img + ldoc_trie_frz_annos_off(hdr->cnt));
+    frz->img = img;
+    frz->img_len = len;
+    frz->map = map;
+    
+    return frz;
+}
+
+// Double array under construction; unused slots are kept in a circular list
+// in ascending order (`nxt`, `prv`), starting at `fre`:
+typedef struct ldoc_trie_dab_t
+{
+    uint32_t cap;
+    uint32_t top;
+    uint32_t fre;
+    ldoc_trie_slt_t* slts;
+    uint32_t* idxs;
+    uint32_t* nxt;
+    uint32_t* prv;
+    uint8_t* fails;
+} ldoc_trie_dab_t;
+
+// Descendant to place: character code, node and position in the node's edge label:
+typedef struct ldoc_trie_dab_dsc_t
+{
+    uint16_t cde;
+    uint16_t lpos;
+    ldoc_trie_nde_t* nde;
+} ldoc_trie_dab_dsc_t;
+
+// Queued state: node, position in the node's edge label and slot:
+typedef struct ldoc_trie_dab_st_t
+{
+    ldoc_trie_nde_t* nde;
+    uint16_t lpos;
+    uint32_t slt;
+} ldoc_trie_dab_st_t;
+
+static inline void ldoc_trie_dab_unlink(ldoc_trie_dab_t* dab, uint32_t slt)
+{
+    // Slots that were given up on are no longer listed:
+    if (dab->fails[slt] >= LDOC_TRIE_FRZ_FAILS)
+        return;
+    
+    if (dab->nxt[slt] == slt)
     {
-        // Note: Should be obvious that this overwrites existing entries.
-        nde->anno = anno;
-        
-        // Now the node carries some annotations:
-        nde->alloc = NDE_ANNO;
+        dab->fre = LDOC_TRIE_FRZ_NULL;
         
         return;
     }
     
-    ldoc_trie_nde_t* dsc = ldoc_trie_dsc(nde, chr);
+    dab->prv[dab->nxt[slt]] = dab->prv[slt];
+    dab->nxt[dab->prv[slt]] = dab->nxt[slt];
+    
+    if (dab->fre == slt)
+        dab->fre = dab->nxt[slt];
+}
+
+static bool ldoc_trie_dab_grow(ldoc_trie_dab_t* dab, uint64_t min)
+{
+    uint64_t cap = dab->cap ? (uint64_t)dab->cap * 2 : 1024;
+    
+    if (cap < min)
+        cap = min;
+    
+    // Bases are signed 32-bit integers:
+    if (cap > INT32_MAX)
+        cap = INT32_MAX;
+    
+    if (cap < min || cap <= dab->cap)
+        return false;
+    
+    ldoc_trie_slt_t* slts = (ldoc_trie_slt_t*)realloc(dab->slts, cap * sizeof(ldoc_trie_slt_t));
+    
+    if (slts)
+        dab->slts = slts;
+    
+    uint32_t* idxs = (uint32_t*)realloc(dab->idxs, cap * sizeof(uint32_t));
+    
+    if (idxs)
+        dab->idxs = idxs;
+    
+    uint32_t* nxt = (uint32_t*)realloc(dab->nxt, cap * sizeof(uint32_t));
+    
+    if (nxt)
+        dab->nxt = nxt;
+    
+    uint32_t* prv = (uint32_t*)realloc(dab->prv, cap * sizeof(uint32_t));
+    
+    if (prv)
+        dab->prv = prv;
+    
+    uint8_t* fails = (uint8_t*)realloc(dab->fails, cap);
+    
+    if (fails)
+        dab->fails = fails;
+    
+    if (!slts || !idxs || !nxt || !prv || !fails)
+        return false;
+    
+    // Append the new slots to the list of unused slots:
+    uint32_t i = dab->cap;
+    for (; i < cap; i++)
+    {
+        dab->slts[i].base = 0;
+        dab->slts[i].chck = LDOC_TRIE_FRZ_NULL;
+        dab->idxs[i] = LDOC_TRIE_FRZ_NULL;
+        dab->fails[i] = 0;
+        dab->nxt[i] = i + 1;
+        dab->prv[i] = i - 1;
+    }
+    
+    uint32_t fst = dab->cap;
+    uint32_t lst = (uint32_t)cap - 1;
     
-    // If there is no descendent node available, create one now:
-    if (!dsc)
+    if (dab->fre == LDOC_TRIE_FRZ_NULL)
     {
-        // Set category and payload to default values here, because this might not be
-        // the last node we are creating on the "way down".
-        dsc = ldoc_trie_nde_new(tpe, NDE_EMPTY, LDOC_TRIE_ANNO_NULL);
+        dab->fre = fst;
+        dab->prv[fst] = lst;
+        dab->nxt[lst] = fst;
+    }
+    else
+    {
+        uint32_t tl = dab->prv[dab->fre];
         
-        ldoc_trie_nde_set(nde, dsc, chr);
+        dab->nxt[tl] = fst;
+        dab->prv[fst] = tl;
+        dab->nxt[lst] = dab->fre;
+        dab->prv[dab->fre] = lst;
     }
     
-    ldoc_trie_add_trv(dsc, str + 1, tpe, anno);
+    dab->cap = (uint32_t)cap;
+    
+    return true;
 }
 
-ldoc_trie_nde_t* ldoc_trie_lookup_trv(ldoc_trie_nde_t* nde, const char* string, bool prefixes)
+// Finds a base for which the slots of all (sorted) descendants are unused:
+static int64_t ldoc_trie_dab_base(ldoc_trie_dab_t* dab, ldoc_trie_dab_dsc_t* dscs, uint16_t cnt)
+{
+    if (dab->fre == LDOC_TRIE_FRZ_NULL && !ldoc_trie_dab_grow(dab, 0))
+        return -1;
+    
+    uint32_t slt = dab->fre;
+    
+    for (;;)
+    {
+        uint32_t nxt = dab->nxt[slt];
+        
+        if (slt >= dscs[0].cde)
+        {
+            uint32_t base = slt - dscs[0].cde;
+            
+            if ((uint64_t)base + dscs[cnt - 1].cde >= dab->cap && !ldoc_trie_dab_grow(dab, (uint64_t)base + dscs[cnt - 1].cde + 1))
+                return -1;
+            
+            uint16_t i = 1;
+            while (i < cnt && dab->slts[base + dscs[i].cde].chck == LDOC_TRIE_FRZ_NULL)
+                i++;
+            
+            if (i == cnt)
+                return base;
+            
+            if (dab->fails[slt] + 1 == LDOC_TRIE_FRZ_FAILS)
+                ldoc_trie_dab_unlink(dab, slt);
+            
+            dab->fails[slt]++;
+            
+            // The list may have been emptied or extended:
+            nxt = dab->fre == LDOC_TRIE_FRZ_NULL ? LDOC_TRIE_FRZ_NULL : dab->nxt[slt];
+        }
+        
+        // At the end of the list, make room:
+        if (nxt == LDOC_TRIE_FRZ_NULL || nxt == dab->fre || nxt <= slt)
+        {
+            uint32_t cap = dab->cap;
+            
+            if (!ldoc_trie_dab_grow(dab, 0))
+                return -1;
+            
+            nxt = cap;
+        }
+        
+        slt = nxt;
+    }
+}
+
+ldoc_trie_frz_t* ldoc_trie_frz_new(ldoc_trie_t* trie, uint64_t (*off)(void* pld, void* ctx), void* ctx)
 {
-    char chr = *string;
+    uint32_t cnt = ldoc_trie_ac_cnt(trie->root);
+    ldoc_trie_dab_t dab = { 0, 1, LDOC_TRIE_FRZ_NULL, NULL, NULL, NULL, NULL, NULL };
+    ldoc_trie_dab_st_t* sts = (ldoc_trie_dab_st_t*)malloc((size_t)cnt * sizeof(ldoc_trie_dab_st_t));
+    ldoc_trie_dab_dsc_t dscs[256];
+    ldoc_trie_frz_anno_t* annos = NULL;
+    uint32_t anno_cnt = 0;
+    uint32_t anno_max = 0;
+    uint32_t nxt = 1;
+    ldoc_trie_frz_t* frz = NULL;
+    bool ok = cnt && sts && ldoc_trie_dab_grow(&dab, 0);
+    
+    if (ok)
+    {
+        // The root has slot 0:
+        ldoc_trie_dab_unlink(&dab, 0);
+        dab.slts[0].chck = 0;
+        sts[0].nde = trie->root;
+        sts[0].lpos = 0;
+        sts[0].slt = 0;
+    }
     
-    // If the string has been consumed, then the entry has been found in the trie.
-    if (!chr)
+    // Breadth-first, so that siblings are placed close to each other:
+    uint32_t st = 0;
+    for (; ok && st < nxt; st++)
     {
-        if (prefixes)
-            return nde;
-        else if (nde->alloc == NDE_ANNO)
-            return nde;
+        ldoc_trie_nde_t* nde = sts[st].nde;
+        uint16_t lpos = sts[st].lpos;
+        uint32_t slt = sts[st].slt;
+        
+        if (lpos == nde->llen && nde->alloc == NDE_ANNO)
+        {
+            if (anno_cnt == anno_max)
+            {
+                uint32_t max = anno_max ? anno_max * 2 : 1024;
+                ldoc_trie_frz_anno_t* nannos = (ldoc_trie_frz_anno_t*)realloc(annos, (size_t)max * sizeof(ldoc_trie_frz_anno_t));
+                
+                if (!nannos)
+                {
+                    ok = false;
+                    
+                    break;
+                }
+                
+                annos = nannos;
+                anno_max = max;
+            }
+            
+            ldoc_trie_frz_anno_t* anno = &(annos[anno_cnt]);
+            
+            memset(anno, 0, sizeof(ldoc_trie_frz_anno_t));
+            anno->off = off ? off(nde->anno.pld, ctx) : (uint64_t)(uintptr_t)nde->anno.pld;
+            anno->cat = nde->anno.cat;
+            dab.idxs[slt] = anno_cnt++;
+        }
+        
+        // Descendants, sorted by character code (character plus one):
+        uint16_t dcnt = 0;
+        
+        if (lpos < nde->llen)
+        {
+            dscs[0].cde = (uint8_t)nde->lbl[lpos] + 1;
+            dscs[0].lpos = lpos + 1;
+            dscs[0].nde = nde;
+            dcnt = 1;
+        }
         else
-            return LDOC_TRIE_NDE_NULL;
+        {
+            uint16_t i = 0;
+            for (; i < nde->size; i++)
+            {
+                if (!nde->dscs[i])
+                    continue;
+                
+                uint16_t cde = (uint8_t)ldoc_trie_char(nde, i) + 1;
+                uint16_t j = dcnt++;
+                
+                for (; j > 0 && dscs[j - 1].cde > cde; j--)
+                    dscs[j] = dscs[j - 1];
+                
+                dscs[j].cde = cde;
+                dscs[j].lpos = 0;
+                dscs[j].nde = nde->dscs[i];
+            }
+        }
+        
+        if (!dcnt)
+            continue;
+        
+        int64_t base = ldoc_trie_dab_base(&dab, dscs, dcnt);
+        
+        if (base < 0)
+        {
+            ok = false;
+            
+            break;
+        }
+        
+        dab.slts[slt].base = (int32_t)base;
+        
+        uint16_t i = 0;
+        for (; i < dcnt; i++)
+        {
+            uint32_t dslt = (uint32_t)base + dscs[i].cde;
+            
+            ldoc_trie_dab_unlink(&dab, dslt);
+            dab.slts[dslt].chck = slt;
+            
+            if (dslt >= dab.top)
+                dab.top = dslt + 1;
+            
+            sts[nxt].nde = dscs[i].nde;
+            sts[nxt].lpos = dscs[i].lpos;
+            sts[nxt++].slt = dslt;
+        }
     }
     
-    ldoc_trie_nde_t* dsc = ldoc_trie_dsc(nde, chr);
+    // Lay out the image:
+    size_t len = ok ? ldoc_trie_frz_len(dab.top, anno_cnt) : 0;
+    char* img = ok ? (char*)malloc(len) : NULL;
     
-    if (!dsc)
-        return LDOC_TRIE_NDE_NULL;
+    if (img)
+    {
+        ldoc_trie_frz_hdr_t hdr = { LDOC_TRIE_FRZ_MGC, LDOC_TRIE_FRZ_VER, LDOC_TRIE_FRZ_BOM, 0, dab.top, anno_cnt };
+        
+        memset(img, 0, len);
+        memcpy(img, &hdr, sizeof(hdr));
+        memcpy(img + sizeof(hdr), dab.slts, (size_t)dab.top * sizeof(ldoc_trie_slt_t));
+        memcpy(img + ldoc_trie_frz_idxs_off(dab.top), dab.idxs, (size_t)dab.top * sizeof(uint32_t));
+        
+        if (anno_cnt)
+            memcpy(img + ldoc_trie_frz_annos_off(dab.top), annos, (size_t)anno_cnt * sizeof(ldoc_trie_frz_anno_t));
+        
+        frz = ldoc_trie_frz_init(img, len, false);
+        
+        if (!frz)
+            free(img);
+    }
+    
+    free(dab.slts);
+    free(dab.idxs);
+    free(dab.nxt);
+    free(dab.prv);
+    free(dab.fails);
+    free(sts);
+    free(annos);
     
-    return ldoc_trie_lookup_trv(dsc, string + 1, prefixes);
+    return frz;
 }
 
-void ldoc_trie_add(ldoc_trie_t* trie, const char* str, ldoc_trie_ptr_t tpe, ldoc_trie_anno_t anno)
+void ldoc_trie_frz_free(ldoc_trie_frz_t* frz)
 {
-    ldoc_trie_add_trv(trie->root, str, tpe, anno);
+    if (!frz)
+        return;
+    
+    if (frz->map)
+        munmap(frz->img, frz->img_len);
+    else
+        free(frz->img);
+    
+    free(frz);
 }
 
-ldoc_trie_nde_t* ldoc_trie_remove(ldoc_trie_t* trie, const char* str)
+bool ldoc_trie_frz_save(ldoc_trie_frz_t* frz, const char* pth)
 {
-    ldoc_trie_nde_t* nde = ldoc_trie_lookup(trie, str, false);
+    FILE* fle = fopen(pth, "wb");
     
-    if (nde)
-        nde->alloc = NDE_EMPTY;
+    if (!fle)
+        return false;
     
-    return nde;
+    bool ok = fwrite(frz->img, frz->img_len, 1, fle) == 1;
+    
+    if (fclose(fle))
+        ok = false;
+    
+    return ok;
 }
 
-ldoc_trie_nde_t* ldoc_trie_lookup(ldoc_trie_t* trie, const char* string, bool prefixes)
+ldoc_trie_frz_t* ldoc_trie_frz_load_mmap(const char* pth)
 {
-    return ldoc_trie_lookup_trv(trie->root, string, prefixes);
+    int fd = open(pth, O_RDONLY);
+    
+    if (fd < 0)
+        return NULL;
+    
+    struct stat st;
+    
+    if (fstat(fd, &st) || (size_t)st.st_size < sizeof(ldoc_trie_frz_hdr_t))
+    {
+        close(fd);
+        
+        return NULL;
+    }
+    
+    size_t len = st.st_size;
+    void* map = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, 0);
+    
+    // The mapping stays valid after closing the file:
+    close(fd);
+    
+    if (map == MAP_FAILED)
+        return NULL;
+    
+    ldoc_trie_frz_hdr_t* hdr = (ldoc_trie_frz_hdr_t*)map;
+    ldoc_trie_frz_t* frz = NULL;
+    
+    // Lookups check slot and annotation indices, so the header suffices:
+    if (!memcmp(hdr->mgc, LDOC_TRIE_FRZ_MGC, 4) && hdr->ver == LDOC_TRIE_FRZ_VER && hdr->bom == LDOC_TRIE_FRZ_BOM &&
+        hdr->cnt && hdr->cnt <= INT32_MAX && ldoc_trie_frz_len(hdr->cnt, hdr->anno_cnt) == len)
+        frz = ldoc_trie_frz_init(map, len, true);
+    
+    if (!frz)
+        munmap(map, len);
+    
+    return frz;
 }
 
-char* ldoc_trie_collect_trv(ldoc_trie_nde_t* nde, const char* sep, char* str, size_t* len, size_t* max, char* pth, size_t* plen, size_t* pmax)
+bool ldoc_trie_frz_lookup(ldoc_trie_frz_t* frz, const char* string, bool prefixes, ldoc_trie_frz_anno_t* anno)
 {
-    ldoc_trie_nde_t* dsc;
-    char chr;
-    uint16_t i = 0;
-    for (; i < nde->size; i++)
+    uint32_t slt = 0;
+    
+    for (; *string; string++)
+    {
+        int64_t dslt = (int64_t)frz->slts[slt].base + (uint8_t)*string + 1;
+        
+        if (dslt < 0 || dslt >= frz->cnt || frz->slts[dslt].chck != slt)
+            return false;
+        
+        slt = (uint32_t)dslt;
+    }
+    
+    uint32_t idx = frz->idxs[slt];
+    
+    if (idx == LDOC_TRIE_FRZ_NULL || idx >= frz->anno_cnt)
+    {
+        if (!prefixes)
+            return false;
+        
+        if (anno)
+        {
+            memset(anno, 0, sizeof(ldoc_trie_frz_anno_t));
+            anno->off = UINT64_MAX;
+        }
+        
+        return true;
+    }
+    
+    if (anno)
+        *anno = frz->annos[idx];
+    
+    return true;
+}
+
+#pragma mark - Summarization
+
+char* ldoc_trie_collect_trv(ldoc_trie_nde_t* nde, const char* sep, char* str, size_t* len, size_t* max, char** pth, size_t* plen, size_t* pmax)
+{
+    ldoc_trie_stk_t stk;
+    
+    ldoc_trie_stk_init(&stk);
+    ldoc_trie_stk_push(&stk, nde, *plen);
+    
+    while (stk.cnt)
     {
-        // Append current iteration's character to path:
-        chr = ldoc_trie_char(nde, i);
-        pth = ldoc_sheap_ccatc(pth, plen, pmax, chr);
-        dsc = ldoc_trie_dsc(nde, chr);
+        ldoc_trie_frm_t* frm = &(stk.frms[stk.cnt - 1]);
+        
+        // Remove the node's path characters when all descendants are done:
+        if (frm->i == frm->nde->size)
+        {
+            *plen = frm->pend;
+            *(*pth + *plen) = 0;
+            stk.cnt--;
+            
+            continue;
+        }
+        
+        uint16_t i = frm->i++;
+        ldoc_trie_nde_t* dsc = ldoc_trie_dscn(frm->nde, i);
+        
+        if (!dsc)
+            continue;
+        
+        size_t pend = *plen;
+        
+        // Append current iteration's character (and label) to path:
+        *pth = ldoc_sheap_ccatc(*pth, plen, pmax, ldoc_trie_char(frm->nde, i));
+        
+        uint16_t off = 0;
+        for (; off < dsc->llen; off++)
+            *pth = ldoc_sheap_ccatc(*pth, plen, pmax, dsc->lbl[off]);
         
         // If this is a populated entry in the trie, add to `str`:
-        if (dsc)
+        if (dsc->alloc == NDE_ANNO)
         {
-            if (dsc->alloc == NDE_ANNO)
-            {
-                if (str)
-                    str = ldoc_sheap_ccat(str, len, max, (char*)sep);
-                
-                str = ldoc_sheap_ccat(str, len, max, pth);
-            }
+            if (str)
+                str = ldoc_sheap_ccat(str, len, max, (char*)sep);
             
-            // Traverse:
-            str = ldoc_trie_collect_trv(dsc, sep, str, len, max, pth, plen, pmax);
+            str = ldoc_sheap_ccat(str, len, max, *pth);
         }
         
-        // Remove last path character to make room for next iteration:
-        if (*plen)
+        // Traverse (an incomplete list is not returned):
+        if (!ldoc_trie_stk_push(&stk, dsc, pend))
         {
-            (*plen)--;
-            *(pth + *plen) = 0;
+            free(str);
+            str = NULL;
+            
+            break;
         }
     }
     
+    ldoc_trie_stk_free(&stk);
+    
     return str;
 }
 
@@ -605,9 +1903,11 @@ char* ldoc_trie_collect(ldoc_trie_t* trie, const char* sep)
     char* pth = malloc(pmax);
     
     if (!pth)
-    {
-        // TODO Error handling.
-    }
+        return NULL;
+    
+    char* str = ldoc_trie_collect_trv(trie->root, sep, NULL, &len, &max, &pth, &plen, &pmax);
     
-    return ldoc_trie_collect_trv(trie->root, sep, NULL, &len, &max, pth, &plen, &pmax);
+    free(pth);
+    
+    return str;
 }
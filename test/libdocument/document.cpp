@@ -17,6 +17,7 @@
 #include <gtest/gtest.h>
 
 #include "document.h"
+#include "json.h"
 
 #define LDOC_NULLTYPE long
 
@@ -369,6 +370,42 @@ TEST(ldoc_document, big_document)
 {
 }
 
+TEST(ldoc_document, arena_document)
+{
+    ldoc_doc_t* doc = ldoc_doc_new_arena(256);
+    EXPECT_NE(NULL, (LDOC_NULLTYPE)doc);
+    EXPECT_NE(NULL, (LDOC_NULLTYPE)doc->arna);
+    EXPECT_EQ(LDOC_NDE_RT, doc->rt->tpe);
+    
+    // Enough nodes, entities and strings to span several arena blocks:
+    for (int i = 0; i < 100; i++)
+    {
+        ldoc_nde_t* nde = ldoc_doc_nde_new(doc, LDOC_NDE_UA);
+        EXPECT_NE(NULL, (LDOC_NULLTYPE)nde);
+        EXPECT_EQ(0, (uintptr_t)nde % sizeof(void*));
+        nde->mkup.anno.str = ldoc_doc_strndup(doc, "key", 3);
+        ldoc_nde_dsc_push(doc->rt, nde);
+        
+        ldoc_ent_t* ent = ldoc_doc_ent_new(doc, LDOC_ENT_OR);
+        EXPECT_NE(NULL, (LDOC_NULLTYPE)ent);
+        EXPECT_EQ(0, (uintptr_t)ent % sizeof(void*));
+        ent->pld.pair.anno.str = ldoc_doc_strndup(doc, "a", 1);
+        ent->pld.pair.dtm.str = ldoc_doc_strndup(doc, "value", 3);
+        ldoc_nde_ent_push(nde, ent);
+    }
+    
+    EXPECT_EQ(100, doc->rt->dsc_cnt);
+    EXPECT_STREQ("val", doc->rt->dscs.tqh_first->ents.tqh_first->pld.pair.dtm.str);
+    
+    // Oversized allocations get a block of their own:
+    char big[8192];
+    memset(big, 'x', sizeof(big) - 1);
+    big[sizeof(big) - 1] = 0;
+    EXPECT_EQ(sizeof(big) - 1, strlen(ldoc_doc_strndup(doc, big, sizeof(big))));
+    
+    ldoc_doc_free(doc);
+}
+
 //
 // Document manipulation
 //
@@ -439,14 +476,320 @@ TEST(ldoc_document, find_annotation)
     ldoc_doc_free(doc);
 }
 
+TEST(ldoc_document, find_annotation_index)
+{
+    ldoc_doc_t* doc = ldoc_doc_new_arena(0);
+    EXPECT_NE(NULL, (LDOC_NULLTYPE)doc);
+    
+    // Wide node with entities and two equally annotated nodes, where only
+    // the second one has the searched for child:
+    static char keys[64][8];
+    for (size_t i = 0; i < 64; i++)
+    {
+        snprintf(keys[i], sizeof(keys[i]), "k%zu", i);
+        ldoc_ent_t* ent = ldoc_doc_ent_new(doc, LDOC_ENT_OR);
+        ent->pld.pair.anno.str = keys[i];
+        ent->pld.pair.dtm.str = keys[i];
+        ldoc_nde_ent_push(doc->rt, ent);
+    }
+    
+    ldoc_nde_t* nde1 = ldoc_doc_nde_new(doc, LDOC_NDE_UA);
+    nde1->mkup.anno.str = (char*)ldoc_ord_doc_4_1;
+    ldoc_nde_dsc_push(doc->rt, nde1);
+    ldoc_nde_t* nde2 = ldoc_doc_nde_new(doc, LDOC_NDE_UA);
+    nde2->mkup.anno.str = (char*)ldoc_ord_doc_4_1;
+    ldoc_nde_dsc_push(doc->rt, nde2);
+    ldoc_ent_t* ent = ldoc_doc_ent_new(doc, LDOC_ENT_BR);
+    ent->pld.pair.anno.str = (char*)ldoc_ord_doc_4_1_1k;
+    ent->pld.pair.dtm.bl = true;
+    ldoc_nde_ent_push(nde2, ent);
+    
+    EXPECT_TRUE(ldoc_doc_index(doc));
+    EXPECT_NE((struct ldoc_nde_idx_t*)NULL, doc->rt->idx);
+    EXPECT_EQ((struct ldoc_nde_idx_t*)NULL, nde2->idx);
+    
+    char* pth1[] = { keys[42] };
+    ldoc_res_t* res = ldoc_find_anno(doc, pth1, 1);
+    EXPECT_NE((ldoc_res_t*)NULL, res);
+    EXPECT_EQ(false, res->nde);
+    EXPECT_EQ(keys[42], res->info.ent->pld.pair.dtm.str);
+    ldoc_res_free(res);
+    
+    const char* pth2[] = { ldoc_ord_doc_4_1, ldoc_ord_doc_4_1_1k };
+    res = ldoc_find_anno(doc, (char**)pth2, 2);
+    EXPECT_NE((ldoc_res_t*)NULL, res);
+    EXPECT_EQ(ent, res->info.ent);
+    ldoc_res_free(res);
+    
+    res = ldoc_find_anno(doc, (char**)pth2, 1);
+    EXPECT_NE((ldoc_res_t*)NULL, res);
+    EXPECT_EQ(nde1, res->info.nde);
+    ldoc_res_free(res);
+    
+    // Pushing keeps the index up to date, removing drops it:
+    ldoc_nde_t* nde3 = ldoc_doc_nde_new(doc, LDOC_NDE_UA);
+    nde3->mkup.anno.str = (char*)ldoc_ord_doc_4_3;
+    ldoc_nde_dsc_push(doc->rt, nde3);
+    const char* pth3[] = { ldoc_ord_doc_4_3 };
+    res = ldoc_find_anno(doc, (char**)pth3, 1);
+    EXPECT_NE((ldoc_res_t*)NULL, res);
+    EXPECT_EQ(nde3, res->info.nde);
+    ldoc_res_free(res);
+    
+    ldoc_nde_rm(nde3);
+    EXPECT_EQ((struct ldoc_nde_idx_t*)NULL, doc->rt->idx);
+    EXPECT_EQ(LDOC_RES_NULL, ldoc_find_anno(doc, (char**)pth3, 1));
+    EXPECT_NE((struct ldoc_nde_idx_t*)NULL, doc->rt->idx);
+    
+    const char* none[] = { "k64" };
+    EXPECT_EQ(LDOC_RES_NULL, ldoc_find_anno(doc, (char**)none, 1));
+    
+    ldoc_doc_free(doc);
+}
+
 TEST(ldoc_document, find_by_position)
 {
+    ldoc_doc_t* doc = ldoc_big_doc();
+    ldoc_nde_t* h1 = TAILQ_FIRST(&(doc->rt->dscs));
+    ldoc_nde_t* par = TAILQ_FIRST(&(h1->dscs));
+    uint64_t len1 = strlen(ldoc_big_doc_1_1);
+    uint64_t len2 = strlen(ldoc_big_doc_1_2_1);
+    
+    ldoc_pos_t* pos;
+    uint64_t end;
+    
+    // Without an offset index, the document is traversed:
+    for (int idx = 0; idx < 2; idx++)
+    {
+        if (idx)
+            EXPECT_TRUE(ldoc_doc_pos_index(doc));
+        else
+            EXPECT_EQ((struct ldoc_pos_idx_t*)NULL, doc->pos);
+        
+        // The root has no text of its own:
+        pos = ldoc_find_pos(doc, 0);
+        EXPECT_NE((ldoc_pos_t*)NULL, pos);
+        EXPECT_EQ(doc->rt, pos->nde);
+        ldoc_pos_free(pos);
+        
+        pos = ldoc_find_pos(doc, 1);
+        EXPECT_EQ(h1, pos->nde);
+        EXPECT_EQ(0, pos->nde_off);
+        EXPECT_EQ(1, pos->off);
+        ldoc_pos_free(pos);
+        
+        // Boundaries belong to the node that ends there:
+        pos = ldoc_find_pos(doc, len1);
+        EXPECT_EQ(h1, pos->nde);
+        EXPECT_EQ(len1, pos->off);
+        ldoc_pos_free(pos);
+        
+        pos = ldoc_find_pos(doc, len1 + 1);
+        EXPECT_EQ(par, pos->nde);
+        EXPECT_EQ(len1, pos->nde_off);
+        EXPECT_EQ(1, pos->off);
+        ldoc_pos_free(pos);
+        
+        // End of the text, and beyond:
+        end = len1 + len2 + strlen(ldoc_big_doc_1_2_2) + strlen(ldoc_big_doc_2_1) +
+                       strlen(ldoc_big_doc_2_1_1) + strlen(ldoc_big_doc_2_1_2) + strlen(ldoc_big_doc_2_2_1_1) +
+                       strlen(ldoc_big_doc_2_2_1_2) + strlen(ldoc_big_doc_2_2_1_3) + strlen(ldoc_big_doc_2_2_2) +
+                       strlen(ldoc_big_doc_2_2_3) + strlen(ldoc_big_doc_2_2_4);
+        pos = ldoc_find_pos(doc, end);
+        EXPECT_NE((ldoc_pos_t*)NULL, pos);
+        EXPECT_EQ(strlen(ldoc_big_doc_2_2_2) + strlen(ldoc_big_doc_2_2_3) + strlen(ldoc_big_doc_2_2_4), pos->off);
+        ldoc_pos_free(pos);
+        EXPECT_EQ((ldoc_pos_t*)NULL, ldoc_find_pos(doc, end + 1));
+        
+    }
+    
+    // Edits of a node's entities update the index:
+    TAILQ_FIRST(&(h1->ents))->pld.str = (char*)"H";
+    ldoc_doc_pos_upd(doc, h1);
+    pos = ldoc_find_pos(doc, 2);
+    EXPECT_EQ(par, pos->nde);
+    EXPECT_EQ(1, pos->nde_off);
+    EXPECT_EQ(1, pos->off);
+    ldoc_pos_free(pos);
+    EXPECT_EQ((ldoc_pos_t*)NULL, ldoc_find_pos(doc, end - len1 + 2));
+    
+    ldoc_doc_pos_drop(doc);
+    EXPECT_EQ((struct ldoc_pos_idx_t*)NULL, doc->pos);
+    
+    // Without an index, edits are seen right away:
+    TAILQ_FIRST(&(h1->ents))->pld.str = (char*)"Hi";
+    pos = ldoc_find_pos(doc, 3);
+    EXPECT_EQ(par, pos->nde);
+    EXPECT_EQ(2, pos->nde_off);
+    ldoc_pos_free(pos);
+    EXPECT_EQ((struct ldoc_pos_idx_t*)NULL, doc->pos);
     
+    ldoc_doc_free(doc);
+}
+
+TEST(ldoc_document, find_by_position_booleans)
+{
+    const char* json = "{\"a\":\"hello\",\"b\":true,\"c\":[false,null,\"world\"]}";
+    off_t err = 0;
+    ldoc_doc_t* doc = ldoc_json_read((char*)json, strlen(json), &err);
+    ASSERT_NE((ldoc_doc_t*)NULL, doc);
+    
+    // Booleans and null values have no text:
+    for (int idx = 0; idx < 2; idx++)
+    {
+        if (idx)
+            EXPECT_TRUE(ldoc_doc_pos_index(doc));
+        
+        ldoc_pos_t* pos = ldoc_find_pos(doc, 7);
+        ASSERT_NE((ldoc_pos_t*)NULL, pos);
+        EXPECT_EQ(LDOC_NDE_OL, pos->nde->tpe);
+        EXPECT_EQ(5, pos->nde_off);
+        EXPECT_EQ(2, pos->off);
+        ldoc_pos_free(pos);
+        EXPECT_EQ((ldoc_pos_t*)NULL, ldoc_find_pos(doc, 11));
+        
+        ldoc_ser_t* ser = ldoc_lkahead(doc, 3, 16);
+        ASSERT_NE((ldoc_ser_t*)NULL, ser);
+        EXPECT_STREQ("loworld", ser->pld.str);
+        ldoc_ser_free(ser);
+    }
+    
+    ldoc_doc_free(doc);
 }
 
 TEST(ldoc_document, find_by_keyword)
 {
+    ldoc_doc_t* doc = ldoc_big_doc();
+    ldoc_nde_t* h1 = TAILQ_FIRST(&(doc->rt->dscs));
+    ldoc_nde_t* par = TAILQ_FIRST(&(h1->dscs));
+    ldoc_nde_t* h2 = TAILQ_LAST(&(h1->dscs), ldoc_nde_t::ldoc_nde_list);
+    ldoc_nde_t* h3 = TAILQ_LAST(&(h2->dscs), ldoc_nde_t::ldoc_nde_list);
+    uint64_t len1 = strlen(ldoc_big_doc_1_1);
+    
+    ldoc_pos_t* pos = ldoc_find_kw(doc, 0, (char*)"ipsum");
+    EXPECT_NE((ldoc_pos_t*)NULL, pos);
+    EXPECT_EQ(par, pos->nde);
+    EXPECT_EQ(len1, pos->nde_off);
+    EXPECT_EQ(6, pos->off);
+    ldoc_pos_free(pos);
+    
+    // Resuming after the first match:
+    pos = ldoc_find_kw(doc, 1, (char*)"Heading");
+    EXPECT_EQ(h2, pos->nde);
+    EXPECT_EQ(0, pos->off);
+    ldoc_pos_free(pos);
+    
+    // Matches across entities and across nodes:
+    pos = ldoc_find_kw(doc, 0, (char*)"3, again!");
+    EXPECT_EQ(h3, pos->nde);
+    EXPECT_EQ(strlen("Heading "), pos->off);
+    ldoc_pos_free(pos);
+    
+    pos = ldoc_find_kw(doc, 0, (char*)"Heading 2Heading 3");
+    EXPECT_EQ(h2, pos->nde);
+    EXPECT_EQ(0, pos->off);
+    ldoc_pos_free(pos);
+    
+    pos = ldoc_find_kw(doc, 0, (char*)"!Introducing some emphasized");
+    EXPECT_EQ(h3, pos->nde);
+    ldoc_pos_free(pos);
+    
+    EXPECT_EQ((ldoc_pos_t*)NULL, ldoc_find_kw(doc, 0, (char*)"idea!!"));
+    EXPECT_EQ((ldoc_pos_t*)NULL, ldoc_find_kw(doc, len1 + 1, (char*)"Lorem ipsum dolor"));
+    
+    ldoc_doc_free(doc);
+    
+    // Booleans have no text, so that matches span them:
+    const char* json = "{\"a\":\"hello\",\"b\":true,\"c\":\"world\"}";
+    off_t err = 0;
+    doc = ldoc_json_read((char*)json, strlen(json), &err);
+    ASSERT_NE((ldoc_doc_t*)NULL, doc);
+    
+    pos = ldoc_find_kw(doc, 0, (char*)"world");
+    ASSERT_NE((ldoc_pos_t*)NULL, pos);
+    EXPECT_EQ(doc->rt, pos->nde);
+    EXPECT_EQ(5, pos->off);
+    ldoc_pos_free(pos);
+    
+    pos = ldoc_find_kw(doc, 0, (char*)"lowo");
+    ASSERT_NE((ldoc_pos_t*)NULL, pos);
+    EXPECT_EQ(3, pos->off);
+    ldoc_pos_free(pos);
+    
+    EXPECT_EQ((ldoc_pos_t*)NULL, ldoc_find_kw(doc, 0, (char*)"true"));
+    
+    ldoc_doc_free(doc);
+}
+
+TEST(ldoc_document, find_matches)
+{
+    ldoc_doc_t* doc = ldoc_big_doc();
+    ldoc_nde_t* h1 = TAILQ_FIRST(&(doc->rt->dscs));
+    ldoc_nde_t* h2 = TAILQ_LAST(&(h1->dscs), ldoc_nde_t::ldoc_nde_list);
+    ldoc_nde_t* h3 = TAILQ_LAST(&(h2->dscs), ldoc_nde_t::ldoc_nde_list);
+    ldoc_nde_t* par = TAILQ_FIRST(&(h3->dscs));
+    
+    ldoc_trie_t* trie = ldoc_trie_new();
+    ldoc_trie_anno_t anno1 = { 1, NULL };
+    ldoc_trie_anno_t anno2 = { 2, NULL };
+    ldoc_trie_anno_t anno3 = { 3, NULL };
+    ldoc_trie_add(trie, "Heading", ASCII, anno1);
+    ldoc_trie_add(trie, "some emphasized", ASCII, anno2);
+    ldoc_trie_add(trie, "!Intro", ASCII, anno3);
+    
+    ldoc_mtch_arr_t* arr = ldoc_find_mtchs(doc, 0, trie);
+    EXPECT_NE((ldoc_mtch_arr_t*)NULL, arr);
+    EXPECT_EQ(6, arr->wptr);
+    EXPECT_EQ(h1, arr->mtchs[0].pos.nde);
+    EXPECT_EQ(0, arr->mtchs[0].pos.off);
+    EXPECT_EQ(1, arr->mtchs[0].anno.cat);
+    
+    // Across nodes, and across entities:
+    EXPECT_EQ(h3, arr->mtchs[4].pos.nde);
+    EXPECT_EQ(strlen("Heading 3, again"), arr->mtchs[4].pos.off);
+    EXPECT_EQ(6, arr->mtchs[4].len);
+    EXPECT_EQ(3, arr->mtchs[4].anno.cat);
+    EXPECT_EQ(par, arr->mtchs[5].pos.nde);
+    EXPECT_EQ(strlen("Introducing "), arr->mtchs[5].pos.off);
+    EXPECT_EQ(2, arr->mtchs[5].anno.cat);
+    ldoc_mtch_arr_free(arr);
+    
+    // Resuming after the first occurrence:
+    arr = ldoc_find_mtchs(doc, 1, trie);
+    EXPECT_EQ(5, arr->wptr);
+    ldoc_mtch_arr_free(arr);
+    
+    ldoc_ser_t* ser = ldoc_lkahead(doc, 2, 12);
+    EXPECT_STREQ("ading 1Lorem", ser->pld.str);
+    ldoc_ser_free(ser);
+    
+    ldoc_trie_free(trie);
+    ldoc_doc_free(doc);
     
+    // Booleans have no text, so that occurrences span them:
+    const char* json = "{\"a\":\"hello\",\"b\":true,\"c\":[false,\"world\"]}";
+    off_t err = 0;
+    doc = ldoc_json_read((char*)json, strlen(json), &err);
+    ASSERT_NE((ldoc_doc_t*)NULL, doc);
+    
+    trie = ldoc_trie_new();
+    ldoc_trie_add(trie, "world", ASCII, anno1);
+    ldoc_trie_add(trie, "lowo", ASCII, anno2);
+    ldoc_trie_add(trie, "true", ASCII, anno3);
+    
+    arr = ldoc_find_mtchs(doc, 0, trie);
+    ASSERT_NE((ldoc_mtch_arr_t*)NULL, arr);
+    EXPECT_EQ(2, arr->wptr);
+    EXPECT_EQ(doc->rt, arr->mtchs[0].pos.nde);
+    EXPECT_EQ(3, arr->mtchs[0].pos.off);
+    EXPECT_EQ(2, arr->mtchs[0].anno.cat);
+    EXPECT_EQ(LDOC_NDE_OL, arr->mtchs[1].pos.nde->tpe);
+    EXPECT_EQ(0, arr->mtchs[1].pos.off);
+    EXPECT_EQ(1, arr->mtchs[1].anno.cat);
+    ldoc_mtch_arr_free(arr);
+    
+    ldoc_trie_free(trie);
+    ldoc_doc_free(doc);
 }
 
 //
@@ -754,6 +1097,94 @@ TEST(ldoc_document, format_json_multiple_lists)
     ldoc_doc_free(doc);
 }
 
+//
+// Sinks
+//
+
+static bool ldoc_test_snk_wrt(void* ctx, const char* str, size_t len)
+{
+    ((std::string*)ctx)->append(str, len);
+    
+    return true;
+}
+
+TEST(ldoc_document, format_json_sink)
+{
+    ldoc_doc_t* doc = ldoc_ord_doc();
+    EXPECT_NE(NULL, (LDOC_NULLTYPE)doc);
+    
+    ldoc_snk_t* snk = ldoc_snk_new(0);
+    EXPECT_NE((ldoc_snk_t*)NULL, snk);
+    
+    EXPECT_TRUE(ldoc_format_json_to(doc, snk));
+    EXPECT_STREQ("{\"List 1\":[\"Entity 1\",\"Entity 2\",{\"Entity 3 (key)\":\"Entity 3 (value)\"},{\"Key 1\":\"Value 1\"},{\"Key 2.1\":\"Value 2.1\",\"Key 2.2\":\"Value 2.2\"},{}],\"List 2\":[[{\"Key 4.1\":\"Value 4.1\"}]]}", snk->buf);
+    
+    char* str = ldoc_snk_take(snk);
+    EXPECT_NE((char*)NULL, str);
+    EXPECT_EQ(0, snk->len);
+    EXPECT_EQ((char*)NULL, snk->buf);
+    free(str);
+    
+    // The sink keeps working after its buffer was taken:
+    ldoc_snk_appnd(snk, "{}", 2);
+    EXPECT_STREQ("{}", snk->buf);
+    
+    str = ldoc_snk_take(snk);
+    EXPECT_STREQ("{}", str);
+    free(str);
+    
+    str = ldoc_snk_take(snk);
+    EXPECT_STREQ("", str);
+    free(str);
+    
+    ldoc_snk_free(snk);
+    
+    // New buffers after taking one have the requested size:
+    snk = ldoc_snk_new(1 << 16);
+    ASSERT_NE((ldoc_snk_t*)NULL, snk);
+    ldoc_snk_appnd(snk, "{}", 2);
+    free(ldoc_snk_take(snk));
+    ldoc_snk_appnd(snk, "{}", 2);
+    EXPECT_EQ(1 << 16, snk->max);
+    ldoc_snk_free(snk);
+    
+    ldoc_doc_free(doc);
+}
+
+TEST(ldoc_document, format_html_sink_callback)
+{
+    ldoc_doc_t* doc = ldoc_big_doc();
+    
+    ldoc_vis_nde_ord_t* vis_nde = ldoc_vis_nde_ord_new();
+    vis_nde->vis_setup = ldoc_vis_setup_html;
+    vis_nde->vis_teardown = ldoc_vis_teardown_html;
+    ldoc_vis_nde_uni(&(vis_nde->pre), ldoc_vis_nde_pre_html);
+    ldoc_vis_nde_uni(&(vis_nde->infx), ldoc_vis_nde_infx_html);
+    ldoc_vis_nde_uni(&(vis_nde->post), ldoc_vis_nde_post_html);
+    
+    ldoc_vis_ent_t* vis_ent = ldoc_vis_ent_new();
+    ldoc_vis_ent_uni(vis_ent, ldoc_vis_ent_html);
+    
+    ldoc_ser_t* ser = ldoc_format(doc, vis_nde, vis_ent);
+    EXPECT_NE((ldoc_ser_t*)NULL, ser);
+    
+    // Tiny buffer, so that fragments are written out both buffered and directly:
+    std::string out;
+    ldoc_snk_t* snk = ldoc_snk_new_wrt(ldoc_test_snk_wrt, &out, 32);
+    EXPECT_NE((ldoc_snk_t*)NULL, snk);
+    
+    EXPECT_TRUE(ldoc_format_to(doc, vis_nde, vis_ent, snk));
+    EXPECT_EQ(0, snk->len);
+    EXPECT_EQ(strlen(ser->pld.str), snk->tot);
+    EXPECT_STREQ(ser->pld.str, out.c_str());
+    
+    ldoc_snk_free(snk);
+    ldoc_ser_free(ser);
+    ldoc_vis_nde_ord_free(vis_nde);
+    ldoc_vis_ent_free(vis_ent);
+    ldoc_doc_free(doc);
+}
+
 #ifndef LDOC_NOPYTHON
 
 //
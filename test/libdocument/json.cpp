@@ -15,6 +15,8 @@
  */
 
 #include <gtest/gtest.h>
+#include <unistd.h>
+#include <vector>
 
 #include "json.h"
 
@@ -108,3 +110,903 @@ TEST(ldoc_json, ldj)
     
     EXPECT_STREQ(ldoc_ldj, ldj);
 }
+
+TEST(ldoc_json, arena_json)
+{
+    off_t err = 0;
+    
+    ldoc_doc_t* doc = ldoc_doc_new_arena(0);
+    EXPECT_TRUE(ldoc_json_read_into(doc, (char*)ldoc_json_small, strlen(ldoc_json_small), &err, NULL));
+    EXPECT_EQ(0, err);
+    
+    ldoc_ser_t* ser = ldoc_format_json(doc);
+    EXPECT_NE((ldoc_ser_t*)NULL, ser);
+    EXPECT_STREQ(ldoc_json_small_ref, ser->pld.str);
+    
+    ldoc_ser_free(ser);
+    ldoc_doc_free(doc);
+}
+
+TEST(ldoc_json, arena_ldj)
+{
+    const char* refs[] = { "{\"key1\":123}", "{\"key2\":true}", "{\"key3\":[1,2,3]}" };
+    off_t err = 0;
+    off_t nxt = 0;
+    size_t len = strlen(ldoc_ldj);
+    
+    for (int i = 0; i < 3; i++)
+    {
+        ldoc_doc_t* doc = ldoc_doc_new_arena(128);
+        EXPECT_TRUE(ldoc_json_read_into(doc, (char*)ldoc_ldj, len, &err, &nxt));
+        EXPECT_EQ(0, err);
+        
+        ldoc_ser_t* ser = ldoc_format_json(doc);
+        EXPECT_STREQ(refs[i], ser->pld.str);
+        
+        ldoc_ser_free(ser);
+        ldoc_doc_free(doc);
+    }
+    
+    EXPECT_EQ(len, nxt);
+}
+
+TEST(ldoc_json, view_json)
+{
+    off_t err = 0;
+    char* json = strdup(ldoc_json_small);
+    
+    ldoc_doc_t* doc = ldoc_json_read_view(json, strlen(json), &err);
+    EXPECT_NE((ldoc_doc_t*)NULL, doc);
+    EXPECT_EQ(0, err);
+    
+    // Payloads point into the input buffer:
+    char* pth[] = { (char*)"key2" };
+    ldoc_res_t* res = ldoc_find_anno(doc, pth, 1);
+    EXPECT_NE((ldoc_res_t*)NULL, res);
+    EXPECT_FALSE(res->nde);
+    EXPECT_EQ(LDOC_REP_RAW, res->info.ent->rep);
+    EXPECT_EQ(strstr(json, "Hello"), (char*)res->info.ent->pld.pair.dtm.raw.pld);
+    EXPECT_EQ(7, res->info.ent->pld.pair.dtm.raw.len);
+    ldoc_res_free(res);
+    
+    // Booleans have no string datum:
+    char* key4[] = { (char*)"key4" };
+    const char* bl = "{\"key4\":true}";
+    ldoc_doc_t* doc_bl = ldoc_json_read_view((char*)bl, strlen(bl), &err);
+    res = ldoc_find_anno(doc_bl, key4, 1);
+    ASSERT_NE((ldoc_res_t*)NULL, res);
+    EXPECT_EQ(LDOC_ENT_BR, res->info.ent->tpe);
+    size_t len = 1;
+    EXPECT_EQ(NULL, ldoc_ent_dtm_str(res->info.ent, &len));
+    EXPECT_EQ(0, len);
+    char num[LDOC_NUM_LEN];
+    len = 1;
+    EXPECT_EQ(NULL, ldoc_ent_dtm_fmt(res->info.ent, num, &len));
+    EXPECT_EQ(0, len);
+    ldoc_res_free(res);
+    ldoc_doc_free(doc_bl);
+    
+    ldoc_ser_t* ser = ldoc_format_json(doc);
+    EXPECT_NE((ldoc_ser_t*)NULL, ser);
+    EXPECT_STREQ(ldoc_json_small_ref, ser->pld.str);
+    
+    ldoc_ser_free(ser);
+    ldoc_doc_free(doc);
+    free(json);
+}
+
+TEST(ldoc_json, view_ldj)
+{
+    off_t err = 0;
+    off_t nxt = 0;
+    size_t len = strlen(ldoc_ldj);
+    std::string ldj;
+    
+    ldoc_doc_t* doc;
+    while ((doc = ldoc_ldjson_read_view((char*)ldoc_ldj, len, &err, &nxt)))
+    {
+        ldoc_ser_t* ser = ldoc_format_json(doc);
+        
+        if (!ldj.empty())
+            ldj += "\n";
+        ldj += ser->pld.str;
+        
+        ldoc_ser_free(ser);
+        ldoc_doc_free(doc);
+    }
+    
+    EXPECT_EQ(0, err);
+    EXPECT_STREQ(ldoc_ldj, ldj.c_str());
+}
+
+TEST(ldoc_json, unescape)
+{
+    const char* esc = "a\\\"b\\\\c\\/d\\n\\u00e9\\u20ac\\ud83d\\ude00";
+    size_t len;
+    
+    char* str = ldoc_json_unesc(esc, strlen(esc), &len);
+    EXPECT_STREQ("a\"b\\c/d\n\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80", str);
+    EXPECT_EQ(strlen(str), len);
+    free(str);
+    
+    // Only the first three characters, no escapes:
+    str = ldoc_json_unesc("plain", 3, &len);
+    EXPECT_STREQ("pla", str);
+    EXPECT_EQ(3, len);
+    free(str);
+}
+
+TEST(ldoc_json, scanning_kernels)
+{
+    // Long strings with escapes and whitespace runs at varying block offsets:
+    std::string json = "{";
+    for (int i = 0; i < 70; i++)
+    {
+        if (i)
+            json += ",\n" + std::string(i % 37, ' ') + "\t";
+        json += "\"key" + std::to_string(i) + "\" : \"" + std::string(i, 'x') + "\\\"" + std::string(i % 5, 'y') + "\\\\\\u00e9" + "\"";
+    }
+    json += "  }";
+    
+    std::string ref;
+    
+    ldoc_json_krnl_t krnls[] = { LDOC_JSON_KRNL_SCL, LDOC_JSON_KRNL_SSE2, LDOC_JSON_KRNL_AVX2, LDOC_JSON_KRNL_NEON };
+    for (ldoc_json_krnl_t krnl : krnls)
+    {
+        if (!ldoc_json_krnl(krnl))
+            continue;
+        
+        off_t err = 0;
+        ldoc_doc_t* doc = ldoc_json_read((char*)json.c_str(), json.size(), &err);
+        EXPECT_NE((ldoc_doc_t*)NULL, doc);
+        EXPECT_EQ(0, err);
+        EXPECT_EQ(70, doc->rt->ent_cnt);
+        
+        ldoc_ser_t* ser = ldoc_format_json(doc);
+        
+        if (ref.empty())
+            ref = ser->pld.str;
+        else
+            EXPECT_STREQ(ref.c_str(), ser->pld.str);
+        
+        ldoc_ser_free(ser);
+        ldoc_doc_free(doc);
+    }
+    
+    EXPECT_TRUE(ldoc_json_krnl(LDOC_JSON_KRNL_AUTO));
+    EXPECT_NE(std::string::npos, ref.find("\"key69\":\"" + std::string(69, 'x') + "\\\"yyyy\\\\\\u00e9\""));
+}
+
+static std::string ldoc_json_fmt(ldoc_json_prsr_t prsr, const std::string& json)
+{
+    ldoc_json_prsr(prsr);
+    
+    off_t err = 0;
+    ldoc_doc_t* doc = ldoc_json_read((char*)json.c_str(), json.size(), &err);
+    
+    ldoc_json_prsr(LDOC_JSON_PRSR_RD);
+    
+    if (!doc)
+        return "error at " + std::to_string(err);
+    
+    ldoc_ser_t* ser = ldoc_format_json(doc);
+    std::string str = ser->pld.str;
+    ldoc_ser_free(ser);
+    ldoc_doc_free(doc);
+    
+    return str;
+}
+
+TEST(ldoc_json, structural_index)
+{
+    // Backslash runs and strings that straddle 64-byte blocks:
+    std::string json = "{ \"a\" : [";
+    for (int i = 0; i < 40; i++)
+        json += std::string(i ? "," : "") + "{\"k" + std::to_string(i) + "\":\"" + std::string(2 * (i % 4), '\\') + std::string(i, 'x') + "\\\"\",\"n\":-" + std::to_string(i) + ".5e+3 , \"b\":[true,false , null,[]],\"o\":{}}";
+    json += "], \"z\" : 0 }";
+    
+    const char* vld[] = { ldoc_json_empty, ldoc_json_small, ldoc_json_empty_list, "{\"a\":1,}", json.c_str() };
+    for (const char* str : vld)
+    {
+        std::string rd = ldoc_json_fmt(LDOC_JSON_PRSR_RD, str);
+        EXPECT_EQ(std::string::npos, rd.find("error")) << str;
+        EXPECT_EQ(rd, ldoc_json_fmt(LDOC_JSON_PRSR_IDX, str));
+    }
+    
+    const char* inv[] = { "{", "{\"a\":[1}", "{\"a\":{]}", "{\"a\":\"x}", "{\"a\":1x}", "{\"a\":tru}", "{\"a\":[1,]}", "{\"a\" 1}", "{\"a\":1 \"b\":2}", "{\"a\\\":1}", "{\"a\":1]" };
+    for (const char* str : inv)
+    {
+        EXPECT_NE(std::string::npos, ldoc_json_fmt(LDOC_JSON_PRSR_RD, str).find("error")) << str;
+        EXPECT_NE(std::string::npos, ldoc_json_fmt(LDOC_JSON_PRSR_IDX, str).find("error")) << str;
+    }
+    
+    // Every kernel classifies blocks identically:
+    std::string ref = ldoc_json_fmt(LDOC_JSON_PRSR_RD, json);
+    ldoc_json_krnl_t krnls[] = { LDOC_JSON_KRNL_SCL, LDOC_JSON_KRNL_SSE2, LDOC_JSON_KRNL_AVX2, LDOC_JSON_KRNL_NEON };
+    for (ldoc_json_krnl_t krnl : krnls)
+    {
+        if (ldoc_json_krnl(krnl))
+            EXPECT_EQ(ref, ldoc_json_fmt(LDOC_JSON_PRSR_IDX, json));
+    }
+    ldoc_json_krnl(LDOC_JSON_KRNL_AUTO);
+    
+    // Parsing stops at the end of each object:
+    ldoc_json_prsr(LDOC_JSON_PRSR_IDX);
+    off_t err = 0;
+    off_t nxt = 0;
+    size_t len = strlen(ldoc_ldj);
+    std::string ldj;
+    ldoc_doc_t* doc;
+    while ((doc = ldoc_ldjson_read((char*)ldoc_ldj, len, &err, &nxt)))
+    {
+        ldoc_ser_t* ser = ldoc_format_json(doc);
+        ldj += (ldj.empty() ? "" : "\n") + std::string(ser->pld.str);
+        ldoc_ser_free(ser);
+        ldoc_doc_free(doc);
+    }
+    ldoc_json_prsr(LDOC_JSON_PRSR_RD);
+    EXPECT_EQ(0, err);
+    EXPECT_STREQ(ldoc_ldj, ldj.c_str());
+}
+
+TEST(ldoc_json, ldj_batch)
+{
+    std::string ldj;
+    for (int i = 0; i < 1000; i++)
+        ldj += "{\"id\":" + std::to_string(i) + ",\"val\":[" + std::string(i % 3 ? "true" : "\"x\"") + "]}\n" + (i % 10 ? "" : "\n");
+    
+    off_t err = 0;
+    size_t cnt = 0;
+    ldoc_doc_t** docs = ldoc_ldjson_read_batch((char*)ldj.c_str(), ldj.size(), 4, &cnt, &err);
+    EXPECT_NE((ldoc_doc_t**)NULL, docs);
+    EXPECT_EQ(0, err);
+    EXPECT_EQ(1000, cnt);
+    
+    // Input order is retained:
+    for (size_t i = 0; i < cnt; i++)
+    {
+        ldoc_ser_t* ser = ldoc_format_json(docs[i]);
+        EXPECT_EQ("{\"id\":" + std::to_string(i) + ",\"val\":[" + std::string(i % 3 ? "true" : "\"x\"") + "]}", ser->pld.str);
+        ldoc_ser_free(ser);
+    }
+    
+    ldoc_ldjson_batch_free(docs, cnt);
+    
+    // The first error is reported:
+    size_t off = ldj.find("{\"id\":500,");
+    ldj[off + 1] = 'x';
+    docs = ldoc_ldjson_read_batch((char*)ldj.c_str(), ldj.size(), 0, &cnt, &err);
+    EXPECT_EQ((ldoc_doc_t**)NULL, docs);
+    EXPECT_EQ(0, cnt);
+    EXPECT_EQ(off + 1, err);
+}
+
+TEST(ldoc_json, files)
+{
+    char pth[] = "/tmp/ldoc_json_XXXXXX";
+    int fd = mkstemp(pth);
+    ASSERT_LE(0, fd);
+    
+    std::string ldj = std::string(ldoc_ldj) + "\n\n";
+    EXPECT_EQ(ldj.size(), write(fd, ldj.c_str(), ldj.size()));
+    close(fd);
+    
+    off_t err = 0;
+    
+    ldoc_ldjson_file_t* file = ldoc_ldjson_file_open(pth);
+    ASSERT_NE((ldoc_ldjson_file_t*)NULL, file);
+    
+    std::string out;
+    ldoc_doc_t* doc;
+    while ((doc = ldoc_ldjson_file_read(file, &err)))
+    {
+        ldoc_ser_t* ser = ldoc_format_json(doc);
+        out += (out.empty() ? "" : "\n") + std::string(ser->pld.str);
+        ldoc_ser_free(ser);
+        ldoc_doc_free(doc);
+    }
+    EXPECT_TRUE(ldoc_ldjson_file_eof(file));
+    EXPECT_EQ(0, err);
+    EXPECT_STREQ(ldoc_ldj, out.c_str());
+    ldoc_ldjson_file_close(file);
+    
+    // Single object:
+    FILE* f = fopen(pth, "w");
+    fputs(ldoc_json_small, f);
+    fclose(f);
+    
+    doc = ldoc_json_read_file(pth, &err);
+    ASSERT_NE((ldoc_doc_t*)NULL, doc);
+    ldoc_ser_t* ser = ldoc_format_json(doc);
+    EXPECT_STREQ(ldoc_json_small_ref, ser->pld.str);
+    ldoc_ser_free(ser);
+    ldoc_doc_free(doc);
+    
+    // A malformed record in the middle does not stop reading:
+    f = fopen(pth, "w");
+    fputs("{\"a\":1}\n{\"b\":}\n{\"c\":3}\n", f);
+    fclose(f);
+    
+    file = ldoc_ldjson_file_open(pth);
+    ASSERT_NE((ldoc_ldjson_file_t*)NULL, file);
+    
+    out.clear();
+    int fails = 0;
+    int reads = 0;
+    while (!ldoc_ldjson_file_eof(file) && reads++ < 10)
+    {
+        err = 0;
+        doc = ldoc_ldjson_file_read(file, &err);
+        
+        if (!doc)
+        {
+            EXPECT_EQ(13, err);
+            fails++;
+            
+            continue;
+        }
+        
+        ser = ldoc_format_json(doc);
+        out += (out.empty() ? "" : "\n") + std::string(ser->pld.str);
+        ldoc_ser_free(ser);
+        ldoc_doc_free(doc);
+    }
+    EXPECT_TRUE(ldoc_ldjson_file_eof(file));
+    EXPECT_EQ(1, fails);
+    EXPECT_EQ(3, reads);
+    EXPECT_STREQ("{\"a\":1}\n{\"c\":3}", out.c_str());
+    ldoc_ldjson_file_close(file);
+    
+    unlink(pth);
+    EXPECT_EQ((ldoc_ldjson_file_t*)NULL, ldoc_ldjson_file_open(pth));
+}
+
+TEST(ldoc_json, ldj_push)
+{
+    std::string ldj = std::string(ldoc_ldj) + "\n{\"esc\":\"\\\"}\\\\\",\"bad\":[}\nnot json\n{\"key4\":\"}\"}\n{\"cut\":";
+    
+    // Byte by byte and in larger chunks:
+    for (size_t sz : { 1, 7, 1024 })
+    {
+        ldoc_ldjson_psh_t* psh = ldoc_ldjson_psh_new();
+        ASSERT_NE((ldoc_ldjson_psh_t*)NULL, psh);
+        
+        std::string out;
+        std::vector<off_t> errs;
+        for (size_t off = 0; off < ldj.size(); off += sz)
+        {
+            EXPECT_TRUE(ldoc_ldjson_psh_feed(psh, ldj.c_str() + off, std::min(sz, ldj.size() - off)));
+            
+            ldoc_doc_t* doc;
+            off_t err = 0;
+            ldoc_json_prs_err_t prs;
+            while ((prs = ldoc_ldjson_psh_read(psh, &doc, &err)) != LDOC_JSON_MORE)
+            {
+                if (prs == LDOC_JSON_INV)
+                {
+                    errs.push_back(err);
+                    continue;
+                }
+                
+                ldoc_ser_t* ser = ldoc_format_json(doc);
+                out += (out.empty() ? "" : "\n") + std::string(ser->pld.str);
+                ldoc_ser_free(ser);
+                ldoc_doc_free(doc);
+            }
+        }
+        
+        EXPECT_EQ(std::string(ldoc_ldj) + "\n{\"key4\":\"}\"}", out);
+        ASSERT_EQ(2, errs.size());
+        EXPECT_EQ(ldj.find("}\nnot"), errs[0]);
+        EXPECT_EQ(ldj.find("not json"), errs[1]);
+        EXPECT_EQ(7, ldoc_ldjson_psh_pndg(psh));
+        
+        ldoc_ldjson_psh_free(psh);
+    }
+}
+
+static bool ldoc_json_sax_obj(void* usr)
+{
+    *(std::string*)usr += "{";
+    return true;
+}
+
+static bool ldoc_json_sax_arr(void* usr)
+{
+    *(std::string*)usr += "[";
+    return true;
+}
+
+static bool ldoc_json_sax_end(void* usr)
+{
+    *(std::string*)usr += "}";
+    return true;
+}
+
+static bool ldoc_json_sax_ky(void* usr, const char* str, size_t len)
+{
+    *(std::string*)usr += std::string(str, len) + ":";
+    return true;
+}
+
+static bool ldoc_json_sax_str(void* usr, const char* str, size_t len)
+{
+    *(std::string*)usr += "'" + std::string(str, len) + "' ";
+    return true;
+}
+
+static bool ldoc_json_sax_num(void* usr, const char* str, size_t len)
+{
+    *(std::string*)usr += std::string(str, len) + " ";
+    // Stop at a magic number:
+    return std::string(str, len) != "42";
+}
+
+TEST(ldoc_json, sax)
+{
+    // Booleans and nulls are not of interest:
+    ldoc_json_sax_t sax = { ldoc_json_sax_obj, ldoc_json_sax_end, ldoc_json_sax_arr, ldoc_json_sax_end, ldoc_json_sax_ky, ldoc_json_sax_str, ldoc_json_sax_num, NULL, NULL };
+    
+    ldoc_json_prsr_t prsrs[] = { LDOC_JSON_PRSR_RD, LDOC_JSON_PRSR_IDX };
+    for (ldoc_json_prsr_t prsr : prsrs)
+    {
+        ldoc_json_prsr(prsr);
+        
+        std::string evts;
+        off_t err = 0;
+        EXPECT_EQ(LDOC_JSON_OK, ldoc_json_read_sax(&sax, &evts, (char*)ldoc_json_small, strlen(ldoc_json_small), &err, NULL));
+        EXPECT_EQ("{key1:123 key2:'Hello\\n' key3:['val3.1' 3.141 [[{nested:}}}}}", evts);
+        
+        const char* json = "{\"a\":[1,42,3],\"b\":2}";
+        evts.clear();
+        EXPECT_EQ(LDOC_JSON_STOP, ldoc_json_read_sax(&sax, &evts, (char*)json, strlen(json), &err, NULL));
+        EXPECT_EQ("{a:[1 42 ", evts);
+        EXPECT_EQ(strchr(json, '4') + 2 - json, err);
+        
+        evts.clear();
+        EXPECT_EQ(LDOC_JSON_INV, ldoc_json_read_sax(&sax, &evts, (char*)"{\"a\":nul}", 9, &err, NULL));
+    }
+    
+    ldoc_json_prsr(LDOC_JSON_PRSR_RD);
+}
+
+TEST(ldoc_json, paths)
+{
+    const char* json = "{ \"id\" : 7, \"skip\" : { \"a\" : [ \"]}\\\"\", { } ] }, \"address\" : { \"name\" : \"x\", \"zip\" : [1, 2] }, \"list\" : [ 1, { \"id\" : true }, [ null ] ], \"n\" : -1.5e3 }";
+    
+    char* id[] = { (char*)"id" };
+    char* name[] = { (char*)"address", (char*)"name" };
+    char* nested[] = { (char*)"list", (char*)"NA", (char*)"id" };
+    char* none[] = { (char*)"skip", (char*)"b" };
+    char** pths[] = { id, name, nested, none };
+    size_t plens[] = { 1, 2, 3, 2 };
+    
+    off_t err = 0;
+    ldoc_doc_t* doc = ldoc_json_read_pths((char*)json, strlen(json), pths, plens, 4, &err);
+    ASSERT_NE((ldoc_doc_t*)NULL, doc);
+    EXPECT_EQ(0, err);
+    
+    ldoc_ser_t* ser = ldoc_format_json(doc);
+    // Nested arrays match "NA" as well:
+    EXPECT_STREQ("{\"id\":7,\"skip\":{},\"address\":{\"name\":\"x\"},\"list\":[{\"id\":true},[]]}", ser->pld.str);
+    ldoc_ser_free(ser);
+    
+    // Same results as for the full document:
+    for (size_t i = 0; i < 3; i++)
+    {
+        ldoc_res_t* res = ldoc_find_anno(doc, pths[i], plens[i]);
+        EXPECT_NE((ldoc_res_t*)NULL, res);
+        ldoc_res_free(res);
+    }
+    ldoc_doc_free(doc);
+    
+    // Skipped values still need to be terminated:
+    const char* inv = "{ \"skip\" : [ \"abc ], \"id\" : 1 }";
+    EXPECT_EQ((ldoc_doc_t*)NULL, ldoc_json_read_pths((char*)inv, strlen(inv), pths, plens, 1, &err));
+    
+    off_t nxt = 0;
+    size_t len = strlen(ldoc_ldj);
+    std::string ldj;
+    char* ky3[] = { (char*)"key3" };
+    char** ldj_pths[] = { ky3 };
+    size_t ldj_plens[] = { 1 };
+    while ((doc = ldoc_ldjson_read_pths((char*)ldoc_ldj, len, ldj_pths, ldj_plens, 1, &err, &nxt)))
+    {
+        ser = ldoc_format_json(doc);
+        ldj += ser->pld.str;
+        ldoc_ser_free(ser);
+        ldoc_doc_free(doc);
+    }
+    EXPECT_EQ("{}{}{\"key3\":[1,2,3]}", ldj);
+}
+
+TEST(ldoc_json, numbers)
+{
+    const char* json = "{ \"i\" : -42, \"max\" : 9223372036854775807, \"big\" : 18446744073709551616, \"f\" : 1.5e3, \"pi\" : 3.141, \"neg0\" : -0, \"tiny\" : 1e-30, \"lst\" : [ 0.1, 7 ] }";
+    
+    off_t err = 0;
+    ldoc_doc_t* doc = ldoc_json_read((char*)json, strlen(json), &err);
+    ASSERT_NE((ldoc_doc_t*)NULL, doc);
+    EXPECT_EQ(0, err);
+    
+    char* i[] = { (char*)"i" };
+    ldoc_res_t* res = ldoc_find_anno(doc, i, 1);
+    ASSERT_NE((ldoc_res_t*)NULL, res);
+    EXPECT_EQ(LDOC_REP_I64, res->info.ent->rep);
+    EXPECT_EQ(-42, res->info.ent->pld.pair.dtm.i64);
+    ldoc_res_free(res);
+    
+    char* max[] = { (char*)"max" };
+    res = ldoc_find_anno(doc, max, 1);
+    ASSERT_NE((ldoc_res_t*)NULL, res);
+    EXPECT_EQ(INT64_MAX, res->info.ent->pld.pair.dtm.i64);
+    ldoc_res_free(res);
+    
+    // Integers beyond 64 bits remain strings:
+    char* big[] = { (char*)"big" };
+    res = ldoc_find_anno(doc, big, 1);
+    ASSERT_NE((ldoc_res_t*)NULL, res);
+    EXPECT_EQ(LDOC_REP_STR, res->info.ent->rep);
+    ldoc_res_free(res);
+    
+    char* f[] = { (char*)"f" };
+    res = ldoc_find_anno(doc, f, 1);
+    ASSERT_NE((ldoc_res_t*)NULL, res);
+    EXPECT_EQ(LDOC_REP_F64, res->info.ent->rep);
+    EXPECT_EQ(1500.0, res->info.ent->pld.pair.dtm.f64);
+    size_t len;
+    EXPECT_EQ(NULL, ldoc_ent_dtm_str(res->info.ent, &len));
+    char buf[LDOC_NUM_LEN];
+    EXPECT_STREQ("1500", ldoc_ent_dtm_fmt(res->info.ent, buf, &len));
+    EXPECT_EQ(4, len);
+    ldoc_res_free(res);
+    
+    // Slow path:
+    char* tiny[] = { (char*)"tiny" };
+    res = ldoc_find_anno(doc, tiny, 1);
+    ASSERT_NE((ldoc_res_t*)NULL, res);
+    EXPECT_EQ(1e-30, res->info.ent->pld.pair.dtm.f64);
+    ldoc_res_free(res);
+    
+    // Slow path for literals of any length:
+    std::string lng = "{\"lng\":0." + std::string(80, '0') + "15}";
+    ldoc_doc_t* doc_lng = ldoc_json_read((char*)lng.c_str(), lng.size(), &err);
+    ASSERT_NE((ldoc_doc_t*)NULL, doc_lng);
+    char* lng_pth[] = { (char*)"lng" };
+    res = ldoc_find_anno(doc_lng, lng_pth, 1);
+    ASSERT_NE((ldoc_res_t*)NULL, res);
+    EXPECT_EQ(LDOC_REP_F64, res->info.ent->rep);
+    EXPECT_EQ(1.5e-81, res->info.ent->pld.pair.dtm.f64);
+    ldoc_res_free(res);
+    ldoc_doc_free(doc_lng);
+    
+    ldoc_ser_t* ser = ldoc_format_json(doc);
+    EXPECT_STREQ("{\"i\":-42,\"max\":9223372036854775807,\"big\":18446744073709551616,\"f\":1500,\"pi\":3.141,\"neg0\":-0,\"tiny\":1e-30,\"lst\":[0.1,7]}", ser->pld.str);
+    ldoc_ser_free(ser);
+    ldoc_doc_free(doc);
+    
+    // Views keep their raw flag:
+    doc = ldoc_json_read_view((char*)json, strlen(json), &err);
+    ASSERT_NE((ldoc_doc_t*)NULL, doc);
+    res = ldoc_find_anno(doc, i, 1);
+    ASSERT_NE((ldoc_res_t*)NULL, res);
+    EXPECT_EQ(LDOC_REP_RAW | LDOC_REP_I64, res->info.ent->rep);
+    ldoc_res_free(res);
+    ldoc_doc_free(doc);
+}
+
+TEST(ldoc_json, binary)
+{
+    char pth[] = "/tmp/ldoc_bin_XXXXXX";
+    int fd = mkstemp(pth);
+    ASSERT_LE(0, fd);
+    close(fd);
+    
+    // Raw strings and typed numbers:
+    off_t err = 0;
+    const char* json = "{ \"key1\" : 123, \"f\" : -1.25, \"key2\" : \"Hello\\n\", \"key3\" : [ \"val3.1\", 3.141, null, true, false, [[ { \"nested\" : true } ]] ], \"\" : \"\" }";
+    // Entities are formatted before nodes:
+    const char* ref = "{\"key1\":123,\"f\":-1.25,\"key2\":\"Hello\\n\",\"\":\"\",\"key3\":[\"val3.1\",3.141,null,true,false,[[{\"nested\":true}]]]}";
+    ldoc_doc_t* doc = ldoc_json_read_view((char*)json, strlen(json), &err);
+    ASSERT_NE((ldoc_doc_t*)NULL, doc);
+    EXPECT_TRUE(ldoc_doc_save(doc, pth));
+    ldoc_doc_free(doc);
+    
+    doc = ldoc_doc_load_mmap(pth);
+    ASSERT_NE((ldoc_doc_t*)NULL, doc);
+    ldoc_ser_t* ser = ldoc_format_json(doc);
+    EXPECT_STREQ(ref, ser->pld.str);
+    ldoc_ser_free(ser);
+    
+    char* pth1[] = { (char*)"key1" };
+    ldoc_res_t* res = ldoc_find_anno(doc, pth1, 1);
+    ASSERT_NE((ldoc_res_t*)NULL, res);
+    EXPECT_EQ(LDOC_REP_I64, res->info.ent->rep);
+    EXPECT_EQ(123, res->info.ent->pld.pair.dtm.i64);
+    ldoc_res_free(res);
+    
+    // Saving a loaded document yields the same file:
+    char cpy[] = "/tmp/ldoc_bin_XXXXXX";
+    fd = mkstemp(cpy);
+    ASSERT_LE(0, fd);
+    close(fd);
+    EXPECT_TRUE(ldoc_doc_save(doc, cpy));
+    ldoc_doc_free(doc);
+    
+    std::vector<char> a, b;
+    for (auto p : { std::make_pair(pth, &a), std::make_pair(cpy, &b) })
+    {
+        FILE* f = fopen(p.first, "rb");
+        int c;
+        while ((c = fgetc(f)) != EOF)
+            p.second->push_back(c);
+        fclose(f);
+    }
+    EXPECT_EQ(a, b);
+    unlink(cpy);
+    
+    // Unknown types and representations are rejected; the second node and the
+    // first entity follow the header (40 bytes) and the node records (32 bytes each):
+    uint64_t nde_cnt;
+    memcpy(&nde_cnt, &a[16], sizeof(uint64_t));
+    for (size_t off : { (size_t)72, (size_t)76, (size_t)(40 + nde_cnt * 32), (size_t)(44 + nde_cnt * 32) })
+    {
+        std::vector<char> bad = a;
+        bad[off] = 0x7f;
+        
+        FILE* f = fopen(cpy, "wb");
+        fwrite(bad.data(), 1, bad.size(), f);
+        fclose(f);
+        
+        EXPECT_EQ((ldoc_doc_t*)NULL, ldoc_doc_load_mmap(cpy));
+    }
+    unlink(cpy);
+    
+    // Truncated files are rejected:
+    EXPECT_EQ(0, truncate(pth, a.size() - 1));
+    EXPECT_EQ((ldoc_doc_t*)NULL, ldoc_doc_load_mmap(pth));
+    
+    unlink(pth);
+    EXPECT_EQ((ldoc_doc_t*)NULL, ldoc_doc_load_mmap(pth));
+}
+
+TEST(ldoc_json, frozen)
+{
+    off_t err = 0;
+    const char* json = "{ \"a\" : { \"b\" : [ 1, { \"c\" : null } ], \"d\" : 2.5 }, \"a\" : { \"e\" : false }, \"s\" : \"x\" }";
+    
+    ldoc_doc_t* doc = ldoc_json_read((char*)json, strlen(json), &err);
+    ASSERT_NE((ldoc_doc_t*)NULL, doc);
+    ldoc_ser_t* ref = ldoc_format_json(doc);
+    
+    ldoc_frz_t* frz = ldoc_frz_new(doc);
+    ASSERT_NE((ldoc_frz_t*)NULL, frz);
+    ldoc_doc_free(doc);
+    
+    EXPECT_EQ(5, frz->nde_cnt);
+    EXPECT_EQ(5, frz->ent_cnt);
+    
+    ldoc_ser_t* ser = ldoc_frz_format_json(frz);
+    ASSERT_NE((ldoc_ser_t*)NULL, ser);
+    EXPECT_STREQ(ref->pld.str, ser->pld.str);
+    ldoc_ser_free(ser);
+    ldoc_ser_free(ref);
+    
+    // Nodes and entities; the second node "a" is found by backtracking:
+    bool nde;
+    char* a[] = { (char*)"a" };
+    EXPECT_EQ(1, ldoc_frz_find_anno(frz, a, 1, &nde));
+    EXPECT_TRUE(nde);
+    
+    char* e[] = { (char*)"a", (char*)"e" };
+    uint32_t idx = ldoc_frz_find_anno(frz, e, 2, &nde);
+    ASSERT_NE(LDOC_FRZ_NULL, idx);
+    EXPECT_FALSE(nde);
+    EXPECT_EQ(LDOC_ENT_BR, frz->ent_tpe[idx]);
+    EXPECT_FALSE(frz->ent_dtm[idx].bl);
+    
+    char* c[] = { (char*)"a", (char*)"b", (char*)"NA", (char*)"c" };
+    idx = ldoc_frz_find_anno(frz, c, 4, &nde);
+    ASSERT_NE(LDOC_FRZ_NULL, idx);
+    EXPECT_EQ(NULL, frz->ent_dtm[idx].raw.pld);
+    
+    char* s[] = { (char*)"s" };
+    idx = ldoc_frz_find_anno(frz, s, 1, &nde);
+    ASSERT_NE(LDOC_FRZ_NULL, idx);
+    EXPECT_STREQ("x", (char*)frz->ent_dtm[idx].raw.pld);
+    
+    char* none[] = { (char*)"a", (char*)"x" };
+    EXPECT_EQ(LDOC_FRZ_NULL, ldoc_frz_find_anno(frz, none, 2, &nde));
+    
+    ldoc_frz_free(frz);
+}
+
+TEST(ldoc_json, interning)
+{
+    const char* ldj = "{\"id\":1,\"tags\":[{\"id\":2}]}\n{\"id\":3,\"name\":\"x\"}";
+    size_t len = strlen(ldj);
+    off_t err = 0;
+    off_t nxt = 0;
+    
+    ldoc_intn_t* intn = ldoc_intn_new();
+    ASSERT_NE((ldoc_intn_t*)NULL, intn);
+    
+    ldoc_doc_t* doc1 = ldoc_ldjson_read_intn((char*)ldj, len, intn, &err, &nxt);
+    ldoc_doc_t* doc2 = ldoc_ldjson_read_intn((char*)ldj, len, intn, &err, &nxt);
+    ASSERT_NE((ldoc_doc_t*)NULL, doc1);
+    ASSERT_NE((ldoc_doc_t*)NULL, doc2);
+    EXPECT_EQ((ldoc_doc_t*)NULL, ldoc_ldjson_read_intn((char*)ldj, len, intn, &err, &nxt));
+    EXPECT_EQ(0, err);
+    
+    // "id", "tags", "NA" and "name":
+    EXPECT_EQ(4, ldoc_intn_cnt(intn));
+    
+    // Keys are shared between documents:
+    char* id[] = { (char*)"id" };
+    ldoc_res_t* res1 = ldoc_find_anno(doc1, id, 1);
+    ldoc_res_t* res2 = ldoc_find_anno(doc2, id, 1);
+    ASSERT_NE((ldoc_res_t*)NULL, res1);
+    ASSERT_NE((ldoc_res_t*)NULL, res2);
+    EXPECT_EQ(res1->info.ent->pld.pair.anno.str, res2->info.ent->pld.pair.anno.str);
+    EXPECT_EQ(ldoc_intn_get(intn, "id", 2), res1->info.ent->pld.pair.anno.str);
+    EXPECT_EQ(1, res1->info.ent->pld.pair.dtm.i64);
+    ldoc_res_free(res1);
+    ldoc_res_free(res2);
+    
+    char* nested[] = { (char*)"tags", (char*)"NA", (char*)"id" };
+    res1 = ldoc_find_anno(doc1, nested, 3);
+    ASSERT_NE((ldoc_res_t*)NULL, res1);
+    EXPECT_EQ(2, res1->info.ent->pld.pair.dtm.i64);
+    ldoc_res_free(res1);
+    
+    // Keys that were never interned cannot be found:
+    char* none[] = { (char*)"none" };
+    EXPECT_EQ((ldoc_res_t*)NULL, ldoc_find_anno(doc1, none, 1));
+    EXPECT_EQ((char*)NULL, ldoc_intn_get(intn, "none", 4));
+    char* name[] = { (char*)"name" };
+    EXPECT_EQ((ldoc_res_t*)NULL, ldoc_find_anno(doc1, name, 1));
+    
+    ldoc_ser_t* ser = ldoc_format_json(doc2);
+    EXPECT_STREQ("{\"id\":3,\"name\":\"x\"}", ser->pld.str);
+    ldoc_ser_free(ser);
+    
+    ldoc_doc_free(doc1);
+    ldoc_doc_free(doc2);
+    
+    // Growth beyond the initial table:
+    char key[16];
+    for (size_t i = 0; i < 1000; i++)
+    {
+        snprintf(key, sizeof(key), "key%zu", i);
+        EXPECT_STREQ(key, ldoc_intn_str(intn, key, strlen(key)));
+    }
+    EXPECT_EQ(1004, ldoc_intn_cnt(intn));
+    EXPECT_STREQ("key500", ldoc_intn_get(intn, "key500", 6));
+    
+    ldoc_intn_free(intn);
+}
+
+TEST(ldoc_json, queries)
+{
+    const char* js1 = "{\"a\":{\"b\":1,\"c\":{\"d\":2}},\"e\":3}";
+    const char* js2 = "{\"a\":{\"c\":{\"d\":4}}}";
+    off_t err = 0;
+    
+    char* pth[] = { (char*)"a", (char*)"c", (char*)"d" };
+    ldoc_qry_t* qry = ldoc_qry_new(pth, 3);
+    ASSERT_NE((ldoc_qry_t*)NULL, qry);
+    
+    // Same results as `ldoc_find_anno` across documents:
+    ldoc_doc_t* doc1 = ldoc_json_read((char*)js1, strlen(js1), &err);
+    ldoc_doc_t* doc2 = ldoc_json_read((char*)js2, strlen(js2), &err);
+    ldoc_res_t* res = ldoc_qry_exec(qry, doc1);
+    ASSERT_NE((ldoc_res_t*)NULL, res);
+    EXPECT_EQ(2, res->info.ent->pld.pair.dtm.i64);
+    ldoc_res_free(res);
+    res = ldoc_qry_exec(qry, doc2);
+    ASSERT_NE((ldoc_res_t*)NULL, res);
+    EXPECT_EQ(4, res->info.ent->pld.pair.dtm.i64);
+    ldoc_res_free(res);
+    ldoc_doc_free(doc1);
+    ldoc_doc_free(doc2);
+    
+    // Interned documents, where "d" is not interned before the second one:
+    const char* ldj = "{\"a\":{\"c\":1}}\n{\"a\":{\"c\":{\"d\":5}}}";
+    off_t nxt = 0;
+    ldoc_intn_t* intn = ldoc_intn_new();
+    doc1 = ldoc_ldjson_read_intn((char*)ldj, strlen(ldj), intn, &err, &nxt);
+    ASSERT_NE((ldoc_doc_t*)NULL, doc1);
+    EXPECT_EQ((ldoc_res_t*)NULL, ldoc_qry_exec(qry, doc1));
+    doc2 = ldoc_ldjson_read_intn((char*)ldj, strlen(ldj), intn, &err, &nxt);
+    ASSERT_NE((ldoc_doc_t*)NULL, doc2);
+    res = ldoc_qry_exec(qry, doc2);
+    ASSERT_NE((ldoc_res_t*)NULL, res);
+    EXPECT_EQ(5, res->info.ent->pld.pair.dtm.i64);
+    ldoc_res_free(res);
+    EXPECT_EQ((ldoc_res_t*)NULL, ldoc_qry_exec(qry, doc1));
+    ldoc_doc_free(doc1);
+    ldoc_doc_free(doc2);
+    ldoc_intn_free(intn);
+    
+    ldoc_qry_free(qry);
+}
+
+static std::string glob_dtm(ldoc_ent_t* ent)
+{
+    size_t len;
+    const char* str = ldoc_ent_dtm_str(ent, &len);
+    
+    return std::string(str, len);
+}
+
+TEST(ldoc_json, glob_queries)
+{
+    const char* js = "{\"tags\":[{\"name\":\"a\"},{\"name\":\"b\",\"x\":{\"name\":\"c\"}}],\"name\":\"d\"}";
+    off_t err = 0;
+    ldoc_doc_t* doc = ldoc_json_read((char*)js, strlen(js), &err);
+    ASSERT_NE((ldoc_doc_t*)NULL, doc);
+    
+    ldoc_qry_itr_t itr;
+    ldoc_res_t* res;
+    ldoc_res_t buf[8];
+    std::string vals;
+    
+    // All matches of a plain path:
+    char* plain[] = { (char*)"tags", (char*)"NA", (char*)"name" };
+    ldoc_qry_t* qry = ldoc_qry_new(plain, 3);
+    ldoc_qry_itr_init(&itr, qry, doc);
+    while ((res = ldoc_qry_itr_nxt(&itr)))
+        vals += glob_dtm(res->info.ent);
+    EXPECT_FALSE(itr.fail);
+    ldoc_qry_itr_fin(&itr);
+    EXPECT_EQ("ab", vals);
+    ldoc_qry_free(qry);
+    
+    char* any[] = { (char*)"tags", (char*)"*", (char*)"name" };
+    qry = ldoc_qry_glob(any, 3);
+    EXPECT_EQ(2, ldoc_qry_all(qry, doc, buf, 8));
+    ldoc_qry_free(qry);
+    
+    // Any depth, in document order:
+    char* dsc[] = { (char*)"**", (char*)"name" };
+    qry = ldoc_qry_glob(dsc, 2);
+    EXPECT_EQ(4, ldoc_qry_all(qry, doc, buf, 2));
+    EXPECT_EQ("d", glob_dtm(buf[0].info.ent));
+    EXPECT_EQ("a", glob_dtm(buf[1].info.ent));
+    EXPECT_EQ(4, ldoc_qry_all(qry, doc, buf, 8));
+    EXPECT_EQ("c", glob_dtm(buf[3].info.ent));
+    res = ldoc_qry_exec(qry, doc);
+    ASSERT_NE((ldoc_res_t*)NULL, res);
+    EXPECT_EQ("d", glob_dtm(res->info.ent));
+    ldoc_res_free(res);
+    ldoc_qry_free(qry);
+    
+    char* all[] = { (char*)"tags", (char*)"**" };
+    qry = ldoc_qry_glob(all, 2);
+    EXPECT_EQ(6, ldoc_qry_all(qry, doc, buf, 8));
+    EXPECT_TRUE(buf[0].nde);
+    EXPECT_FALSE(buf[1].nde);
+    ldoc_qry_free(qry);
+    
+    char* nodes[] = { (char*)"tags", (char*)"*" };
+    qry = ldoc_qry_glob(nodes, 2);
+    EXPECT_EQ(2, ldoc_qry_all(qry, doc, buf, 8));
+    ldoc_qry_free(qry);
+    
+    ldoc_doc_free(doc);
+    
+    // Deeper than the iterator's preallocated frames:
+    std::string deep;
+    for (size_t i = 0; i < 40; i++)
+        deep += "{\"a\":";
+    deep += "{\"name\":1}";
+    for (size_t i = 0; i < 40; i++)
+        deep += "}";
+    doc = ldoc_json_read((char*)deep.c_str(), deep.size(), &err);
+    ASSERT_NE((ldoc_doc_t*)NULL, doc);
+    qry = ldoc_qry_glob(dsc, 2);
+    EXPECT_EQ(1, ldoc_qry_all(qry, doc, buf, 8));
+    EXPECT_EQ(1, buf[0].info.ent->pld.pair.dtm.i64);
+    ldoc_qry_free(qry);
+    ldoc_doc_free(doc);
+}
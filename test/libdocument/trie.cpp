@@ -16,6 +16,9 @@
 
 #include <gtest/gtest.h>
 
+#include <unistd.h>
+#include <string>
+
 #include "trie.h"
 
 #define LDOC_NULLTYPE long
@@ -195,3 +198,353 @@ TEST(ldoc_trie, collect)
     ldoc_trie_free(trie);
 }
 
+TEST(ldoc_trie, layouts)
+{
+    ldoc_trie_nde_t* res;
+    ldoc_trie_t* trie = ldoc_trie_new();
+    
+    EXPECT_NE(NULL, (LDOC_NULLTYPE)trie);
+    
+    // Add "xA", "xB", ... so that both the root and "x" outgrow all layouts:
+    char str[3] = { 0, 0, 0 };
+    uint16_t n = 0;
+    for (int chr = 1; chr < 256; chr++)
+    {
+        if (chr == LDOC_TRIE_RES_CHR)
+            continue;
+        
+        ldoc_trie_anno_t anno = { (uint16_t)chr, NULL };
+        
+        str[0] = (char)chr;
+        str[1] = 0;
+        ldoc_trie_add(trie, str, ASCII, anno);
+        
+        str[0] = 'x';
+        str[1] = (char)chr;
+        ldoc_trie_add(trie, str, ASCII, anno);
+        
+        // "x" has exactly `n` descendants:
+        res = ldoc_trie_lookup(trie, "x", true);
+        n++;
+        
+        if (n == 4)
+            EXPECT_EQ(LYT_N4, res->lyt);
+        else if (n == 16)
+            EXPECT_EQ(LYT_N16, res->lyt);
+        else if (n == 48)
+            EXPECT_EQ(LYT_N48, res->lyt);
+        else if (n == 49)
+            EXPECT_EQ(LYT_N256, res->lyt);
+        
+        // Everything added so far is still there:
+        int lkp = 1;
+        for (; lkp <= chr; lkp++)
+        {
+            if (lkp == LDOC_TRIE_RES_CHR)
+                continue;
+            
+            str[0] = 'x';
+            str[1] = (char)lkp;
+            res = ldoc_trie_lookup(trie, str, false);
+            ASSERT_NE(NULL, (LDOC_NULLTYPE)res);
+            EXPECT_EQ(lkp, res->anno.cat);
+        }
+    }
+    
+    EXPECT_EQ(LYT_N256, trie->root->lyt);
+    
+    res = ldoc_trie_lookup(trie, "xx", false);
+    EXPECT_NE(NULL, (LDOC_NULLTYPE)res);
+    
+    res = ldoc_trie_lookup(trie, "yy", false);
+    EXPECT_EQ(NULL, (LDOC_NULLTYPE)res);
+    
+    ldoc_trie_free(trie);
+}
+
+TEST(ldoc_trie, slab)
+{
+    // Nodes "a" to "h" each grow through all layouts, while "ab", "ac", ...
+    // are created in between and take up the arrays the others outgrew:
+    ldoc_trie_t* tries[2] = { ldoc_trie_new(), ldoc_trie_new_rdx() };
+    
+    int t = 0;
+    for (; t < 2; t++)
+    {
+        ldoc_trie_t* trie = tries[t];
+        
+        ASSERT_NE(NULL, (LDOC_NULLTYPE)trie);
+        
+        std::string exp;
+        char str[4] = { 0, 0, 'z', 0 };
+        int chr = 1;
+        for (; chr < 256; chr++)
+        {
+            if (chr == LDOC_TRIE_RES_CHR)
+                continue;
+            
+            char pfx = 'a';
+            for (; pfx <= 'h'; pfx++)
+            {
+                ldoc_trie_anno_t anno = { (uint16_t)(pfx * 256 + chr), NULL };
+                
+                str[0] = pfx;
+                str[1] = (char)chr;
+                EXPECT_TRUE(ldoc_trie_add(trie, str, ASCII, anno));
+            }
+        }
+        
+        // Everything is still there:
+        char pfx = 'a';
+        for (; pfx <= 'h'; pfx++)
+        {
+            ldoc_trie_nde_t* res = ldoc_trie_lookup(trie, std::string(1, pfx).c_str(), true);
+            ASSERT_NE(NULL, (LDOC_NULLTYPE)res);
+            EXPECT_EQ(LYT_N256, res->lyt);
+            
+            for (chr = 1; chr < 256; chr++)
+            {
+                if (chr == LDOC_TRIE_RES_CHR)
+                    continue;
+                
+                str[0] = pfx;
+                str[1] = (char)chr;
+                res = ldoc_trie_lookup(trie, str, false);
+                ASSERT_NE(NULL, (LDOC_NULLTYPE)res);
+                EXPECT_EQ(pfx * 256 + chr, res->anno.cat);
+                
+                if (!exp.empty())
+                    exp += collect_sep;
+                
+                exp += str;
+            }
+        }
+        
+        char* col = ldoc_trie_collect(trie, collect_sep);
+        EXPECT_STREQ(exp.c_str(), col);
+        free(col);
+        
+        ldoc_trie_free(trie);
+    }
+}
+
+TEST(ldoc_trie, radix)
+{
+    ldoc_trie_nde_t* res;
+    ldoc_trie_t* trie = ldoc_trie_new_rdx();
+    
+    EXPECT_NE(NULL, (LDOC_NULLTYPE)trie);
+    
+    ldoc_trie_anno_t fauna = { FAUNA, (void*)123 };
+    ldoc_trie_anno_t flora = { FLORA, LDOC_TRIE_ANNO_NULL.pld };
+    
+    ldoc_trie_add(trie, entry_catnip, ASCII, flora);
+    ldoc_trie_add(trie, entry_rose, ASCII, flora);
+    
+    // "catnip" is a single node with label "atnip":
+    res = ldoc_trie_lookup(trie, "catnip", false);
+    EXPECT_NE(NULL, (LDOC_NULLTYPE)res);
+    EXPECT_EQ(5, res->llen);
+    EXPECT_EQ(0, strncmp("atnip", res->lbl, 5));
+    
+    // Splits "catnip" into "cat" and "nip":
+    ldoc_trie_add(trie, entry_cat, ASCII, fauna);
+    
+    res = ldoc_trie_lookup(trie, "cat", false);
+    EXPECT_NE(NULL, (LDOC_NULLTYPE)res);
+    EXPECT_EQ(FAUNA, res->anno.cat);
+    EXPECT_EQ((void*)123, res->anno.pld);
+    EXPECT_EQ(2, res->llen);
+    
+    res = ldoc_trie_lookup(trie, "catnip", false);
+    EXPECT_NE(NULL, (LDOC_NULLTYPE)res);
+    EXPECT_EQ(FLORA, res->anno.cat);
+    EXPECT_EQ(2, res->llen);
+    
+    res = ldoc_trie_lookup(trie, "ca", false);
+    EXPECT_EQ(NULL, (LDOC_NULLTYPE)res);
+    
+    res = ldoc_trie_lookup(trie, "catn", false);
+    EXPECT_EQ(NULL, (LDOC_NULLTYPE)res);
+    
+    res = ldoc_trie_lookup(trie, "carrot", false);
+    EXPECT_EQ(NULL, (LDOC_NULLTYPE)res);
+    
+    // Prefixes within labels have no node of their own:
+    res = ldoc_trie_lookup(trie, "ca", true);
+    EXPECT_EQ(LDOC_TRIE_NDE_PFX, res);
+    EXPECT_EQ(NDE_EMPTY, res->alloc);
+    EXPECT_EQ(0, res->anno.cat);
+    EXPECT_EQ(NULL, res->anno.pld);
+    
+    res = ldoc_trie_lookup(trie, "catnipper", true);
+    EXPECT_EQ(NULL, (LDOC_NULLTYPE)res);
+    
+    char* str = ldoc_trie_collect(trie, collect_sep);
+    EXPECT_STRCASEEQ(collect_entries, str);
+    
+    res = ldoc_trie_remove(trie, "cat");
+    EXPECT_NE(NULL, (LDOC_NULLTYPE)res);
+    
+    res = ldoc_trie_lookup(trie, "cat", false);
+    EXPECT_EQ(NULL, (LDOC_NULLTYPE)res);
+    
+    res = ldoc_trie_lookup(trie, "catnip", false);
+    EXPECT_NE(NULL, (LDOC_NULLTYPE)res);
+    
+    ldoc_trie_free(trie);
+}
+
+TEST(ldoc_trie, long_strings)
+{
+    ldoc_trie_nde_t* res;
+    ldoc_trie_t* trie = ldoc_trie_new();
+    
+    EXPECT_NE(NULL, (LDOC_NULLTYPE)trie);
+    
+    // One node per character, far deeper than a recursion could go:
+    size_t len = 1000000;
+    char* str = (char*)malloc(len + 1);
+    memset(str, 'a', len);
+    str[len] = 0;
+    
+    ldoc_trie_anno_t fauna = { FAUNA, NULL };
+    ldoc_trie_anno_t flora = { FLORA, NULL };
+    
+    ldoc_trie_add(trie, str, ASCII, fauna);
+    str[len - 1] = 'b';
+    ldoc_trie_add(trie, str, ASCII, flora);
+    
+    res = ldoc_trie_lookup(trie, str, false);
+    EXPECT_NE(NULL, (LDOC_NULLTYPE)res);
+    EXPECT_EQ(FLORA, res->anno.cat);
+    
+    str[len / 2] = 0;
+    res = ldoc_trie_lookup(trie, str, false);
+    EXPECT_EQ(NULL, (LDOC_NULLTYPE)res);
+    
+    res = ldoc_trie_lookup(trie, str, true);
+    EXPECT_NE(NULL, (LDOC_NULLTYPE)res);
+    
+    char* all = ldoc_trie_collect(trie, collect_sep);
+    EXPECT_EQ(2 * len + strlen(collect_sep), strlen(all));
+    
+    free(all);
+    free(str);
+    
+    ldoc_trie_free(trie);
+}
+
+static uint64_t frozen_off(void* pld, void* ctx)
+{
+    return (uint64_t)(uintptr_t)pld + *(uint64_t*)ctx;
+}
+
+TEST(ldoc_trie, frozen)
+{
+    ldoc_trie_frz_anno_t anno;
+    char pth[] = "/tmp/ldoc_trie_XXXXXX";
+    int fd = mkstemp(pth);
+    ASSERT_LE(0, fd);
+    close(fd);
+    
+    ldoc_trie_anno_t fauna = { FAUNA, (void*)123 };
+    ldoc_trie_anno_t flora = { FLORA, (void*)456 };
+    uint64_t base = 1000;
+    
+    // Frozen tries read the same from plain and path-compressed tries:
+    int rdx = 0;
+    for (; rdx < 2; rdx++)
+    {
+        ldoc_trie_t* trie = rdx ? ldoc_trie_new_rdx() : ldoc_trie_new();
+        
+        ldoc_trie_add(trie, entry_cat, ASCII, fauna);
+        ldoc_trie_add(trie, entry_catnip, ASCII, flora);
+        ldoc_trie_add(trie, entry_rose, ASCII, flora);
+        
+        ldoc_trie_frz_t* frz = ldoc_trie_frz_new(trie, frozen_off, &base);
+        ASSERT_NE((ldoc_trie_frz_t*)NULL, frz);
+        EXPECT_EQ(3, frz->anno_cnt);
+        EXPECT_TRUE(ldoc_trie_frz_save(frz, pth));
+        ldoc_trie_frz_free(frz);
+        ldoc_trie_free(trie);
+        
+        frz = ldoc_trie_frz_load_mmap(pth);
+        ASSERT_NE((ldoc_trie_frz_t*)NULL, frz);
+        EXPECT_TRUE(frz->map);
+        
+        EXPECT_TRUE(ldoc_trie_frz_lookup(frz, "cat", false, &anno));
+        EXPECT_EQ(FAUNA, anno.cat);
+        EXPECT_EQ(1123, anno.off);
+        
+        EXPECT_TRUE(ldoc_trie_frz_lookup(frz, "catnip", false, &anno));
+        EXPECT_EQ(FLORA, anno.cat);
+        EXPECT_EQ(1456, anno.off);
+        
+        EXPECT_TRUE(ldoc_trie_frz_lookup(frz, "rose", false, NULL));
+        EXPECT_FALSE(ldoc_trie_frz_lookup(frz, "ca", false, NULL));
+        EXPECT_FALSE(ldoc_trie_frz_lookup(frz, "catn", false, NULL));
+        EXPECT_FALSE(ldoc_trie_frz_lookup(frz, "catnipper", true, NULL));
+        EXPECT_FALSE(ldoc_trie_frz_lookup(frz, "carrot", true, NULL));
+        
+        // Prefixes that are not strings of their own have no annotation:
+        EXPECT_TRUE(ldoc_trie_frz_lookup(frz, "catn", true, &anno));
+        EXPECT_EQ(0, anno.cat);
+        EXPECT_EQ(UINT64_MAX, anno.off);
+        
+        ldoc_trie_frz_free(frz);
+    }
+    
+    // Not a frozen trie:
+    FILE* f = fopen(pth, "w");
+    fputs(entry_catnip, f);
+    fclose(f);
+    
+    EXPECT_EQ((ldoc_trie_frz_t*)NULL, ldoc_trie_frz_load_mmap(pth));
+    
+    unlink(pth);
+}
+
+static void scan_hit(void* ctx, size_t end, ldoc_trie_nde_t* nde, uint16_t len)
+{
+    char buf[32];
+    
+    snprintf(buf, sizeof(buf), "%zu:%u:%u ", end, len, nde->anno.cat);
+    ((std::string*)ctx)->append(buf);
+}
+
+TEST(ldoc_trie, scan)
+{
+    ldoc_trie_t* trie = ldoc_trie_new();
+    
+    EXPECT_NE(NULL, (LDOC_NULLTYPE)trie);
+    
+    ldoc_trie_anno_t fauna = { FAUNA, NULL };
+    ldoc_trie_anno_t flora = { FLORA, NULL };
+    
+    ldoc_trie_add(trie, entry_cat, EN_ALPH, fauna);
+    ldoc_trie_add(trie, entry_catnip, EN_ALPH, flora);
+    ldoc_trie_add(trie, entry_rose, EN_ALPH, flora);
+    ldoc_trie_add(trie, "at", EN_ALPH, fauna);
+    
+    // All occurrences, including overlapping ones:
+    const char* txt = "a cat ate catnip";
+    std::string hits;
+    uint32_t st = ldoc_trie_scan(trie, LDOC_TRIE_ST_RT, txt, strlen(txt), scan_hit, &hits);
+    EXPECT_NE(LDOC_TRIE_ST_ERR, st);
+    EXPECT_EQ("5:3:2 5:2:2 8:2:2 13:3:2 13:2:2 16:6:1 ", hits);
+    
+    // Occurrences across pieces of a text:
+    hits.clear();
+    st = ldoc_trie_scan(trie, LDOC_TRIE_ST_RT, txt, 11, scan_hit, &hits);
+    st = ldoc_trie_scan(trie, st, txt + 11, strlen(txt) - 11, scan_hit, &hits);
+    EXPECT_EQ("5:3:2 5:2:2 8:2:2 2:3:2 2:2:2 5:6:1 ", hits);
+    
+    // Removed strings are not found:
+    ldoc_trie_remove(trie, "at");
+    hits.clear();
+    ldoc_trie_scan(trie, LDOC_TRIE_ST_RT, txt, strlen(txt), scan_hit, &hits);
+    EXPECT_EQ("5:3:2 13:3:2 16:6:1 ", hits);
+    
+    ldoc_trie_free(trie);
+}